@@ -1,10 +1,19 @@
 #include "alert_engine.h"
 #include "logutil.h"
 #include "cJSON.h"
+#include "rollup.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define HISTORY_CAPACITY 4096
+#define MAX_RUNS 64
+#define TAIL_IDLE_SECS 300
+#define SAMPLE_PREFIX "zencube_samples_"
+#define SAMPLE_SUFFIX ".jsonl"
 
 // Initialize alert engine
 int alert_engine_init(AlertEngine *engine, const char *config_path, const char *alert_log_path) {
@@ -12,6 +21,11 @@ int alert_engine_init(AlertEngine *engine, const char *config_path, const char *
     
     memset(engine, 0, sizeof(AlertEngine));
     strncpy(engine->alert_log_path, alert_log_path, sizeof(engine->alert_log_path) - 1);
+    engine->started_at = time(NULL);
+    engine->next_seq = 1;
+    engine->history_capacity = HISTORY_CAPACITY;
+    engine->history = calloc(engine->history_capacity, sizeof(AlertEvent));
+    if (!engine->history) return -1;
     
     return alert_engine_load_rules(engine, config_path);
 }
@@ -92,72 +106,267 @@ static int evaluate_condition(double value, AlertOperator op, double threshold)
     }
 }
 
-// Evaluate samples against rules
-int alert_engine_evaluate(AlertEngine *engine, const char *log_path, const char *run_id) {
-    if (!engine || !log_path) return -1;
+// Find the evaluation state of a run, creating it (and recycling the
+// stalest run once MAX_RUNS are tracked) if needed
+static AlertRunState* get_run(AlertEngine *engine, const char *run_id) {
+    for (int i = 0; i < engine->run_count; i++) {
+        if (strcmp(engine->runs[i].run_id, run_id) == 0) {
+            return &engine->runs[i];
+        }
+    }
     
-    FILE *fp = fopen(log_path, "r");
-    if (!fp) return -1;
+    AlertRunState *run;
+    if (engine->run_count < MAX_RUNS) {
+        AlertRunState *grown = realloc(engine->runs, sizeof(AlertRunState) * (size_t)(engine->run_count + 1));
+        if (!grown) return NULL;
+        engine->runs = grown;
+        run = &engine->runs[engine->run_count++];
+    } else {
+        run = &engine->runs[0];
+        for (int i = 1; i < engine->run_count; i++) {
+            if (engine->runs[i].updated < run->updated) run = &engine->runs[i];
+        }
+        free(run->violation_counts);
+        free(run->active);
+    }
     
-    char line[2048];
-    int *violation_counts = calloc(engine->rule_count, sizeof(int));
+    memset(run, 0, sizeof(AlertRunState));
+    snprintf(run->run_id, sizeof(run->run_id), "%s", run_id);
+    run->violation_counts = calloc((size_t)engine->rule_count + 1, sizeof(int));
+    run->active = calloc((size_t)engine->rule_count + 1, sizeof(AlertRecord));
+    if (!run->violation_counts || !run->active) return NULL;
+    return run;
+}
+
+// Record a state change in the history ring and notify the listener
+static void emit_event(AlertEngine *engine, int firing, const AlertRecord *alert) {
+    AlertEvent *event = &engine->history[(engine->next_seq - 1) % engine->history_capacity];
+    event->seq = engine->next_seq++;
+    event->firing = firing;
+    event->alert = *alert;
+    if (engine->history_count < engine->history_capacity) {
+        engine->history_count++;
+    }
     
-    while (fgets(line, sizeof(line), fp)) {
-        cJSON *sample = cJSON_Parse(line);
-        if (!sample) continue;
+    if (engine->on_event) {
+        engine->on_event(event, engine->on_event_ctx);
+    }
+}
+
+// Evaluate one sample against every rule. An alert fires once the rule has
+// held for duration_samples consecutive samples, stays active while it
+// keeps holding and resolves on the first sample where it does not.
+static void evaluate_sample(AlertEngine *engine, cJSON *sample, const char *default_run_id) {
+    cJSON *event = cJSON_GetObjectItem(sample, "event");
+    if (!cJSON_IsString(event) || strcmp(event->valuestring, "sample") != 0) {
+        return;
+    }
+    
+    cJSON *run_id = cJSON_GetObjectItem(sample, "run_id");
+    AlertRunState *run = get_run(engine, cJSON_IsString(run_id) ? run_id->valuestring : default_run_id);
+    if (!run) return;
+    run->updated = ++engine->samples_seen;
+    
+    // Check each rule
+    for (int i = 0; i < engine->rule_count; i++) {
+        AlertRule *rule = &engine->rules[i];
+        cJSON *metric_val = cJSON_GetObjectItem(sample, rule->metric);
         
-        cJSON *event = cJSON_GetObjectItem(sample, "event");
-        if (!event || strcmp(event->valuestring, "sample") != 0) {
-            cJSON_Delete(sample);
-            continue;
-        }
+        if (!metric_val || !cJSON_IsNumber(metric_val)) continue;
+        double value = metric_val->valuedouble;
+        AlertRecord *active = &run->active[i];
         
-        // Check each rule
-        for (int i = 0; i < engine->rule_count; i++) {
-            AlertRule *rule = &engine->rules[i];
-            cJSON *metric_val = cJSON_GetObjectItem(sample, rule->metric);
+        if (evaluate_condition(value, rule->operator, rule->threshold)) {
+            run->violation_counts[i]++;
             
-            if (metric_val && cJSON_IsNumber(metric_val)) {
-                double value = metric_val->valuedouble;
+            // Trigger alert if duration threshold met
+            if (active->alert_id[0] == '\0' && run->violation_counts[i] >= rule->duration_samples) {
+                AlertRecord alert = {0};
+                snprintf(alert.alert_id, sizeof(alert.alert_id), 
+                        "alert_%ld_%s_%llu", time(NULL), rule->metric,
+                        (unsigned long long)engine->next_seq);
+                strncpy(alert.metric, rule->metric, sizeof(alert.metric) - 1);
+                alert.metric[sizeof(alert.metric) - 1] = '\0';  // Ensure null termination
+                strncpy(alert.run_id, run->run_id, sizeof(alert.run_id) - 1);
+                alert.run_id[sizeof(alert.run_id) - 1] = '\0';  // Ensure null termination
+                get_iso_timestamp(alert.triggered_at, sizeof(alert.triggered_at));
+                alert.value = value;
+                alert.threshold = rule->threshold;
+                alert.duration_sec = rule->duration_samples * 1.0;  // Approximate
+                alert.acknowledged = 0;
                 
-                if (evaluate_condition(value, rule->operator, rule->threshold)) {
-                    violation_counts[i]++;
-                    
-                    // Trigger alert if duration threshold met
-                    if (violation_counts[i] >= rule->duration_samples) {
-                        AlertRecord alert = {0};
-                        snprintf(alert.alert_id, sizeof(alert.alert_id), 
-                                "alert_%ld_%s", time(NULL), rule->metric);
-                        strncpy(alert.metric, rule->metric, sizeof(alert.metric) - 1);
-                        alert.metric[sizeof(alert.metric) - 1] = '\0';  // Ensure null termination
-                        strncpy(alert.run_id, run_id, sizeof(alert.run_id) - 1);
-                        alert.run_id[sizeof(alert.run_id) - 1] = '\0';  // Ensure null termination
-                        get_iso_timestamp(alert.triggered_at, sizeof(alert.triggered_at));
-                        alert.value = value;
-                        alert.threshold = rule->threshold;
-                        alert.duration_sec = rule->duration_samples * 1.0;  // Approximate
-                        alert.acknowledged = 0;
-                        
-                        alert_engine_write_alert(engine->alert_log_path, &alert);
-                        
-                        // Reset counter to avoid duplicate alerts
-                        violation_counts[i] = 0;
-                    }
-                } else {
-                    // Reset count if condition not met
-                    violation_counts[i] = 0;
-                }
+                alert_engine_write_alert(engine->alert_log_path, &alert);
+                *active = alert;
+                emit_event(engine, 1, active);
             }
+        } else {
+            // Reset count if condition not met
+            run->violation_counts[i] = 0;
+            
+            if (active->alert_id[0] != '\0') {
+                active->value = value;
+                emit_event(engine, 0, active);
+                memset(active, 0, sizeof(AlertRecord));
+            }
+        }
+    }
+}
+
+typedef struct {
+    AlertEngine *engine;
+    const char *run_id;
+} IngestContext;
+
+static void ingest_line(const char *line, void *ctx) {
+    IngestContext *ingest = ctx;
+    cJSON *sample = cJSON_Parse(line);
+    if (!sample) return;
+    evaluate_sample(ingest->engine, sample, ingest->run_id);
+    cJSON_Delete(sample);
+}
+
+// Tail for a log path, added on first use
+static JsonlTail* get_tail(AlertEngine *engine, const char *log_path) {
+    for (int i = 0; i < engine->tail_count; i++) {
+        if (strcmp(engine->tails[i].path, log_path) == 0) {
+            return &engine->tails[i];
         }
+    }
+    
+    JsonlTail *grown = realloc(engine->tails, sizeof(JsonlTail) * (size_t)(engine->tail_count + 1));
+    if (!grown) return NULL;
+    engine->tails = grown;
+    jsonl_tail_init(&engine->tails[engine->tail_count], log_path);
+    return &engine->tails[engine->tail_count++];
+}
+
+// Evaluate samples appended since the last call
+int alert_engine_evaluate(AlertEngine *engine, const char *log_path, const char *run_id) {
+    if (!engine || !log_path) return -1;
+    
+    JsonlTail *tail = get_tail(engine, log_path);
+    if (!tail) return -1;
+    
+    IngestContext ctx = { engine, run_id ? run_id : "default" };
+    return jsonl_tail_poll(tail, ingest_line, &ctx) < 0 ? -1 : 0;
+}
+
+// Follow every sample log written to a directory after startup
+int alert_engine_watch_dir(AlertEngine *engine, const char *log_dir) {
+    if (!engine || !log_dir) return -1;
+    strncpy(engine->log_dir, log_dir, sizeof(engine->log_dir) - 1);
+    engine->last_scan = 0;
+    return 0;
+}
+
+// Rollup sidecars share the prefix and suffix but hold aggregated rows
+int alert_engine_is_sample_log(const char *name) {
+    size_t len = strlen(name);
+    size_t prefix_len = strlen(SAMPLE_PREFIX);
+    size_t suffix_len = strlen(SAMPLE_SUFFIX);
+    return len > prefix_len + suffix_len &&
+           strncmp(name, SAMPLE_PREFIX, prefix_len) == 0 &&
+           strcmp(name + len - suffix_len, SAMPLE_SUFFIX) == 0 &&
+           !rollup_is_sidecar(name);
+}
+
+// Pick up sample logs written since the engine started; older files in a
+// shared temp directory belong to previous sessions, and idle ones to
+// finished runs
+static void scan_log_dir(AlertEngine *engine, time_t now) {
+    DIR *dir = opendir(engine->log_dir);
+    if (!dir) return;
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (!alert_engine_is_sample_log(entry->d_name)) continue;
         
-        cJSON_Delete(sample);
+        char path[sizeof(engine->log_dir) + 256];
+        snprintf(path, sizeof(path), "%s/%s", engine->log_dir, entry->d_name);
+        
+        struct stat st;
+        if (stat(path, &st) != 0 || st.st_mtime < engine->started_at - 1 ||
+            st.st_mtime < now - TAIL_IDLE_SECS) {
+            continue;
+        }
+        
+        get_tail(engine, path);
     }
     
-    fclose(fp);
-    free(violation_counts);
+    closedir(dir);
+}
+
+// Stop following logs that are gone or have been idle for TAIL_IDLE_SECS,
+// so a long-lived daemon holds an fd only for live runs. A retired log
+// that is written to again is read from the start; the app never appends
+// to an old log (a reused pid's log is replaced first).
+static void retire_tails(AlertEngine *engine, time_t now) {
+    int kept = 0;
+    for (int i = 0; i < engine->tail_count; i++) {
+        JsonlTail *tail = &engine->tails[i];
+        struct stat st;
+        if (stat(tail->path, &st) != 0 || st.st_mtime < now - TAIL_IDLE_SECS) {
+            jsonl_tail_close(tail);
+            continue;
+        }
+        if (kept != i) engine->tails[kept] = *tail;
+        kept++;
+    }
+    engine->tail_count = kept;
+}
+
+// Evaluate new samples from every followed log
+int alert_engine_poll(AlertEngine *engine) {
+    if (!engine) return -1;
+    
+    time_t now = time(NULL);
+    int scan = engine->log_dir[0] != '\0' && now != engine->last_scan;
+    if (scan) {
+        engine->last_scan = now;
+        scan_log_dir(engine, now);
+    }
+    
+    IngestContext ctx = { engine, "default" };
+    for (int i = 0; i < engine->tail_count; i++) {
+        jsonl_tail_poll(&engine->tails[i], ingest_line, &ctx);
+    }
+    
+    // After the last poll, so nothing a retired log holds is missed
+    if (scan) {
+        retire_tails(engine, now);
+    }
     return 0;
 }
 
+// Visit history events newer than `since`
+int alert_engine_events_since(const AlertEngine *engine, uint64_t since, AlertEventCallback cb, void *ctx) {
+    uint64_t oldest = engine->next_seq - engine->history_count;
+    uint64_t first = since + 1 > oldest ? since + 1 : oldest;
+    int visited = 0;
+    
+    for (uint64_t seq = first; seq < engine->next_seq; seq++) {
+        cb(&engine->history[(seq - 1) % engine->history_capacity], ctx);
+        visited++;
+    }
+    return visited;
+}
+
+// Visit currently firing alerts
+int alert_engine_active(const AlertEngine *engine, AlertEventCallback cb, void *ctx) {
+    int visited = 0;
+    for (int r = 0; r < engine->run_count; r++) {
+        for (int i = 0; i < engine->rule_count; i++) {
+            const AlertRecord *active = &engine->runs[r].active[i];
+            if (active->alert_id[0] == '\0') continue;
+            
+            AlertEvent event = { 0, 1, *active };
+            cb(&event, ctx);
+            visited++;
+        }
+    }
+    return visited;
+}
+
 // Write alert to JSONL
 int alert_engine_write_alert(const char *path, const AlertRecord *alert) {
     cJSON *root = cJSON_CreateObject();
@@ -189,7 +398,28 @@ int alert_engine_write_alert(const char *path, const AlertRecord *alert) {
 
 // Cleanup
 void alert_engine_cleanup(AlertEngine *engine) {
-    if (engine && engine->rules) {
+    if (!engine) return;
+    
+    for (int i = 0; i < engine->tail_count; i++) {
+        jsonl_tail_close(&engine->tails[i]);
+    }
+    free(engine->tails);
+    engine->tails = NULL;
+    engine->tail_count = 0;
+    
+    for (int i = 0; i < engine->run_count; i++) {
+        free(engine->runs[i].violation_counts);
+        free(engine->runs[i].active);
+    }
+    free(engine->runs);
+    engine->runs = NULL;
+    engine->run_count = 0;
+    
+    free(engine->history);
+    engine->history = NULL;
+    engine->history_count = 0;
+    
+    if (engine->rules) {
         free(engine->rules);
         engine->rules = NULL;
         engine->rule_count = 0;
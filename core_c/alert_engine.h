@@ -1,7 +1,10 @@
 #ifndef ZENCUBE_ALERT_ENGINE_H
 #define ZENCUBE_ALERT_ENGINE_H
 
+#include "logutil.h"
+#include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 // Alert rule operators
 typedef enum {
@@ -33,12 +36,42 @@ typedef struct {
     char acknowledged_at[32];
 } AlertRecord;
 
+// Alert state change, numbered in the order the engine produced it
+typedef struct {
+    uint64_t seq;
+    int firing;                // 1 = started firing, 0 = resolved
+    AlertRecord alert;
+} AlertEvent;
+
+typedef void (*AlertEventCallback)(const AlertEvent *event, void *ctx);
+
+// Per-run evaluation state
+typedef struct {
+    char run_id[128];
+    int *violation_counts;     // Consecutive violating samples per rule
+    AlertRecord *active;       // Firing alert per rule (alert_id[0] == 0 if none)
+    uint64_t updated;
+} AlertRunState;
+
 // Alert engine state
 typedef struct {
     AlertRule *rules;
     int rule_count;
     char alert_log_path[512];
-    char log_dir[512];
+    char log_dir[512];         // Directory mode: follow every zencube_samples_*.jsonl
+    time_t started_at;
+    time_t last_scan;
+    JsonlTail *tails;
+    int tail_count;
+    AlertRunState *runs;
+    int run_count;
+    uint64_t samples_seen;
+    AlertEvent *history;       // Ring of recent events
+    size_t history_capacity;
+    size_t history_count;
+    uint64_t next_seq;         // Sequence number of the next event (starts at 1)
+    AlertEventCallback on_event;
+    void *on_event_ctx;
 } AlertEngine;
 
 // Initialize alert engine from JSON config
@@ -47,9 +80,27 @@ int alert_engine_init(AlertEngine *engine, const char *config_path, const char *
 // Load alert rules from JSON
 int alert_engine_load_rules(AlertEngine *engine, const char *config_path);
 
-// Evaluate samples against rules
+// Evaluate samples appended to log_path since the last call. Samples
+// without a run_id are attributed to run_id.
 int alert_engine_evaluate(AlertEngine *engine, const char *log_path, const char *run_id);
 
+// Follow every sample log written to a directory after startup
+int alert_engine_watch_dir(AlertEngine *engine, const char *log_dir);
+
+// Whether a file name is a sample log directory mode follows
+// (zencube_samples_*.jsonl, not its rollup sidecars)
+int alert_engine_is_sample_log(const char *name);
+
+// Evaluate new samples from the watched directory
+int alert_engine_poll(AlertEngine *engine);
+
+// Call cb for every event with seq > since still in the history ring.
+// Returns the number of events visited.
+int alert_engine_events_since(const AlertEngine *engine, uint64_t since, AlertEventCallback cb, void *ctx);
+
+// Call cb for every currently firing alert. Returns the number visited.
+int alert_engine_active(const AlertEngine *engine, AlertEventCallback cb, void *ctx);
+
 // Write alert to JSONL
 int alert_engine_write_alert(const char *path, const AlertRecord *alert);
 
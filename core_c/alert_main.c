@@ -1,12 +1,14 @@
 #include "alert_engine.h"
+#include "alert_server.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <getopt.h>
 #include <signal.h>
 #include <unistd.h>
+#include <time.h>
 
-static volatile int running = 1;
+static volatile sig_atomic_t running = 1;
 
 static void handle_signal(int sig) {
     (void)sig;
@@ -14,13 +16,18 @@ static void handle_signal(int sig) {
 }
 
 static void print_usage(const char *prog) {
-    fprintf(stderr, "Usage: %s --config <config.json> --log <samples.jsonl> --out <alerts.jsonl> --run-id <id> [--interval <sec>]\n", prog);
+    fprintf(stderr, "Usage: %s --config <config.json> (--log <samples.jsonl> --run-id <id> | --dir <dir>)\n", prog);
+    fprintf(stderr, "       --out <alerts.jsonl> [--socket <path>] [--interval <sec>]\n");
     fprintf(stderr, "Options:\n");
     fprintf(stderr, "  --config PATH      Alert rules JSON config\n");
     fprintf(stderr, "  --log PATH         Sample JSONL log to monitor\n");
+    fprintf(stderr, "  --dir DIR          Monitor every zencube_samples_*.jsonl written to DIR\n");
+    fprintf(stderr, "                     after startup (run ids come from the samples)\n");
     fprintf(stderr, "  --out PATH         Output alerts JSONL path\n");
-    fprintf(stderr, "  --run-id ID        Run identifier\n");
-    fprintf(stderr, "  --interval SEC     Evaluation interval (default: 5)\n");
+    fprintf(stderr, "  --run-id ID        Run identifier for samples without one\n");
+    fprintf(stderr, "  --socket PATH      Serve alert queries on a Unix socket\n");
+    fprintf(stderr, "  --interval SEC     Evaluation interval (default: 5, or 0.5 with --socket,\n");
+    fprintf(stderr, "                     where log changes also wake evaluation immediately)\n");
     fprintf(stderr, "  --help             Show this help\n");
 }
 
@@ -29,26 +36,32 @@ int main(int argc, char **argv) {
     char *log_path = NULL;
     char *out_path = NULL;
     char *run_id = NULL;
-    int interval = 5;
+    char *log_dir = NULL;
+    char *socket_path = NULL;
+    double interval = 0;
     
     static struct option long_options[] = {
         {"config",   required_argument, 0, 'c'},
         {"log",      required_argument, 0, 'l'},
         {"out",      required_argument, 0, 'o'},
         {"run-id",   required_argument, 0, 'r'},
+        {"dir",      required_argument, 0, 'd'},
+        {"socket",   required_argument, 0, 's'},
         {"interval", required_argument, 0, 'i'},
         {"help",     no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "c:l:o:r:i:h", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:l:o:r:d:s:i:h", long_options, NULL)) != -1) {
         switch (opt) {
             case 'c': config_path = optarg; break;
             case 'l': log_path = optarg; break;
             case 'o': out_path = optarg; break;
             case 'r': run_id = optarg; break;
-            case 'i': interval = atoi(optarg); break;
+            case 'd': log_dir = optarg; break;
+            case 's': socket_path = optarg; break;
+            case 'i': interval = atof(optarg); break;
             case 'h':
             default:
                 print_usage(argv[0]);
@@ -56,7 +69,7 @@ int main(int argc, char **argv) {
         }
     }
     
-    if (!config_path || !log_path || !out_path || !run_id) {
+    if (!config_path || !out_path || !(log_dir || (log_path && run_id))) {
         fprintf(stderr, "Error: Missing required arguments\n");
         print_usage(argv[0]);
         return 1;
@@ -69,9 +82,18 @@ int main(int argc, char **argv) {
         return 1;
     }
     
-    printf("Alert engine started (run-id=%s, interval=%ds)\n", run_id, interval);
+    if (interval <= 0) {
+        interval = socket_path ? 0.5 : 5;
+    }
+    
+    if (log_dir) {
+        alert_engine_watch_dir(&engine, log_dir);
+        log_path = NULL;
+    }
+    
+    printf("Alert engine started (run-id=%s, interval=%.2fs)\n", run_id ? run_id : "from samples", interval);
     printf("Config: %s\n", config_path);
-    printf("Monitoring: %s\n", log_path);
+    printf("Monitoring: %s\n", log_dir ? log_dir : log_path);
     printf("Alerts: %s\n", out_path);
     printf("Loaded %d rules\n", engine.rule_count);
     
@@ -79,12 +101,30 @@ int main(int argc, char **argv) {
     signal(SIGINT, handle_signal);
     signal(SIGTERM, handle_signal);
     
-    // Main evaluation loop
-    while (running) {
-        if (alert_engine_evaluate(&engine, log_path, run_id) != 0) {
-            fprintf(stderr, "Warning: Evaluation cycle failed\n");
+    if (socket_path) {
+        AlertServer server;
+        if (alert_server_init(&server, socket_path, &engine) != 0) {
+            fprintf(stderr, "Failed to open alert socket %s\n", socket_path);
+            alert_engine_cleanup(&engine);
+            return 1;
+        }
+        alert_server_watch(&server, log_dir ? log_dir : log_path);
+        
+        printf("Serving alert queries on %s\n", socket_path);
+        fflush(stdout);
+        
+        alert_server_run(&server, log_path, run_id, (int)(interval * 1000), &running);
+        alert_server_cleanup(&server);
+    } else {
+        // Main evaluation loop
+        while (running) {
+            int rc = log_path ? alert_engine_evaluate(&engine, log_path, run_id) : alert_engine_poll(&engine);
+            if (rc != 0) {
+                fprintf(stderr, "Warning: Evaluation cycle failed\n");
+            }
+            struct timespec pause = { (time_t)interval, (long)((interval - (time_t)interval) * 1e9) };
+            nanosleep(&pause, NULL);
         }
-        sleep(interval);
     }
     
     printf("\nShutdown signal received, cleaning up...\n");
@@ -0,0 +1,418 @@
+#include "alert_server.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <libgen.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/inotify.h>
+#include <time.h>
+
+// Serialize an event (or active alert, which has no seq) as a JSON object
+static cJSON* event_to_json(const AlertEvent *event) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) return NULL;
+    
+    const AlertRecord *alert = &event->alert;
+    if (event->seq > 0) {
+        cJSON_AddNumberToObject(root, "seq", (double)event->seq);
+    }
+    cJSON_AddStringToObject(root, "state", event->firing ? "firing" : "resolved");
+    cJSON_AddStringToObject(root, "alert_id", alert->alert_id);
+    cJSON_AddStringToObject(root, "metric", alert->metric);
+    cJSON_AddStringToObject(root, "run_id", alert->run_id);
+    cJSON_AddStringToObject(root, "triggered_at", alert->triggered_at);
+    cJSON_AddNumberToObject(root, "value", alert->value);
+    cJSON_AddNumberToObject(root, "threshold", alert->threshold);
+    cJSON_AddNumberToObject(root, "duration_sec", alert->duration_sec);
+    cJSON_AddBoolToObject(root, "acknowledged", alert->acknowledged);
+    return root;
+}
+
+static void close_client(AlertClient *client) {
+    if (client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+    free(client->out);
+    client->out = NULL;
+    client->out_len = 0;
+    client->out_cap = 0;
+}
+
+// Write as much of the queued output as the socket takes
+static void flush_client(AlertClient *client) {
+    size_t done = 0;
+    while (done < client->out_len) {
+        ssize_t sent = send(client->fd, client->out + done, client->out_len - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            close_client(client);
+            return;
+        }
+        done += (size_t)sent;
+    }
+    if (done == 0) return;
+    client->out_len -= done;
+    memmove(client->out, client->out + done, client->out_len);
+}
+
+// Queue one JSON line and send what the socket takes; the rest goes out on
+// POLLOUT. A client more than ALERT_SERVER_MAX_QUEUED behind is dropped, so
+// a stuck GUI never stalls evaluation or grows the daemon.
+static void send_json(AlertClient *client, cJSON *json) {
+    if (client->fd < 0 || !json) return;
+    
+    char *text = cJSON_PrintUnformatted(json);
+    if (!text) return;
+    
+    size_t len = strlen(text);
+    text[len] = '\n';           // Replace the terminator; length is explicit
+    if (client->out_len + len + 1 > ALERT_SERVER_MAX_QUEUED) {
+        close_client(client);
+        free(text);
+        return;
+    }
+    if (client->out_len + len + 1 > client->out_cap) {
+        size_t cap = client->out_cap ? client->out_cap : 4096;
+        while (cap < client->out_len + len + 1) cap *= 2;
+        char *grown = realloc(client->out, cap);
+        if (!grown) {
+            close_client(client);
+            free(text);
+            return;
+        }
+        client->out = grown;
+        client->out_cap = cap;
+    }
+    memcpy(client->out + client->out_len, text, len + 1);
+    client->out_len += len + 1;
+    free(text);
+    
+    flush_client(client);
+}
+
+// Engine callback: push each new event to subscribers
+static void broadcast_event(const AlertEvent *event, void *ctx) {
+    AlertServer *server = ctx;
+    cJSON *json = NULL;
+    
+    for (int i = 0; i < server->client_count; i++) {
+        AlertClient *client = &server->clients[i];
+        if (client->fd < 0 || !client->subscribed) continue;
+        
+        if (!json) {
+            json = event_to_json(event);
+            cJSON_AddStringToObject(json, "type", "event");
+        }
+        send_json(client, json);
+    }
+    
+    cJSON_Delete(json);
+}
+
+static void collect_event(const AlertEvent *event, void *ctx) {
+    cJSON_AddItemToArray((cJSON *)ctx, event_to_json(event));
+}
+
+typedef struct {
+    AlertClient *client;
+} ReplayContext;
+
+static void replay_event(const AlertEvent *event, void *ctx) {
+    ReplayContext *replay = ctx;
+    cJSON *json = event_to_json(event);
+    cJSON_AddStringToObject(json, "type", "event");
+    send_json(replay->client, json);
+    cJSON_Delete(json);
+}
+
+// Handle one request line:
+//   {"cmd":"active"}               -> {"type":"active","next_seq":M,"alerts":[...]}
+//   {"cmd":"since","seq":N}        -> {"type":"events","next_seq":M,"events":[...]}
+//   {"cmd":"subscribe","seq":N}    -> {"type":"subscribed","next_seq":M}, then
+//                                     {"type":"event",...} lines, replaying
+//                                     events after N and pushing new ones
+static void handle_command(AlertServer *server, AlertClient *client, const char *line) {
+    cJSON *request = cJSON_Parse(line);
+    cJSON *cmd = request ? cJSON_GetObjectItem(request, "cmd") : NULL;
+    cJSON *seq_item = request ? cJSON_GetObjectItem(request, "seq") : NULL;
+    uint64_t since = cJSON_IsNumber(seq_item) && seq_item->valuedouble > 0 ? (uint64_t)seq_item->valuedouble : 0;
+    cJSON *response = cJSON_CreateObject();
+    
+    if (!cJSON_IsString(cmd)) {
+        cJSON_AddStringToObject(response, "type", "error");
+        cJSON_AddStringToObject(response, "message", "invalid request");
+        send_json(client, response);
+    } else if (strcmp(cmd->valuestring, "active") == 0) {
+        cJSON_AddStringToObject(response, "type", "active");
+        cJSON_AddNumberToObject(response, "next_seq", (double)server->engine->next_seq);
+        cJSON *alerts = cJSON_AddArrayToObject(response, "alerts");
+        alert_engine_active(server->engine, collect_event, alerts);
+        send_json(client, response);
+    } else if (strcmp(cmd->valuestring, "since") == 0) {
+        cJSON_AddStringToObject(response, "type", "events");
+        cJSON_AddNumberToObject(response, "next_seq", (double)server->engine->next_seq);
+        cJSON *events = cJSON_AddArrayToObject(response, "events");
+        alert_engine_events_since(server->engine, since, collect_event, events);
+        send_json(client, response);
+    } else if (strcmp(cmd->valuestring, "subscribe") == 0) {
+        cJSON_AddStringToObject(response, "type", "subscribed");
+        cJSON_AddNumberToObject(response, "next_seq", (double)server->engine->next_seq);
+        send_json(client, response);
+        
+        ReplayContext replay = { client };
+        alert_engine_events_since(server->engine, since, replay_event, &replay);
+        client->subscribed = 1;
+    } else {
+        cJSON_AddStringToObject(response, "type", "error");
+        cJSON_AddStringToObject(response, "message", "unknown command");
+        send_json(client, response);
+    }
+    
+    cJSON_Delete(response);
+    cJSON_Delete(request);
+}
+
+// Read from a client and dispatch complete lines
+static void read_client(AlertServer *server, AlertClient *client) {
+    ssize_t n = recv(client->fd, client->buffer + client->len, sizeof(client->buffer) - 1 - client->len, 0);
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        close_client(client);
+        return;
+    }
+    client->len += (size_t)n;
+    client->buffer[client->len] = '\0';
+    
+    char *start = client->buffer;
+    char *nl;
+    while (client->fd >= 0 && (nl = strchr(start, '\n')) != NULL) {
+        *nl = '\0';
+        if (nl > start) handle_command(server, client, start);
+        start = nl + 1;
+    }
+    if (client->fd < 0) return;
+    
+    client->len -= (size_t)(start - client->buffer);
+    memmove(client->buffer, start, client->len);
+    
+    // A request that does not fit the buffer is not a request
+    if (client->len >= sizeof(client->buffer) - 1) {
+        close_client(client);
+    }
+}
+
+// Bind the socket and hook into the engine
+int alert_server_init(AlertServer *server, const char *socket_path, AlertEngine *engine) {
+    memset(server, 0, sizeof(AlertServer));
+    server->listen_fd = -1;
+    server->inotify_fd = -1;
+    server->engine = engine;
+    
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+    strcpy(server->socket_path, socket_path);
+    
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listen_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    
+    // A socket left behind by a previous daemon would make bind fail
+    unlink(socket_path);
+    if (bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        perror("bind");
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        return -1;
+    }
+    chmod(socket_path, 0600);
+    
+    if (listen(server->listen_fd, 8) < 0) {
+        perror("listen");
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        return -1;
+    }
+    
+    // Without inotify the loop still polls every poll_ms
+    server->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    
+    engine->on_event = broadcast_event;
+    engine->on_event_ctx = server;
+    return 0;
+}
+
+// Watch the directory holding path (or path itself if it is a directory)
+int alert_server_watch(AlertServer *server, const char *path) {
+    if (server->inotify_fd < 0) return -1;
+    
+    struct stat st;
+    snprintf(server->watch_dir, sizeof(server->watch_dir), "%s", path);
+    server->watch_name[0] = '\0';
+    if (stat(path, &st) != 0 || !S_ISDIR(st.st_mode)) {
+        // The log may not exist yet; its directory does
+        char copy[1024];
+        snprintf(copy, sizeof(copy), "%s", path);
+        snprintf(server->watch_dir, sizeof(server->watch_dir), "%s", dirname(copy));
+        snprintf(copy, sizeof(copy), "%s", path);
+        snprintf(server->watch_name, sizeof(server->watch_name), "%s", basename(copy));
+        inotify_add_watch(server->inotify_fd, path, IN_MODIFY);
+    }
+    
+    return inotify_add_watch(server->inotify_fd, server->watch_dir, IN_CREATE | IN_MOVED_TO) < 0 ? -1 : 0;
+}
+
+// Drop closed clients from the table
+static void compact_clients(AlertServer *server) {
+    int kept = 0;
+    for (int i = 0; i < server->client_count; i++) {
+        if (server->clients[i].fd >= 0) {
+            if (kept != i) server->clients[kept] = server->clients[i];
+            kept++;
+        }
+    }
+    server->client_count = kept;
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Drain the inotify queue; returns whether a sample log changed. Appends
+// come from the logs' own watches; a new log in the directory gets one.
+static int sample_log_changed(AlertServer *server) {
+    _Alignas(struct inotify_event) char events[4096];
+    int changed = 0;
+    ssize_t n;
+    while ((n = read(server->inotify_fd, events, sizeof(events))) > 0) {
+        for (char *p = events; p < events + n; ) {
+            const struct inotify_event *event = (const struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+            if (event->mask & (IN_MODIFY | IN_Q_OVERFLOW)) {
+                changed = 1;
+                continue;
+            }
+            if (event->len == 0) continue;
+            if (server->watch_name[0] ? strcmp(event->name, server->watch_name) != 0
+                                      : !alert_engine_is_sample_log(event->name)) {
+                continue;
+            }
+            char log[sizeof(server->watch_dir) + 256];
+            snprintf(log, sizeof(log), "%s/%s", server->watch_dir, event->name);
+            inotify_add_watch(server->inotify_fd, log, IN_MODIFY);
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+// Serve until stopped
+int alert_server_run(AlertServer *server, const char *log_path, const char *run_id,
+                     int poll_ms, volatile sig_atomic_t *running) {
+    struct pollfd fds[2 + ALERT_SERVER_MAX_CLIENTS];
+    int changed = 1;
+    int64_t next_poll = 0;
+    
+    while (*running) {
+        // Evaluate when a sample log changed, and every poll_ms regardless
+        int64_t now = now_ms();
+        if (changed || now >= next_poll) {
+            if (log_path) {
+                alert_engine_evaluate(server->engine, log_path, run_id);
+            } else {
+                alert_engine_poll(server->engine);
+            }
+            changed = 0;
+            next_poll = now + poll_ms;
+        }
+        compact_clients(server);
+        
+        int nfds = 0;
+        fds[nfds++] = (struct pollfd){ .fd = server->listen_fd, .events = POLLIN, .revents = 0 };
+        fds[nfds++] = (struct pollfd){ .fd = server->inotify_fd, .events = POLLIN, .revents = 0 };
+        for (int i = 0; i < server->client_count; i++) {
+            short events = server->clients[i].out_len > 0 ? POLLIN | POLLOUT : POLLIN;
+            fds[nfds++] = (struct pollfd){ .fd = server->clients[i].fd, .events = events, .revents = 0 };
+        }
+        
+        int ready = poll(fds, (nfds_t)nfds, (int)(next_poll - now));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            return -1;
+        }
+        if (ready == 0) continue;
+        
+        // Which log matters, not what changed in it; the tails find that out
+        if (fds[1].revents & POLLIN) {
+            changed = sample_log_changed(server);
+        }
+        
+        for (int i = 0; i < server->client_count; i++) {
+            AlertClient *client = &server->clients[i];
+            if (client->fd >= 0 && (fds[2 + i].revents & POLLOUT)) {
+                flush_client(client);
+            }
+            if (client->fd >= 0 && (fds[2 + i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                read_client(server, client);
+            }
+        }
+        
+        if (fds[0].revents & POLLIN) {
+            int fd;
+            while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                compact_clients(server);
+                if (server->client_count >= ALERT_SERVER_MAX_CLIENTS) {
+                    close(fd);
+                    continue;
+                }
+                AlertClient *client = &server->clients[server->client_count++];
+                memset(client, 0, sizeof(AlertClient));
+                client->fd = fd;
+            }
+        }
+    }
+    
+    return 0;
+}
+
+// Close all clients and remove the socket
+void alert_server_cleanup(AlertServer *server) {
+    for (int i = 0; i < server->client_count; i++) {
+        close_client(&server->clients[i]);
+    }
+    server->client_count = 0;
+    
+    if (server->inotify_fd >= 0) {
+        close(server->inotify_fd);
+        server->inotify_fd = -1;
+    }
+    
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        unlink(server->socket_path);
+    }
+    
+    if (server->engine) {
+        server->engine->on_event = NULL;
+        server->engine->on_event_ctx = NULL;
+    }
+}
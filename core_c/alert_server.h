@@ -0,0 +1,50 @@
+#ifndef ZENCUBE_ALERT_SERVER_H
+#define ZENCUBE_ALERT_SERVER_H
+
+#include "alert_engine.h"
+#include <signal.h>
+
+#define ALERT_SERVER_MAX_CLIENTS 32
+#define ALERT_SERVER_MAX_QUEUED (4 * 1024 * 1024)
+
+// Connected client; requests are newline-delimited JSON
+typedef struct {
+    int fd;
+    int subscribed;            // Receives every new event as it happens
+    char buffer[1024];
+    size_t len;
+    char *out;                 // Replies the socket has not taken yet
+    size_t out_len;
+    size_t out_cap;
+} AlertClient;
+
+// Unix-socket query service in front of an alert engine
+typedef struct {
+    int listen_fd;
+    int inotify_fd;            // Wakes the loop when sample logs change
+    char watch_dir[1024];      // Directory watched for new logs
+    char watch_name[256];      // Log file name to follow; empty = any sample log
+    char socket_path[108];
+    AlertEngine *engine;
+    AlertClient clients[ALERT_SERVER_MAX_CLIENTS];
+    int client_count;
+} AlertServer;
+
+// Bind the socket at path (replacing a stale one) and hook into the engine
+int alert_server_init(AlertServer *server, const char *socket_path, AlertEngine *engine);
+
+// Watch a sample log or directory so appends wake the loop immediately.
+// The directory is only watched for new logs and each log for appends, so
+// other files written next to them never wake the loop. Logs that already
+// existed are only re-checked every poll_ms.
+int alert_server_watch(AlertServer *server, const char *path);
+
+// Serve requests and evaluate samples until *running becomes 0. Samples are
+// re-checked on every inotify wakeup and at least every poll_ms.
+int alert_server_run(AlertServer *server, const char *log_path, const char *run_id,
+                     int poll_ms, volatile sig_atomic_t *running);
+
+// Close all clients and remove the socket
+void alert_server_cleanup(AlertServer *server);
+
+#endif // ZENCUBE_ALERT_SERVER_H
@@ -0,0 +1,588 @@
+#include "batch.h"
+#include "launcher.h"
+#include "cgroup.h"
+#include "logutil.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+
+static double elapsed_sec(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) + (double)(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static struct timespec add_sec(struct timespec t, double sec) {
+    long ns = t.tv_nsec + (long)((sec - (double)(long)sec) * 1e9);
+    t.tv_sec += (time_t)sec + ns / 1000000000L;
+    t.tv_nsec = ns % 1000000000L;
+    return t;
+}
+
+static int before(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+int batch_init(BatchRunner *runner) {
+    memset(runner, 0, sizeof(BatchRunner));
+    runner->pin = 1;
+    runner->sample_interval = 0.1;
+    snprintf(runner->run_id, sizeof(runner->run_id), "batch_%ld", (long)time(NULL));
+    overlay_config_init(&runner->overlay);
+    placement_request_init(&runner->placement);
+    runner->placement.reserve_cores = 0;   // The runner samples its jobs itself
+    
+    // Size the pool by the CPUs we may run on (cgroups and taskset narrow this)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        runner->cpu_count = CPU_COUNT(&set);
+    }
+    if (runner->cpu_count == 0) {
+        runner->cpu_count = 1;
+        runner->pin = 0;
+    }
+    
+    runner->workers = runner->cpu_count;
+    return 0;
+}
+
+// Job key, falling back to the manifest defaults
+static cJSON* job_item(cJSON *job, cJSON *defaults, const char *key) {
+    cJSON *item = cJSON_GetObjectItem(job, key);
+    return item ? item : (defaults ? cJSON_GetObjectItem(defaults, key) : NULL);
+}
+
+static double job_number(cJSON *job, cJSON *defaults, const char *key) {
+    cJSON *item = job_item(job, defaults, key);
+    return cJSON_IsNumber(item) && item->valuedouble > 0 ? item->valuedouble : 0;
+}
+
+static char** copy_argv(cJSON *job, cJSON *defaults) {
+    cJSON *argv = job_item(job, defaults, "argv");
+    cJSON *command = job_item(job, defaults, "command");
+    
+    if (cJSON_IsString(command)) {
+        char **out = calloc(4, sizeof(char *));
+        if (!out) return NULL;
+        out[0] = strdup("/bin/sh");
+        out[1] = strdup("-c");
+        out[2] = strdup(command->valuestring);
+        return out;
+    }
+    
+    int count = cJSON_IsArray(argv) ? cJSON_GetArraySize(argv) : 0;
+    if (count == 0) return NULL;
+    
+    char **out = calloc((size_t)count + 1, sizeof(char *));
+    if (!out) return NULL;
+    for (int i = 0; i < count; i++) {
+        cJSON *arg = cJSON_GetArrayItem(argv, i);
+        out[i] = strdup(cJSON_IsString(arg) ? arg->valuestring : "");
+    }
+    return out;
+}
+
+static void free_argv(char **argv) {
+    if (!argv) return;
+    for (int i = 0; argv[i]; i++) {
+        free(argv[i]);
+    }
+    free(argv);
+}
+
+int batch_load_manifest(BatchRunner *runner, const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Manifest not found: %s\n", path);
+        return -1;
+    }
+    
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    
+    char *content = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    if (!content) {
+        fprintf(stderr, "Cannot read manifest: %s\n", path);
+        fclose(fp);
+        return -1;
+    }
+    size_t bytes_read = fread(content, 1, (size_t)size, fp);
+    content[bytes_read] = '\0';
+    fclose(fp);
+    
+    cJSON *root = cJSON_Parse(content);
+    free(content);
+    
+    cJSON *jobs = root ? cJSON_GetObjectItem(root, "jobs") : NULL;
+    if (!cJSON_IsArray(jobs)) {
+        fprintf(stderr, "Manifest needs a \"jobs\" array: %s\n", path);
+        cJSON_Delete(root);
+        return -1;
+    }
+    cJSON *defaults = cJSON_GetObjectItem(root, "defaults");
+    
+    int count = cJSON_GetArraySize(jobs);
+    runner->jobs = calloc((size_t)(count > 0 ? count : 1), sizeof(BatchJob));
+    if (!runner->jobs) {
+        cJSON_Delete(root);
+        return -1;
+    }
+    
+    int max_cpus = runner->cpu_count < PLACEMENT_MAX_CORES_PER_RUN ? runner->cpu_count : PLACEMENT_MAX_CORES_PER_RUN;
+    for (int i = 0; i < count; i++) {
+        cJSON *item = cJSON_GetArrayItem(jobs, i);
+        BatchJob *job = &runner->jobs[runner->job_count];
+        
+        job->argv = copy_argv(item, defaults);
+        if (!job->argv) {
+            fprintf(stderr, "Job %d has neither argv nor command, skipping\n", i);
+            continue;
+        }
+        
+        cJSON *id = cJSON_GetObjectItem(item, "id");
+        if (cJSON_IsString(id)) {
+            snprintf(job->id, sizeof(job->id), "%s", id->valuestring);
+        } else {
+            snprintf(job->id, sizeof(job->id), "job-%d", i);
+        }
+        
+        cJSON *jail = job_item(item, defaults, "jail");
+        if (cJSON_IsString(jail)) {
+            snprintf(job->jail_dir, sizeof(job->jail_dir), "%s", jail->valuestring);
+        }
+        job->overlay = job->jail_dir[0] && cJSON_IsTrue(job_item(item, defaults, "overlay"));
+        job->no_net = cJSON_IsTrue(job_item(item, defaults, "no_net"));
+        
+        job->cpus = (int)job_number(item, defaults, "cpus");
+        if (job->cpus < 1) job->cpus = 1;
+        if (job->cpus > max_cpus) job->cpus = max_cpus;
+        
+        job->limits.timeout_sec = job_number(item, defaults, "timeout");
+        job->limits.cpu_sec = (long)job_number(item, defaults, "cpu_limit");
+        job->limits.mem_mb = (long)job_number(item, defaults, "mem_limit");
+        job->limits.proc_limit = (long)job_number(item, defaults, "proc_limit");
+        job->limits.file_size_mb = (long)job_number(item, defaults, "file_size_limit");
+        job->state = BATCH_JOB_PENDING;
+        job->status_fd = -1;
+        runner->job_count++;
+    }
+    
+    cJSON_Delete(root);
+    return 0;
+}
+
+static void set_limit(int resource, rlim_t value) {
+    struct rlimit limit = { value, value };
+    setrlimit(resource, &limit);
+}
+
+// Child side: stdio, then the launcher applies the job's cgroup, core
+// lease, jail/net restrictions and CPU budget, reports them on status_fd
+// and execs. Never returns.
+static void exec_job(const BatchRunner *runner, const BatchJob *job, int log_fd, int status_fd) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, NULL);
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    setpgid(0, 0);
+    
+    // Per process, so an rlimit fits; memory and tasks are per cgroup below
+    const BatchLimits *limits = &job->limits;
+    if (limits->file_size_mb > 0) set_limit(RLIMIT_FSIZE, (rlim_t)limits->file_size_mb * 1024 * 1024);
+    
+    int null_fd = open("/dev/null", O_RDONLY);
+    if (null_fd >= 0) dup2(null_fd, STDIN_FILENO);
+    dup2(log_fd, STDOUT_FILENO);
+    dup2(log_fd, STDERR_FILENO);
+    
+    LaunchConfig config;
+    launch_config_init(&config);
+    config.jail_best_effort = 1;
+    config.cgroup_best_effort = 1;
+    config.status_fd = status_fd;
+    config.cpu_seconds = (unsigned long)limits->cpu_sec;
+    if (limits->mem_mb > 0 || limits->proc_limit > 0) {
+        if (launch_use_cgroup(&config, runner->cgroup_parent[0] ? runner->cgroup_parent : NULL) == 0) {
+            config.cgroup.memory_max_mb = limits->mem_mb;
+            config.cgroup.pids_max = limits->proc_limit;
+        } else {
+            fprintf(stderr, "zencube_batch: no cgroup v2 hierarchy; memory and task limits not applied\n");
+        }
+    }
+    if (runner->pin) {
+        config.placement_mode = LAUNCH_PLACE_RUN;
+        config.placement = runner->placement;
+        config.placement.cores = job->cpus;
+    }
+    if (job->jail_dir[0]) {
+        if (launch_set_jail(&config, job->jail_dir) != 0) {
+            fprintf(stderr, "zencube_batch: cannot use jail directory %s\n", job->jail_dir);
+            _exit(126);
+        }
+        launch_add_default_paths(&config);
+        if (strchr(job->argv[0], '/')) {
+            launch_add_path(&config, job->argv[0], LAUNCH_PATH_READ_ONLY);
+        }
+        if (job->overlay) {
+            config.overlay = runner->overlay;
+            launch_use_overlay(&config);
+        }
+    }
+    if (job->no_net) {
+        launch_deny_network(&config);
+    }
+    
+    LaunchResult result;
+    launch_exec(&config, job->argv, &result);
+    fprintf(stderr, "zencube_batch: %s\n", result.error);
+    _exit(strncmp(result.error, "exec ", 5) == 0 ? 127 : 126);
+}
+
+static int start_job(BatchRunner *runner, BatchJob *job) {
+    int log_fd;
+    if (runner->log_dir[0]) {
+        // Ids name files; keep them inside the log directory
+        char name[128];
+        snprintf(name, sizeof(name), "%s", job->id);
+        for (char *c = name; *c; c++) {
+            if (*c == '/') *c = '_';
+        }
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s.log", runner->log_dir, name);
+        log_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    } else {
+        log_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    }
+    if (log_fd < 0) return -1;
+    
+    // The launcher's status line says where the job was placed; it is
+    // read once the job has exited
+    int status_pipe[2] = { -1, -1 };
+    if (pipe2(status_pipe, O_CLOEXEC) == 0) {
+        fcntl(status_pipe[0], F_SETFL, O_NONBLOCK);
+    } else {
+        status_pipe[0] = status_pipe[1] = -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &job->started);
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(log_fd);
+        if (status_pipe[0] >= 0) {
+            close(status_pipe[0]);
+            close(status_pipe[1]);
+        }
+        return -1;
+    }
+    if (pid == 0) {
+        if (status_pipe[0] >= 0) close(status_pipe[0]);
+        exec_job(runner, job, log_fd, status_pipe[1]);
+    }
+    
+    // Also set here so a timeout can kill the group before the child runs
+    setpgid(pid, pid);
+    close(log_fd);
+    if (status_pipe[1] >= 0) close(status_pipe[1]);
+    job->status_fd = status_pipe[0];
+    
+    job->pid = pid;
+    job->state = BATCH_JOB_RUNNING;
+    if (job->limits.timeout_sec > 0) {
+        job->deadline = add_sec(job->started, job->limits.timeout_sec);
+    }
+    
+    char run_id[256];
+    snprintf(run_id, sizeof(run_id), "%s_%s", runner->run_id, job->id);
+    sampler_target_init(&job->sampler, pid, run_id);
+    runner->running++;
+    return 0;
+}
+
+static void write_result(const BatchRunner *runner, cJSON *json) {
+    char *text = cJSON_PrintUnformatted(json);
+    if (text) {
+        append_jsonl(runner->results_path, text);
+        free(text);
+    }
+}
+
+// Summary line for a job the runner never started
+static void write_skipped(const BatchRunner *runner, const BatchJob *job, const char *status) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "event", "job");
+    cJSON_AddStringToObject(json, "id", job->id);
+    cJSON_AddStringToObject(json, "status", status);
+    write_result(runner, json);
+    cJSON_Delete(json);
+}
+
+// The first line the launcher wrote on the job's status pipe ("ready",
+// or "error" if it failed before exec); NULL if there is none
+static cJSON* read_status(BatchJob *job) {
+    if (job->status_fd < 0) return NULL;
+    char buf[8192];
+    size_t len = 0;
+    ssize_t n;
+    while (len < sizeof(buf) - 1 && (n = read(job->status_fd, buf + len, sizeof(buf) - 1 - len)) > 0) {
+        len += (size_t)n;
+    }
+    close(job->status_fd);
+    job->status_fd = -1;
+    buf[len] = '\0';
+    char *newline = strchr(buf, '\n');
+    if (newline) *newline = '\0';
+    return len > 0 ? cJSON_Parse(buf) : NULL;
+}
+
+// Kill what is left of a limited job and remove its cgroup, as the app
+// does when a run ends
+static void remove_cgroup(const char *path) {
+    cgroup_write(path, "cgroup.kill", "1");
+    for (int i = 0; i < 20 && rmdir(path) != 0 && errno == EBUSY; i++) {
+        struct timespec pause = { 0, 10 * 1000000L };
+        nanosleep(&pause, NULL);
+    }
+}
+
+static const char* finish_job(BatchRunner *runner, BatchJob *job, int status, const struct rusage *usage) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    job->state = BATCH_JOB_DONE;
+    runner->running--;
+    
+    const char *outcome;
+    if (job->timed_out) {
+        outcome = "timeout";
+    } else if (WIFSIGNALED(status)) {
+        outcome = "signaled";
+    } else {
+        outcome = WEXITSTATUS(status) == 0 ? "ok" : "failed";
+    }
+    
+    char timestamp[32];
+    get_iso_timestamp(timestamp, sizeof(timestamp));
+    
+    // rusage is exact for short jobs the sampler never saw; samples add
+    // CPU percent and fd peaks
+    uint64_t max_rss = (uint64_t)usage->ru_maxrss * 1024;
+    if (job->sampler.max_rss > max_rss) max_rss = job->sampler.max_rss;
+    
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "event", "job");
+    cJSON_AddStringToObject(json, "id", job->id);
+    cJSON_AddStringToObject(json, "timestamp", timestamp);
+    cJSON_AddStringToObject(json, "run_id", job->sampler.run_id);
+    cJSON_AddNumberToObject(json, "pid", job->pid);
+    cJSON_AddStringToObject(json, "status", outcome);
+    if (WIFSIGNALED(status)) {
+        cJSON_AddNumberToObject(json, "signal", WTERMSIG(status));
+    } else {
+        cJSON_AddNumberToObject(json, "exit_code", WEXITSTATUS(status));
+    }
+    cJSON_AddNumberToObject(json, "duration_seconds", elapsed_sec(&job->started, &now));
+    cJSON_AddNumberToObject(json, "user_seconds", (double)usage->ru_utime.tv_sec + (double)usage->ru_utime.tv_usec / 1e6);
+    cJSON_AddNumberToObject(json, "system_seconds", (double)usage->ru_stime.tv_sec + (double)usage->ru_stime.tv_usec / 1e6);
+    cJSON_AddNumberToObject(json, "max_memory_rss", (double)max_rss);
+    cJSON_AddNumberToObject(json, "max_cpu_percent", job->sampler.max_cpu);
+    cJSON_AddNumberToObject(json, "peak_open_files", job->sampler.peak_files);
+    cJSON_AddNumberToObject(json, "read_bytes", (double)job->sampler.read_bytes);
+    cJSON_AddNumberToObject(json, "write_bytes", (double)job->sampler.write_bytes);
+    cJSON_AddNumberToObject(json, "samples", job->sampler.samples);
+    sampler_summary_to_json(&job->sampler.summary, json);
+    if (job->overlay) {
+        // One rename; the upper layer is deleted in the background
+        cJSON_AddNumberToObject(json, "overlay_bytes", (double)job->overlay_bytes);
+        overlay_release(&runner->overlay, job->pid);
+    }
+    
+    cJSON *launched = read_status(job);
+    cJSON *placement = cJSON_GetObjectItem(launched, "placement");
+    cJSON *placed_cpus = cJSON_GetObjectItem(placement, "cpus");
+    cJSON *cgroup = cJSON_GetObjectItem(launched, "cgroup");
+    cJSON *cgroup_error = cJSON_GetObjectItem(launched, "cgroup_error");
+    cJSON *cpus = cJSON_AddArrayToObject(json, "cpus");
+    int placed[PLACEMENT_MAX_CPUS];
+    int placed_count = cJSON_IsString(placed_cpus)
+        ? placement_parse_cpus(placed_cpus->valuestring, placed, PLACEMENT_MAX_CPUS) : 0;
+    for (int n = 0; n < placed_count; n++) {
+        cJSON_AddItemToArray(cpus, cJSON_CreateNumber(placed[n]));
+    }
+    if (cJSON_IsString(cgroup_error)) {
+        cJSON_AddStringToObject(json, "cgroup_error", cgroup_error->valuestring);
+    }
+    if (cJSON_IsString(cgroup)) {
+        remove_cgroup(cgroup->valuestring);
+    }
+    cJSON_Delete(launched);
+    
+    write_result(runner, json);
+    cJSON_Delete(json);
+    return outcome;
+}
+
+static BatchJob* find_running(BatchRunner *runner, pid_t pid) {
+    for (int i = 0; i < runner->job_count; i++) {
+        if (runner->jobs[i].state == BATCH_JOB_RUNNING && runner->jobs[i].pid == pid) {
+            return &runner->jobs[i];
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    int ok;
+    int failed;
+    int timeouts;
+    int skipped;
+} BatchTotals;
+
+static void count_outcome(BatchTotals *totals, const char *outcome) {
+    if (strcmp(outcome, "ok") == 0) totals->ok++;
+    else if (strcmp(outcome, "timeout") == 0) totals->timeouts++;
+    else totals->failed++;
+}
+
+// Reap every exited job; with block set, wait for at least one
+static void reap_jobs(BatchRunner *runner, BatchTotals *totals, int block) {
+    int status;
+    struct rusage usage;
+    pid_t pid;
+    while ((pid = wait4(-1, &status, block ? 0 : WNOHANG, &usage)) > 0) {
+        BatchJob *job = find_running(runner, pid);
+        if (job) {
+            count_outcome(totals, finish_job(runner, job, status, &usage));
+        }
+        block = 0;
+    }
+}
+
+// One sweep of the shared sampler over every running job
+static void sample_jobs(BatchRunner *runner) {
+    const char *out = runner->samples_path[0] ? runner->samples_path : NULL;
+    for (int i = 0; i < runner->job_count; i++) {
+        BatchJob *job = &runner->jobs[i];
+        if (job->state != BATCH_JOB_RUNNING) continue;
+        sampler_target_collect(&job->sampler, out);
+        
+        uint64_t bytes;
+        if (job->overlay && overlay_usage(&runner->overlay, job->pid, &bytes) == 0 && bytes > job->overlay_bytes) {
+            job->overlay_bytes = bytes;
+        }
+    }
+}
+
+// Kill jobs past their deadline; returns the earliest remaining deadline
+static struct timespec enforce_timeouts(BatchRunner *runner, const struct timespec *now, struct timespec next) {
+    for (int i = 0; i < runner->job_count; i++) {
+        BatchJob *job = &runner->jobs[i];
+        if (job->state != BATCH_JOB_RUNNING || job->deadline.tv_sec == 0 || job->timed_out) continue;
+        
+        if (!before(now, &job->deadline)) {
+            kill(-job->pid, SIGKILL);
+            job->timed_out = 1;
+        } else if (before(&job->deadline, &next)) {
+            next = job->deadline;
+        }
+    }
+    return next;
+}
+
+int batch_run(BatchRunner *runner, volatile sig_atomic_t *running) {
+    if (runner->workers < 1) runner->workers = 1;
+    
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    int signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    
+    BatchTotals totals = {0};
+    struct timespec batch_start, now;
+    clock_gettime(CLOCK_MONOTONIC, &batch_start);
+    struct timespec next_sample = add_sec(batch_start, runner->sample_interval);
+    
+    while (*running && (runner->next_job < runner->job_count || runner->running > 0)) {
+        while (runner->running < runner->workers && runner->next_job < runner->job_count) {
+            BatchJob *job = &runner->jobs[runner->next_job++];
+            if (start_job(runner, job) != 0) {
+                job->state = BATCH_JOB_DONE;
+                write_skipped(runner, job, "error");
+                totals.failed++;
+            }
+        }
+        
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (!before(&now, &next_sample)) {
+            sample_jobs(runner);
+            next_sample = add_sec(now, runner->sample_interval);
+        }
+        struct timespec wake = enforce_timeouts(runner, &now, next_sample);
+        
+        double wait_ms = elapsed_sec(&now, &wake) * 1000.0;
+        struct pollfd pfd = { .fd = signal_fd, .events = POLLIN, .revents = 0 };
+        if (runner->running > 0 && poll(&pfd, 1, wait_ms > 0 ? (int)wait_ms + 1 : 0) > 0) {
+            struct signalfd_siginfo info;
+            while (read(signal_fd, &info, sizeof(info)) > 0) {
+            }
+        }
+        reap_jobs(runner, &totals, 0);
+    }
+    
+    // Interrupted: stop what is running, report what never ran
+    for (int i = 0; i < runner->job_count; i++) {
+        BatchJob *job = &runner->jobs[i];
+        if (job->state == BATCH_JOB_RUNNING) {
+            kill(-job->pid, SIGKILL);
+        }
+    }
+    while (runner->running > 0) {
+        reap_jobs(runner, &totals, 1);
+    }
+    for (; runner->next_job < runner->job_count; runner->next_job++) {
+        write_skipped(runner, &runner->jobs[runner->next_job], "skipped");
+        totals.skipped++;
+    }
+    
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double duration = elapsed_sec(&batch_start, &now);
+    char timestamp[32];
+    get_iso_timestamp(timestamp, sizeof(timestamp));
+    
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "event", "batch");
+    cJSON_AddStringToObject(json, "timestamp", timestamp);
+    cJSON_AddStringToObject(json, "run_id", runner->run_id);
+    cJSON_AddNumberToObject(json, "jobs", runner->job_count);
+    cJSON_AddNumberToObject(json, "ok", totals.ok);
+    cJSON_AddNumberToObject(json, "failed", totals.failed);
+    cJSON_AddNumberToObject(json, "timeouts", totals.timeouts);
+    cJSON_AddNumberToObject(json, "skipped", totals.skipped);
+    cJSON_AddNumberToObject(json, "workers", runner->workers);
+    cJSON_AddNumberToObject(json, "duration_seconds", duration);
+    cJSON_AddNumberToObject(json, "jobs_per_second", duration > 0 ? (totals.ok + totals.failed + totals.timeouts) / duration : 0);
+    write_result(runner, json);
+    cJSON_Delete(json);
+    
+    if (signal_fd >= 0) close(signal_fd);
+    return totals.failed + totals.timeouts + totals.skipped;
+}
+
+void batch_cleanup(BatchRunner *runner) {
+    for (int i = 0; i < runner->job_count; i++) {
+        free_argv(runner->jobs[i].argv);
+    }
+    free(runner->jobs);
+    runner->jobs = NULL;
+    runner->job_count = 0;
+}
@@ -0,0 +1,85 @@
+#ifndef ZENCUBE_BATCH_H
+#define ZENCUBE_BATCH_H
+
+#include "sampler.h"
+#include "overlay.h"
+#include "placement.h"
+#include <signal.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+typedef enum {
+    BATCH_JOB_PENDING,
+    BATCH_JOB_RUNNING,
+    BATCH_JOB_DONE
+} BatchJobState;
+
+// Per-job limits; 0 = unlimited. Memory and tasks are limited through the
+// job's cgroup, as zencube_launch does.
+typedef struct {
+    double timeout_sec;        // Wall clock, enforced by killing the job's process group
+    long cpu_sec;              // CPU time budget (the launcher's RLIMIT_CPU)
+    long mem_mb;               // memory.max
+    long proc_limit;           // pids.max
+    long file_size_mb;         // RLIMIT_FSIZE (per process; no cgroup equivalent)
+} BatchLimits;
+
+typedef struct {
+    char id[128];
+    char **argv;               // NULL-terminated, owned
+    char jail_dir[4096];       // Empty = no file jail
+    int overlay;               // Discard the job's writes to the jail (overlay_enter)
+    int no_net;
+    int cpus;                  // Physical cores leased (and pinned to) while running
+    BatchLimits limits;
+    
+    BatchJobState state;
+    pid_t pid;
+    int status_fd;             // Read end of the launcher's status pipe (-1 = none)
+    struct timespec started;
+    struct timespec deadline;  // tv_sec == 0: no timeout
+    int timed_out;
+    uint64_t overlay_bytes;    // Peak size of the overlay's upper layer
+    SamplerTarget sampler;
+} BatchJob;
+
+typedef struct {
+    BatchJob *jobs;
+    int job_count;
+    int workers;               // Concurrent jobs
+    int pin;                   // Pin jobs to the CPUs they are placed on
+    double sample_interval;    // Seconds between sweeps of the shared sampler
+    char run_id[128];          // Prefix of every job's sampler run id
+    char results_path[512];    // One summary line per job, then a batch line
+    char samples_path[512];    // Empty = keep samples in memory only
+    char log_dir[512];         // Empty = job output to /dev/null
+    OverlayConfig overlay;     // Upper layers of jobs with "overlay"
+    PlacementRequest placement; // Core leases, shared with every zencube_launch
+    char cgroup_parent[4096];  // Parent of limited jobs' cgroups; empty = <cgroup2>/zencube
+    
+    int cpu_count;             // CPUs in our affinity mask
+    int running;
+    int next_job;
+} BatchRunner;
+
+// Defaults: one worker per available CPU, pinned to leased cores (none
+// reserved), 100 ms sampling
+int batch_init(BatchRunner *runner);
+
+// Load jobs from a manifest:
+//   {"defaults": {...}, "jobs": [{"id": "...", "argv": [...] | "command": "...",
+//     "timeout": s, "cpu_limit": s, "mem_limit": MB, "proc_limit": n,
+//     "file_size_limit": MB, "jail": "dir", "overlay": bool, "no_net": bool,
+//     "cpus": n}, ...]}
+// Keys missing from a job come from "defaults".
+int batch_load_manifest(BatchRunner *runner, const char *path);
+
+// Run every job, at most runner->workers at a time, until all have
+// finished or *running becomes 0 (running jobs are then killed and the
+// rest reported as skipped). Returns the number of jobs that did not
+// exit 0.
+int batch_run(BatchRunner *runner, volatile sig_atomic_t *running);
+
+void batch_cleanup(BatchRunner *runner);
+
+#endif // ZENCUBE_BATCH_H
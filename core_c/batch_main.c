@@ -0,0 +1,110 @@
+#include "batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <signal.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --manifest <jobs.json> --results <results.jsonl> [options]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --manifest PATH    Jobs to run (see core_c/README.md for the format)\n");
+    fprintf(stderr, "  --results PATH     Append one summary line per job and one for the batch\n");
+    fprintf(stderr, "  --jobs N           Concurrent jobs (default: available CPUs)\n");
+    fprintf(stderr, "  --no-pin           Do not lease cores to jobs and pin them there\n");
+    fprintf(stderr, "  --reserve-cores N  Leading cores kept off-limits to jobs (default 0)\n");
+    fprintf(stderr, "  --placement-dir D  Core lease directory (shared with zencube_launch)\n");
+    fprintf(stderr, "  --cgroup-parent D  Parent of the cgroups of jobs with memory or process\n");
+    fprintf(stderr, "                     limits (default <cgroup2>/zencube)\n");
+    fprintf(stderr, "  --samples PATH     Also append every sample as JSONL\n");
+    fprintf(stderr, "  --log-dir DIR      Write each job's output to DIR/<id>.log\n");
+    fprintf(stderr, "  --interval SEC     Sampling interval (default: 0.1)\n");
+    fprintf(stderr, "  --run-id ID        Prefix of per-job run ids (default: batch_<time>)\n");
+    fprintf(stderr, "  --overlay-dir DIR  Upper layers of jobs with \"overlay\" (see zencube_launch)\n");
+    fprintf(stderr, "  --help             Show this help\n");
+}
+
+int main(int argc, char **argv) {
+    char *manifest_path = NULL;
+    char *results_path = NULL;
+    
+    BatchRunner runner;
+    batch_init(&runner);
+    
+    static struct option long_options[] = {
+        {"manifest",    required_argument, 0, 'm'},
+        {"results",     required_argument, 0, 'r'},
+        {"jobs",        required_argument, 0, 'j'},
+        {"no-pin",      no_argument,       0, 'n'},
+        {"reserve-cores", required_argument, 0, 'e'},
+        {"placement-dir", required_argument, 0, 'd'},
+        {"cgroup-parent", required_argument, 0, 'G'},
+        {"samples",     required_argument, 0, 's'},
+        {"log-dir",     required_argument, 0, 'l'},
+        {"interval",    required_argument, 0, 'i'},
+        {"run-id",      required_argument, 0, 'R'},
+        {"overlay-dir", required_argument, 0, 'o'},
+        {"help",        no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while ((opt = getopt_long(argc, argv, "m:r:j:ne:d:G:s:l:i:R:o:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'm': manifest_path = optarg; break;
+            case 'r': results_path = optarg; break;
+            case 'j': runner.workers = atoi(optarg); break;
+            case 'n': runner.pin = 0; break;
+            case 'e': runner.placement.reserve_cores = atoi(optarg); break;
+            case 'd':
+                snprintf(runner.placement.dir, sizeof(runner.placement.dir), "%s", optarg);
+                break;
+            case 'G': snprintf(runner.cgroup_parent, sizeof(runner.cgroup_parent), "%s", optarg); break;
+            case 's': snprintf(runner.samples_path, sizeof(runner.samples_path), "%s", optarg); break;
+            case 'l': snprintf(runner.log_dir, sizeof(runner.log_dir), "%s", optarg); break;
+            case 'i': runner.sample_interval = atof(optarg); break;
+            case 'R': snprintf(runner.run_id, sizeof(runner.run_id), "%s", optarg); break;
+            case 'o':
+                snprintf(runner.overlay.runs_dir, sizeof(runner.overlay.runs_dir), "%s", optarg);
+                break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    if (!manifest_path || !results_path) {
+        fprintf(stderr, "Error: Missing required arguments\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    if (runner.sample_interval <= 0) {
+        runner.sample_interval = 0.1;
+    }
+    snprintf(runner.results_path, sizeof(runner.results_path), "%s", results_path);
+    
+    if (batch_load_manifest(&runner, manifest_path) != 0) {
+        return 1;
+    }
+    
+    printf("Running %d jobs with %d workers on %d CPUs%s\n", runner.job_count, runner.workers,
+           runner.cpu_count, runner.pin ? " (pinned)" : "");
+    fflush(stdout);
+    
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    
+    int unsuccessful = batch_run(&runner, &running);
+    printf("Done: %d of %d jobs did not succeed; results in %s\n", unsuccessful, runner.job_count, results_path);
+    
+    batch_cleanup(&runner);
+    return unsuccessful == 0 ? 0 : 1;
+}
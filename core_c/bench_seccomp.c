@@ -0,0 +1,164 @@
+#include "seccomp_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+// Syscalls the measuring child makes; never denied by generated policies
+static const int CHILD_SYSCALLS[] = {
+    __NR_getppid, __NR_write, __NR_exit, __NR_exit_group, __NR_clock_gettime, -1
+};
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--iterations N]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --iterations N     getppid() calls per case (default: 2000000)\n");
+    fprintf(stderr, "  --help             Show this help\n");
+    fprintf(stderr, "\nMeasures syscall cost without a filter and under tree and linear\n");
+    fprintf(stderr, "filters of increasing size, each in a fresh child process.\n");
+}
+
+static int child_uses(int nr) {
+    for (int i = 0; CHILD_SYSCALLS[i] >= 0; i++) {
+        if (CHILD_SYSCALLS[i] == nr) return 1;
+    }
+    return 0;
+}
+
+// Kernels since 5.11 skip the filter for syscalls it allows by number
+// alone; an argument check on getppid() keeps it evaluated on every call
+static void add_probe(SeccompPolicy *policy) {
+    seccomp_policy_add_arg0(policy, __NR_getppid, seccomp_action_errno(EPERM), 0);
+}
+
+// Deny rule_count syscalls spread over the table, skipping the child's own
+static void build_deny_policy(SeccompPolicy *policy, int rule_count) {
+    seccomp_policy_init(policy, seccomp_action_allow());
+    int stride = rule_count < 440 ? 440 / rule_count : 1;
+    for (int nr = 0, added = 0; added < rule_count; nr += stride) {
+        if (child_uses(nr)) {
+            nr -= stride - 1;
+            continue;
+        }
+        seccomp_policy_add(policy, nr, seccomp_action_errno(EPERM));
+        added++;
+    }
+    add_probe(policy);
+}
+
+static double elapsed_ns(const struct timespec *start, const struct timespec *end) {
+    return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+// ns per getppid() in a child running under program (NULL = no filter)
+static double measure(const SeccompProgram *program, long iterations) {
+    int fds[2];
+    if (pipe(fds) != 0) return -1;
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    
+    if (pid == 0) {
+        close(fds[0]);
+        double ns = -1;
+        if (!program || seccomp_install(program) == 0) {
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (long i = 0; i < iterations; i++) {
+                syscall(SYS_getppid, 0);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            ns = elapsed_ns(&start, &end) / (double)iterations;
+        }
+        ssize_t written = write(fds[1], &ns, sizeof(ns));
+        _exit(written == (ssize_t)sizeof(ns) ? 0 : 1);
+    }
+    
+    close(fds[1]);
+    double ns = -1;
+    if (read(fds[0], &ns, sizeof(ns)) != (ssize_t)sizeof(ns)) ns = -1;
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+    return ns;
+}
+
+static void run_case(const char *name, const SeccompPolicy *policy, SeccompCompileMode mode,
+                     long iterations, double baseline) {
+    SeccompProgram program;
+    if (seccomp_compile(policy, mode, &program) != 0) {
+        printf("%-22s compile failed\n", name);
+        return;
+    }
+    
+    double ns = measure(&program, iterations);
+    if (ns < 0) {
+        printf("%-22s %8s %6zu %6d\n", name, "failed", program.len, program.depth);
+    } else {
+        printf("%-22s %8.1f %6zu %6d %+9.1f\n", name, ns, program.len, program.depth, ns - baseline);
+    }
+    seccomp_program_free(&program);
+}
+
+int main(int argc, char **argv) {
+    long iterations = 2000000;
+    
+    static struct option long_options[] = {
+        {"iterations", required_argument, 0, 'i'},
+        {"help",       no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while ((opt = getopt_long(argc, argv, "i:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'i': iterations = atol(optarg); break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    if (iterations <= 0) {
+        fprintf(stderr, "Error: --iterations must be positive\n");
+        return 1;
+    }
+    
+    double baseline = measure(NULL, iterations);
+    if (baseline < 0) {
+        fprintf(stderr, "Error: baseline measurement failed\n");
+        return 1;
+    }
+    
+    printf("%-22s %8s %6s %6s %9s\n", "case", "ns/call", "insns", "depth", "overhead");
+    printf("%-22s %8.1f %6s %6s %9s\n", "no filter", baseline, "-", "-", "-");
+    
+    SeccompPolicy policy;
+    seccomp_policy_init(&policy, seccomp_action_allow());
+    seccomp_policy_add_network_deny(&policy);
+    add_probe(&policy);
+    run_case("network (tree)", &policy, SECCOMP_COMPILE_TREE, iterations, baseline);
+    seccomp_policy_free(&policy);
+    
+    static const int SIZES[] = { 1, 16, 64, 256 };
+    for (size_t i = 0; i < sizeof(SIZES) / sizeof(SIZES[0]); i++) {
+        char name[64];
+        build_deny_policy(&policy, SIZES[i]);
+        snprintf(name, sizeof(name), "deny %d (tree)", SIZES[i]);
+        run_case(name, &policy, SECCOMP_COMPILE_TREE, iterations, baseline);
+        snprintf(name, sizeof(name), "deny %d (linear)", SIZES[i]);
+        run_case(name, &policy, SECCOMP_COMPILE_LINEAR, iterations, baseline);
+        seccomp_policy_free(&policy);
+    }
+    
+    return 0;
+}
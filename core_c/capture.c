@@ -0,0 +1,328 @@
+#include "capture.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+// Most a single splice or tee moves; also the pipe size asked for
+#define CAPTURE_CHUNK (1 << 20)
+
+// Output a rate-limited command may burst after being idle
+#define CAPTURE_BURST_NS 250000000LL
+
+// The capture process's view of one capture
+typedef struct {
+    int pipe_fd;
+    int log_fd;
+    int ring_fd;               // <log>.tail; -1 without a tail limit
+    int null_fd;               // Sink for discarded output
+    int out_fd;                // Passthrough; -1 = none
+    CaptureHeader *header;
+    CapturePolicy policy;
+    int limited;               // head or tail limit set
+    int64_t next_ns;           // Rate limit: when the next byte is due
+    char ring_path[4096 + 8];
+} Capture;
+
+static double now_epoch(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Publish n more bytes: counters first, then the update count readers poll
+static void publish(Capture *cap, uint64_t bytes, uint64_t passed, uint64_t dropped) {
+    CaptureHeader *header = cap->header;
+    uint64_t total = header->bytes + bytes;
+    if (cap->limited) {
+        uint64_t kept = cap->policy.head_bytes + cap->policy.tail_bytes;
+        __atomic_store_n(&header->elided, total > kept ? total - kept : 0, __ATOMIC_RELAXED);
+        uint64_t log_bytes = total < cap->policy.head_bytes ? total : cap->policy.head_bytes;
+        __atomic_store_n(&header->log_bytes, log_bytes, __ATOMIC_RELAXED);
+    } else {
+        __atomic_store_n(&header->log_bytes, total, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&header->bytes, total, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->passed, header->passed + passed, __ATOMIC_RELAXED);
+    __atomic_store_n(&header->dropped, header->dropped + dropped, __ATOMIC_RELAXED);
+    header->updated = now_epoch();
+    __atomic_add_fetch(&header->updates, 1, __ATOMIC_RELEASE);
+}
+
+// Close every descriptor except the (ascending) keep list
+static void close_others(const int *keep, int count) {
+    unsigned int from = 0;
+    for (int i = 0; i < count; i++) {
+        if (keep[i] < 0) continue;
+        if ((unsigned int)keep[i] > from) syscall(SYS_close_range, from, (unsigned int)keep[i] - 1, 0U);
+        from = (unsigned int)keep[i] + 1;
+    }
+    syscall(SYS_close_range, from, ~0U, 0U);
+}
+
+// Where the byte at stream offset `at` goes, and how many may follow it
+// there: the head of the log, the tail ring, or the null sink
+static int destination(const Capture *cap, uint64_t at, loff_t *offset, size_t *room) {
+    *room = CAPTURE_CHUNK;
+    if (!cap->limited || at < cap->policy.head_bytes) {
+        *offset = (loff_t)at;
+        if (cap->limited && cap->policy.head_bytes - at < *room) *room = cap->policy.head_bytes - at;
+        return cap->log_fd;
+    }
+    if (cap->ring_fd >= 0) {
+        uint64_t pos = (at - cap->policy.head_bytes) % cap->policy.tail_bytes;
+        *offset = (loff_t)pos;
+        if (cap->policy.tail_bytes - pos < *room) *room = cap->policy.tail_bytes - pos;
+        return cap->ring_fd;
+    }
+    *offset = 0;
+    return cap->null_fd;
+}
+
+// Move up to n bytes from the front of the pipe to where the policy puts
+// them; stops early only when the pipe is empty (nonblock) or at EOF
+static ssize_t store(Capture *cap, size_t n, int nonblock) {
+    size_t done = 0;
+    while (done < n) {
+        loff_t offset;
+        size_t room;
+        int fd = destination(cap, cap->header->bytes + done, &offset, &room);
+        size_t want = n - done < room ? n - done : room;
+        unsigned int flags = SPLICE_F_MOVE | (nonblock ? SPLICE_F_NONBLOCK : 0);
+        ssize_t moved = splice(cap->pipe_fd, NULL, fd, fd == cap->null_fd ? NULL : &offset, want, flags);
+        if (moved <= 0) {
+            if (moved < 0 && errno == EINTR) continue;
+            if (done > 0 || moved == 0) break;
+            return -1;
+        }
+        done += (size_t)moved;
+        if ((size_t)moved < want && nonblock) break;
+    }
+    return (ssize_t)done;
+}
+
+// Hold the command to the rate limit: while we sleep, the pipe fills and
+// its writes block
+static void throttle(Capture *cap, size_t moved) {
+    if (cap->policy.rate_bytes == 0) return;
+    
+    int64_t now = now_ns();
+    if (cap->next_ns < now - CAPTURE_BURST_NS) cap->next_ns = now - CAPTURE_BURST_NS;
+    cap->next_ns += (int64_t)((double)moved * 1e9 / (double)cap->policy.rate_bytes);
+    if (cap->next_ns <= now) return;
+    
+    int64_t wait = cap->next_ns - now;
+    struct timespec ts = { .tv_sec = wait / 1000000000LL, .tv_nsec = wait % 1000000000LL };
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {}
+    __atomic_store_n(&cap->header->throttled_ms, cap->header->throttled_ms + (uint64_t)(wait / 1000000),
+                     __ATOMIC_RELAXED);
+}
+
+// Copy len bytes of the ring from pos (wrapping) to the log at *log_off
+static void copy_ring(Capture *cap, uint64_t pos, uint64_t len, loff_t *log_off) {
+    while (len > 0) {
+        loff_t in = (loff_t)pos;
+        uint64_t span = cap->policy.tail_bytes - pos < len ? cap->policy.tail_bytes - pos : len;
+        ssize_t n = copy_file_range(cap->ring_fd, &in, cap->log_fd, log_off, span, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        len -= (uint64_t)n;
+        pos = (pos + (uint64_t)n) % cap->policy.tail_bytes;
+    }
+}
+
+// End of output: append the marker and the tail ring, oldest byte first,
+// so the log reads head, marker, tail
+static void finish_log(Capture *cap) {
+    uint64_t total = cap->header->bytes;
+    uint64_t head = cap->policy.head_bytes;
+    loff_t log_off = (loff_t)(total < head ? total : head);
+    if (total > head) {
+        uint64_t kept = total - head < cap->policy.tail_bytes ? total - head : cap->policy.tail_bytes;
+        uint64_t elided = total - head - kept;
+        if (elided > 0) {
+            char marker[128];
+            int len = snprintf(marker, sizeof(marker),
+                               "\n[zencube: %" PRIu64 " bytes of output elided (offsets %" PRIu64 "-%" PRIu64 ")]\n",
+                               elided, head, head + elided);
+            if (pwrite(cap->log_fd, marker, (size_t)len, log_off) == len) log_off += len;
+        }
+        if (kept > 0) copy_ring(cap, (total - kept - head) % cap->policy.tail_bytes, kept, &log_off);
+    }
+    if (cap->ring_fd >= 0) unlink(cap->ring_path);
+    __atomic_store_n(&cap->header->log_bytes, (uint64_t)log_off, __ATOMIC_RELAXED);
+}
+
+// The capture process: runs until every writer has closed the pipe
+static void capture_loop(Capture *cap) {
+    signal(SIGPIPE, SIG_IGN);
+    for (;;) {
+        struct pollfd pfd = { .fd = cap->pipe_fd, .events = POLLIN };
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        // Duplicate what the passthrough reader has room for, then move
+        // exactly that much so the next tee starts at the right byte
+        ssize_t teed = 0;
+        if (cap->out_fd >= 0) {
+            teed = tee(cap->pipe_fd, cap->out_fd, CAPTURE_CHUNK, SPLICE_F_NONBLOCK);
+            if (teed < 0) {
+                if (errno != EAGAIN && errno != EINTR) {
+                    close(cap->out_fd);
+                    cap->out_fd = -1;
+                }
+                teed = 0;
+            }
+        }
+        
+        ssize_t moved;
+        if (teed > 0) {
+            moved = store(cap, (size_t)teed, 0);
+        } else {
+            moved = store(cap, CAPTURE_CHUNK, 1);
+            if (moved < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        }
+        if (moved <= 0) break;   // EOF, or the log cannot be written
+        
+        uint64_t passed = (uint64_t)(teed < moved ? teed : moved);
+        publish(cap, (uint64_t)moved, passed, cap->out_fd >= 0 ? (uint64_t)moved - passed : 0);
+        throttle(cap, (size_t)moved);
+    }
+    
+    if (cap->limited) finish_log(cap);
+    cap->header->updated = now_epoch();
+    __atomic_store_n(&cap->header->done, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&cap->header->updates, 1, __ATOMIC_RELEASE);
+}
+
+int capture_start(const char *log_path, int passthrough, const CapturePolicy *policy,
+                  CaptureResult *result) {
+    memset(result, 0, sizeof(CaptureResult));
+    snprintf(result->log_path, sizeof(result->log_path), "%s", log_path);
+    snprintf(result->header_path, sizeof(result->header_path), "%s.head", log_path);
+    
+    Capture cap;
+    memset(&cap, 0, sizeof(cap));
+    cap.ring_fd = cap.null_fd = cap.out_fd = -1;
+    if (policy) cap.policy = *policy;
+    result->policy = cap.policy;
+    cap.limited = cap.policy.head_bytes > 0 || cap.policy.tail_bytes > 0;
+    snprintf(cap.ring_path, sizeof(cap.ring_path), "%s.tail", log_path);
+    
+    // The log is written at explicit offsets; the ring is also read back
+    cap.log_fd = open(log_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    int header_fd = open(result->header_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (cap.limited && cap.policy.tail_bytes > 0) {
+        cap.ring_fd = open(cap.ring_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    } else if (cap.limited) {
+        cap.null_fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    }
+    CaptureHeader *header = MAP_FAILED;
+    if (cap.log_fd >= 0 && header_fd >= 0 && (!cap.limited || cap.ring_fd >= 0 || cap.null_fd >= 0) &&
+        ftruncate(header_fd, CAPTURE_HEADER_SIZE) == 0) {
+        header = mmap(NULL, CAPTURE_HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, header_fd, 0);
+    }
+    if (header_fd >= 0) close(header_fd);
+    if (header == MAP_FAILED) {
+        snprintf(result->error, sizeof(result->error), "capture %.200s: %s", log_path, strerror(errno));
+        if (cap.log_fd >= 0) close(cap.log_fd);
+        if (cap.ring_fd >= 0) close(cap.ring_fd);
+        if (cap.null_fd >= 0) close(cap.null_fd);
+        return -1;
+    }
+    memcpy(header->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+    header->started = header->updated = now_epoch();
+    header->head_limit = cap.policy.head_bytes;
+    header->tail_limit = cap.policy.tail_bytes;
+    header->rate_limit = cap.policy.rate_bytes;
+    cap.header = header;
+    
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        snprintf(result->error, sizeof(result->error), "capture pipe: %s", strerror(errno));
+        munmap(header, CAPTURE_HEADER_SIZE);
+        close(cap.log_fd);
+        if (cap.ring_fd >= 0) close(cap.ring_fd);
+        if (cap.null_fd >= 0) close(cap.null_fd);
+        return -1;
+    }
+    fcntl(fds[1], F_SETPIPE_SZ, CAPTURE_CHUNK);   // Fewer wakeups; the default may be all we get
+    cap.pipe_fd = fds[0];
+    
+    // tee() needs a pipe on both ends
+    struct stat st;
+    if (passthrough && fstat(STDOUT_FILENO, &st) == 0 && S_ISFIFO(st.st_mode)) {
+        cap.out_fd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 3);
+    }
+    
+    // Double fork: the capture process must not be a child of the command
+    // we are about to exec, nor end up in its cgroup or jail
+    pid_t child = fork();
+    if (child == 0) {
+        pid_t writer = fork();
+        if (writer > 0) {
+            header->writer_pid = writer;
+            _exit(0);
+        }
+        if (writer == 0) {
+            setsid();
+            close(fds[1]);
+            int keep[5] = { cap.pipe_fd, cap.log_fd, cap.ring_fd, cap.null_fd, cap.out_fd };
+            for (int i = 0; i < 4; i++) {
+                for (int j = i + 1; j < 5; j++) {
+                    if (keep[j] < keep[i]) {
+                        int t = keep[i];
+                        keep[i] = keep[j];
+                        keep[j] = t;
+                    }
+                }
+            }
+            close_others(keep, 5);
+            capture_loop(&cap);
+        }
+        _exit(writer < 0 ? 1 : 0);
+    }
+    
+    int status = 0;
+    if (child > 0) waitpid(child, &status, 0);
+    result->writer_pid = header->writer_pid;
+    munmap(header, CAPTURE_HEADER_SIZE);
+    close(fds[0]);
+    close(cap.log_fd);
+    if (cap.ring_fd >= 0) close(cap.ring_fd);
+    if (cap.null_fd >= 0) close(cap.null_fd);
+    if (cap.out_fd >= 0) close(cap.out_fd);
+    
+    if (child < 0 || status != 0 || result->writer_pid <= 0) {
+        snprintf(result->error, sizeof(result->error), "capture: cannot start writer");
+        close(fds[1]);
+        return -1;
+    }
+    if (dup2(fds[1], STDOUT_FILENO) < 0 || dup2(fds[1], STDERR_FILENO) < 0) {
+        snprintf(result->error, sizeof(result->error), "capture dup2: %s", strerror(errno));
+        close(fds[1]);
+        return -1;
+    }
+    if (fds[1] > STDERR_FILENO) close(fds[1]);
+    return 0;
+}
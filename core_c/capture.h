@@ -0,0 +1,59 @@
+#ifndef ZENCUBE_CAPTURE_H
+#define ZENCUBE_CAPTURE_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define CAPTURE_MAGIC "ZCCAPT1"
+#define CAPTURE_HEADER_SIZE 4096
+
+// Bounds on what a capture keeps. With head_bytes or tail_bytes set, the
+// log holds the first head_bytes and the last tail_bytes of the output with
+// a marker between them; the middle is discarded as it arrives.
+typedef struct {
+    uint64_t head_bytes;
+    uint64_t tail_bytes;       // Kept in <log>.tail, a ring, until the end
+    uint64_t rate_bytes;       // Per second; 0 = unlimited
+} CapturePolicy;
+
+// Shared state of a capture, mapped from <log>.head by the writer and
+// read by anyone (the GUI polls it to know what to pread from the log).
+// Little-endian, 112 bytes used; counters only grow and "updates" is
+// bumped after every change.
+typedef struct {
+    char magic[8];             // CAPTURE_MAGIC
+    uint64_t bytes;            // Bytes the command wrote
+    uint64_t passed;           // Also forwarded to the launcher's stdout
+    uint64_t dropped;          // Not forwarded: that reader was behind
+    uint64_t updates;
+    uint32_t done;             // Every writer closed its end; bytes is final
+    int32_t writer_pid;        // The capture process
+    double started;            // Epoch seconds
+    double updated;
+    uint64_t head_limit;       // CapturePolicy, 0 = none
+    uint64_t tail_limit;
+    uint64_t rate_limit;
+    uint64_t elided;           // Discarded from the middle by the policy
+    uint64_t throttled_ms;     // Time the command was held to rate_limit
+    uint64_t log_bytes;        // Bytes in the log file
+} CaptureHeader;
+
+typedef struct {
+    char log_path[4096];
+    char header_path[4096 + 8];
+    pid_t writer_pid;
+    CapturePolicy policy;
+    char error[256];
+} CaptureResult;
+
+// Send the caller's stdout and stderr (one stream, in write order) to
+// log_path through a pipe that a detached capture process drains with
+// splice(), so the bytes move from pipe to page cache without a
+// user-space copy. With passthrough, data is also tee()d to the original
+// stdout when it is a pipe with room; a slow reader there loses data
+// (counted as dropped) instead of stalling the command. policy may be
+// NULL (keep everything, no rate limit).
+int capture_start(const char *log_path, int passthrough, const CapturePolicy *policy,
+                  CaptureResult *result);
+
+#endif // ZENCUBE_CAPTURE_H
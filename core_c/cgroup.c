@@ -0,0 +1,182 @@
+#include "cgroup.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+static const char *CONTROLLERS[] = { "+cpu", "+cpuset", "+memory", "+pids", "+io", NULL };
+
+// One write() so the kernel sees one command
+int cgroup_write(const char *dir, const char *file, const char *value) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    
+    size_t len = strlen(value);
+    ssize_t written = write(fd, value, len);
+    int saved = errno;
+    close(fd);
+    errno = saved;
+    return written == (ssize_t)len ? 0 : -1;
+}
+
+int cgroup_v2_mount(char *out, size_t size) {
+    FILE *fp = fopen("/proc/self/mountinfo", "r");
+    if (!fp) return -1;
+    
+    // "36 25 0:31 / /sys/fs/cgroup rw,... - cgroup2 cgroup2 rw"
+    char line[1024];
+    int found = -1;
+    while (found != 0 && fgets(line, sizeof(line), fp)) {
+        char *sep = strstr(line, " - cgroup2 ");
+        if (!sep) continue;
+        
+        char mount_point[512];
+        if (sscanf(line, "%*s %*s %*s %*s %511s", mount_point) == 1) {
+            snprintf(out, size, "%s", mount_point);
+            found = 0;
+        }
+    }
+    
+    fclose(fp);
+    return found;
+}
+
+int cgroup_default_parent(char *out, size_t size) {
+    char mount_point[512];
+    if (cgroup_v2_mount(mount_point, sizeof(mount_point)) != 0) return -1;
+    snprintf(out, size, "%s/zencube", mount_point);
+    return 0;
+}
+
+// Enable what we can one controller at a time: a missing one (bound to
+// cgroup v1, or not delegated) must not block the others
+static void enable_controllers(const char *dir) {
+    for (int i = 0; CONTROLLERS[i]; i++) {
+        cgroup_write(dir, "cgroup.subtree_control", CONTROLLERS[i]);
+    }
+}
+
+int cgroup_create(const char *parent, const char *name, char *path, size_t size) {
+    // A parent we create ourselves needs the controllers from its own parent
+    if (mkdir(parent, 0755) == 0) {
+        char above[PATH_MAX];
+        snprintf(above, sizeof(above), "%s", parent);
+        char *slash = strrchr(above, '/');
+        if (slash && slash != above) {
+            *slash = '\0';
+            enable_controllers(above);
+        }
+    } else if (errno != EEXIST) {
+        return -1;
+    }
+    enable_controllers(parent);
+    
+    if ((size_t)snprintf(path, size, "%s/%s", parent, name) >= size) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+int cgroup_block_device(const char *path, char *out, size_t size) {
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+    if (major(st.st_dev) == 0) {
+        errno = ENODEV;   // tmpfs, overlay, ...: no disk to throttle
+        return -1;
+    }
+    
+    unsigned int maj = major(st.st_dev);
+    unsigned int min = minor(st.st_dev);
+    
+    // Partitions resolve to their disk: /sys/dev/block/M:m is a symlink into
+    // .../sda/sda1, whose parent directory holds the disk's "dev"
+    char sys_path[128];
+    snprintf(sys_path, sizeof(sys_path), "/sys/dev/block/%u:%u/partition", maj, min);
+    if (access(sys_path, F_OK) == 0) {
+        char resolved[PATH_MAX];
+        snprintf(sys_path, sizeof(sys_path), "/sys/dev/block/%u:%u/../dev", maj, min);
+        if (realpath(sys_path, resolved)) {
+            FILE *fp = fopen(resolved, "r");
+            if (fp) {
+                if (fscanf(fp, "%u:%u", &maj, &min) != 2) {
+                    maj = major(st.st_dev);
+                    min = minor(st.st_dev);
+                }
+                fclose(fp);
+            }
+        }
+    }
+    
+    snprintf(out, size, "%u:%u", maj, min);
+    return 0;
+}
+
+// Record a failed limit, keeping the first message
+static void note_failure(int *failures, char *error, size_t error_size, const char *file) {
+    if (*failures == 0) {
+        snprintf(error, error_size, "%s: %s", file, strerror(errno));
+    }
+    (*failures)++;
+}
+
+int cgroup_apply_limits(const char *path, const CgroupLimits *limits, const char *workdir,
+                        char *error, size_t error_size) {
+    int failures = 0;
+    char value[128];
+    
+    if (limits->cpu_max_percent > 0) {
+        long period = 100000;
+        long quota = (long)(limits->cpu_max_percent / 100.0 * (double)period);
+        if (quota < 1000) quota = 1000;   // Kernel minimum is 1 ms
+        snprintf(value, sizeof(value), "%ld %ld", quota, period);
+        if (cgroup_write(path, "cpu.max", value) != 0) note_failure(&failures, error, error_size, "cpu.max");
+    }
+    
+    if (limits->memory_max_mb > 0) {
+        // 90% in bytes, not MB: a 1 MB limit must not throttle at 0
+        long high = limits->memory_high_mb > 0 ? limits->memory_high_mb * 1024 * 1024
+                                               : limits->memory_max_mb * 1024 * 1024 / 10 * 9;
+        snprintf(value, sizeof(value), "%ld", high);
+        if (cgroup_write(path, "memory.high", value) != 0) note_failure(&failures, error, error_size, "memory.high");
+        snprintf(value, sizeof(value), "%ld", limits->memory_max_mb * 1024 * 1024);
+        if (cgroup_write(path, "memory.max", value) != 0) note_failure(&failures, error, error_size, "memory.max");
+    } else if (limits->memory_high_mb > 0) {
+        snprintf(value, sizeof(value), "%ld", limits->memory_high_mb * 1024 * 1024);
+        if (cgroup_write(path, "memory.high", value) != 0) note_failure(&failures, error, error_size, "memory.high");
+    }
+    
+    if (limits->pids_max > 0) {
+        snprintf(value, sizeof(value), "%ld", limits->pids_max);
+        if (cgroup_write(path, "pids.max", value) != 0) note_failure(&failures, error, error_size, "pids.max");
+    }
+    
+    if (limits->io_max_bps > 0) {
+        char device[32];
+        if (limits->io_device[0]) {
+            snprintf(device, sizeof(device), "%s", limits->io_device);
+        } else if (cgroup_block_device(workdir ? workdir : ".", device, sizeof(device)) != 0) {
+            note_failure(&failures, error, error_size, "io.max (no block device)");
+            return failures;
+        }
+        snprintf(value, sizeof(value), "%s rbps=%ld wbps=%ld", device, limits->io_max_bps, limits->io_max_bps);
+        if (cgroup_write(path, "io.max", value) != 0) note_failure(&failures, error, error_size, "io.max");
+    }
+    
+    return failures;
+}
+
+int cgroup_join(const char *path, pid_t pid) {
+    char value[32];
+    snprintf(value, sizeof(value), "%d", pid);
+    return cgroup_write(path, "cgroup.procs", value);
+}
@@ -0,0 +1,43 @@
+#ifndef ZENCUBE_CGROUP_H
+#define ZENCUBE_CGROUP_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+// cgroup v2 limits for one run; 0 = leave the kernel default (max)
+typedef struct {
+    double cpu_max_percent;    // Bandwidth, 100 = one full CPU
+    long memory_max_mb;        // Hard limit (OOM kill inside the run)
+    long memory_high_mb;       // Throttle point; 0 = 90% of memory_max_mb
+    long pids_max;             // Tasks in the run (stops fork bombs)
+    long io_max_bps;           // Read and write bytes/s on io_device
+    char io_device[32];        // "MAJ:MIN"; empty = disk backing the working directory
+} CgroupLimits;
+
+// Where cgroup2 is mounted (e.g. /sys/fs/cgroup, /sys/fs/cgroup/unified)
+int cgroup_v2_mount(char *out, size_t size);
+
+// <mount>/zencube, the parent used when none is delegated explicitly
+int cgroup_default_parent(char *out, size_t size);
+
+// Create parent (if missing) and parent/name, enabling the cpu, cpuset,
+// memory, pids and io controllers for parent's children where the kernel allows.
+// The full path of the new cgroup is written to path.
+int cgroup_create(const char *parent, const char *name, char *path, size_t size);
+
+// Write every set limit. Returns the number of limits that could not be
+// applied, naming the first in error.
+int cgroup_apply_limits(const char *path, const CgroupLimits *limits, const char *workdir,
+                        char *error, size_t error_size);
+
+// Write value to the control file path/file
+int cgroup_write(const char *path, const char *file, const char *value);
+
+// Move pid (0 = the caller) into the cgroup
+int cgroup_join(const char *path, pid_t pid);
+
+// "MAJ:MIN" of the whole disk holding path (io.max takes disks, not
+// partitions). Fails for filesystems without a block device.
+int cgroup_block_device(const char *path, char *out, size_t size);
+
+#endif // ZENCUBE_CGROUP_H
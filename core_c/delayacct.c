@@ -0,0 +1,152 @@
+#include "delayacct.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <linux/netlink.h>
+#include <linux/genetlink.h>
+#include <linux/taskstats.h>
+
+#define REPLY_SIZE 8192
+
+// Request: netlink header, generic netlink header, one attribute
+typedef struct {
+    struct nlmsghdr nlh;
+    struct genlmsghdr genl;
+    char attrs[64];
+} GenlRequest;
+
+static int send_request(DelayAcct *acct, uint16_t type, uint8_t cmd, uint8_t version,
+                        uint16_t attr_type, const void *data, uint16_t len) {
+    GenlRequest req;
+    memset(&req, 0, sizeof(req));
+    
+    struct nlattr *attr = (struct nlattr *)req.attrs;
+    attr->nla_type = attr_type;
+    attr->nla_len = (uint16_t)(NLA_HDRLEN + len);
+    memcpy((char *)attr + NLA_HDRLEN, data, len);
+    
+    req.nlh.nlmsg_len = (uint32_t)(NLMSG_LENGTH(GENL_HDRLEN) + NLA_ALIGN(attr->nla_len));
+    req.nlh.nlmsg_type = type;
+    req.nlh.nlmsg_flags = NLM_F_REQUEST;
+    req.nlh.nlmsg_seq = ++acct->seq;
+    req.genl.cmd = cmd;
+    req.genl.version = version;
+    
+    struct sockaddr_nl kernel = { .nl_family = AF_NETLINK };
+    ssize_t n = sendto(acct->fd, &req, req.nlh.nlmsg_len, 0, (struct sockaddr *)&kernel, sizeof(kernel));
+    return n == (ssize_t)req.nlh.nlmsg_len ? 0 : -1;
+}
+
+// Receive the reply to the last request, skipping late replies to earlier
+// ones that timed out. Returns its length, or -1 (errno set on a netlink error).
+static int recv_reply(DelayAcct *acct, char *buf, struct nlmsghdr **msg) {
+    for (;;) {
+        ssize_t n = recv(acct->fd, buf, REPLY_SIZE, 0);
+        if (n < 0) return -1;
+        
+        struct nlmsghdr *nlh = (struct nlmsghdr *)buf;
+        if (!NLMSG_OK(nlh, (size_t)n) || nlh->nlmsg_seq != acct->seq) continue;
+        if (nlh->nlmsg_type == NLMSG_ERROR) {
+            struct nlmsgerr *err = NLMSG_DATA(nlh);
+            errno = err->error ? -err->error : EPROTO;
+            return -1;
+        }
+        *msg = nlh;
+        return (int)nlh->nlmsg_len;
+    }
+}
+
+// First attribute of the given type in [start, end)
+static struct nlattr* find_attr(char *start, char *end, uint16_t type) {
+    while (start + NLA_HDRLEN <= end) {
+        struct nlattr *attr = (struct nlattr *)start;
+        if (attr->nla_len < NLA_HDRLEN || start + attr->nla_len > end) return NULL;
+        if ((attr->nla_type & NLA_TYPE_MASK) == type) return attr;
+        start += NLA_ALIGN(attr->nla_len);
+    }
+    return NULL;
+}
+
+static char* genl_attrs(struct nlmsghdr *nlh) {
+    return (char *)NLMSG_DATA(nlh) + GENL_HDRLEN;
+}
+
+static int read_kernel_enabled(void) {
+    FILE *fp = fopen("/proc/sys/kernel/task_delayacct", "r");
+    if (!fp) return -1;
+    int value = -1;
+    if (fscanf(fp, "%d", &value) != 1) value = -1;
+    fclose(fp);
+    return value;
+}
+
+int delayacct_open(DelayAcct *acct) {
+    memset(acct, 0, sizeof(*acct));
+    acct->fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+    if (acct->fd < 0) return -1;
+    
+    // A lost reply must not stall the sampling loop
+    struct timeval timeout = { .tv_sec = 1 };
+    setsockopt(acct->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    
+    struct sockaddr_nl local = { .nl_family = AF_NETLINK };
+    char buf[REPLY_SIZE];
+    struct nlmsghdr *reply;
+    if (bind(acct->fd, (struct sockaddr *)&local, sizeof(local)) != 0 ||
+        send_request(acct, GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 1, CTRL_ATTR_FAMILY_NAME,
+                     TASKSTATS_GENL_NAME, sizeof(TASKSTATS_GENL_NAME)) != 0 ||
+        recv_reply(acct, buf, &reply) < 0) {
+        delayacct_close(acct);
+        return -1;
+    }
+    
+    struct nlattr *id = find_attr(genl_attrs(reply), (char *)reply + reply->nlmsg_len, CTRL_ATTR_FAMILY_ID);
+    if (!id) {
+        delayacct_close(acct);
+        return -1;
+    }
+    memcpy(&acct->family, (char *)id + NLA_HDRLEN, sizeof(acct->family));
+    acct->kernel_enabled = read_kernel_enabled();
+    return 0;
+}
+
+int delayacct_query(DelayAcct *acct, int tgid, DelayTotals *totals) {
+    if (acct->fd < 0) return -1;
+    
+    uint32_t id = (uint32_t)tgid;
+    char buf[REPLY_SIZE];
+    struct nlmsghdr *reply;
+    if (send_request(acct, acct->family, TASKSTATS_CMD_GET, TASKSTATS_GENL_VERSION,
+                     TASKSTATS_CMD_ATTR_TGID, &id, sizeof(id)) != 0 ||
+        recv_reply(acct, buf, &reply) < 0) {
+        return -1;
+    }
+    
+    // TASKSTATS_TYPE_AGGR_TGID { TASKSTATS_TYPE_PID, TASKSTATS_TYPE_STATS }
+    char *end = (char *)reply + reply->nlmsg_len;
+    struct nlattr *aggr = find_attr(genl_attrs(reply), end, TASKSTATS_TYPE_AGGR_TGID);
+    if (!aggr) return -1;
+    struct nlattr *stats = find_attr((char *)aggr + NLA_HDRLEN, (char *)aggr + aggr->nla_len,
+                                     TASKSTATS_TYPE_STATS);
+    if (!stats) return -1;
+    
+    // Older kernels send a shorter struct; missing fields stay zero
+    struct taskstats ts;
+    memset(&ts, 0, sizeof(ts));
+    size_t len = stats->nla_len - NLA_HDRLEN;
+    memcpy(&ts, (char *)stats + NLA_HDRLEN, len < sizeof(ts) ? len : sizeof(ts));
+    
+    totals->cpu_delay_total = ts.cpu_delay_total;
+    totals->blkio_delay_total = ts.blkio_delay_total;
+    totals->swapin_delay_total = ts.swapin_delay_total;
+    totals->freepages_delay_total = ts.freepages_delay_total;
+    return 0;
+}
+
+void delayacct_close(DelayAcct *acct) {
+    if (acct->fd >= 0) close(acct->fd);
+    acct->fd = -1;
+}
@@ -0,0 +1,32 @@
+#ifndef ZENCUBE_DELAYACCT_H
+#define ZENCUBE_DELAYACCT_H
+
+#include <stdint.h>
+
+// Cumulative time a process waited, in nanoseconds, summed over its threads
+typedef struct {
+    uint64_t cpu_delay_total;       // Runnable but not running
+    uint64_t blkio_delay_total;     // Synchronous block I/O
+    uint64_t swapin_delay_total;    // Swapping pages in
+    uint64_t freepages_delay_total; // Direct memory reclaim
+} DelayTotals;
+
+// A persistent generic netlink socket bound to the TASKSTATS family
+typedef struct {
+    int fd;
+    uint16_t family;
+    uint32_t seq;
+    int kernel_enabled;        // kernel.task_delayacct: 1, 0, or -1 unknown
+} DelayAcct;
+
+// Open the socket and resolve the family. Returns -1 when taskstats is not
+// available (no CONFIG_TASKSTATS, or no CAP_NET_ADMIN for queries).
+int delayacct_open(DelayAcct *acct);
+
+// Query one thread group's delays. Returns -1 if the process is gone or
+// the kernel refused the query.
+int delayacct_query(DelayAcct *acct, int tgid, DelayTotals *totals);
+
+void delayacct_close(DelayAcct *acct);
+
+#endif // ZENCUBE_DELAYACCT_H
@@ -0,0 +1,376 @@
+#include "elfdeps.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <glob.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ELF_MAX_NEEDED 256
+
+// What the loader needs from one object
+typedef struct {
+    int elf_class;             // ELFCLASS32 or ELFCLASS64
+    int machine;
+    char interp[PATH_MAX];     // PT_INTERP; empty for libraries and static binaries
+    const char *needed[ELF_MAX_NEEDED];
+    int needed_count;
+    const char *rpath;         // DT_RPATH (only honoured without DT_RUNPATH)
+    const char *runpath;
+} ElfInfo;
+
+// Program headers of either class
+typedef struct {
+    uint32_t type;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t filesz;
+} Segment;
+
+// Library directories from /etc/ld.so.conf, then the defaults; loaded once
+static char **g_system_dirs;
+static int g_system_dir_count;
+
+static void add_system_dir(const char *dir, int *capacity) {
+    for (int i = 0; i < g_system_dir_count; i++) {
+        if (strcmp(g_system_dirs[i], dir) == 0) return;
+    }
+    if (g_system_dir_count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 16;
+        char **dirs = realloc(g_system_dirs, (size_t)grown * sizeof(char *));
+        if (!dirs) return;
+        g_system_dirs = dirs;
+        *capacity = grown;
+    }
+    char *copy = strdup(dir);
+    if (copy) g_system_dirs[g_system_dir_count++] = copy;
+}
+
+// ld.so.conf: one directory per line, "include <glob>" pulls in more files
+static void read_ld_conf(const char *path, int depth, int *capacity) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    
+    char line[PATH_MAX];
+    while (fgets(line, sizeof(line), fp)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        char *start = line + strspn(line, " \t");
+        start[strcspn(start, " \t\r\n")] = '\0';
+        
+        if (strcmp(start, "include") == 0) {
+            char *pattern = start + strlen(start) + 1;
+            pattern += strspn(pattern, " \t");
+            pattern[strcspn(pattern, " \t\r\n")] = '\0';
+            
+            glob_t matches;
+            if (depth < 8 && glob(pattern, 0, NULL, &matches) == 0) {
+                for (size_t i = 0; i < matches.gl_pathc; i++) {
+                    read_ld_conf(matches.gl_pathv[i], depth + 1, capacity);
+                }
+                globfree(&matches);
+            }
+        } else if (start[0] == '/') {
+            add_system_dir(start, capacity);
+        }
+    }
+    fclose(fp);
+}
+
+static void load_system_dirs(void) {
+    if (g_system_dirs) return;
+    int capacity = 0;
+    read_ld_conf("/etc/ld.so.conf", 0, &capacity);
+    static const char *defaults[] = { "/lib64", "/usr/lib64", "/lib", "/usr/lib", NULL };
+    for (int i = 0; defaults[i]; i++) {
+        add_system_dir(defaults[i], &capacity);
+    }
+}
+
+static uint16_t read_u16(const uint8_t *p) { uint16_t v; memcpy(&v, p, sizeof(v)); return v; }
+static uint32_t read_u32(const uint8_t *p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+static uint64_t read_u64(const uint8_t *p) { uint64_t v; memcpy(&v, p, sizeof(v)); return v; }
+
+// File offset of a virtual address, through the PT_LOAD segments
+static int vaddr_offset(const Segment *segs, int count, uint64_t addr, uint64_t *offset) {
+    for (int i = 0; i < count; i++) {
+        if (segs[i].type == PT_LOAD && addr >= segs[i].vaddr && addr - segs[i].vaddr < segs[i].filesz) {
+            *offset = addr - segs[i].vaddr + segs[i].offset;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Parse an ELF image in memory. The strings in info point into data.
+// Returns 0 for a (little-endian) ELF object, -1 otherwise.
+static int parse_elf(const uint8_t *data, size_t size, ElfInfo *info) {
+    memset(info, 0, sizeof(*info));
+    if (size < EI_NIDENT || memcmp(data, ELFMAG, SELFMAG) != 0 || data[EI_DATA] != ELFDATA2LSB) {
+        return -1;
+    }
+    
+    int is64 = data[EI_CLASS] == ELFCLASS64;
+    size_t ehdr_size = is64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr);
+    if (size < ehdr_size) return -1;
+    info->elf_class = data[EI_CLASS];
+    info->machine = read_u16(data + offsetof(Elf64_Ehdr, e_machine));
+    
+    uint64_t phoff = is64 ? read_u64(data + offsetof(Elf64_Ehdr, e_phoff))
+                          : read_u32(data + offsetof(Elf32_Ehdr, e_phoff));
+    uint16_t phentsize = read_u16(data + (is64 ? offsetof(Elf64_Ehdr, e_phentsize) : offsetof(Elf32_Ehdr, e_phentsize)));
+    uint16_t phnum = read_u16(data + (is64 ? offsetof(Elf64_Ehdr, e_phnum) : offsetof(Elf32_Ehdr, e_phnum)));
+    if (phnum > 512 || phentsize < (is64 ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr)) ||
+        phoff > size || (uint64_t)phnum * phentsize > size - phoff) {
+        return -1;
+    }
+    
+    Segment segs[512];
+    int dynamic = -1;
+    for (int i = 0; i < phnum; i++) {
+        const uint8_t *ph = data + phoff + (uint64_t)i * phentsize;
+        if (is64) {
+            segs[i].type = read_u32(ph + offsetof(Elf64_Phdr, p_type));
+            segs[i].offset = read_u64(ph + offsetof(Elf64_Phdr, p_offset));
+            segs[i].vaddr = read_u64(ph + offsetof(Elf64_Phdr, p_vaddr));
+            segs[i].filesz = read_u64(ph + offsetof(Elf64_Phdr, p_filesz));
+        } else {
+            segs[i].type = read_u32(ph + offsetof(Elf32_Phdr, p_type));
+            segs[i].offset = read_u32(ph + offsetof(Elf32_Phdr, p_offset));
+            segs[i].vaddr = read_u32(ph + offsetof(Elf32_Phdr, p_vaddr));
+            segs[i].filesz = read_u32(ph + offsetof(Elf32_Phdr, p_filesz));
+        }
+        if (segs[i].offset > size || segs[i].filesz > size - segs[i].offset) {
+            segs[i].filesz = 0;   // Truncated: ignore
+        }
+        
+        if (segs[i].type == PT_INTERP && segs[i].filesz > 0 && segs[i].filesz < sizeof(info->interp)) {
+            memcpy(info->interp, data + segs[i].offset, segs[i].filesz);
+            info->interp[segs[i].filesz] = '\0';
+        } else if (segs[i].type == PT_DYNAMIC) {
+            dynamic = i;
+        }
+    }
+    if (dynamic < 0) return 0;   // Static
+    
+    // First pass finds the string table, the second reads the entries
+    size_t entsize = is64 ? sizeof(Elf64_Dyn) : sizeof(Elf32_Dyn);
+    const uint8_t *dyn = data + segs[dynamic].offset;
+    size_t dyn_count = segs[dynamic].filesz / entsize;
+    uint64_t strtab_addr = 0, strsz = 0;
+    for (size_t i = 0; i < dyn_count; i++) {
+        int64_t tag = is64 ? (int64_t)read_u64(dyn + i * entsize) : (int32_t)read_u32(dyn + i * entsize);
+        uint64_t val = is64 ? read_u64(dyn + i * entsize + 8) : read_u32(dyn + i * entsize + 4);
+        if (tag == DT_NULL) break;
+        if (tag == DT_STRTAB) strtab_addr = val;
+        if (tag == DT_STRSZ) strsz = val;
+    }
+    uint64_t strtab;
+    if (strtab_addr == 0 || vaddr_offset(segs, phnum, strtab_addr, &strtab) != 0 || strtab >= size) {
+        return 0;
+    }
+    if (strsz == 0 || strsz > size - strtab) strsz = size - strtab;
+    
+    for (size_t i = 0; i < dyn_count; i++) {
+        int64_t tag = is64 ? (int64_t)read_u64(dyn + i * entsize) : (int32_t)read_u32(dyn + i * entsize);
+        uint64_t val = is64 ? read_u64(dyn + i * entsize + 8) : read_u32(dyn + i * entsize + 4);
+        if (tag == DT_NULL) break;
+        if (val >= strsz || !memchr(data + strtab + val, '\0', strsz - val)) continue;
+        
+        const char *str = (const char *)data + strtab + val;
+        if (tag == DT_NEEDED && info->needed_count < ELF_MAX_NEEDED) {
+            info->needed[info->needed_count++] = str;
+        } else if (tag == DT_RPATH) {
+            info->rpath = str;
+        } else if (tag == DT_RUNPATH) {
+            info->runpath = str;
+        }
+    }
+    return 0;
+}
+
+// Class and machine of a candidate library, without mapping all of it
+static int elf_matches(const char *path, int elf_class, int machine) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    uint8_t header[sizeof(Elf64_Ehdr)];
+    ssize_t n = read(fd, header, sizeof(header));
+    close(fd);
+    return n >= (ssize_t)sizeof(Elf32_Ehdr) && memcmp(header, ELFMAG, SELFMAG) == 0 &&
+           header[EI_CLASS] == elf_class &&
+           read_u16(header + offsetof(Elf64_Ehdr, e_machine)) == machine;
+}
+
+// Look for name in a colon-separated list, expanding $ORIGIN
+static int search_list(const char *list, const char *origin, const char *name,
+                       const ElfInfo *info, char *out) {
+    char buf[4096];
+    snprintf(buf, sizeof(buf), "%s", list);
+    char *save = NULL;
+    for (char *dir = strtok_r(buf, ":", &save); dir; dir = strtok_r(NULL, ":", &save)) {
+        char expanded[PATH_MAX];
+        if (strncmp(dir, "$ORIGIN", 7) == 0) {
+            snprintf(expanded, sizeof(expanded), "%s%s", origin, dir + 7);
+        } else if (strncmp(dir, "${ORIGIN}", 9) == 0) {
+            snprintf(expanded, sizeof(expanded), "%s%s", origin, dir + 9);
+        } else {
+            snprintf(expanded, sizeof(expanded), "%s", dir);
+        }
+        if ((size_t)snprintf(out, PATH_MAX, "%s/%s", expanded, name) < PATH_MAX &&
+            elf_matches(out, info->elf_class, info->machine)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int find_library(const char *name, const ElfInfo *info, const char *origin, char *out) {
+    if (strchr(name, '/')) {
+        snprintf(out, PATH_MAX, "%s", name);
+        return access(out, F_OK);
+    }
+    if (info->rpath && !info->runpath && search_list(info->rpath, origin, name, info, out) == 0) return 0;
+    if (info->runpath && search_list(info->runpath, origin, name, info, out) == 0) return 0;
+    
+    load_system_dirs();
+    for (int i = 0; i < g_system_dir_count; i++) {
+        if ((size_t)snprintf(out, PATH_MAX, "%s/%s", g_system_dirs[i], name) < PATH_MAX &&
+            elf_matches(out, info->elf_class, info->machine)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static char **push_string(char **list, int *count, int *capacity, const char *value) {
+    if (*count == *capacity) {
+        int grown = *capacity ? *capacity * 2 : 32;
+        char **bigger = realloc(list, (size_t)grown * sizeof(char *));
+        if (!bigger) return list;
+        list = bigger;
+        *capacity = grown;
+    }
+    char *copy = strdup(value);
+    if (copy) list[(*count)++] = copy;
+    return list;
+}
+
+static void add_unique(ElfDeps *deps, const char *path) {
+    for (int i = 0; i < deps->count; i++) {
+        if (strcmp(deps->paths[i], path) == 0) return;
+    }
+    deps->paths = push_string(deps->paths, &deps->count, &deps->capacity, path);
+}
+
+static void add_missing(ElfDeps *deps, const char *name) {
+    for (int i = 0; i < deps->missing_count; i++) {
+        if (strcmp(deps->missing[i], name) == 0) return;
+    }
+    deps->missing = push_string(deps->missing, &deps->missing_count, &deps->missing_capacity, name);
+}
+
+// Queue what the object at path needs
+static void scan_object(ElfDeps *deps, const char *path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < 4) {
+        close(fd);
+        return;
+    }
+    size_t size = (size_t)st.st_size;
+    uint8_t *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return;
+    
+    // "#!/bin/sh -e": the interpreter is what actually runs
+    if (data[0] == '#' && data[1] == '!') {
+        char line[PATH_MAX];
+        size_t len = size - 2 < sizeof(line) - 1 ? size - 2 : sizeof(line) - 1;
+        memcpy(line, data + 2, len);
+        line[len] = '\0';
+        char *interp = line + strspn(line, " \t");
+        interp[strcspn(interp, " \t\r\n")] = '\0';
+        if (interp[0] == '/') add_unique(deps, interp);
+        munmap(data, size);
+        return;
+    }
+    
+    ElfInfo info;
+    if (parse_elf(data, size, &info) == 0) {
+        if (info.interp[0]) add_unique(deps, info.interp);
+        
+        char real[PATH_MAX], origin[PATH_MAX];
+        snprintf(origin, sizeof(origin), "%s", realpath(path, real) ? real : path);
+        char *slash = strrchr(origin, '/');
+        if (slash) *slash = '\0';
+        
+        for (int i = 0; i < info.needed_count; i++) {
+            char found[PATH_MAX];
+            if (find_library(info.needed[i], &info, origin, found) == 0) {
+                add_unique(deps, found);
+            } else {
+                add_missing(deps, info.needed[i]);
+            }
+        }
+    }
+    munmap(data, size);
+}
+
+void elfdeps_init(ElfDeps *deps) {
+    memset(deps, 0, sizeof(*deps));
+}
+
+// A bare name is searched in $PATH like execvp does
+static int resolve_program(const char *program, char *out) {
+    if (strchr(program, '/')) {
+        if (program[0] == '/') {
+            snprintf(out, PATH_MAX, "%s", program);
+        } else if (!realpath(program, out)) {
+            return -1;
+        }
+        return access(out, F_OK);
+    }
+    
+    const char *env = getenv("PATH");
+    char path_list[4096];
+    snprintf(path_list, sizeof(path_list), "%s", env && env[0] ? env : "/usr/local/bin:/usr/bin:/bin");
+    char *save = NULL;
+    for (char *dir = strtok_r(path_list, ":", &save); dir; dir = strtok_r(NULL, ":", &save)) {
+        if ((size_t)snprintf(out, PATH_MAX, "%s/%s", dir, program) < PATH_MAX && access(out, X_OK) == 0) {
+            return 0;
+        }
+    }
+    errno = ENOENT;
+    return -1;
+}
+
+int elfdeps_add(ElfDeps *deps, const char *program, char *error, size_t error_size) {
+    char path[PATH_MAX];
+    if (resolve_program(program, path) != 0) {
+        snprintf(error, error_size, "%s: %s", program, strerror(errno));
+        return -1;
+    }
+    
+    // Breadth-first: everything from first on is scanned once, in order
+    int first = deps->count;
+    add_unique(deps, path);
+    if (deps->count == first) return 0;   // Already there (with its dependencies)
+    for (int i = first; i < deps->count; i++) {
+        scan_object(deps, deps->paths[i]);
+    }
+    return 0;
+}
+
+void elfdeps_free(ElfDeps *deps) {
+    for (int i = 0; i < deps->count; i++) free(deps->paths[i]);
+    for (int i = 0; i < deps->missing_count; i++) free(deps->missing[i]);
+    free(deps->paths);
+    free(deps->missing);
+    memset(deps, 0, sizeof(*deps));
+}
@@ -0,0 +1,28 @@
+#ifndef ZENCUBE_ELFDEPS_H
+#define ZENCUBE_ELFDEPS_H
+
+#include <stddef.h>
+
+// Every file the dynamic loader opens to run a set of programs, found by
+// reading PT_INTERP and DT_NEEDED ourselves (no ldd, nothing is executed)
+typedef struct {
+    char **paths;              // Absolute paths as the loader opens them
+    int count;
+    int capacity;
+    char **missing;            // DT_NEEDED names no search directory had
+    int missing_count;
+    int missing_capacity;
+} ElfDeps;
+
+void elfdeps_init(ElfDeps *deps);
+
+// Add program (absolute, or searched in $PATH) and everything it needs:
+// its loader, libraries (DT_RPATH, DT_RUNPATH with $ORIGIN, then
+// /etc/ld.so.conf and the default directories, matching ELF class and
+// machine) and, for #! scripts, the interpreter. Returns -1 if program
+// itself cannot be found or read.
+int elfdeps_add(ElfDeps *deps, const char *program, char *error, size_t error_size);
+
+void elfdeps_free(ElfDeps *deps);
+
+#endif // ZENCUBE_ELFDEPS_H
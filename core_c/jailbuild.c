@@ -0,0 +1,534 @@
+#include "jailbuild.h"
+#include "elfdeps.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <linux/fs.h>
+
+// One file of a template: where it goes and which cached object it is
+typedef struct {
+    char *path;
+    char object[SHA256_HEX_SIZE];
+    char identity[96];         // dev:ino:size:mtime of the source when stored
+    mode_t mode;
+    uint64_t size;
+} TemplateFile;
+
+typedef struct {
+    TemplateFile *files;
+    int count;
+    int missing;
+} Template;
+
+// Per-build link state: a filesystem that refused a reflink or hardlink once is not asked again
+typedef struct {
+    const JailBuildConfig *config;
+    int reflink_failed;
+    int hardlink_failed;
+} Linker;
+
+void jailbuild_config_init(JailBuildConfig *config) {
+    memset(config, 0, sizeof(*config));
+    config->mode = JAIL_LINK_AUTO;
+    config->stub_etc = 1;
+    
+    const char *cache = getenv("XDG_CACHE_HOME");
+    const char *home = getenv("HOME");
+    if (cache && cache[0]) {
+        snprintf(config->cache_dir, sizeof(config->cache_dir), "%s/zencube/jail", cache);
+    } else {
+        snprintf(config->cache_dir, sizeof(config->cache_dir), "%s/.cache/zencube/jail",
+                 home && home[0] ? home : "/tmp");
+    }
+}
+
+static int mkdir_p(const char *path, mode_t mode) {
+    char buf[PATH_MAX];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, mode) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return mkdir(buf, mode) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+static void file_identity(const struct stat *st, char *out, size_t size) {
+    snprintf(out, size, "%lu:%lu:%lld:%lld.%09ld", (unsigned long)st->st_dev, (unsigned long)st->st_ino,
+             (long long)st->st_size, (long long)st->st_mtim.tv_sec, st->st_mtim.tv_nsec);
+}
+
+static void object_path(const JailBuildConfig *config, const char *object, char *out, size_t size) {
+    snprintf(out, size, "%s/objects/%.2s/%s", config->cache_dir, object, object);
+}
+
+// Copy src_fd into dst_fd in the kernel where possible
+static int copy_fd(int src_fd, int dst_fd, uint64_t size) {
+    uint64_t done = 0;
+    loff_t in_off = 0, out_off = 0;
+    while (done < size) {
+        ssize_t n = copy_file_range(src_fd, &in_off, dst_fd, &out_off, size - done, 0);
+        if (n <= 0) break;
+        done += (uint64_t)n;
+    }
+    if (done == size) return 0;
+    
+    // Filesystems without copy_file_range: plain read/write from where it stopped
+    char buf[65536];
+    while (done < size) {
+        ssize_t n = pread(src_fd, buf, sizeof(buf), (off_t)done);
+        if (n <= 0) return -1;
+        if (pwrite(dst_fd, buf, (size_t)n, (off_t)done) != n) return -1;
+        done += (uint64_t)n;
+    }
+    return 0;
+}
+
+static void hash_fd(int fd, char hex[SHA256_HEX_SIZE]) {
+    Sha256 ctx;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_init(&ctx);
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        sha256_update(&ctx, buf, (size_t)n);
+    }
+    sha256_final(&ctx, digest);
+    sha256_digest_hex(digest, hex);
+}
+
+static int same_time(const struct timespec *a, const struct timespec *b) {
+    return a->tv_sec == b->tv_sec && a->tv_nsec == b->tv_nsec;
+}
+
+// Give a private copy its object's mtime, which marks it as untouched
+static void stamp_copy(int fd, const struct stat *object) {
+    struct timespec times[2] = { { .tv_nsec = UTIME_OMIT }, object->st_mtim };
+    futimens(fd, times);
+}
+
+// Whether a jail's private copy still has the object's content. Copies
+// carry the object's mtime, so one whose size and mtime still match is
+// taken as intact without reading it; anything else is hashed. Reading it
+// back is cheaper than writing it again, and a jailed program's changes to
+// its copy do not survive a rebuild unless it also restored the mtime.
+static int holds_object(const char *dest, const TemplateFile *file, const struct stat *object) {
+    int fd = open(dest, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) return 0;
+    struct stat st;
+    char hex[SHA256_HEX_SIZE];
+    int same = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && (uint64_t)st.st_size == file->size &&
+               (st.st_mode & 07777) == file->mode;
+    if (same && !same_time(&st.st_mtim, &object->st_mtim)) {
+        hash_fd(fd, hex);
+        same = strcmp(hex, file->object) == 0;
+        // Copies made before they were stamped: next time, skip the hash
+        if (same) stamp_copy(fd, object);
+    }
+    close(fd);
+    return same;
+}
+
+// Hash path and store it as objects/<sha256> unless it is there already
+static int ingest(const JailBuildConfig *config, const char *path, TemplateFile *file, JailBuildResult *result) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    
+    hash_fd(fd, file->object);
+    file_identity(&st, file->identity, sizeof(file->identity));
+    file->mode = (st.st_mode & 0555) | 0444;   // Objects are never written again
+    file->size = (uint64_t)st.st_size;
+    
+    char object[PATH_MAX];
+    object_path(config, file->object, object, sizeof(object));
+    if (access(object, F_OK) == 0) {
+        close(fd);
+        return 0;
+    }
+    
+    // Write to a temporary name and rename, so a half-written object is never seen
+    char dir[PATH_MAX], tmp[PATH_MAX + 16];
+    snprintf(dir, sizeof(dir), "%s/objects/%.2s", config->cache_dir, file->object);
+    snprintf(tmp, sizeof(tmp), "%s/.tmp.XXXXXX", dir);
+    int out = mkdir_p(dir, 0755) == 0 ? mkstemp(tmp) : -1;
+    if (out < 0) {
+        close(fd);
+        return -1;
+    }
+    int ok = ioctl(out, FICLONE, fd) == 0;
+    if (!ok) {
+        ok = copy_fd(fd, out, file->size) == 0;
+        result->bytes_copied += file->size;
+    }
+    ok = ok && fchmod(out, file->mode) == 0;
+    close(out);
+    close(fd);
+    if (!ok || rename(tmp, object) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    result->objects_added++;
+    return 0;
+}
+
+static void free_template(Template *tmpl) {
+    for (int i = 0; i < tmpl->count; i++) free(tmpl->files[i].path);
+    free(tmpl->files);
+    memset(tmpl, 0, sizeof(*tmpl));
+}
+
+// Load a stored template; it is only valid while every source file is
+// unchanged and every object is still cached
+static int load_template(const JailBuildConfig *config, const char *path, Template *tmpl) {
+    memset(tmpl, 0, sizeof(*tmpl));
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    fseek(fp, 0, SEEK_END);
+    long len = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *text = len > 0 ? malloc((size_t)len + 1) : NULL;
+    if (!text || fread(text, 1, (size_t)len, fp) != (size_t)len) {
+        free(text);
+        fclose(fp);
+        return -1;
+    }
+    fclose(fp);
+    text[len] = '\0';
+    cJSON *json = cJSON_Parse(text);
+    free(text);
+    if (!json) return -1;
+    
+    cJSON *files = cJSON_GetObjectItem(json, "files");
+    int count = cJSON_GetArraySize(files);
+    tmpl->files = calloc((size_t)(count > 0 ? count : 1), sizeof(TemplateFile));
+    tmpl->missing = cJSON_GetArraySize(cJSON_GetObjectItem(json, "missing"));
+    int valid = tmpl->files != NULL && count > 0;
+    
+    cJSON *item;
+    cJSON_ArrayForEach(item, files) {
+        if (!valid) break;
+        cJSON *file_path = cJSON_GetObjectItem(item, "path");
+        cJSON *object = cJSON_GetObjectItem(item, "object");
+        cJSON *identity = cJSON_GetObjectItem(item, "identity");
+        cJSON *mode = cJSON_GetObjectItem(item, "mode");
+        cJSON *size = cJSON_GetObjectItem(item, "size");
+        if (!cJSON_IsString(file_path) || !cJSON_IsString(object) || !cJSON_IsString(identity) ||
+            !cJSON_IsNumber(mode) || !cJSON_IsNumber(size) ||
+            strlen(object->valuestring) != SHA256_HEX_SIZE - 1) {
+            valid = 0;
+            break;
+        }
+        
+        TemplateFile *file = &tmpl->files[tmpl->count++];
+        file->path = strdup(file_path->valuestring);
+        snprintf(file->object, sizeof(file->object), "%s", object->valuestring);
+        snprintf(file->identity, sizeof(file->identity), "%s", identity->valuestring);
+        file->mode = (mode_t)mode->valueint;
+        file->size = (uint64_t)size->valuedouble;
+        
+        struct stat st;
+        char current[96], cached[PATH_MAX];
+        object_path(config, file->object, cached, sizeof(cached));
+        if (!file->path || stat(file->path, &st) != 0 || access(cached, F_OK) != 0) {
+            valid = 0;
+            break;
+        }
+        file_identity(&st, current, sizeof(current));
+        valid = strcmp(current, file->identity) == 0;
+    }
+    cJSON_Delete(json);
+    
+    if (!valid) {
+        free_template(tmpl);
+        return -1;
+    }
+    return 0;
+}
+
+static int save_template(const char *path, const char *const *programs, int program_count,
+                         const Template *tmpl, const ElfDeps *deps) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON *list = cJSON_AddArrayToObject(json, "programs");
+    for (int i = 0; i < program_count; i++) {
+        cJSON_AddItemToArray(list, cJSON_CreateString(programs[i]));
+    }
+    cJSON *files = cJSON_AddArrayToObject(json, "files");
+    for (int i = 0; i < tmpl->count; i++) {
+        const TemplateFile *file = &tmpl->files[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "path", file->path);
+        cJSON_AddStringToObject(item, "object", file->object);
+        cJSON_AddStringToObject(item, "identity", file->identity);
+        cJSON_AddNumberToObject(item, "mode", file->mode);
+        cJSON_AddNumberToObject(item, "size", (double)file->size);
+        cJSON_AddItemToArray(files, item);
+    }
+    cJSON *missing = cJSON_AddArrayToObject(json, "missing");
+    for (int i = 0; i < deps->missing_count; i++) {
+        cJSON_AddItemToArray(missing, cJSON_CreateString(deps->missing[i]));
+    }
+    
+    char *text = cJSON_Print(json);
+    cJSON_Delete(json);
+    if (!text) return -1;
+    
+    char tmp[PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    int ok = fp && fputs(text, fp) >= 0;
+    if (fp && fclose(fp) != 0) ok = 0;
+    free(text);
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// Resolve the programs' dependencies and store every file in the cache
+static int build_template(const JailBuildConfig *config, const char *const *programs, int program_count,
+                          const char *template_path, Template *tmpl, JailBuildResult *result) {
+    ElfDeps deps;
+    elfdeps_init(&deps);
+    for (int i = 0; i < program_count; i++) {
+        if (elfdeps_add(&deps, programs[i], result->error, sizeof(result->error)) != 0) {
+            elfdeps_free(&deps);
+            return -1;
+        }
+    }
+    
+    memset(tmpl, 0, sizeof(*tmpl));
+    tmpl->files = calloc((size_t)deps.count, sizeof(TemplateFile));
+    if (!tmpl->files) {
+        elfdeps_free(&deps);
+        return -1;
+    }
+    for (int i = 0; i < deps.count; i++) {
+        TemplateFile *file = &tmpl->files[tmpl->count];
+        if (ingest(config, deps.paths[i], file, result) != 0) {
+            snprintf(result->error, sizeof(result->error), "%.200s: %s", deps.paths[i], strerror(errno));
+            free_template(tmpl);
+            elfdeps_free(&deps);
+            return -1;
+        }
+        file->path = strdup(deps.paths[i]);
+        tmpl->count++;
+    }
+    tmpl->missing = deps.missing_count;
+    for (int i = 0; i < deps.missing_count; i++) {
+        fprintf(stderr, "jailbuild: warning: %s not found\n", deps.missing[i]);
+    }
+    
+    save_template(template_path, programs, program_count, tmpl, &deps);
+    elfdeps_free(&deps);
+    return 0;
+}
+
+static int link_reflink(const char *object, const char *dest, mode_t mode) {
+    int src = open(object, O_RDONLY | O_CLOEXEC);
+    if (src < 0) return -1;
+    int dst = open(dest, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+    if (dst < 0) {
+        close(src);
+        return -1;
+    }
+    int rc = ioctl(dst, FICLONE, src);
+    int saved = errno;
+    struct stat st;
+    if (rc == 0 && fstat(src, &st) == 0) stamp_copy(dst, &st);
+    close(dst);
+    close(src);
+    if (rc != 0) {
+        unlink(dest);
+        errno = saved;
+    }
+    return rc;
+}
+
+static int link_copy(const char *object, const char *dest, mode_t mode, uint64_t size) {
+    int src = open(object, O_RDONLY | O_CLOEXEC);
+    if (src < 0) return -1;
+    int dst = open(dest, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+    if (dst < 0) {
+        close(src);
+        return -1;
+    }
+    int rc = copy_fd(src, dst, size);
+    struct stat st;
+    if (rc == 0 && fstat(src, &st) == 0) stamp_copy(dst, &st);
+    close(dst);
+    close(src);
+    if (rc != 0) unlink(dest);
+    return rc;
+}
+
+// Recreate the host's directory symlinks on the way to path (usr-merged
+// /bin -> usr/bin, /lib -> usr/lib), so programs keep every name they had
+static void mirror_links(const char *jail_dir, const char *path) {
+    char host[PATH_MAX], jail[PATH_MAX * 2], target[PATH_MAX];
+    snprintf(host, sizeof(host), "%s", path);
+    for (char *p = host + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        struct stat st;
+        snprintf(jail, sizeof(jail), "%s%s", jail_dir, host);
+        if (lstat(jail, &st) != 0 && lstat(host, &st) == 0 && S_ISLNK(st.st_mode)) {
+            ssize_t n = readlink(host, target, sizeof(target) - 1);
+            if (n > 0) {
+                target[n] = '\0';
+                // Create what it points to as well, or nothing can be placed through it
+                char resolved[PATH_MAX * 3];
+                if (target[0] == '/') {
+                    snprintf(resolved, sizeof(resolved), "%s%s", jail_dir, target);
+                } else {
+                    snprintf(resolved, sizeof(resolved), "%.*s/%s", (int)(strrchr(jail, '/') - jail), jail, target);
+                }
+                if (mkdir_p(resolved, 0755) == 0) symlink(target, jail);
+            }
+        }
+        *p = '/';
+    }
+}
+
+// Put one cached object at jail/path
+static int place_file(Linker *linker, const char *jail_dir, const TemplateFile *file, JailBuildResult *result) {
+    char object[PATH_MAX], dest[PATH_MAX * 2], dir[PATH_MAX * 2];
+    object_path(linker->config, file->object, object, sizeof(object));
+    snprintf(dest, sizeof(dest), "%s%s", jail_dir, file->path);
+    snprintf(dir, sizeof(dir), "%s", dest);
+    *strrchr(dir, '/') = '\0';
+    mirror_links(jail_dir, file->path);
+    if (mkdir_p(dir, 0755) != 0) return -1;
+    
+    result->files++;
+    result->bytes += file->size;
+    
+    // A read-only jail (an overlay's lower layer or a read-only bind mount)
+    // can share the object's inode: nothing run in it can write to it.
+    // Writable jails only ever hold private copies.
+    JailLinkMode mode = linker->config->mode;
+    int share = mode == JAIL_LINK_HARDLINK || (mode == JAIL_LINK_AUTO && linker->config->read_only);
+    
+    // Keep a hardlink to the object only when sharing (a writable jail built
+    // by an older version may hold them), and a private copy only while its
+    // content is intact; anything else is replaced
+    struct stat have, want;
+    if (lstat(dest, &have) == 0) {
+        if (stat(object, &want) != 0) return -1;
+        int shared = have.st_dev == want.st_dev && have.st_ino == want.st_ino;
+        if (shared ? share : mode != JAIL_LINK_HARDLINK && holds_object(dest, file, &want)) {
+            result->unchanged++;
+            return 0;
+        }
+        if (unlink(dest) != 0) return -1;
+    }
+    
+    if (share && !linker->hardlink_failed) {
+        if (link(object, dest) == 0) {
+            result->hardlinked++;
+            return 0;
+        }
+        if (mode == JAIL_LINK_HARDLINK) return -1;
+        // The jail is on another filesystem than the cache: copy instead
+        linker->hardlink_failed = 1;
+    }
+    if ((mode == JAIL_LINK_AUTO && !linker->reflink_failed) || mode == JAIL_LINK_REFLINK) {
+        if (link_reflink(object, dest, file->mode) == 0) {
+            result->reflinked++;
+            return 0;
+        }
+        if (mode == JAIL_LINK_REFLINK) return -1;
+        linker->reflink_failed = 1;
+    }
+    if (link_copy(object, dest, file->mode, file->size) != 0) return -1;
+    result->copied++;
+    result->bytes_copied += file->size;
+    return 0;
+}
+
+static void write_stub_etc(const char *jail_dir) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/etc", jail_dir);
+    mkdir_p(path, 0755);
+    snprintf(path, sizeof(path), "%s/etc/passwd", jail_dir);
+    if (access(path, F_OK) == 0) return;
+    
+    FILE *fp = fopen(path, "w");
+    if (!fp) return;
+    fputs("root:x:0:0:root:/root:/bin/sh\n"
+          "nobody:x:65534:65534:nobody:/nonexistent:/usr/sbin/nologin\n", fp);
+    fclose(fp);
+}
+
+int jailbuild_build(const JailBuildConfig *config, const char *jail_dir,
+                    const char *const *programs, int program_count, JailBuildResult *result) {
+    memset(result, 0, sizeof(*result));
+    
+    // The template is named by the program list; its files are checked on use
+    Sha256 ctx;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha256_init(&ctx);
+    for (int i = 0; i < program_count; i++) {
+        sha256_update(&ctx, programs[i], strlen(programs[i]) + 1);
+    }
+    sha256_final(&ctx, digest);
+    sha256_digest_hex(digest, result->template_key);
+    
+    char templates[1024], template_path[PATH_MAX];
+    snprintf(templates, sizeof(templates), "%s/templates", config->cache_dir);
+    snprintf(template_path, sizeof(template_path), "%s/%s.json", templates, result->template_key);
+    if (mkdir_p(templates, 0755) != 0) {
+        snprintf(result->error, sizeof(result->error), "cache %.200s: %s", config->cache_dir, strerror(errno));
+        return -1;
+    }
+    
+    Template tmpl;
+    if (load_template(config, template_path, &tmpl) == 0) {
+        result->template_hit = 1;
+    } else if (build_template(config, programs, program_count, template_path, &tmpl, result) != 0) {
+        return -1;
+    }
+    result->missing = tmpl.missing;
+    
+    char tmp_dir[PATH_MAX];
+    snprintf(tmp_dir, sizeof(tmp_dir), "%s/tmp", jail_dir);
+    if (mkdir_p(tmp_dir, 0755) != 0) {
+        snprintf(result->error, sizeof(result->error), "jail %.200s: %s", jail_dir, strerror(errno));
+        free_template(&tmpl);
+        return -1;
+    }
+    if (config->stub_etc) {
+        write_stub_etc(jail_dir);
+    }
+    
+    // Top-level links such as /bin -> usr/bin exist whichever name a program was found by
+    static const char *const top_links[] = { "/bin/", "/sbin/", "/lib/", "/lib64/" };
+    for (size_t i = 0; i < sizeof(top_links) / sizeof(top_links[0]); i++) {
+        mirror_links(jail_dir, top_links[i]);
+    }
+    
+    Linker linker = { .config = config };
+    for (int i = 0; i < tmpl.count; i++) {
+        if (place_file(&linker, jail_dir, &tmpl.files[i], result) != 0) {
+            snprintf(result->error, sizeof(result->error), "%.200s: %s", tmpl.files[i].path, strerror(errno));
+            free_template(&tmpl);
+            return -1;
+        }
+    }
+    free_template(&tmpl);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef ZENCUBE_JAILBUILD_H
+#define ZENCUBE_JAILBUILD_H
+
+#include <stdint.h>
+#include "sha256.h"
+
+// How cached objects are put into a jail
+typedef enum {
+    JAIL_LINK_AUTO,            // Hardlink if the jail is read-only, else reflink, else copy
+    JAIL_LINK_REFLINK,         // FICLONE: copy-on-write, private to the jail
+    JAIL_LINK_HARDLINK,        // Shares the cached inode: only for jails mounted
+                               // read-only, since the owner of a writable jail can
+                               // chmod and rewrite the object for every other jail
+    JAIL_LINK_COPY
+} JailLinkMode;
+
+typedef struct {
+    char cache_dir[512];       // objects/<sha256>, templates/<key>.json
+    JailLinkMode mode;
+    int read_only;             // Jail is only mounted read-only or as an overlay's lower layer
+    int stub_etc;              // Write etc/passwd like build_jail_dev.sh
+} JailBuildConfig;
+
+typedef struct {
+    int files;                 // Files in the jail
+    int missing;               // Libraries that could not be resolved
+    uint64_t bytes;            // Their total size
+    uint64_t bytes_copied;     // Bytes actually written (copies, new objects)
+    int reflinked;
+    int hardlinked;
+    int copied;
+    int unchanged;             // Already linked to the right object
+    int objects_added;         // New objects stored in the cache
+    int template_hit;          // Dependencies came from a cached template
+    char template_key[SHA256_HEX_SIZE];
+    char error[256];
+} JailBuildResult;
+
+// Defaults: $XDG_CACHE_HOME/zencube/jail (or ~/.cache/...), auto mode
+void jailbuild_config_init(JailBuildConfig *config);
+
+// Populate jail_dir with programs and everything they need at the same
+// absolute paths, from the cache. The first build of a set of programs
+// resolves their ELF dependencies and stores a template; later builds only
+// stat the sources to validate it and link the cached objects.
+int jailbuild_build(const JailBuildConfig *config, const char *jail_dir,
+                    const char *const *programs, int program_count, JailBuildResult *result);
+
+#endif // ZENCUBE_JAILBUILD_H
@@ -0,0 +1,91 @@
+#include "jailbuild.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --jail <dir> [options] <program>...\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --jail DIR         Jail root to populate (created if missing)\n");
+    fprintf(stderr, "  --cache DIR        Object and template cache (default: ~/.cache/zencube/jail)\n");
+    fprintf(stderr, "  --mode MODE        auto, reflink, hardlink or copy (default: auto)\n");
+    fprintf(stderr, "  --read-only        Jail is only mounted read-only or as an overlay's lower\n");
+    fprintf(stderr, "                     layer: auto mode hardlinks cached objects\n");
+    fprintf(stderr, "  --no-stub-etc      Do not write etc/passwd\n");
+    fprintf(stderr, "  --help             Show this help\n");
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+int main(int argc, char **argv) {
+    char *jail_dir = NULL;
+    
+    JailBuildConfig config;
+    jailbuild_config_init(&config);
+    
+    static struct option long_options[] = {
+        {"jail",        required_argument, 0, 'j'},
+        {"cache",       required_argument, 0, 'c'},
+        {"mode",        required_argument, 0, 'm'},
+        {"read-only",   no_argument,       0, 'r'},
+        {"no-stub-etc", no_argument,       0, 'E'},
+        {"help",        no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while ((opt = getopt_long(argc, argv, "j:c:m:rEh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'j': jail_dir = optarg; break;
+            case 'c': snprintf(config.cache_dir, sizeof(config.cache_dir), "%s", optarg); break;
+            case 'm':
+                if (strcmp(optarg, "auto") == 0) config.mode = JAIL_LINK_AUTO;
+                else if (strcmp(optarg, "reflink") == 0) config.mode = JAIL_LINK_REFLINK;
+                else if (strcmp(optarg, "hardlink") == 0) config.mode = JAIL_LINK_HARDLINK;
+                else if (strcmp(optarg, "copy") == 0) config.mode = JAIL_LINK_COPY;
+                else {
+                    fprintf(stderr, "Error: Unknown mode '%s'\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'r': config.read_only = 1; break;
+            case 'E': config.stub_etc = 0; break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    if (!jail_dir || optind >= argc) {
+        fprintf(stderr, "Error: Missing required arguments\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    
+    // Paths inside the jail are appended to it, so drop a trailing slash
+    size_t len = strlen(jail_dir);
+    while (len > 1 && jail_dir[len - 1] == '/') jail_dir[--len] = '\0';
+    
+    double start = now_ms();
+    JailBuildResult result;
+    if (jailbuild_build(&config, jail_dir, (const char *const *)&argv[optind], argc - optind, &result) != 0) {
+        fprintf(stderr, "Error: %s\n", result.error);
+        return 1;
+    }
+    
+    printf("{\"jail\":\"%s\",\"template\":\"%s\",\"template_hit\":%s,\"files\":%d,\"missing\":%d,"
+           "\"bytes\":%llu,\"bytes_copied\":%llu,\"reflinked\":%d,\"hardlinked\":%d,\"copied\":%d,"
+           "\"unchanged\":%d,\"objects_added\":%d,\"elapsed_ms\":%.3f}\n",
+           jail_dir, result.template_key, result.template_hit ? "true" : "false", result.files,
+           result.missing, (unsigned long long)result.bytes, (unsigned long long)result.bytes_copied,
+           result.reflinked, result.hardlinked, result.copied, result.unchanged, result.objects_added,
+           now_ms() - start);
+    return 0;
+}
@@ -0,0 +1,603 @@
+#include "jailusage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/sysmacros.h>
+
+#define WATCH_MASK (IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | \
+                    IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK)
+#define STAT_MASK (STATX_TYPE | STATX_INO | STATX_BLOCKS | STATX_MNT_ID)
+#define MAX_SCAN_THREADS 8
+
+// Record returned by getdents64
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// An inode seen by a scan worker, merged into the table after the scan
+typedef struct {
+    uint64_t ino;
+    uint64_t bytes;
+} InodeRef;
+
+// Directories waiting to be scanned; workers add the subdirectories they find
+typedef struct {
+    JailUsage *usage;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int *pending;
+    int count;
+    int capacity;
+    int busy;                  // Workers inside scan_dir
+} ScanQueue;
+
+typedef struct {
+    ScanQueue *queue;
+    InodeRef *refs;
+    size_t count;
+    size_t capacity;
+} ScanWorker;
+
+typedef struct {
+    int dir;
+    char *name;
+} DirtyName;
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static uint64_t hash_name(const char *name) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static size_t hash_ino(uint64_t ino) {
+    return (size_t)((ino * 0x9E3779B97F4A7C15ULL) >> 17);
+}
+
+// ---- Names of one directory ----
+
+static long dir_find(const JailUsageDir *dir, const char *name) {
+    if (dir->capacity == 0) return -1;
+    size_t mask = dir->capacity - 1;
+    for (size_t i = hash_name(name) & mask; dir->entries[i].name; i = (i + 1) & mask) {
+        if (strcmp(dir->entries[i].name, name) == 0) return (long)i;
+    }
+    return -1;
+}
+
+static int dir_insert(JailUsageDir *dir, char *name, uint64_t ino, int child) {
+    if ((dir->count + 1) * 10 > dir->capacity * 7) {
+        size_t capacity = dir->capacity ? dir->capacity * 2 : 16;
+        JailUsageEntry *entries = calloc(capacity, sizeof(JailUsageEntry));
+        if (!entries) return -1;
+        for (size_t i = 0; i < dir->capacity; i++) {
+            if (!dir->entries[i].name) continue;
+            size_t j = hash_name(dir->entries[i].name) & (capacity - 1);
+            while (entries[j].name) j = (j + 1) & (capacity - 1);
+            entries[j] = dir->entries[i];
+        }
+        free(dir->entries);
+        dir->entries = entries;
+        dir->capacity = capacity;
+    }
+    size_t mask = dir->capacity - 1;
+    size_t i = hash_name(name) & mask;
+    while (dir->entries[i].name) i = (i + 1) & mask;
+    dir->entries[i] = (JailUsageEntry){ .name = name, .ino = ino, .child = child };
+    dir->count++;
+    return 0;
+}
+
+// Linear probing delete: pull later entries of the cluster back into the hole
+static void dir_remove(JailUsageDir *dir, size_t hole) {
+    size_t mask = dir->capacity - 1;
+    dir->entries[hole].name = NULL;
+    dir->count--;
+    for (size_t i = (hole + 1) & mask; dir->entries[i].name; i = (i + 1) & mask) {
+        size_t home = hash_name(dir->entries[i].name) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            dir->entries[hole] = dir->entries[i];
+            dir->entries[i].name = NULL;
+            hole = i;
+        }
+    }
+}
+
+// ---- Inodes ----
+
+static long inode_find(const JailUsage *usage, uint64_t ino) {
+    if (usage->inode_capacity == 0) return -1;
+    size_t mask = usage->inode_capacity - 1;
+    for (size_t i = hash_ino(ino) & mask; usage->inodes[i].ino; i = (i + 1) & mask) {
+        if (usage->inodes[i].ino == ino) return (long)i;
+    }
+    return -1;
+}
+
+static int inode_ref(JailUsage *usage, uint64_t ino, uint64_t bytes) {
+    long found = inode_find(usage, ino);
+    if (found >= 0) {
+        JailUsageInode *inode = &usage->inodes[found];
+        usage->bytes += bytes - inode->bytes;
+        inode->bytes = bytes;
+        inode->links++;
+        return 0;
+    }
+    
+    if ((usage->inode_count + 1) * 10 > usage->inode_capacity * 7) {
+        size_t capacity = usage->inode_capacity ? usage->inode_capacity * 2 : 1024;
+        JailUsageInode *inodes = calloc(capacity, sizeof(JailUsageInode));
+        if (!inodes) return -1;
+        for (size_t i = 0; i < usage->inode_capacity; i++) {
+            if (!usage->inodes[i].ino) continue;
+            size_t j = hash_ino(usage->inodes[i].ino) & (capacity - 1);
+            while (inodes[j].ino) j = (j + 1) & (capacity - 1);
+            inodes[j] = usage->inodes[i];
+        }
+        free(usage->inodes);
+        usage->inodes = inodes;
+        usage->inode_capacity = capacity;
+    }
+    size_t mask = usage->inode_capacity - 1;
+    size_t i = hash_ino(ino) & mask;
+    while (usage->inodes[i].ino) i = (i + 1) & mask;
+    usage->inodes[i] = (JailUsageInode){ .ino = ino, .bytes = bytes, .links = 1 };
+    usage->inode_count++;
+    usage->bytes += bytes;
+    usage->files++;
+    return 0;
+}
+
+static void inode_unref(JailUsage *usage, uint64_t ino) {
+    long found = inode_find(usage, ino);
+    if (found < 0 || --usage->inodes[found].links > 0) return;
+    
+    usage->bytes -= usage->inodes[found].bytes;
+    usage->files--;
+    usage->inode_count--;
+    size_t mask = usage->inode_capacity - 1;
+    size_t hole = (size_t)found;
+    usage->inodes[hole].ino = 0;
+    for (size_t i = (hole + 1) & mask; usage->inodes[i].ino; i = (i + 1) & mask) {
+        size_t home = hash_ino(usage->inodes[i].ino) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            usage->inodes[hole] = usage->inodes[i];
+            usage->inodes[i].ino = 0;
+            hole = i;
+        }
+    }
+}
+
+static void inode_update(JailUsage *usage, uint64_t ino, uint64_t bytes) {
+    long found = inode_find(usage, ino);
+    if (found < 0) return;
+    usage->bytes += bytes - usage->inodes[found].bytes;
+    usage->inodes[found].bytes = bytes;
+}
+
+// ---- Directories ----
+
+// Caller holds the scan lock when workers are running
+static int new_dir(JailUsage *usage, char *path) {
+    JailUsageDir *dir = calloc(1, sizeof(JailUsageDir));
+    if (!dir) return -1;
+    dir->wd = -1;
+    dir->path = path;
+    
+    if (usage->free_count > 0) {
+        int index = usage->free_dirs[--usage->free_count];
+        usage->dirs[index] = dir;
+        return index;
+    }
+    if (usage->dir_count == usage->dir_capacity) {
+        int capacity = usage->dir_capacity ? usage->dir_capacity * 2 : 256;
+        JailUsageDir **dirs = realloc(usage->dirs, sizeof(JailUsageDir *) * (size_t)capacity);
+        int *free_dirs = realloc(usage->free_dirs, sizeof(int) * (size_t)capacity);
+        if (dirs) usage->dirs = dirs;
+        if (free_dirs) usage->free_dirs = free_dirs;
+        if (!dirs || !free_dirs) {
+            free(dir);
+            return -1;
+        }
+        usage->dir_capacity = capacity;
+    }
+    usage->dirs[usage->dir_count] = dir;
+    return usage->dir_count++;
+}
+
+static void map_watch(JailUsage *usage, int wd, int index) {
+    if (wd >= usage->wd_capacity) {
+        int capacity = usage->wd_capacity ? usage->wd_capacity : 256;
+        while (capacity <= wd) capacity *= 2;
+        int *grown = realloc(usage->wd_dirs, sizeof(int) * (size_t)capacity);
+        if (!grown) return;
+        for (int i = usage->wd_capacity; i < capacity; i++) grown[i] = -1;
+        usage->wd_dirs = grown;
+        usage->wd_capacity = capacity;
+    }
+    usage->wd_dirs[wd] = index;
+}
+
+// Forget a directory and everything beneath it
+static void drop_dir(JailUsage *usage, int index) {
+    JailUsageDir *dir = usage->dirs[index];
+    if (!dir) return;
+    usage->dirs[index] = NULL;
+    
+    for (size_t i = 0; i < dir->capacity; i++) {
+        JailUsageEntry *entry = &dir->entries[i];
+        if (!entry->name) continue;
+        inode_unref(usage, entry->ino);
+        if (entry->child >= 0) drop_dir(usage, entry->child);
+        free(entry->name);
+    }
+    // A directory moved within the jail keeps its watch, which its new
+    // name may have picked up already
+    if (dir->wd >= 0 && dir->wd < usage->wd_capacity && usage->wd_dirs[dir->wd] == index) {
+        inotify_rm_watch(usage->inotify_fd, dir->wd);   // Already gone if the directory was deleted
+        usage->wd_dirs[dir->wd] = -1;
+    }
+    free(dir->entries);
+    free(dir->path);
+    free(dir);
+    usage->free_dirs[usage->free_count++] = index;
+}
+
+// Same filesystem and, where the kernel says (5.8+), same mount as the root
+static int same_mount(const JailUsage *usage, const struct statx *stx) {
+    if (makedev(stx->stx_dev_major, stx->stx_dev_minor) != usage->dev) return 0;
+    return !(stx->stx_mask & STATX_MNT_ID) || !usage->mnt_id || stx->stx_mnt_id == usage->mnt_id;
+}
+
+static char* join_path(const char *dir, const char *name) {
+    size_t dir_len = strlen(dir);
+    size_t name_len = strlen(name);
+    char *path = malloc(dir_len + name_len + 2);
+    if (!path) return NULL;
+    memcpy(path, dir, dir_len);
+    path[dir_len] = '/';
+    memcpy(path + dir_len + 1, name, name_len + 1);
+    return path;
+}
+
+// ---- Scanning ----
+
+static void add_ref(ScanWorker *worker, uint64_t ino, uint64_t bytes) {
+    if (worker->count == worker->capacity) {
+        size_t capacity = worker->capacity ? worker->capacity * 2 : 4096;
+        InodeRef *grown = realloc(worker->refs, sizeof(InodeRef) * capacity);
+        if (!grown) return;
+        worker->refs = grown;
+        worker->capacity = capacity;
+    }
+    worker->refs[worker->count++] = (InodeRef){ ino, bytes };
+}
+
+// Queue a subdirectory; caller holds the lock
+static int queue_dir(ScanQueue *queue, char *path) {
+    if (queue->count == queue->capacity) {
+        int capacity = queue->capacity ? queue->capacity * 2 : 256;
+        int *grown = realloc(queue->pending, sizeof(int) * (size_t)capacity);
+        if (!grown) return -1;
+        queue->pending = grown;
+        queue->capacity = capacity;
+    }
+    int index = new_dir(queue->usage, path);
+    if (index < 0) return -1;
+    queue->pending[queue->count++] = index;
+    pthread_cond_signal(&queue->cond);
+    return index;
+}
+
+// Watch a directory, then list it: anything created after the watch is
+// also reported as an event, so nothing falls between the two
+static void scan_dir(ScanWorker *worker, JailUsageDir *dir, int index) {
+    ScanQueue *queue = worker->queue;
+    JailUsage *usage = queue->usage;
+    
+    int wd = inotify_add_watch(usage->inotify_fd, dir->path, WATCH_MASK);
+    int fd = open(dir->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    pthread_mutex_lock(&queue->lock);
+    dir->wd = wd;
+    if (wd >= 0) map_watch(usage, wd, index);
+    pthread_mutex_unlock(&queue->lock);
+    if (fd < 0) return;
+    
+    char buf[32768] __attribute__((aligned(8)));
+    long n;
+    while ((n = syscall(SYS_getdents64, fd, buf, sizeof(buf))) > 0) {
+        for (long off = 0; off < n;) {
+            struct linux_dirent64 *d = (struct linux_dirent64 *)(buf + off);
+            off += d->d_reclen;
+            const char *name = d->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            
+            struct statx stx;
+            if (statx(fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STAT_MASK, &stx) != 0 ||
+                !same_mount(usage, &stx)) {
+                continue;   // Gone already, or a mount point
+            }
+            char *copy = strdup(name);
+            if (!copy) continue;
+            
+            int child = -1;
+            if (S_ISDIR(stx.stx_mode)) {
+                char *path = join_path(dir->path, name);
+                pthread_mutex_lock(&queue->lock);
+                child = path ? queue_dir(queue, path) : -1;
+                pthread_mutex_unlock(&queue->lock);
+                if (child < 0) free(path);
+            }
+            if (dir_insert(dir, copy, stx.stx_ino, child) != 0) {
+                free(copy);
+                continue;
+            }
+            add_ref(worker, stx.stx_ino, stx.stx_blocks * 512);
+        }
+    }
+    close(fd);
+}
+
+static void* scan_worker(void *arg) {
+    ScanWorker *worker = arg;
+    ScanQueue *queue = worker->queue;
+    
+    pthread_mutex_lock(&queue->lock);
+    for (;;) {
+        while (queue->count == 0 && queue->busy > 0) {
+            pthread_cond_wait(&queue->cond, &queue->lock);
+        }
+        if (queue->count == 0) break;   // Nothing left and nobody can add more
+        
+        int index = queue->pending[--queue->count];
+        JailUsageDir *dir = queue->usage->dirs[index];
+        queue->busy++;
+        pthread_mutex_unlock(&queue->lock);
+        scan_dir(worker, dir, index);
+        pthread_mutex_lock(&queue->lock);
+        queue->busy--;
+    }
+    pthread_cond_broadcast(&queue->cond);
+    pthread_mutex_unlock(&queue->lock);
+    return NULL;
+}
+
+// Scan the tree below directory `first` with up to `threads` workers, then
+// count the inodes they found
+static void scan_tree(JailUsage *usage, int first, int threads) {
+    ScanQueue queue = { .usage = usage };
+    pthread_mutex_init(&queue.lock, NULL);
+    pthread_cond_init(&queue.cond, NULL);
+    queue.pending = malloc(sizeof(int) * 256);
+    queue.capacity = queue.pending ? 256 : 0;
+    if (queue.pending) queue.pending[queue.count++] = first;
+    
+    if (threads < 1) threads = 1;
+    ScanWorker *workers = calloc((size_t)threads, sizeof(ScanWorker));
+    pthread_t *tids = calloc((size_t)threads, sizeof(pthread_t));
+    int started = 0;
+    if (workers && tids) {
+        for (int i = 0; i < threads; i++) workers[i].queue = &queue;
+        for (int i = 1; i < threads; i++) {
+            if (pthread_create(&tids[i], NULL, scan_worker, &workers[i]) != 0) break;
+            started = i;
+        }
+        scan_worker(&workers[0]);
+        for (int i = 1; i <= started; i++) pthread_join(tids[i], NULL);
+        
+        for (int i = 0; i < threads; i++) {
+            for (size_t j = 0; j < workers[i].count; j++) {
+                inode_ref(usage, workers[i].refs[j].ino, workers[i].refs[j].bytes);
+            }
+            free(workers[i].refs);
+        }
+    }
+    free(workers);
+    free(tids);
+    free(queue.pending);
+    pthread_mutex_destroy(&queue.lock);
+    pthread_cond_destroy(&queue.cond);
+}
+
+// Bring one name of a directory in line with the filesystem
+static void reconcile(JailUsage *usage, int index, const char *name) {
+    JailUsageDir *dir = usage->dirs[index];
+    if (!dir) return;
+    char *path = join_path(dir->path, name);
+    if (!path) return;
+    usage->restats++;
+    
+    struct statx stx;
+    int exists = statx(AT_FDCWD, path, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, STAT_MASK, &stx) == 0 &&
+                 same_mount(usage, &stx);
+    long slot = dir_find(dir, name);
+    if (slot >= 0 && exists && dir->entries[slot].ino == stx.stx_ino) {
+        inode_update(usage, stx.stx_ino, stx.stx_blocks * 512);   // Written or truncated
+        free(path);
+        return;
+    }
+    if (slot >= 0) {
+        // Deleted, moved away or replaced
+        JailUsageEntry entry = dir->entries[slot];
+        dir_remove(dir, (size_t)slot);
+        inode_unref(usage, entry.ino);
+        if (entry.child >= 0) drop_dir(usage, entry.child);
+        free(entry.name);
+    }
+    if (!exists) {
+        free(path);
+        return;
+    }
+    
+    char *copy = strdup(name);
+    int child = -1;
+    if (copy && S_ISDIR(stx.stx_mode)) {
+        child = new_dir(usage, path);
+        path = NULL;
+    }
+    if (!copy || dir_insert(usage->dirs[index], copy, stx.stx_ino, child) != 0) {
+        free(copy);
+        if (child >= 0) drop_dir(usage, child);
+        free(path);
+        return;
+    }
+    inode_ref(usage, stx.stx_ino, stx.stx_blocks * 512);
+    if (child >= 0) scan_tree(usage, child, 1);   // Created or moved in
+    free(path);
+}
+
+// ---- Public API ----
+
+int jailusage_init(JailUsage *usage, const char *jail_dir, int threads) {
+    memset(usage, 0, sizeof(JailUsage));
+    usage->inotify_fd = -1;
+    if (!realpath(jail_dir, usage->root)) return -1;
+    
+    struct statx stx;
+    if (statx(AT_FDCWD, usage->root, AT_NO_AUTOMOUNT, STAT_MASK, &stx) != 0 || !S_ISDIR(stx.stx_mode)) {
+        if (errno == 0) errno = ENOTDIR;
+        return -1;
+    }
+    usage->dev = makedev(stx.stx_dev_major, stx.stx_dev_minor);
+    usage->mnt_id = stx.stx_mask & STATX_MNT_ID ? stx.stx_mnt_id : 0;
+    usage->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (usage->inotify_fd < 0) return -1;
+    
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = cpus < 1 ? 1 : cpus > MAX_SCAN_THREADS ? MAX_SCAN_THREADS : (int)cpus;
+    }
+    usage->threads = threads;
+    
+    char *path = strdup(usage->root);
+    int root = path ? new_dir(usage, path) : -1;
+    if (root < 0) {
+        free(path);
+        jailusage_cleanup(usage);
+        return -1;
+    }
+    inode_ref(usage, stx.stx_ino, stx.stx_blocks * 512);
+    
+    double start = monotonic_ms();
+    scan_tree(usage, root, threads);
+    usage->scan_ms = monotonic_ms() - start;
+    return 0;
+}
+
+static int compare_dirty(const void *a, const void *b) {
+    const DirtyName *x = a;
+    const DirtyName *y = b;
+    if (x->dir != y->dir) return x->dir < y->dir ? -1 : 1;
+    return strcmp(x->name, y->name);
+}
+
+// Start over: the event queue overflowed, so changes were lost
+static int rescan(JailUsage *usage) {
+    char root[sizeof(usage->root)];
+    memcpy(root, usage->root, sizeof(root));
+    uint64_t events = usage->events;
+    uint64_t restats = usage->restats;
+    uint64_t rescans = usage->rescans + 1;
+    int threads = usage->threads;
+    
+    jailusage_cleanup(usage);
+    int rc = jailusage_init(usage, root, threads);
+    usage->events = events;
+    usage->restats = restats;
+    usage->rescans = rescans;
+    return rc;
+}
+
+int jailusage_poll(JailUsage *usage) {
+    if (usage->inotify_fd < 0) return -1;
+    
+    DirtyName *dirty = NULL;
+    size_t count = 0, capacity = 0;
+    int overflow = 0;
+    char buf[65536] __attribute__((aligned(__alignof__(struct inotify_event))));
+    
+    ssize_t n;
+    while ((n = read(usage->inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n;) {
+            struct inotify_event *event = (struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + event->len;
+            usage->events++;
+            if (event->mask & IN_Q_OVERFLOW) overflow = 1;
+            if (event->len == 0 || event->wd < 0 || event->wd >= usage->wd_capacity) continue;
+            int index = usage->wd_dirs[event->wd];
+            if (index < 0 || overflow) continue;
+            
+            if (count == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                DirtyName *grown = realloc(dirty, sizeof(DirtyName) * capacity);
+                if (!grown) {
+                    overflow = 1;
+                    continue;
+                }
+                dirty = grown;
+            }
+            dirty[count].dir = index;
+            dirty[count].name = strdup(event->name);
+            if (dirty[count].name) count++;
+        }
+    }
+    
+    int read_error = n < 0 && errno != EAGAIN;
+    
+    // Every event for a name leads to the same restat, so do it once
+    qsort(dirty, count, sizeof(DirtyName), compare_dirty);
+    int restated = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!overflow && (i == 0 || compare_dirty(&dirty[i - 1], &dirty[i]) != 0)) {
+            reconcile(usage, dirty[i].dir, dirty[i].name);
+            restated++;
+        }
+    }
+    for (size_t i = 0; i < count; i++) free(dirty[i].name);
+    free(dirty);
+    
+    if (overflow) return rescan(usage) == 0 ? 0 : -1;
+    return read_error ? -1 : restated;
+}
+
+void jailusage_cleanup(JailUsage *usage) {
+    for (int i = 0; i < usage->dir_count; i++) {
+        JailUsageDir *dir = usage->dirs[i];
+        if (!dir) continue;
+        for (size_t j = 0; j < dir->capacity; j++) free(dir->entries[j].name);
+        free(dir->entries);
+        free(dir->path);
+        free(dir);
+    }
+    free(usage->dirs);
+    free(usage->free_dirs);
+    free(usage->wd_dirs);
+    free(usage->inodes);
+    if (usage->inotify_fd >= 0) close(usage->inotify_fd);   // Drops every watch
+    usage->dirs = NULL;
+    usage->free_dirs = NULL;
+    usage->wd_dirs = NULL;
+    usage->inodes = NULL;
+    usage->inotify_fd = -1;
+    usage->dir_count = usage->dir_capacity = usage->free_count = usage->wd_capacity = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef ZENCUBE_JAILUSAGE_H
+#define ZENCUBE_JAILUSAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// One name in a watched directory
+typedef struct {
+    char *name;                // NULL = empty slot
+    uint64_t ino;
+    int child;                 // Directory index of a subdirectory, -1 otherwise
+} JailUsageEntry;
+
+// A watched directory and the names in it (open-addressed by name)
+typedef struct {
+    int wd;                    // inotify watch descriptor
+    char *path;
+    JailUsageEntry *entries;
+    size_t capacity;
+    size_t count;
+} JailUsageDir;
+
+// Allocated bytes of one inode and how many tracked names refer to it, so
+// hard links are counted once
+typedef struct {
+    uint64_t ino;              // 0 = empty slot
+    uint64_t bytes;
+    uint32_t links;
+} JailUsageInode;
+
+// Disk usage of a jail directory, kept current from inotify events after
+// one initial scan. Does not cross into other mounts (like du -x).
+typedef struct {
+    char root[4096];
+    uint64_t dev;              // Filesystem of the root
+    uint64_t mnt_id;           // Mount of the root, 0 = unknown
+    int inotify_fd;
+    int threads;               // Initial scan workers
+    JailUsageDir **dirs;       // Indexed by directory number; NULL = free
+    int dir_count;
+    int dir_capacity;
+    int *free_dirs;
+    int free_count;
+    int *wd_dirs;              // Watch descriptor -> directory number, -1 = none
+    int wd_capacity;
+    JailUsageInode *inodes;
+    size_t inode_capacity;
+    size_t inode_count;
+    uint64_t bytes;            // Allocated bytes under root
+    uint64_t files;            // Distinct inodes, directories included
+    uint64_t events;
+    uint64_t restats;
+    uint64_t rescans;          // Full scans after an event queue overflow
+    double scan_ms;            // Duration of the last full scan
+} JailUsage;
+
+// Scan jail_dir with `threads` workers (getdents64 + statx) and watch every
+// directory in it. Returns -1 if the directory or inotify is unavailable.
+int jailusage_init(JailUsage *usage, const char *jail_dir, int threads);
+
+// Apply pending events without blocking: each changed name is restatted
+// once per call however many events it produced. Returns the number of
+// names restatted, or -1 on error.
+int jailusage_poll(JailUsage *usage);
+
+// Release watches and tables
+void jailusage_cleanup(JailUsage *usage);
+
+#endif // ZENCUBE_JAILUSAGE_H
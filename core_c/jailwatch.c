@@ -0,0 +1,508 @@
+#include "jailwatch.h"
+#include "logutil.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <mntent.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <sys/fanotify.h>
+
+#define ANCESTOR_WALK_LIMIT 64
+
+// Filesystems that never hold jail escapes worth reporting (and are
+// whitelisted anyway); marking them would only add event traffic
+static const char *PSEUDO_FILESYSTEMS[] = {
+    "proc", "sysfs", "cgroup", "cgroup2", "devpts", "devtmpfs", "mqueue",
+    "debugfs", "tracefs", "securityfs", "pstore", "bpf", "configfs",
+    "fusectl", "autofs", "binfmt_misc", "hugetlbfs", "nsfs", "rpc_pipefs",
+    NULL
+};
+
+const char* jailwatch_mode_name(JailWatchMode mode) {
+    switch (mode) {
+        case JAILWATCH_FANOTIFY: return "fanotify";
+        case JAILWATCH_FDSCAN: return "fdscan";
+        default: return "auto";
+    }
+}
+
+static uint64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+// Read /proc/<pid>/stat and return the state character (0 if gone) and
+// optionally the parent pid
+static char read_proc_state(int pid, int *ppid) {
+    char path[64];
+    char buffer[512];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return 0;
+    ssize_t n = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (n <= 0) return 0;
+    buffer[n] = '\0';
+    
+    // comm may contain spaces and parentheses; fields resume after the last ')'
+    char *end = strrchr(buffer, ')');
+    if (!end || end[1] == '\0') return 0;
+    
+    char state = 0;
+    int parent = 0;
+    if (sscanf(end + 2, "%c %d", &state, &parent) != 2) return 0;
+    if (ppid) *ppid = parent;
+    return state;
+}
+
+static int process_alive(int pid) {
+    char state = read_proc_state(pid, NULL);
+    return state != 0 && state != 'Z' && state != 'X';
+}
+
+static int tree_contains(const JailWatch *watch, int pid) {
+    for (int i = 0; i < watch->pid_count; i++) {
+        if (watch->pids[i] == pid) return 1;
+    }
+    return 0;
+}
+
+static void tree_add(JailWatch *watch, int pid) {
+    if (watch->pid_count < JAILWATCH_MAX_PIDS && !tree_contains(watch, pid)) {
+        watch->pids[watch->pid_count++] = pid;
+    }
+}
+
+// Append the children of every thread of pid to the tree
+static void add_children(JailWatch *watch, int pid) {
+    char path[320];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR *tasks = opendir(path);
+    if (!tasks) return;
+    
+    struct dirent *entry;
+    while ((entry = readdir(tasks)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        
+        snprintf(path, sizeof(path), "/proc/%d/task/%s/children", pid, entry->d_name);
+        FILE *fp = fopen(path, "r");
+        if (!fp) continue;
+        
+        int child;
+        while (fscanf(fp, "%d", &child) == 1) {
+            tree_add(watch, child);
+        }
+        fclose(fp);
+    }
+    closedir(tasks);
+}
+
+// Rebuild the list of live processes under the root (breadth first)
+static void refresh_tree(JailWatch *watch) {
+    watch->pid_count = 0;
+    if (!process_alive(watch->root_pid)) return;
+    
+    watch->pids[watch->pid_count++] = watch->root_pid;
+    for (int i = 0; i < watch->pid_count; i++) {
+        add_children(watch, watch->pids[i]);
+    }
+}
+
+// True if pid is the root or descends from it. Walks the parent chain for
+// processes started since the last refresh.
+static int pid_in_tree(JailWatch *watch, int pid) {
+    if (tree_contains(watch, pid)) return 1;
+    
+    int current = pid;
+    for (int depth = 0; depth < ANCESTOR_WALK_LIMIT; depth++) {
+        int parent = 0;
+        if (!read_proc_state(current, &parent) || parent <= 1) return 0;
+        if (parent == watch->root_pid || tree_contains(watch, parent)) {
+            tree_add(watch, pid);
+            return 1;
+        }
+        current = parent;
+    }
+    return 0;
+}
+
+// FNV-1a over the path, for the reported set
+static uint64_t hash_path(const char *path) {
+    uint64_t hash = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char *)path; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Insert path into the reported set; returns 1 if it was new
+static int mark_reported(JailWatch *watch, const char *path) {
+    if ((watch->reported_count + 1) * 10 >= watch->reported_capacity * 7) {
+        size_t capacity = watch->reported_capacity ? watch->reported_capacity * 2 : 256;
+        char **table = calloc(capacity, sizeof(char *));
+        if (!table) return 1;
+        
+        for (size_t i = 0; i < watch->reported_capacity; i++) {
+            char *entry = watch->reported[i];
+            if (!entry) continue;
+            size_t slot = hash_path(entry) & (capacity - 1);
+            while (table[slot]) slot = (slot + 1) & (capacity - 1);
+            table[slot] = entry;
+        }
+        free(watch->reported);
+        watch->reported = table;
+        watch->reported_capacity = capacity;
+    }
+    
+    size_t mask = watch->reported_capacity - 1;
+    size_t slot = hash_path(path) & mask;
+    while (watch->reported[slot]) {
+        if (strcmp(watch->reported[slot], path) == 0) return 0;
+        slot = (slot + 1) & mask;
+    }
+    
+    watch->reported[slot] = strdup(path);
+    watch->reported_count++;
+    return 1;
+}
+
+// Write one JSON line and flush so the reader sees it immediately
+static void emit_json(JailWatch *watch, cJSON *json) {
+    char timestamp[32];
+    get_iso_timestamp(timestamp, sizeof(timestamp));
+    cJSON_AddStringToObject(json, "timestamp", timestamp);
+    
+    char *text = cJSON_PrintUnformatted(json);
+    if (text) {
+        fprintf(watch->out, "%s\n", text);
+        fflush(watch->out);
+        free(text);
+    }
+    cJSON_Delete(json);
+}
+
+static void report_violation(JailWatch *watch, int pid, const char *path, const char *source) {
+    if (!mark_reported(watch, path)) return;
+    watch->violations++;
+    
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "event", "violation");
+    cJSON_AddNumberToObject(json, "pid", pid);
+    cJSON_AddStringToObject(json, "path", path);
+    cJSON_AddStringToObject(json, "source", source);
+    emit_json(watch, json);
+}
+
+// Check one fd target as returned by readlink
+static void check_target(JailWatch *watch, int pid, char *target, const char *source) {
+    // Unlinked files keep their old path with this suffix
+    static const char deleted[] = " (deleted)";
+    size_t len = strlen(target);
+    if (len > sizeof(deleted) - 1 && strcmp(target + len - (sizeof(deleted) - 1), deleted) == 0) {
+        target[len - (sizeof(deleted) - 1)] = '\0';
+    }
+    
+    if (jailwatch_is_violation(watch, target)) {
+        report_violation(watch, pid, target, source);
+    }
+}
+
+int jailwatch_is_violation(const JailWatch *watch, const char *path) {
+    if (path[0] != '/') return 0;  // pipe:[...], socket:[...], anon_inode:...
+    
+    for (int i = 0; i < watch->allow_count; i++) {
+        if (strncmp(path, watch->allow[i], strlen(watch->allow[i])) == 0) return 0;
+    }
+    
+    if (strncmp(path, watch->jail, watch->jail_len) == 0 &&
+        (path[watch->jail_len] == '\0' || path[watch->jail_len] == '/' || watch->jail_len == 1)) {
+        return 0;
+    }
+    return 1;
+}
+
+int jailwatch_allow(JailWatch *watch, const char *prefix) {
+    if (watch->allow_count >= JAILWATCH_MAX_ALLOW) return -1;
+    watch->allow[watch->allow_count] = strdup(prefix);
+    if (!watch->allow[watch->allow_count]) return -1;
+    watch->allow_count++;
+    return 0;
+}
+
+static JailProc* find_proc(JailWatch *watch, int pid) {
+    for (int i = 0; i < watch->proc_count; i++) {
+        if (watch->procs[i].pid == pid) return &watch->procs[i];
+    }
+    return NULL;
+}
+
+// Keep fd caches for live tree members only
+static void sync_procs(JailWatch *watch) {
+    JailProc *procs = calloc((size_t)watch->pid_count + 1, sizeof(JailProc));
+    if (!procs) return;
+    
+    for (int i = 0; i < watch->pid_count; i++) {
+        JailProc *existing = find_proc(watch, watch->pids[i]);
+        if (existing) {
+            procs[i] = *existing;
+            existing->fds = NULL;
+        } else {
+            procs[i].pid = watch->pids[i];
+        }
+    }
+    
+    for (int i = 0; i < watch->proc_count; i++) {
+        free(watch->procs[i].fds);
+    }
+    free(watch->procs);
+    watch->procs = procs;
+    watch->proc_count = watch->pid_count;
+}
+
+// Diff a process's fd table against the cache. stat() on each fd link gives
+// the target's device and inode, so readlink only runs for slots that were
+// opened (or reused for a different file) since the last scan.
+static void scan_proc(JailWatch *watch, JailProc *proc) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/fd", proc->pid);
+    int dir_fd = open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) return;
+    
+    DIR *dir = fdopendir(dir_fd);
+    if (!dir) {
+        close(dir_fd);
+        return;
+    }
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        
+        long fd = strtol(entry->d_name, NULL, 10);
+        if (fd < 0) continue;
+        
+        if ((size_t)fd >= proc->capacity) {
+            size_t capacity = proc->capacity ? proc->capacity : 64;
+            while (capacity <= (size_t)fd) capacity *= 2;
+            JailFdEntry *fds = realloc(proc->fds, capacity * sizeof(JailFdEntry));
+            if (!fds) continue;
+            memset(fds + proc->capacity, 0, (capacity - proc->capacity) * sizeof(JailFdEntry));
+            proc->fds = fds;
+            proc->capacity = capacity;
+        }
+        
+        struct stat st;
+        if (fstatat(dir_fd, entry->d_name, &st, 0) != 0) continue;  // Closed meanwhile
+        
+        JailFdEntry *cached = &proc->fds[fd];
+        if (cached->valid && cached->dev == st.st_dev && cached->ino == st.st_ino) continue;
+        cached->dev = st.st_dev;
+        cached->ino = st.st_ino;
+        cached->valid = 1;
+        watch->opens_seen++;
+        
+        char target[PATH_MAX];
+        ssize_t n = readlinkat(dir_fd, entry->d_name, target, sizeof(target) - 1);
+        watch->readlinks++;
+        if (n <= 0) continue;
+        target[n] = '\0';
+        
+        check_target(watch, proc->pid, target, "fdscan");
+    }
+    
+    closedir(dir);
+}
+
+static int is_pseudo_filesystem(const char *type) {
+    for (int i = 0; PSEUDO_FILESYSTEMS[i]; i++) {
+        if (strcmp(type, PSEUDO_FILESYSTEMS[i]) == 0) return 1;
+    }
+    return 0;
+}
+
+// Mark every real mount for open events. Needs CAP_SYS_ADMIN.
+static int fanotify_setup(JailWatch *watch) {
+    int fd = fanotify_init(FAN_CLASS_NOTIF | FAN_CLOEXEC | FAN_NONBLOCK, O_RDONLY | O_LARGEFILE | O_CLOEXEC);
+    if (fd < 0) return -1;
+    
+    FILE *mounts = setmntent("/proc/self/mounts", "r");
+    if (!mounts) {
+        close(fd);
+        return -1;
+    }
+    
+    int marked = 0;
+    struct mntent *mount;
+    while ((mount = getmntent(mounts)) != NULL) {
+        if (is_pseudo_filesystem(mount->mnt_type)) continue;
+        if (fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_MOUNT, FAN_OPEN, AT_FDCWD, mount->mnt_dir) == 0) {
+            marked++;
+        }
+    }
+    endmntent(mounts);
+    
+    if (marked == 0) {
+        close(fd);
+        return -1;
+    }
+    
+    watch->fan_fd = fd;
+    return 0;
+}
+
+// Handle every queued open event. Each event carries an fd for the opened
+// file; its path comes from our own /proc/self/fd entry.
+static void drain_fanotify(JailWatch *watch) {
+    union {
+        struct fanotify_event_metadata metadata;
+        char bytes[8192];
+    } buffer;
+    pid_t self = getpid();
+    
+    for (;;) {
+        ssize_t len = read(watch->fan_fd, &buffer, sizeof(buffer));
+        if (len <= 0) break;
+        
+        struct fanotify_event_metadata *event = &buffer.metadata;
+        while (FAN_EVENT_OK(event, len)) {
+            if (event->vers != FANOTIFY_METADATA_VERSION) return;
+            
+            if (event->mask & FAN_Q_OVERFLOW) {
+                cJSON *json = cJSON_CreateObject();
+                cJSON_AddStringToObject(json, "event", "overflow");
+                emit_json(watch, json);
+            }
+            
+            if (event->fd >= 0) {
+                if (event->pid != self && pid_in_tree(watch, event->pid)) {
+                    char link[64];
+                    char target[PATH_MAX];
+                    snprintf(link, sizeof(link), "/proc/self/fd/%d", event->fd);
+                    watch->opens_seen++;
+                    
+                    ssize_t n = readlink(link, target, sizeof(target) - 1);
+                    watch->readlinks++;
+                    if (n > 0) {
+                        target[n] = '\0';
+                        check_target(watch, event->pid, target, "fanotify");
+                    }
+                }
+                close(event->fd);
+            }
+            
+            event = FAN_EVENT_NEXT(event, len);
+        }
+    }
+}
+
+int jailwatch_init(JailWatch *watch, int pid, const char *jail_dir, JailWatchMode mode, FILE *out) {
+    memset(watch, 0, sizeof(JailWatch));
+    watch->root_pid = pid;
+    watch->fan_fd = -1;
+    watch->interval_ms = 100;
+    watch->out = out;
+    
+    if (!realpath(jail_dir, watch->jail)) {
+        fprintf(stderr, "Cannot resolve jail directory %s: %s\n", jail_dir, strerror(errno));
+        return -1;
+    }
+    watch->jail_len = strlen(watch->jail);
+    
+    if (mode != JAILWATCH_FDSCAN && fanotify_setup(watch) == 0) {
+        watch->mode = JAILWATCH_FANOTIFY;
+    } else if (mode == JAILWATCH_FANOTIFY) {
+        fprintf(stderr, "fanotify unavailable: %s\n", strerror(errno));
+        return -1;
+    } else {
+        watch->mode = JAILWATCH_FDSCAN;
+    }
+    
+    return 0;
+}
+
+int jailwatch_run(JailWatch *watch, volatile sig_atomic_t *running) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "event", "started");
+    cJSON_AddNumberToObject(json, "pid", watch->root_pid);
+    cJSON_AddStringToObject(json, "jail", watch->jail);
+    cJSON_AddStringToObject(json, "mode", jailwatch_mode_name(watch->mode));
+    emit_json(watch, json);
+    
+    uint64_t last_refresh = 0;
+    while (*running && process_alive(watch->root_pid)) {
+        uint64_t now = monotonic_ms();
+        if (now - last_refresh >= (uint64_t)watch->interval_ms) {
+            refresh_tree(watch);
+            last_refresh = now;
+        }
+        
+        if (watch->mode == JAILWATCH_FANOTIFY) {
+            struct pollfd pfd = { .fd = watch->fan_fd, .events = POLLIN, .revents = 0 };
+            int ready = poll(&pfd, 1, watch->interval_ms);
+            if (ready < 0 && errno != EINTR) {
+                perror("poll");
+                break;
+            }
+            if (ready > 0) drain_fanotify(watch);
+        } else {
+            sync_procs(watch);
+            for (int i = 0; i < watch->proc_count; i++) {
+                scan_proc(watch, &watch->procs[i]);
+            }
+            
+            struct timespec pause = { watch->interval_ms / 1000, (long)(watch->interval_ms % 1000) * 1000000L };
+            nanosleep(&pause, NULL);
+        }
+    }
+    
+    // Opens made just before exit may still be queued
+    if (watch->mode == JAILWATCH_FANOTIFY) {
+        drain_fanotify(watch);
+    }
+    
+    json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "event", "stopped");
+    cJSON_AddNumberToObject(json, "violations", (double)watch->violations);
+    cJSON_AddNumberToObject(json, "opens_seen", (double)watch->opens_seen);
+    cJSON_AddNumberToObject(json, "readlinks", (double)watch->readlinks);
+    emit_json(watch, json);
+    return 0;
+}
+
+void jailwatch_cleanup(JailWatch *watch) {
+    if (watch->fan_fd >= 0) {
+        close(watch->fan_fd);
+        watch->fan_fd = -1;
+    }
+    
+    for (int i = 0; i < watch->proc_count; i++) {
+        free(watch->procs[i].fds);
+    }
+    free(watch->procs);
+    watch->procs = NULL;
+    watch->proc_count = 0;
+    
+    for (size_t i = 0; i < watch->reported_capacity; i++) {
+        free(watch->reported[i]);
+    }
+    free(watch->reported);
+    watch->reported = NULL;
+    watch->reported_capacity = 0;
+    watch->reported_count = 0;
+    
+    for (int i = 0; i < watch->allow_count; i++) {
+        free(watch->allow[i]);
+    }
+    watch->allow_count = 0;
+}
@@ -0,0 +1,76 @@
+#ifndef ZENCUBE_JAILWATCH_H
+#define ZENCUBE_JAILWATCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <signal.h>
+#include <sys/types.h>
+
+#define JAILWATCH_MAX_ALLOW 32
+#define JAILWATCH_MAX_PIDS 1024
+
+// How opens are observed
+typedef enum {
+    JAILWATCH_AUTO,            // fanotify if permitted, otherwise fd scanning
+    JAILWATCH_FANOTIFY,        // Kernel open events on every mounted filesystem
+    JAILWATCH_FDSCAN           // Incremental /proc/<pid>/fd diff
+} JailWatchMode;
+
+// Cached target of one fd slot; readlink only runs when it changes
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    int valid;
+} JailFdEntry;
+
+// fd table cache of one watched process
+typedef struct {
+    int pid;
+    JailFdEntry *fds;          // Indexed by fd number
+    size_t capacity;
+} JailProc;
+
+// Violation detector for a sandboxed process tree
+typedef struct {
+    int root_pid;
+    char jail[4096];           // Resolved jail directory
+    size_t jail_len;
+    char *allow[JAILWATCH_MAX_ALLOW];  // Path prefixes that are never violations
+    int allow_count;
+    JailWatchMode mode;        // Resolved mode (never AUTO after init)
+    int fan_fd;
+    int interval_ms;           // fd scan period / liveness check period
+    int pids[JAILWATCH_MAX_PIDS];  // Root and its live descendants
+    int pid_count;
+    JailProc *procs;
+    int proc_count;
+    char **reported;           // Open-addressed set of paths already reported
+    size_t reported_capacity;
+    size_t reported_count;
+    uint64_t violations;
+    uint64_t opens_seen;       // fanotify events or changed fd slots
+    uint64_t readlinks;
+    FILE *out;                 // JSON lines sink
+} JailWatch;
+
+// Watch pid and its descendants for opens outside jail_dir. Returns -1 if
+// the jail cannot be resolved or the requested mode is unavailable.
+int jailwatch_init(JailWatch *watch, int pid, const char *jail_dir, JailWatchMode mode, FILE *out);
+
+// Add a path prefix that is always allowed (e.g. "/usr/lib/")
+int jailwatch_allow(JailWatch *watch, const char *prefix);
+
+// 1 if path is outside the jail and every allowed prefix. Non-path fd
+// targets (pipes, sockets, anon inodes) are never violations.
+int jailwatch_is_violation(const JailWatch *watch, const char *path);
+
+// Stream violations until the root process exits or *running becomes 0
+int jailwatch_run(JailWatch *watch, volatile sig_atomic_t *running);
+
+// Mode name for logs
+const char* jailwatch_mode_name(JailWatchMode mode);
+
+// Release all resources
+void jailwatch_cleanup(JailWatch *watch);
+
+#endif // ZENCUBE_JAILWATCH_H
@@ -0,0 +1,110 @@
+#include "jailwatch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <signal.h>
+
+static volatile sig_atomic_t running = 1;
+
+// Whitelist the Electron monitor has always applied, plus the binaries and
+// loader cache every exec opens (fanotify sees those; fd polling never did)
+static const char *DEFAULT_ALLOW[] = {
+    "/dev/", "/proc/", "/sys/", "/usr/lib/", "/lib/", "/lib64/", "/tmp/",
+    "/usr/lib64/", "/bin/", "/sbin/", "/usr/bin/", "/usr/sbin/", "/etc/ld.so.cache",
+    NULL
+};
+
+static void handle_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --pid <pid> --jail <dir> [--allow <prefix>]... [--mode auto|fanotify|fdscan]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --pid PID          Sandboxed process (its descendants are watched too)\n");
+    fprintf(stderr, "  --jail DIR         Jail directory; opens outside it are violations\n");
+    fprintf(stderr, "  --allow PREFIX     Extra allowed path prefix (repeatable)\n");
+    fprintf(stderr, "  --no-default-allow Do not allow /dev/, /proc/, /sys/, /tmp/, library and\n");
+    fprintf(stderr, "                     binary directories and /etc/ld.so.cache\n");
+    fprintf(stderr, "  --mode MODE        fanotify (needs CAP_SYS_ADMIN), fdscan, or auto (default)\n");
+    fprintf(stderr, "  --interval-ms MS   fd scan / liveness check period (default: 100)\n");
+    fprintf(stderr, "  --help             Show this help\n");
+    fprintf(stderr, "\nViolations are written to stdout as JSON lines until the process exits.\n");
+}
+
+int main(int argc, char **argv) {
+    int pid = 0;
+    char *jail_dir = NULL;
+    char *allow[JAILWATCH_MAX_ALLOW];
+    int allow_count = 0;
+    int default_allow = 1;
+    int interval_ms = 100;
+    JailWatchMode mode = JAILWATCH_AUTO;
+    
+    static struct option long_options[] = {
+        {"pid",              required_argument, 0, 'p'},
+        {"jail",             required_argument, 0, 'j'},
+        {"allow",            required_argument, 0, 'a'},
+        {"no-default-allow", no_argument,       0, 'n'},
+        {"mode",             required_argument, 0, 'm'},
+        {"interval-ms",      required_argument, 0, 'i'},
+        {"help",             no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while ((opt = getopt_long(argc, argv, "p:j:a:nm:i:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'p': pid = atoi(optarg); break;
+            case 'j': jail_dir = optarg; break;
+            case 'a':
+                if (allow_count < JAILWATCH_MAX_ALLOW) allow[allow_count++] = optarg;
+                break;
+            case 'n': default_allow = 0; break;
+            case 'm':
+                if (strcmp(optarg, "fanotify") == 0) mode = JAILWATCH_FANOTIFY;
+                else if (strcmp(optarg, "fdscan") == 0) mode = JAILWATCH_FDSCAN;
+                else mode = JAILWATCH_AUTO;
+                break;
+            case 'i': interval_ms = atoi(optarg); break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    if (pid <= 0 || !jail_dir) {
+        fprintf(stderr, "Error: Missing required arguments\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    
+    JailWatch watch;
+    if (jailwatch_init(&watch, pid, jail_dir, mode, stdout) != 0) {
+        jailwatch_cleanup(&watch);
+        return 1;
+    }
+    if (interval_ms > 0) {
+        watch.interval_ms = interval_ms;
+    }
+    
+    if (default_allow) {
+        for (int i = 0; DEFAULT_ALLOW[i]; i++) {
+            jailwatch_allow(&watch, DEFAULT_ALLOW[i]);
+        }
+    }
+    for (int i = 0; i < allow_count; i++) {
+        jailwatch_allow(&watch, allow[i]);
+    }
+    
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    signal(SIGPIPE, SIG_IGN);
+    
+    jailwatch_run(&watch, &running);
+    jailwatch_cleanup(&watch);
+    return 0;
+}
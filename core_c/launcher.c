@@ -0,0 +1,424 @@
+#include "launcher.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/landlock.h>
+
+// Rights newer than the installed UAPI header
+#ifndef LANDLOCK_ACCESS_FS_REFER
+#define LANDLOCK_ACCESS_FS_REFER (1ULL << 13)
+#endif
+#ifndef LANDLOCK_ACCESS_FS_TRUNCATE
+#define LANDLOCK_ACCESS_FS_TRUNCATE (1ULL << 14)
+#endif
+#ifndef LANDLOCK_ACCESS_FS_IOCTL_DEV
+#define LANDLOCK_ACCESS_FS_IOCTL_DEV (1ULL << 15)
+#endif
+
+#define ACCESS_FS_ABI1 ((1ULL << 13) - 1)  // EXECUTE through MAKE_SYM
+
+#define ACCESS_FILE (LANDLOCK_ACCESS_FS_EXECUTE | LANDLOCK_ACCESS_FS_WRITE_FILE | \
+                     LANDLOCK_ACCESS_FS_READ_FILE | LANDLOCK_ACCESS_FS_TRUNCATE | \
+                     LANDLOCK_ACCESS_FS_IOCTL_DEV)
+
+#define ACCESS_READ_ONLY (LANDLOCK_ACCESS_FS_EXECUTE | LANDLOCK_ACCESS_FS_READ_FILE | \
+                          LANDLOCK_ACCESS_FS_READ_DIR)
+
+#define ACCESS_DEVICES (LANDLOCK_ACCESS_FS_READ_FILE | LANDLOCK_ACCESS_FS_WRITE_FILE | \
+                        LANDLOCK_ACCESS_FS_READ_DIR | LANDLOCK_ACCESS_FS_TRUNCATE | \
+                        LANDLOCK_ACCESS_FS_IOCTL_DEV)
+
+static const char *DEFAULT_READ_ONLY[] = {
+    "/usr/lib", "/usr/lib64", "/lib", "/lib64", "/usr/local/lib",
+    "/usr/bin", "/usr/sbin", "/bin", "/sbin", "/usr/local/bin",
+    "/etc/ld.so.cache", "/proc", "/sys",
+    NULL
+};
+
+void launch_config_init(LaunchConfig *config) {
+    memset(config, 0, sizeof(LaunchConfig));
+    config->status_fd = -1;
+    seccomp_policy_init(&config->seccomp, seccomp_action_allow());
+    placement_request_init(&config->placement);
+    overlay_config_init(&config->overlay);
+}
+
+int launch_set_jail(LaunchConfig *config, const char *jail_dir) {
+    if (!realpath(jail_dir, config->jail_dir)) {
+        config->jail_dir[0] = '\0';
+        return -1;
+    }
+    return launch_add_path(config, config->jail_dir, LAUNCH_PATH_READ_WRITE);
+}
+
+int launch_add_path(LaunchConfig *config, const char *path, LaunchPathAccess access) {
+    if (config->rule_count >= LAUNCH_MAX_PATHS) return -1;
+    if (strlen(path) >= sizeof(config->rules[0].path)) return -1;
+    
+    // Resolve now: rules are opened after the chdir into the jail
+    LaunchPathRule *rule = &config->rules[config->rule_count++];
+    if (!realpath(path, rule->path)) {
+        strcpy(rule->path, path);
+    }
+    rule->access = access;
+    return 0;
+}
+
+void launch_add_default_paths(LaunchConfig *config) {
+    for (int i = 0; DEFAULT_READ_ONLY[i]; i++) {
+        if (access(DEFAULT_READ_ONLY[i], F_OK) == 0) {
+            launch_add_path(config, DEFAULT_READ_ONLY[i], LAUNCH_PATH_READ_ONLY);
+        }
+    }
+    launch_add_path(config, "/dev", LAUNCH_PATH_DEVICES);
+    launch_add_path(config, "/tmp", LAUNCH_PATH_READ_WRITE);
+}
+
+int launch_use_cgroup(LaunchConfig *config, const char *parent) {
+    if (parent) {
+        snprintf(config->cgroup_parent, sizeof(config->cgroup_parent), "%s", parent);
+        return 0;
+    }
+    return cgroup_default_parent(config->cgroup_parent, sizeof(config->cgroup_parent));
+}
+
+int launch_use_overlay(LaunchConfig *config) {
+    if (!config->jail_dir[0]) return -1;
+    config->overlay_enabled = 1;
+    return 0;
+}
+
+int launch_deny_network(LaunchConfig *config) {
+    config->seccomp_enabled = 1;
+    return seccomp_policy_add_network_deny(&config->seccomp);
+}
+
+// Filesystem rights this kernel's Landlock ABI understands
+static uint64_t handled_access_fs(int abi) {
+    uint64_t access = ACCESS_FS_ABI1;
+    if (abi >= 2) access |= LANDLOCK_ACCESS_FS_REFER;
+    if (abi >= 3) access |= LANDLOCK_ACCESS_FS_TRUNCATE;
+    if (abi >= 5) access |= LANDLOCK_ACCESS_FS_IOCTL_DEV;
+    return access;
+}
+
+static uint64_t rule_access(LaunchPathAccess access, uint64_t handled) {
+    switch (access) {
+        case LAUNCH_PATH_READ_ONLY: return ACCESS_READ_ONLY & handled;
+        case LAUNCH_PATH_DEVICES: return ACCESS_DEVICES & handled;
+        default: return handled;
+    }
+}
+
+int launch_apply_landlock(const LaunchConfig *config, LaunchResult *result) {
+    long abi = syscall(SYS_landlock_create_ruleset, NULL, 0, LANDLOCK_CREATE_RULESET_VERSION);
+    result->landlock_abi = abi > 0 ? (int)abi : 0;
+    result->landlock_enforced = 0;
+    result->rules_applied = 0;
+    
+    if (config->rule_count == 0) return 0;
+    
+    if (abi <= 0) {
+        snprintf(result->error, sizeof(result->error), "Landlock unavailable: %s", strerror(errno));
+        return config->jail_best_effort ? 0 : -1;
+    }
+    
+    uint64_t handled = handled_access_fs((int)abi);
+    struct landlock_ruleset_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.handled_access_fs = handled;
+    
+    int ruleset_fd = (int)syscall(SYS_landlock_create_ruleset, &attr, sizeof(attr), 0);
+    if (ruleset_fd < 0) {
+        snprintf(result->error, sizeof(result->error), "landlock_create_ruleset: %s", strerror(errno));
+        return config->jail_best_effort ? 0 : -1;
+    }
+    
+    for (int i = 0; i < config->rule_count; i++) {
+        const LaunchPathRule *rule = &config->rules[i];
+        int path_fd = open(rule->path, O_PATH | O_CLOEXEC);
+        if (path_fd < 0) continue;  // Nothing to grant on a missing path
+        
+        struct stat st;
+        uint64_t allowed = rule_access(rule->access, handled);
+        if (fstat(path_fd, &st) == 0 && !S_ISDIR(st.st_mode)) {
+            allowed &= ACCESS_FILE;  // Directory rights are invalid on files
+        }
+        
+        struct landlock_path_beneath_attr beneath = {
+            .allowed_access = allowed,
+            .parent_fd = path_fd,
+        };
+        if (syscall(SYS_landlock_add_rule, ruleset_fd, LANDLOCK_RULE_PATH_BENEATH, &beneath, 0) == 0) {
+            result->rules_applied++;
+        }
+        close(path_fd);
+    }
+    
+    // Required so an unprivileged process may restrict itself
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0 ||
+        syscall(SYS_landlock_restrict_self, ruleset_fd, 0) != 0) {
+        snprintf(result->error, sizeof(result->error), "landlock_restrict_self: %s", strerror(errno));
+        close(ruleset_fd);
+        return -1;
+    }
+    
+    close(ruleset_fd);
+    result->landlock_enforced = 1;
+    return 0;
+}
+
+void launch_report_status(int fd, const LaunchConfig *config, const LaunchResult *result, const char *event) {
+    if (fd < 0) return;
+    
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "event", event);
+    cJSON_AddNumberToObject(json, "pid", getpid());
+    cJSON_AddStringToObject(json, "jail", config->jail_dir);
+    cJSON_AddNumberToObject(json, "landlock_abi", result->landlock_abi);
+    cJSON_AddBoolToObject(json, "landlock", result->landlock_enforced);
+    cJSON_AddNumberToObject(json, "rules", result->rules_applied);
+    if (result->cgroup_path[0]) {
+        cJSON_AddStringToObject(json, "cgroup", result->cgroup_path);
+    }
+    if (result->cgroup_error[0]) {
+        cJSON_AddStringToObject(json, "cgroup_error", result->cgroup_error);
+    }
+    if (result->cpu_seconds) {
+        cJSON_AddNumberToObject(json, "cpu_seconds", (double)result->cpu_seconds);
+    }
+    if (config->placement_mode != LAUNCH_PLACE_NONE) {
+        const PlacementResult *placed = &result->placement;
+        char cpus[1024], nodes[256];
+        int node_ids[PLACEMENT_MAX_NODES], node_count = 0;
+        for (int n = 0; n < PLACEMENT_MAX_NODES; n++) {
+            if (placed->nodes & (1ULL << n)) node_ids[node_count++] = n;
+        }
+        placement_format_cpus(placed->cpus, placed->cpu_count, cpus, sizeof(cpus));
+        placement_format_cpus(node_ids, node_count, nodes, sizeof(nodes));
+        cJSON *placement = cJSON_AddObjectToObject(json, "placement");
+        cJSON_AddStringToObject(placement, "cpus", cpus);
+        cJSON_AddStringToObject(placement, "nodes", nodes);
+        cJSON_AddBoolToObject(placement, "shared", placed->shared);
+        cJSON_AddNumberToObject(placement, "moved", placed->moved);
+        if (placed->error[0]) {
+            cJSON_AddStringToObject(placement, "error", placed->error);
+        }
+    }
+    if (result->capture.writer_pid > 0) {
+        cJSON *capture = cJSON_AddObjectToObject(json, "capture");
+        cJSON_AddStringToObject(capture, "log", result->capture.log_path);
+        cJSON_AddStringToObject(capture, "header", result->capture.header_path);
+        cJSON_AddNumberToObject(capture, "writer_pid", result->capture.writer_pid);
+        const CapturePolicy *policy = &result->capture.policy;
+        if (policy->head_bytes || policy->tail_bytes || policy->rate_bytes) {
+            cJSON_AddNumberToObject(capture, "head_bytes", (double)policy->head_bytes);
+            cJSON_AddNumberToObject(capture, "tail_bytes", (double)policy->tail_bytes);
+            cJSON_AddNumberToObject(capture, "rate_bytes", (double)policy->rate_bytes);
+        }
+    }
+    if (result->overlay.run_dir[0]) {
+        cJSON *overlay = cJSON_AddObjectToObject(json, "overlay");
+        cJSON_AddStringToObject(overlay, "run_dir", result->overlay.run_dir);
+        cJSON_AddStringToObject(overlay, "upper", result->overlay.upper);
+        cJSON_AddBoolToObject(overlay, "tmpfs", config->overlay.upper == OVERLAY_UPPER_TMPFS);
+        cJSON_AddBoolToObject(overlay, "user_namespace", result->overlay.user_namespace);
+    }
+    if (config->seccomp_enabled) {
+        cJSON *seccomp = cJSON_AddObjectToObject(json, "seccomp");
+        cJSON_AddNumberToObject(seccomp, "rules", result->seccomp_rules);
+        cJSON_AddNumberToObject(seccomp, "insns", result->seccomp_insns);
+        cJSON_AddNumberToObject(seccomp, "depth", result->seccomp_depth);
+    }
+    if (result->error[0]) {
+        cJSON_AddStringToObject(json, "message", result->error);
+    }
+    
+    char *text = cJSON_PrintUnformatted(json);
+    if (text) {
+        dprintf(fd, "%s\n", text);
+        free(text);
+    }
+    cJSON_Delete(json);
+}
+
+// Compile the policy so a bad one fails before anything is restricted
+static int compile_seccomp(const LaunchConfig *config, SeccompProgram *program, LaunchResult *result) {
+    memset(program, 0, sizeof(SeccompProgram));
+    if (!config->seccomp_enabled) return 0;
+    
+    if (seccomp_compile(&config->seccomp, SECCOMP_COMPILE_TREE, program) != 0) {
+        snprintf(result->error, sizeof(result->error), "seccomp: cannot compile filter");
+        return -1;
+    }
+    result->seccomp_rules = program->ranges;
+    result->seccomp_insns = (int)program->len;
+    result->seccomp_depth = program->depth;
+    return 0;
+}
+
+static int install_seccomp(const LaunchConfig *config, SeccompProgram *program, LaunchResult *result) {
+    int rc = 0;
+    if (config->seccomp_enabled && seccomp_install(program) != 0) {
+        snprintf(result->error, sizeof(result->error), "seccomp: %s", strerror(errno));
+        rc = -1;
+    }
+    seccomp_program_free(program);
+    return rc;
+}
+
+// Route stdout and stderr to the capture log before anything else can write
+static int start_capture(const LaunchConfig *config, LaunchResult *result) {
+    if (!config->capture_path[0]) return 0;
+    
+    if (capture_start(config->capture_path, config->capture_passthrough, &config->capture_policy,
+                      &result->capture) != 0) {
+        snprintf(result->error, sizeof(result->error), "%s", result->capture.error);
+        return -1;
+    }
+    return 0;
+}
+
+// Create the run's cgroup, set its limits, then move in; children and the
+// exec'd program stay inside
+static int enter_cgroup(const LaunchConfig *config, LaunchResult *result) {
+    if (!config->cgroup_parent[0]) return 0;
+    
+    char name[64];
+    snprintf(name, sizeof(name), "zencube_%d", getpid());
+    if (cgroup_create(config->cgroup_parent, name, result->cgroup_path, sizeof(result->cgroup_path)) != 0) {
+        snprintf(result->cgroup_error, sizeof(result->cgroup_error), "cgroup %.200s: %s",
+                 config->cgroup_parent, strerror(errno));
+        result->cgroup_path[0] = '\0';
+    } else {
+        const char *workdir = config->jail_dir[0] ? config->jail_dir : ".";
+        int failures = cgroup_apply_limits(result->cgroup_path, &config->cgroup, workdir,
+                                           result->cgroup_error, sizeof(result->cgroup_error));
+        if (failures == 0 || config->cgroup_best_effort) {
+            if (cgroup_join(result->cgroup_path, 0) == 0) return 0;
+            snprintf(result->cgroup_error, sizeof(result->cgroup_error), "cgroup.procs: %s", strerror(errno));
+        }
+        rmdir(result->cgroup_path);
+        result->cgroup_path[0] = '\0';
+    }
+    
+    if (config->cgroup_best_effort) return 0;
+    snprintf(result->error, sizeof(result->error), "%s", result->cgroup_error);
+    return -1;
+}
+
+// Pin the run to its leased cores (or the reserved ones). An optimization
+// only: failures are reported, never fatal.
+static void place_run(const LaunchConfig *config, LaunchResult *result) {
+    if (config->placement_mode == LAUNCH_PLACE_RESERVED) {
+        placement_reserve(&config->placement, 0, &result->placement);
+    } else if (config->placement_mode == LAUNCH_PLACE_RUN) {
+        PlacementRequest request = config->placement;
+        snprintf(request.cgroup_path, sizeof(request.cgroup_path), "%s", result->cgroup_path);
+        placement_acquire(&request, getpid(), &result->placement);
+    }
+}
+
+// Limit the CPU time of the run: SIGXCPU at the budget, SIGKILL a second
+// later if it is caught. An existing hard limit is never raised.
+static int limit_cpu_time(const LaunchConfig *config, LaunchResult *result) {
+    if (config->cpu_seconds == 0) return 0;
+    
+    struct rlimit limit;
+    rlim_t seconds = (rlim_t)config->cpu_seconds;
+    rlim_t hard = seconds + 1;
+    if (getrlimit(RLIMIT_CPU, &limit) == 0 && limit.rlim_max != RLIM_INFINITY && limit.rlim_max < hard) {
+        hard = limit.rlim_max;
+        if (seconds > hard) seconds = hard;
+    }
+    limit.rlim_cur = seconds;
+    limit.rlim_max = hard;
+    if (setrlimit(RLIMIT_CPU, &limit) != 0) {
+        snprintf(result->error, sizeof(result->error), "RLIMIT_CPU: %s", strerror(errno));
+        return -1;
+    }
+    result->cpu_seconds = (unsigned long)seconds;
+    return 0;
+}
+
+// Never best effort: without the overlay, writes would land in the shared jail
+static int enter_overlay(const LaunchConfig *config, LaunchResult *result) {
+    if (!config->overlay_enabled || !config->jail_dir[0]) return 0;
+    
+    if (overlay_enter(&config->overlay, config->jail_dir, &result->overlay) != 0) {
+        snprintf(result->error, sizeof(result->error), "%s", result->overlay.error);
+        return -1;
+    }
+    return 0;
+}
+
+static int enter_jail(const LaunchConfig *config, LaunchResult *result) {
+    if (config->jail_dir[0] && chdir(config->jail_dir) != 0) {
+        snprintf(result->error, sizeof(result->error), "chdir %.200s: %s", config->jail_dir, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+int launch_restrict(const LaunchConfig *config, LaunchResult *result) {
+    memset(result, 0, sizeof(LaunchResult));
+    
+    SeccompProgram program;
+    if (enter_jail(config, result) != 0 || compile_seccomp(config, &program, result) != 0) {
+        return -1;
+    }
+    if (launch_apply_landlock(config, result) != 0) {
+        seccomp_program_free(&program);
+        return -1;
+    }
+    return install_seccomp(config, &program, result);
+}
+
+int launch_exec(const LaunchConfig *config, char *const argv[], LaunchResult *result) {
+    memset(result, 0, sizeof(LaunchResult));
+    
+    // The status pipe must not leak into the sandboxed program; its EOF
+    // tells the parent that exec happened
+    if (config->status_fd >= 0) {
+        fcntl(config->status_fd, F_SETFD, FD_CLOEXEC);
+    }
+    
+    SeccompProgram program;
+    if (start_capture(config, result) != 0 || enter_cgroup(config, result) != 0) {
+        launch_report_status(config->status_fd, config, result, "error");
+        return -1;
+    }
+    place_run(config, result);
+    if (enter_overlay(config, result) != 0 || enter_jail(config, result) != 0 ||
+        compile_seccomp(config, &program, result) != 0) {
+        launch_report_status(config->status_fd, config, result, "error");
+        return -1;
+    }
+    
+    if (launch_apply_landlock(config, result) != 0 || limit_cpu_time(config, result) != 0) {
+        launch_report_status(config->status_fd, config, result, "error");
+        seccomp_program_free(&program);
+        return -1;
+    }
+    
+    // Report before installing: the filter may deny the status write
+    launch_report_status(config->status_fd, config, result, "ready");
+    
+    if (install_seccomp(config, &program, result) != 0) {
+        launch_report_status(config->status_fd, config, result, "error");
+        return -1;
+    }
+    execvp(argv[0], argv);
+    
+    snprintf(result->error, sizeof(result->error), "exec %s: %s", argv[0], strerror(errno));
+    launch_report_status(config->status_fd, config, result, "error");
+    return -1;
+}
@@ -0,0 +1,118 @@
+#ifndef ZENCUBE_LAUNCHER_H
+#define ZENCUBE_LAUNCHER_H
+
+#include <stdint.h>
+#include "seccomp_filter.h"
+#include "cgroup.h"
+#include "placement.h"
+#include "overlay.h"
+#include "capture.h"
+
+#define LAUNCH_MAX_PATHS 64
+
+// Access granted beneath a path once the file jail is enforced
+typedef enum {
+    LAUNCH_PATH_READ_ONLY,     // Read, list and execute
+    LAUNCH_PATH_READ_WRITE,    // Everything, including create/remove
+    LAUNCH_PATH_DEVICES        // Read/write/ioctl existing files, no create
+} LaunchPathAccess;
+
+typedef struct {
+    char path[4096];
+    LaunchPathAccess access;
+} LaunchPathRule;
+
+// Which CPUs the child runs on
+typedef enum {
+    LAUNCH_PLACE_NONE,         // Inherit the launcher's affinity
+    LAUNCH_PLACE_RUN,          // Lease idle cores (placement_acquire)
+    LAUNCH_PLACE_RESERVED      // The monitoring stack's reserved cores
+} LaunchPlacement;
+
+// What to apply to the child before exec
+typedef struct {
+    char jail_dir[4096];       // Empty = no file jail
+    LaunchPathRule rules[LAUNCH_MAX_PATHS];
+    int rule_count;
+    int jail_best_effort;      // Run unconfined if Landlock is unavailable
+    int cgroup_best_effort;    // Run without the cgroup limits that cannot be applied
+    int status_fd;             // JSON status line before exec (-1 = none)
+    SeccompPolicy seccomp;     // Syscall filter, installed last
+    int seccomp_enabled;
+    char cgroup_parent[4096];  // Run in <parent>/zencube_<pid>; empty = no cgroup
+    CgroupLimits cgroup;
+    unsigned long cpu_seconds; // RLIMIT_CPU budget of the run; 0 = none
+    LaunchPlacement placement_mode;
+    PlacementRequest placement;
+    int overlay_enabled;       // Writes to the jail go to a per-run upper layer
+    OverlayConfig overlay;
+    char capture_path[4096];   // stdout+stderr to this log (capture_start); empty = inherit
+    int capture_passthrough;   // Also tee to the original stdout while it keeps up
+    CapturePolicy capture_policy; // Head/tail retention and rate limit of the log
+} LaunchConfig;
+
+// What was actually enforced
+typedef struct {
+    int landlock_abi;          // 0 if the kernel has no Landlock
+    int landlock_enforced;
+    int rules_applied;
+    int seccomp_rules;         // Distinct rules compiled into the filter
+    int seccomp_insns;         // 0 = no filter
+    int seccomp_depth;
+    char cgroup_path[4096];    // Empty = not in a per-run cgroup
+    char cgroup_error[256];    // First limit (or the cgroup) that failed
+    unsigned long cpu_seconds; // RLIMIT_CPU applied (lowered to the hard limit)
+    PlacementResult placement;
+    OverlayResult overlay;
+    CaptureResult capture;
+    char error[256];
+} LaunchResult;
+
+// Defaults: no jail, no rules, strict, no status fd
+void launch_config_init(LaunchConfig *config);
+
+// Jail directory (read-write) and working directory of the child
+int launch_set_jail(LaunchConfig *config, const char *jail_dir);
+
+// Allow access beneath path (a file or a directory)
+int launch_add_path(LaunchConfig *config, const char *path, LaunchPathAccess access);
+
+// System paths the advisory jail always whitelisted: libraries, binaries
+// and /proc, /sys read-only, /dev for existing devices, /tmp read-write.
+// Missing paths are skipped.
+void launch_add_default_paths(LaunchConfig *config);
+
+// Run in a per-run cgroup under parent (NULL = cgroup_default_parent)
+int launch_use_cgroup(LaunchConfig *config, const char *parent);
+
+// Make the jail ephemeral: the child sees an overlay of it whose writes
+// are discarded with the run (see overlay_enter)
+int launch_use_overlay(LaunchConfig *config);
+
+// Deny socket() for everything but AF_UNIX (see seccomp_policy_add_network_deny)
+int launch_deny_network(LaunchConfig *config);
+
+// Restrict the calling process with a Landlock ruleset built from config.
+// Returns 0 when enforced or (with jail_best_effort) when Landlock is missing.
+int launch_apply_landlock(const LaunchConfig *config, LaunchResult *result);
+
+// Write the status line for result to fd (event is "ready" or "error").
+// The fd is close-on-exec, so the reader sees EOF once exec succeeds; an
+// "error" line after "ready" means exec itself failed.
+void launch_report_status(int fd, const LaunchConfig *config, const LaunchResult *result, const char *event);
+
+// Enter the jail and apply Landlock and seccomp to the calling process
+// without exec (for long-lived templates whose children inherit them)
+int launch_restrict(const LaunchConfig *config, LaunchResult *result);
+
+// Apply every restriction, report status and exec argv[0] (PATH search).
+// Output capture starts first, outside the run's cgroup. The cgroup is
+// entered next, while /sys is still writable, and the run placed on its
+// CPUs (never fatal), then the overlay mounted. The seccomp filter is
+// compiled before and installed after Landlock, so it only has to allow
+// what exec itself needs. The CPU time budget is set last, after the
+// capture process has forked.
+// Returns only on failure, with result->error set.
+int launch_exec(const LaunchConfig *config, char *const argv[], LaunchResult *result);
+
+#endif // ZENCUBE_LAUNCHER_H
@@ -0,0 +1,284 @@
+#include "launcher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--jail <dir>] [options] [--] <command> [args...]\n", prog);
+    fprintf(stderr, "       %s --rebalance [--reserve-cores N] [--placement-dir D]\n", prog);
+    fprintf(stderr, "       %s --reserve-pid PID [--reserve-cores N]\n", prog);
+    fprintf(stderr, "       %s --overlay-usage PID | --overlay-release PID [--overlay-dir D]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --jail DIR         Confine file access to DIR (read-write) plus system\n");
+    fprintf(stderr, "                     paths, enforced by Landlock; also the working directory\n");
+    fprintf(stderr, "  --ro PATH          Also allow read/execute beneath PATH (repeatable)\n");
+    fprintf(stderr, "  --rw PATH          Also allow full access beneath PATH (repeatable)\n");
+    fprintf(stderr, "  --no-default-paths Do not allow library, binary, /proc, /sys, /dev and /tmp\n");
+    fprintf(stderr, "  --jail-best-effort Run unconfined if the kernel lacks Landlock\n");
+    fprintf(stderr, "  --status-fd FD     Write a JSON status line to FD before exec\n");
+    fprintf(stderr, "  --no-net           Deny sockets other than AF_UNIX (seccomp)\n");
+    fprintf(stderr, "  --seccomp-deny L   Fail the comma-separated syscalls in L with EPERM\n");
+    fprintf(stderr, "  --seccomp-kill L   Kill the process on any syscall in L\n");
+    fprintf(stderr, "  --seccomp-allow L  Allow only the syscalls in L (plus execve); others\n");
+    fprintf(stderr, "                     fail with EPERM\n");
+    fprintf(stderr, "  --cgroup-parent D  Run in a new cgroup under D (default <cgroup2>/zencube\n");
+    fprintf(stderr, "                     when a limit below is set)\n");
+    fprintf(stderr, "  --cpu-max PERCENT  CPU bandwidth limit, 100 = one CPU (cpu.max)\n");
+    fprintf(stderr, "  --memory-max MB    Memory limit (memory.max; memory.high at 90%%)\n");
+    fprintf(stderr, "  --memory-high MB   Memory throttle point (memory.high)\n");
+    fprintf(stderr, "  --pids-max N       Task limit (pids.max)\n");
+    fprintf(stderr, "  --io-max BPS       Read and write bytes/s on the working directory's disk\n");
+    fprintf(stderr, "  --cgroup-best-effort\n");
+    fprintf(stderr, "                     Run without the cgroup or limits that cannot be applied\n");
+    fprintf(stderr, "  --best-effort      Both --jail-best-effort and --cgroup-best-effort\n");
+    fprintf(stderr, "  --cpu-seconds N    CPU time budget (RLIMIT_CPU): SIGXCPU after N seconds\n");
+    fprintf(stderr, "  --cores N          Run on N idle physical cores, leased so concurrent runs\n");
+    fprintf(stderr, "                     get different ones (SMT siblings and NUMA aware)\n");
+    fprintf(stderr, "  --reserved         Run on the cores reserved for the monitoring stack\n");
+    fprintf(stderr, "  --reserve-pid P    Move every thread of running process P onto the\n");
+    fprintf(stderr, "                     reserved cores and print them (no command)\n");
+    fprintf(stderr, "  --reserve-cores N  Leading cores kept off-limits to runs (default 1)\n");
+    fprintf(stderr, "  --placement-dir D  Lease directory shared by all launchers\n");
+    fprintf(stderr, "  --sysfs-root DIR   Read the CPU topology from DIR instead of /sys\n");
+    fprintf(stderr, "  --rebalance        Drop finished runs' leases, move runs sharing cores onto\n");
+    fprintf(stderr, "                     freed ones and print the result (no command)\n");
+    fprintf(stderr, "  --overlay          Mount an overlay on the jail in a private mount namespace;\n");
+    fprintf(stderr, "                     writes go to a per-run upper layer and other processes\n");
+    fprintf(stderr, "                     keep seeing the unchanged jail\n");
+    fprintf(stderr, "  --overlay-upper U  tmpfs (default; gone with the run) or dir (kept under\n");
+    fprintf(stderr, "                     the overlay directory until released)\n");
+    fprintf(stderr, "  --overlay-size MB  Size of the tmpfs upper layer (default: half of RAM)\n");
+    fprintf(stderr, "  --overlay-dir D    Per-run directories (default $XDG_RUNTIME_DIR/zencube/overlay)\n");
+    fprintf(stderr, "  --overlay-usage P  Print the bytes run P has written to its upper layer\n");
+    fprintf(stderr, "  --overlay-release P  Discard run P's upper layer in the background\n");
+    fprintf(stderr, "  --capture FILE     Send stdout and stderr to FILE through a splice()ing\n");
+    fprintf(stderr, "                     capture process; progress in FILE.head (see README)\n");
+    fprintf(stderr, "  --capture-passthrough  Also tee output to our stdout while its reader keeps up\n");
+    fprintf(stderr, "  --capture-head MB  Keep only the first MB of output in the log ...\n");
+    fprintf(stderr, "  --capture-tail MB  ... and the last MB; the middle is dropped with a marker\n");
+    fprintf(stderr, "  --capture-rate MB  Hold the command to MB/s of output (its writes block)\n");
+    fprintf(stderr, "  --help             Show this help\n");
+    fprintf(stderr, "\nExits with 126 if the jail or cgroup cannot be applied and 127 if exec fails.\n");
+}
+
+int main(int argc, char **argv) {
+    LaunchConfig config;
+    launch_config_init(&config);
+    const char *jail_dir = NULL;
+    int default_paths = 1;
+    const char *cgroup_parent = NULL;
+    int cgroup_limited = 0;
+    int rebalance = 0;
+    pid_t reserve_pid = 0;
+    int overlay = 0;
+    pid_t overlay_usage_pid = 0;
+    pid_t overlay_release_pid = 0;
+    
+    static struct option long_options[] = {
+        {"jail",             required_argument, 0, 'j'},
+        {"ro",               required_argument, 0, 'r'},
+        {"rw",               required_argument, 0, 'w'},
+        {"no-default-paths", no_argument,       0, 'n'},
+        {"jail-best-effort", no_argument,       0, 'J'},
+        {"cgroup-best-effort", no_argument,     0, 'g'},
+        {"best-effort",      no_argument,       0, 'b'},
+        {"status-fd",        required_argument, 0, 's'},
+        {"no-net",           no_argument,       0, 'N'},
+        {"seccomp-deny",     required_argument, 0, 'D'},
+        {"seccomp-kill",     required_argument, 0, 'K'},
+        {"seccomp-allow",    required_argument, 0, 'A'},
+        {"cgroup-parent",    required_argument, 0, 'G'},
+        {"cpu-max",          required_argument, 0, 'C'},
+        {"memory-max",       required_argument, 0, 'M'},
+        {"memory-high",      required_argument, 0, 'H'},
+        {"pids-max",         required_argument, 0, 'P'},
+        {"io-max",           required_argument, 0, 'I'},
+        {"cpu-seconds",      required_argument, 0, 't'},
+        {"cores",            required_argument, 0, 'c'},
+        {"reserved",         no_argument,       0, 'R'},
+        {"reserve-pid",      required_argument, 0, 'V'},
+        {"reserve-cores",    required_argument, 0, 'e'},
+        {"placement-dir",    required_argument, 0, 'd'},
+        {"sysfs-root",       required_argument, 0, 'y'},
+        {"rebalance",        no_argument,       0, 'B'},
+        {"overlay",          no_argument,       0, 'O'},
+        {"overlay-upper",    required_argument, 0, 'u'},
+        {"overlay-size",     required_argument, 0, 'z'},
+        {"overlay-dir",      required_argument, 0, 'o'},
+        {"overlay-usage",    required_argument, 0, 'U'},
+        {"overlay-release",  required_argument, 0, 'X'},
+        {"capture",          required_argument, 0, 'L'},
+        {"capture-passthrough", no_argument,    0, 'T'},
+        {"capture-head",     required_argument, 0, 'F'},
+        {"capture-tail",     required_argument, 0, 'Z'},
+        {"capture-rate",     required_argument, 0, 'Q'},
+        {"help",             no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    // '+' stops at the command so its own options are left alone
+    int opt;
+    while ((opt = getopt_long(argc, argv, "+j:r:w:nJgbs:ND:K:A:G:C:M:H:P:I:t:c:RV:e:d:y:BOu:z:o:U:X:L:TF:Z:Q:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'j': jail_dir = optarg; break;
+            case 'r': launch_add_path(&config, optarg, LAUNCH_PATH_READ_ONLY); break;
+            case 'w': launch_add_path(&config, optarg, LAUNCH_PATH_READ_WRITE); break;
+            case 'n': default_paths = 0; break;
+            case 'J': config.jail_best_effort = 1; break;
+            case 'g': config.cgroup_best_effort = 1; break;
+            case 'b':
+                config.jail_best_effort = 1;
+                config.cgroup_best_effort = 1;
+                break;
+            case 's': config.status_fd = atoi(optarg); break;
+            case 'N':
+                launch_deny_network(&config);
+                break;
+            case 'D':
+            case 'K':
+            case 'A': {
+                uint32_t action = opt == 'D' ? seccomp_action_errno(EPERM) :
+                                  opt == 'K' ? seccomp_action_kill() : seccomp_action_allow();
+                if (opt == 'A') {
+                    // Allowlist: everything else fails, but the exec must succeed
+                    config.seccomp.default_action = seccomp_action_errno(EPERM);
+                    seccomp_policy_add_list(&config.seccomp, "execve", action);
+                }
+                if (seccomp_policy_add_list(&config.seccomp, optarg, action) != 0) {
+                    return 1;
+                }
+                config.seccomp_enabled = 1;
+                break;
+            }
+            case 'G': cgroup_parent = optarg; break;
+            case 'C': config.cgroup.cpu_max_percent = atof(optarg); cgroup_limited = 1; break;
+            case 'M': config.cgroup.memory_max_mb = atol(optarg); cgroup_limited = 1; break;
+            case 'H': config.cgroup.memory_high_mb = atol(optarg); cgroup_limited = 1; break;
+            case 'P': config.cgroup.pids_max = atol(optarg); cgroup_limited = 1; break;
+            case 'I': config.cgroup.io_max_bps = atol(optarg); cgroup_limited = 1; break;
+            case 't': config.cpu_seconds = strtoul(optarg, NULL, 10); break;
+            case 'c':
+                config.placement_mode = LAUNCH_PLACE_RUN;
+                config.placement.cores = atoi(optarg);
+                break;
+            case 'R': config.placement_mode = LAUNCH_PLACE_RESERVED; break;
+            case 'e': config.placement.reserve_cores = atoi(optarg); break;
+            case 'd':
+                snprintf(config.placement.dir, sizeof(config.placement.dir), "%s", optarg);
+                break;
+            case 'y':
+                snprintf(config.placement.sysfs_root, sizeof(config.placement.sysfs_root), "%s", optarg);
+                break;
+            case 'V': reserve_pid = (pid_t)atoi(optarg); break;
+            case 'B': rebalance = 1; break;
+            case 'O': overlay = 1; break;
+            case 'u':
+                if (strcmp(optarg, "tmpfs") == 0) config.overlay.upper = OVERLAY_UPPER_TMPFS;
+                else if (strcmp(optarg, "dir") == 0) config.overlay.upper = OVERLAY_UPPER_DIR;
+                else {
+                    fprintf(stderr, "Error: --overlay-upper must be tmpfs or dir\n");
+                    return 1;
+                }
+                break;
+            case 'z': config.overlay.tmpfs_size_mb = atol(optarg); break;
+            case 'o':
+                snprintf(config.overlay.runs_dir, sizeof(config.overlay.runs_dir), "%s", optarg);
+                break;
+            case 'U': overlay_usage_pid = (pid_t)atoi(optarg); break;
+            case 'X': overlay_release_pid = (pid_t)atoi(optarg); break;
+            case 'L': snprintf(config.capture_path, sizeof(config.capture_path), "%s", optarg); break;
+            case 'T': config.capture_passthrough = 1; break;
+            case 'F': config.capture_policy.head_bytes = (uint64_t)(atof(optarg) * 1024 * 1024); break;
+            case 'Z': config.capture_policy.tail_bytes = (uint64_t)(atof(optarg) * 1024 * 1024); break;
+            case 'Q': config.capture_policy.rate_bytes = (uint64_t)(atof(optarg) * 1024 * 1024); break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    if (rebalance) {
+        PlacementResult placed;
+        if (placement_rebalance(&config.placement, &placed) != 0) {
+            fprintf(stderr, "Error: %s\n", placed.error);
+            return 1;
+        }
+        printf("{\"event\":\"rebalance\",\"moved\":%d}\n", placed.moved);
+        return 0;
+    }
+    
+    if (reserve_pid > 0) {
+        PlacementResult placed;
+        if (placement_reserve(&config.placement, reserve_pid, &placed) != 0) {
+            fprintf(stderr, "Error: %s\n", placed.error);
+            return 1;
+        }
+        char cpus[1024];
+        placement_format_cpus(placed.cpus, placed.cpu_count, cpus, sizeof(cpus));
+        printf("{\"event\":\"reserve\",\"pid\":%d,\"cpus\":\"%s\"}\n", (int)reserve_pid, cpus);
+        return 0;
+    }
+    
+    if (overlay_usage_pid > 0) {
+        uint64_t bytes;
+        if (overlay_usage(&config.overlay, overlay_usage_pid, &bytes) != 0) {
+            fprintf(stderr, "Error: No overlay for run %d: %s\n", (int)overlay_usage_pid, strerror(errno));
+            return 1;
+        }
+        printf("{\"event\":\"overlay_usage\",\"pid\":%d,\"bytes\":%llu}\n", (int)overlay_usage_pid,
+               (unsigned long long)bytes);
+        return 0;
+    }
+    if (overlay_release_pid > 0) {
+        if (overlay_release(&config.overlay, overlay_release_pid) != 0) {
+            fprintf(stderr, "Error: Cannot release run %d: %s\n", (int)overlay_release_pid, strerror(errno));
+            return 1;
+        }
+        printf("{\"event\":\"overlay_release\",\"pid\":%d}\n", (int)overlay_release_pid);
+        return 0;
+    }
+    
+    if (optind >= argc) {
+        fprintf(stderr, "Error: Missing command\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    char **command = &argv[optind];
+    
+    if (jail_dir) {
+        if (launch_set_jail(&config, jail_dir) != 0) {
+            fprintf(stderr, "Error: Cannot use jail directory %s\n", jail_dir);
+            return 126;
+        }
+        if (default_paths) {
+            launch_add_default_paths(&config);
+        }
+        
+        // The chosen program may live outside the jail; allow just that file
+        if (strchr(command[0], '/')) {
+            launch_add_path(&config, command[0], LAUNCH_PATH_READ_ONLY);
+        }
+        if (overlay) {
+            launch_use_overlay(&config);
+        }
+    } else if (overlay) {
+        fprintf(stderr, "Error: --overlay needs --jail\n");
+        return 1;
+    }
+    
+    if (cgroup_parent || cgroup_limited) {
+        if (launch_use_cgroup(&config, cgroup_parent) != 0 && !config.cgroup_best_effort) {
+            fprintf(stderr, "Error: No cgroup v2 hierarchy mounted\n");
+            return 126;
+        }
+    }
+    
+    LaunchResult result;
+    launch_exec(&config, command, &result);
+    
+    fprintf(stderr, "zencube_launch: %s\n", result.error);
+    return strncmp(result.error, "exec ", 5) == 0 ? 127 : 126;
+}
@@ -5,10 +5,10 @@
 #include <time.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <zlib.h>
 
-#define TEMP_SUFFIX ".tmp"
 #define GZ_SUFFIX ".gz"
 
 // Get ISO 8601 UTC timestamp
@@ -18,44 +18,149 @@ void get_iso_timestamp(char *buffer, size_t size) {
     strftime(buffer, size, "%Y-%m-%dT%H:%M:%SZ", tm_utc);
 }
 
-// Append JSON line to file atomically
+// Append JSON line to file in place. The line is emitted with a single
+// O_APPEND write, so readers holding the file open (the monitoring worker
+// tails it with one long-lived fd) only ever see it grow.
 int append_jsonl(const char *path, const char *json_string) {
-    char temp_path[1024];
-    snprintf(temp_path, sizeof(temp_path), "%s%s", path, TEMP_SUFFIX);
-    
-    // Read existing content if file exists
-    FILE *existing = fopen(path, "r");
-    FILE *temp = fopen(temp_path, "w");
-    if (!temp) {
-        perror("fopen temp");
-        if (existing) fclose(existing);
+    size_t len = strlen(json_string);
+    char *line = malloc(len + 1);
+    if (!line) return -1;
+    
+    memcpy(line, json_string, len);
+    line[len] = '\n';
+    
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        perror("open");
+        free(line);
         return -1;
     }
     
-    // Copy existing lines
-    if (existing) {
-        char line[4096];
-        while (fgets(line, sizeof(line), existing)) {
-            fputs(line, temp);
-        }
-        fclose(existing);
-    }
+    ssize_t written = write(fd, line, len + 1);
+    close(fd);
+    free(line);
     
-    // Append new line
-    fprintf(temp, "%s\n", json_string);
-    fflush(temp);
-    fsync(fileno(temp));
-    fclose(temp);
+    if (written != (ssize_t)(len + 1)) {
+        perror("write");
+        return -1;
+    }
     
-    // Atomic rename
-    if (rename(temp_path, path) != 0) {
-        perror("rename");
+    return 0;
+}
+
+// Start tailing a JSONL file
+void jsonl_tail_init(JsonlTail *tail, const char *path) {
+    memset(tail, 0, sizeof(JsonlTail));
+    snprintf(tail->path, sizeof(tail->path), "%s", path);
+    tail->fd = -1;
+}
+
+// (Re)open the tailed file if needed; returns 0 when an fd is usable
+static int jsonl_tail_open(JsonlTail *tail) {
+    struct stat st;
+    if (stat(tail->path, &st) != 0) {
         return -1;
     }
     
+    // Rotated or replaced: drop the old fd and start over
+    if (tail->fd >= 0 && (st.st_dev != tail->dev || st.st_ino != tail->ino)) {
+        close(tail->fd);
+        tail->fd = -1;
+    }
+    
+    if (tail->fd < 0) {
+        tail->fd = open(tail->path, O_RDONLY | O_CLOEXEC);
+        if (tail->fd < 0) return -1;
+        tail->dev = st.st_dev;
+        tail->ino = st.st_ino;
+        tail->offset = 0;
+        tail->partial_len = 0;
+    } else if (st.st_size < tail->offset) {
+        // Truncated in place
+        tail->offset = 0;
+        tail->partial_len = 0;
+    }
+    
     return 0;
 }
 
+// Read newly appended bytes and emit complete lines
+int jsonl_tail_poll(JsonlTail *tail, JsonlLineCallback cb, void *ctx) {
+    if (jsonl_tail_open(tail) != 0) {
+        return -1;
+    }
+    
+    char buffer[65536];
+    int lines = 0;
+    
+    for (;;) {
+        ssize_t n = pread(tail->fd, buffer, sizeof(buffer), tail->offset);
+        if (n <= 0) break;
+        tail->offset += n;
+        
+        char *start = buffer;
+        char *end = buffer + n;
+        char *nl;
+        while ((nl = memchr(start, '\n', (size_t)(end - start))) != NULL) {
+            size_t len = (size_t)(nl - start);
+            
+            if (tail->partial_len > 0) {
+                // Complete the line carried over from the previous read
+                if (tail->partial_len + len + 1 > tail->partial_cap) {
+                    size_t cap = tail->partial_len + len + 1;
+                    char *grown = realloc(tail->partial, cap);
+                    if (!grown) return -1;
+                    tail->partial = grown;
+                    tail->partial_cap = cap;
+                }
+                memcpy(tail->partial + tail->partial_len, start, len);
+                tail->partial[tail->partial_len + len] = '\0';
+                tail->partial_len = 0;
+                if (tail->partial[0] != '\0') {
+                    cb(tail->partial, ctx);
+                    lines++;
+                }
+            } else if (len > 0) {
+                *nl = '\0';
+                cb(start, ctx);
+                lines++;
+            }
+            
+            start = nl + 1;
+        }
+        
+        // Keep the unterminated remainder for the next read
+        size_t rest = (size_t)(end - start);
+        if (rest > 0) {
+            if (tail->partial_len + rest + 1 > tail->partial_cap) {
+                size_t cap = (tail->partial_len + rest + 1) * 2;
+                char *grown = realloc(tail->partial, cap);
+                if (!grown) return -1;
+                tail->partial = grown;
+                tail->partial_cap = cap;
+            }
+            memcpy(tail->partial + tail->partial_len, start, rest);
+            tail->partial_len += rest;
+        }
+        
+        if ((size_t)n < sizeof(buffer)) break;
+    }
+    
+    return lines;
+}
+
+// Release tail resources
+void jsonl_tail_close(JsonlTail *tail) {
+    if (tail->fd >= 0) {
+        close(tail->fd);
+        tail->fd = -1;
+    }
+    free(tail->partial);
+    tail->partial = NULL;
+    tail->partial_len = 0;
+    tail->partial_cap = 0;
+}
+
 // Build log path from run_id
 void build_log_path(char *buffer, size_t size, const char *log_dir, const char *run_id) {
     snprintf(buffer, size, "%s/%s.jsonl", log_dir, run_id);
@@ -2,10 +2,37 @@
 #define ZENCUBE_LOGUTIL_H
 
 #include <stdio.h>
+#include <sys/types.h>
 
-// Append JSON line to file (atomic)
+// Incremental JSONL reader. Keeps one fd and the byte offset of the first
+// unread line, so each poll only reads and parses what was appended since
+// the last one. A replaced or truncated file is reopened from the start.
+typedef struct {
+    char path[4096];
+    int fd;
+    dev_t dev;
+    ino_t ino;
+    off_t offset;
+    char *partial;             // Trailing bytes without a newline yet
+    size_t partial_len;
+    size_t partial_cap;
+} JsonlTail;
+
+typedef void (*JsonlLineCallback)(const char *line, void *ctx);
+
+// Append JSON line to file (single O_APPEND write)
 int append_jsonl(const char *path, const char *json_string);
 
+// Start tailing path (the file need not exist yet)
+void jsonl_tail_init(JsonlTail *tail, const char *path);
+
+// Invoke cb for every complete line appended since the last poll.
+// Returns the number of lines, or -1 if the file does not exist.
+int jsonl_tail_poll(JsonlTail *tail, JsonlLineCallback cb, void *ctx);
+
+// Release the fd and buffers
+void jsonl_tail_close(JsonlTail *tail);
+
 // Rotate logs keeping last N files
 int rotate_logs(const char *log_dir, const char *pattern, int keep_count, int compress);
 
@@ -0,0 +1,250 @@
+#include "mapgrowth.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <time.h>
+
+#define READ_CHUNK 65536
+#define DEFAULT_MAX_DUTY 0.01  // Scans may take 1% of wall time
+
+// The mapping being parsed
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint64_t inode;
+    uint64_t rss;
+    uint64_t pss;
+    char name[256];
+    int valid;
+} CurrentMap;
+
+// Parse state carried across read chunks
+typedef struct {
+    MapGrowthTracker *tracker;
+    MapEntry *entries;         // This scan, becomes the previous one
+    size_t count;
+    size_t capacity;
+    CurrentMap map;
+    int failed;
+} ScanState;
+
+static double monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static size_t hash_key(uint64_t start, uint64_t inode) {
+    uint64_t h = (start ^ (inode * 0x9e3779b97f4a7c15ULL)) * 0xff51afd7ed558ccdULL;
+    return (size_t)(h ^ (h >> 33));
+}
+
+// by_end selects the second table, keyed by end address
+static const MapEntry* find_previous(const MapGrowthTracker *tracker, int by_end,
+                                     uint64_t address, uint64_t inode) {
+    if (tracker->slot_capacity == 0) return NULL;
+    const uint32_t *slots = tracker->slots + (by_end ? tracker->slot_capacity : 0);
+    size_t mask = tracker->slot_capacity - 1;
+    for (size_t i = hash_key(address, inode) & mask; slots[i]; i = (i + 1) & mask) {
+        const MapEntry *entry = &tracker->entries[slots[i] - 1];
+        if ((by_end ? entry->end : entry->start) == address && entry->inode == inode) return entry;
+    }
+    return NULL;
+}
+
+// Index the finished scan for the next diff (load factor <= 1/2)
+static int build_index(MapGrowthTracker *tracker) {
+    size_t capacity = 16;
+    while (capacity < tracker->count * 2) capacity *= 2;
+    if (capacity != tracker->slot_capacity) {
+        uint32_t *slots = realloc(tracker->slots, sizeof(uint32_t) * capacity * 2);
+        if (!slots) return -1;
+        tracker->slots = slots;
+        tracker->slot_capacity = capacity;
+    }
+    memset(tracker->slots, 0, sizeof(uint32_t) * capacity * 2);
+    
+    size_t mask = capacity - 1;
+    for (int by_end = 0; by_end <= 1; by_end++) {
+        uint32_t *slots = tracker->slots + (by_end ? capacity : 0);
+        for (size_t e = 0; e < tracker->count; e++) {
+            const MapEntry *entry = &tracker->entries[e];
+            size_t i = hash_key(by_end ? entry->end : entry->start, entry->inode) & mask;
+            while (slots[i]) i = (i + 1) & mask;
+            slots[i] = (uint32_t)(e + 1);
+        }
+    }
+    return 0;
+}
+
+// Keep the top_n growers by Rss, largest first
+static void offer_grower(MapGrowthTracker *tracker, const CurrentMap *map, int64_t rss_delta, int64_t pss_delta) {
+    if (rss_delta <= 0) return;
+    int n = tracker->top_count;
+    if (n == tracker->top_n && tracker->top[n - 1].rss_delta >= rss_delta) return;
+    
+    int at = n < tracker->top_n ? n : n - 1;
+    while (at > 0 && tracker->top[at - 1].rss_delta < rss_delta) {
+        tracker->top[at] = tracker->top[at - 1];
+        at--;
+    }
+    MapGrowth *slot = &tracker->top[at];
+    memcpy(slot->name, map->name, sizeof(slot->name));
+    slot->start = map->start;
+    slot->end = map->end;
+    slot->inode = map->inode;
+    slot->rss = map->rss;
+    slot->pss = map->pss;
+    slot->rss_delta = rss_delta;
+    slot->pss_delta = pss_delta;
+    if (n < tracker->top_n) tracker->top_count++;
+}
+
+// A mapping's fields are complete: record it and diff it
+static void finish_map(ScanState *scan) {
+    CurrentMap *map = &scan->map;
+    if (!map->valid) return;
+    map->valid = 0;
+    
+    if (scan->count == scan->capacity) {
+        size_t capacity = scan->capacity ? scan->capacity * 2 : 1024;
+        MapEntry *grown = realloc(scan->entries, sizeof(MapEntry) * capacity);
+        if (!grown) {
+            scan->failed = 1;
+            return;
+        }
+        scan->entries = grown;
+        scan->capacity = capacity;
+    }
+    scan->entries[scan->count++] = (MapEntry){ map->start, map->end, map->inode, map->rss, map->pss };
+    
+    MapGrowthTracker *tracker = scan->tracker;
+    if (!tracker->primed) return;
+    const MapEntry *previous = find_previous(tracker, 0, map->start, map->inode);
+    if (!previous) previous = find_previous(tracker, 1, map->end, map->inode);
+    int64_t rss_delta = (int64_t)map->rss - (previous ? (int64_t)previous->rss : 0);
+    int64_t pss_delta = (int64_t)map->pss - (previous ? (int64_t)previous->pss : 0);
+    offer_grower(tracker, map, rss_delta, pss_delta);
+}
+
+// "start-end perms offset dev inode [path]" starts a mapping; "Rss: N kB"
+// and "Pss: N kB" are the fields kept from the lines that follow
+static void parse_line(ScanState *scan, char *line) {
+    if (strncmp(line, "Rss:", 4) == 0) {
+        sscanf(line + 4, "%" SCNu64, &scan->map.rss);
+        scan->map.rss *= 1024;
+        return;
+    }
+    if (strncmp(line, "Pss:", 4) == 0) {
+        sscanf(line + 4, "%" SCNu64, &scan->map.pss);
+        scan->map.pss *= 1024;
+        return;
+    }
+    
+    uint64_t start, end, inode;
+    int name_at = 0;
+    if (sscanf(line, "%" SCNx64 "-%" SCNx64 " %*s %*x %*x:%*x %" SCNu64 " %n",
+               &start, &end, &inode, &name_at) != 3 || name_at == 0) {
+        return;   // Another field line
+    }
+    
+    finish_map(scan);
+    CurrentMap *map = &scan->map;
+    memset(map, 0, sizeof(*map));
+    map->start = start;
+    map->end = end;
+    map->inode = inode;
+    map->valid = 1;
+    
+    const char *name = line + name_at;
+    size_t len = strlen(name);
+    if (len == 0) {
+        snprintf(map->name, sizeof(map->name), "[anon]");
+    } else if (len < sizeof(map->name)) {
+        memcpy(map->name, name, len + 1);
+    } else {
+        // Keep the end of a long path: the file name says the most
+        snprintf(map->name, sizeof(map->name), "...%s", name + len - (sizeof(map->name) - 4));
+    }
+}
+
+void mapgrowth_init(MapGrowthTracker *tracker, int top_n, double min_interval_s) {
+    memset(tracker, 0, sizeof(*tracker));
+    if (top_n < 1) top_n = 1;
+    if (top_n > MAPGROWTH_MAX_TOP) top_n = MAPGROWTH_MAX_TOP;
+    tracker->top_n = top_n;
+    tracker->min_interval_ms = min_interval_s * 1000.0;
+    tracker->max_duty = DEFAULT_MAX_DUTY;
+}
+
+int mapgrowth_due(const MapGrowthTracker *tracker) {
+    return monotonic_ms() >= tracker->next_due_ms;
+}
+
+int mapgrowth_scan(MapGrowthTracker *tracker, int pid) {
+    double started = monotonic_ms();
+    tracker->top_count = 0;
+    
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/smaps", pid);
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    
+    // Stream in chunks; a line split across reads is carried over
+    ScanState scan = { .tracker = tracker };
+    char *buf = malloc(READ_CHUNK + 1);
+    if (!buf) {
+        close(fd);
+        return -1;
+    }
+    size_t carry = 0;
+    ssize_t n;
+    while ((n = read(fd, buf + carry, READ_CHUNK - carry)) > 0) {
+        size_t len = carry + (size_t)n;
+        buf[len] = '\0';
+        char *line = buf;
+        char *newline;
+        while ((newline = memchr(line, '\n', len - (size_t)(line - buf))) != NULL) {
+            *newline = '\0';
+            parse_line(&scan, line);
+            line = newline + 1;
+        }
+        carry = len - (size_t)(line - buf);
+        if (carry == READ_CHUNK) carry = 0;   // Overlong line: drop it
+        memmove(buf, line, carry);
+    }
+    close(fd);
+    free(buf);
+    finish_map(&scan);
+    
+    if (n < 0 || scan.failed) {
+        free(scan.entries);
+        tracker->top_count = 0;
+        return -1;
+    }
+    
+    free(tracker->entries);
+    tracker->entries = scan.entries;
+    tracker->count = scan.count;
+    tracker->capacity = scan.capacity;
+    tracker->mappings = scan.count;
+    tracker->primed = build_index(tracker) == 0;
+    
+    double now = monotonic_ms();
+    tracker->scan_ms = now - started;
+    double spacing = tracker->scan_ms / tracker->max_duty;
+    tracker->next_due_ms = now + (spacing > tracker->min_interval_ms ? spacing : tracker->min_interval_ms);
+    return tracker->top_count;
+}
+
+void mapgrowth_cleanup(MapGrowthTracker *tracker) {
+    free(tracker->entries);
+    free(tracker->slots);
+    tracker->entries = NULL;
+    tracker->slots = NULL;
+    tracker->count = tracker->capacity = tracker->slot_capacity = 0;
+    tracker->primed = 0;
+}
@@ -0,0 +1,65 @@
+#ifndef ZENCUBE_MAPGROWTH_H
+#define ZENCUBE_MAPGROWTH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAPGROWTH_MAX_TOP 32
+
+// One mapping that grew since the previous scan
+typedef struct {
+    char name[256];            // Path, [heap], [stack], [anon:...] or [anon]
+    uint64_t start;
+    uint64_t end;
+    uint64_t inode;
+    uint64_t rss;              // Bytes now
+    uint64_t pss;
+    int64_t rss_delta;         // Since the previous scan (new mappings: all of it)
+    int64_t pss_delta;
+} MapGrowth;
+
+// A mapping of the previous scan, found again by start address and inode
+// or, failing that, by end address and inode: a heap grows up from a fixed
+// start, while adjacent anonymous mmaps merge into a region growing down
+// from a fixed end.
+typedef struct {
+    uint64_t start;
+    uint64_t end;
+    uint64_t inode;
+    uint64_t rss;
+    uint64_t pss;
+} MapEntry;
+
+// Per-target state of the smaps collector
+typedef struct {
+    int top_n;                 // Growers reported per scan
+    double min_interval_ms;    // At most one scan per interval...
+    double max_duty;           // ...and at most this fraction of wall time
+    double next_due_ms;        // CLOCK_MONOTONIC
+    int primed;                // A previous scan exists
+    MapEntry *entries;         // Previous scan
+    size_t count;
+    size_t capacity;
+    uint32_t *slots;           // Open-addressed by start, then by end; 0 = empty
+    size_t slot_capacity;      // Per key
+    MapGrowth top[MAPGROWTH_MAX_TOP];
+    int top_count;             // Valid after a scan
+    size_t mappings;           // Mappings in the last scan
+    double scan_ms;            // Cost of the last scan
+} MapGrowthTracker;
+
+void mapgrowth_init(MapGrowthTracker *tracker, int top_n, double min_interval_s);
+
+// Whether a scan is allowed now. Slow scans (tens of thousands of
+// mappings) push the next one back so the collector's share of time stays
+// under max_duty.
+int mapgrowth_due(const MapGrowthTracker *tracker);
+
+// Stream /proc/<pid>/smaps, diff it against the previous scan and keep the
+// top growers in tracker->top. The first scan only primes (top_count 0).
+// Returns the number of growers, or -1 if smaps cannot be read.
+int mapgrowth_scan(MapGrowthTracker *tracker, int pid);
+
+void mapgrowth_cleanup(MapGrowthTracker *tracker);
+
+#endif // ZENCUBE_MAPGROWTH_H
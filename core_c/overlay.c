@@ -0,0 +1,272 @@
+#include "overlay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/magic.h>
+
+// Trash older than this has lost its deleter (e.g. to a reboot or kill)
+#define OVERLAY_TRASH_STALE_SEC 60
+
+void overlay_config_init(OverlayConfig *config) {
+    memset(config, 0, sizeof(OverlayConfig));
+    config->upper = OVERLAY_UPPER_TMPFS;
+    
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0]) {
+        snprintf(config->runs_dir, sizeof(config->runs_dir), "%s/zencube/overlay", runtime);
+    } else {
+        snprintf(config->runs_dir, sizeof(config->runs_dir), "/tmp/zencube_overlay_%d", (int)getuid());
+    }
+}
+
+static int mkdir_p(const char *path, mode_t mode) {
+    char buf[4096];
+    snprintf(buf, sizeof(buf), "%s", path);
+    for (char *p = buf + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(buf, mode) != 0 && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return mkdir(buf, mode) != 0 && errno != EEXIST ? -1 : 0;
+}
+
+static void run_dir_path(const OverlayConfig *config, pid_t pid, char *out, size_t size) {
+    snprintf(out, size, "%.4000s/run_%d", config->runs_dir, (int)pid);
+}
+
+// Delete name beneath dirfd without following symlinks
+static void remove_tree(int dirfd, const char *name) {
+    if (unlinkat(dirfd, name, 0) == 0 || (errno != EISDIR && errno != EPERM)) return;
+    
+    int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) return;
+    fchmod(fd, 0700);   // The run may have left read-only directories
+    DIR *dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        remove_tree(fd, entry->d_name);
+    }
+    closedir(dir);
+    unlinkat(dirfd, name, AT_REMOVEDIR);
+}
+
+// Delete path from a grandchild the caller never waits for, so teardown
+// costs the caller one fork whatever the size of the tree
+static void remove_in_background(const char *path) {
+    pid_t child = fork();
+    if (child < 0) {
+        remove_tree(AT_FDCWD, path);
+        return;
+    }
+    if (child == 0) {
+        if (fork() == 0) {
+            // Drop inherited pipes and status fds: their readers wait for EOF
+            setsid();
+            syscall(SYS_close_range, 0U, ~0U, 0U);
+            int null = open("/dev/null", O_RDWR);
+            if (null == 0) {
+                dup2(null, 1);
+                dup2(null, 2);
+            }
+            remove_tree(AT_FDCWD, path);
+        }
+        _exit(0);
+    }
+    waitpid(child, NULL, 0);
+}
+
+int overlay_release(const OverlayConfig *config, pid_t pid) {
+    char run_dir[4096], trash[4096];
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    run_dir_path(config, pid, run_dir, sizeof(run_dir));
+    snprintf(trash, sizeof(trash), "%.4000s/.trash_%d_%ld%09ld", config->runs_dir, (int)pid,
+             (long)now.tv_sec, now.tv_nsec);
+    
+    if (rename(run_dir, trash) != 0) {
+        return errno == ENOENT ? 0 : -1;
+    }
+    remove_in_background(trash);
+    return 0;
+}
+
+int overlay_sweep(const OverlayConfig *config) {
+    DIR *dir = opendir(config->runs_dir);
+    if (!dir) return 0;
+    
+    int released = 0;
+    time_t now = time(NULL);
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        int pid;
+        char rest;
+        if (sscanf(entry->d_name, "run_%d%c", &pid, &rest) == 1 && pid > 0) {
+            if (kill(pid, 0) != 0 && errno == ESRCH && overlay_release(config, pid) == 0) {
+                released++;
+            }
+        } else if (strncmp(entry->d_name, ".trash_", 7) == 0) {
+            struct stat st;
+            if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) == 0 &&
+                now - st.st_ctime > OVERLAY_TRASH_STALE_SEC) {
+                char path[4096 + 256];
+                snprintf(path, sizeof(path), "%s/%s", config->runs_dir, entry->d_name);
+                remove_in_background(path);
+                released++;
+            }
+        }
+    }
+    closedir(dir);
+    return released;
+}
+
+static int write_file(const char *path, const char *value) {
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t len = (ssize_t)strlen(value);
+    int rc = write(fd, value, (size_t)len) == len ? 0 : -1;
+    close(fd);
+    return rc;
+}
+
+// Unprivileged: a user namespace mapping only our own ids grants the
+// capabilities to mount, and they are dropped again at exec
+static int enter_user_namespace(void) {
+    uid_t uid = getuid();
+    gid_t gid = getgid();
+    if (unshare(CLONE_NEWUSER | CLONE_NEWNS) != 0) return -1;
+    
+    char map[64];
+    write_file("/proc/self/setgroups", "deny");
+    snprintf(map, sizeof(map), "%d %d 1\n", (int)uid, (int)uid);
+    if (write_file("/proc/self/uid_map", map) != 0) return -1;
+    snprintf(map, sizeof(map), "%d %d 1\n", (int)gid, (int)gid);
+    return write_file("/proc/self/gid_map", map);
+}
+
+int overlay_enter(const OverlayConfig *config, const char *jail_dir, OverlayResult *result) {
+    memset(result, 0, sizeof(OverlayResult));
+    
+    // Mount options are comma and colon separated
+    if (jail_dir[0] != '/' || strpbrk(jail_dir, ",:\\") || strpbrk(config->runs_dir, ",:\\")) {
+        snprintf(result->error, sizeof(result->error), "overlay: paths must be absolute, without ',' ':' '\\'");
+        return -1;
+    }
+    if (mkdir_p(config->runs_dir, 0700) != 0) {
+        snprintf(result->error, sizeof(result->error), "overlay %.200s: %s", config->runs_dir, strerror(errno));
+        return -1;
+    }
+    overlay_sweep(config);
+    
+    char run_dir[4096];
+    run_dir_path(config, getpid(), run_dir, sizeof(run_dir));
+    overlay_release(config, getpid());   // A previous process with our pid
+    if (mkdir(run_dir, 0700) != 0) {
+        snprintf(result->error, sizeof(result->error), "overlay %.200s: %s", run_dir, strerror(errno));
+        return -1;
+    }
+    
+    int tmpfs = 0;
+    char work[4096 + 8], options[3 * 4096 + 64];
+    const char *step = "unshare";
+    if (unshare(CLONE_NEWNS) != 0) {
+        if (errno != EPERM || enter_user_namespace() != 0) goto fail;
+        result->user_namespace = 1;
+    }
+    step = "mount --make-rprivate /";
+    if (mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL) != 0) goto fail;
+    
+    if (config->upper == OVERLAY_UPPER_TMPFS) {
+        snprintf(options, sizeof(options), "mode=0700");
+        if (config->tmpfs_size_mb > 0) {
+            snprintf(options, sizeof(options), "mode=0700,size=%ldm", config->tmpfs_size_mb);
+        }
+        step = "mount tmpfs";
+        if (mount("zencube", run_dir, "tmpfs", MS_NOSUID | MS_NODEV, options) != 0) goto fail;
+        tmpfs = 1;
+    }
+    
+    snprintf(result->upper, sizeof(result->upper), "%.4000s/upper", run_dir);
+    snprintf(work, sizeof(work), "%s/work", run_dir);
+    step = "mkdir";
+    if (mkdir(result->upper, 0755) != 0 || mkdir(work, 0700) != 0) goto fail;
+    
+    // The lower layer is resolved before the overlay covers it
+    snprintf(options, sizeof(options), "lowerdir=%s,upperdir=%s,workdir=%s%s", jail_dir, result->upper, work,
+             result->user_namespace ? ",userxattr" : "");
+    step = "mount overlay";
+    if (mount("overlay", jail_dir, "overlay", MS_NOSUID, options) != 0) goto fail;
+    
+    snprintf(result->run_dir, sizeof(result->run_dir), "%s", run_dir);
+    return 0;
+    
+fail:
+    snprintf(result->error, sizeof(result->error), "overlay: %s: %s", step, strerror(errno));
+    result->upper[0] = '\0';
+    if (tmpfs) umount2(run_dir, MNT_DETACH);
+    overlay_release(config, getpid());
+    return -1;
+}
+
+// Allocated bytes beneath dirfd/name
+static uint64_t tree_bytes(int dirfd, const char *name) {
+    struct stat st;
+    if (fstatat(dirfd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) return 0;
+    uint64_t bytes = (uint64_t)st.st_blocks * 512;
+    if (!S_ISDIR(st.st_mode)) return bytes;
+    
+    int fd = openat(dirfd, name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    DIR *dir = fd >= 0 ? fdopendir(fd) : NULL;
+    if (!dir) {
+        if (fd >= 0) close(fd);
+        return bytes;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+        bytes += tree_bytes(fd, entry->d_name);
+    }
+    closedir(dir);
+    return bytes;
+}
+
+int overlay_usage(const OverlayConfig *config, pid_t pid, uint64_t *bytes) {
+    char run_dir[4096], path[4096 + 64];
+    run_dir_path(config, pid, run_dir, sizeof(run_dir));
+    *bytes = 0;
+    
+    if (config->upper == OVERLAY_UPPER_DIR) {
+        snprintf(path, sizeof(path), "%s/upper", run_dir);
+        if (access(path, F_OK) != 0) return -1;
+        *bytes = tree_bytes(AT_FDCWD, path);
+        return 0;
+    }
+    
+    // The tmpfs exists only in the run's mount namespace
+    struct statfs fs;
+    snprintf(path, sizeof(path), "/proc/%d/root%s", (int)pid, run_dir);
+    if (statfs(path, &fs) != 0) return -1;
+    if (fs.f_type != TMPFS_MAGIC) {
+        errno = ENOENT;
+        return -1;
+    }
+    *bytes = (uint64_t)(fs.f_blocks - fs.f_bfree) * (uint64_t)fs.f_bsize;
+    return 0;
+}
@@ -0,0 +1,50 @@
+#ifndef ZENCUBE_OVERLAY_H
+#define ZENCUBE_OVERLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+// Where a run's writes to an overlay jail go
+typedef enum {
+    OVERLAY_UPPER_TMPFS,       // Private tmpfs: freed with the mount namespace
+    OVERLAY_UPPER_DIR          // Directory under runs_dir: survives the run
+} OverlayUpper;
+
+typedef struct {
+    char runs_dir[4096];       // run_<pid>/ per run, .trash_* while deleting
+    OverlayUpper upper;
+    long tmpfs_size_mb;        // 0 = the kernel default (half of RAM)
+} OverlayConfig;
+
+typedef struct {
+    char run_dir[4096];        // Empty = no overlay
+    char upper[4096];          // Path of the upper layer inside the run's namespace
+    int user_namespace;        // A user namespace was needed to mount
+    char error[256];
+} OverlayResult;
+
+// Defaults: $XDG_RUNTIME_DIR/zencube/overlay (or /tmp/zencube_overlay_<uid>),
+// tmpfs upper of the default size
+void overlay_config_init(OverlayConfig *config);
+
+// Make jail_dir an ephemeral copy-on-write view of itself for the calling
+// process: enter a private mount namespace and mount an overlay with
+// jail_dir as the read-only lower layer on jail_dir itself. Every other
+// process still sees the unchanged jail. Without CAP_SYS_ADMIN the mount
+// is made in a new user namespace (Linux 5.11+, "userxattr"). Runs whose
+// process is gone are released first.
+int overlay_enter(const OverlayConfig *config, const char *jail_dir, OverlayResult *result);
+
+// Bytes written to the upper layer of pid's run. A tmpfs upper is read
+// with one statfs through /proc/<pid>/root; a directory upper is walked.
+int overlay_usage(const OverlayConfig *config, pid_t pid, uint64_t *bytes);
+
+// Discard pid's run directory: rename it out of the way (O(1)) and delete
+// it in a detached background process
+int overlay_release(const OverlayConfig *config, pid_t pid);
+
+// Release every run whose process no longer exists. Returns the count.
+int overlay_sweep(const OverlayConfig *config);
+
+#endif // ZENCUBE_OVERLAY_H
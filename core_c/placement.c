@@ -0,0 +1,641 @@
+#include "placement.h"
+#include "cgroup.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sched.h>
+#include <limits.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+// One run's claim on a set of cores, persisted as <dir>/run_<pid>.json
+typedef struct {
+    pid_t pid;
+    unsigned long long start_time;   // Tells a live run from a reused pid
+    int cores;                       // Requested
+    char cgroup[4096];
+    int core_list[PLACEMENT_MAX_CORES_PER_RUN];
+    int core_count;                  // 0 = not placed (yet)
+    int changed;
+} Lease;
+
+void placement_request_init(PlacementRequest *request) {
+    memset(request, 0, sizeof(*request));
+    request->cores = 1;
+    request->reserve_cores = 1;
+    snprintf(request->sysfs_root, sizeof(request->sysfs_root), "/sys");
+    
+    const char *runtime = getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0]) {
+        snprintf(request->dir, sizeof(request->dir), "%s/zencube-placement", runtime);
+    } else {
+        snprintf(request->dir, sizeof(request->dir), "/tmp/zencube-placement-%u", (unsigned)getuid());
+    }
+}
+
+int placement_parse_cpus(const char *text, int *out, int max) {
+    int count = 0;
+    const char *p = text;
+    while (*p && *p != '\n' && count < max) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p) break;
+        long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+        }
+        for (long cpu = first; cpu <= last && count < max; cpu++) {
+            out[count++] = (int)cpu;
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static int read_cpu_list(const char *path, int *out, int max) {
+    char text[4096];
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    int ok = fgets(text, sizeof(text), fp) != NULL;
+    fclose(fp);
+    return ok ? placement_parse_cpus(text, out, max) : -1;
+}
+
+void placement_format_cpus(const int *cpus, int count, char *out, size_t size) {
+    size_t used = 0;
+    out[0] = '\0';
+    for (int i = 0; i < count && used < size; ) {
+        int j = i;
+        while (j + 1 < count && cpus[j + 1] == cpus[j] + 1) j++;
+        int n = j > i
+            ? snprintf(out + used, size - used, "%s%d-%d", used ? "," : "", cpus[i], cpus[j])
+            : snprintf(out + used, size - used, "%s%d", used ? "," : "", cpus[i]);
+        if (n < 0) break;
+        used += (size_t)n;
+        i = j + 1;
+    }
+}
+
+static int cpu_index(const PlacementTopology *topo, int cpu) {
+    for (int i = 0; i < topo->cpu_count; i++) {
+        if (topo->cpus[i] == cpu) return i;
+    }
+    return -1;
+}
+
+int placement_read_topology(const char *sysfs_root, PlacementTopology *topo) {
+    memset(topo, 0, sizeof(*topo));
+    topo->node_count = 1;
+    
+    char path[512];
+    int online[PLACEMENT_MAX_CPUS];
+    snprintf(path, sizeof(path), "%s/devices/system/cpu/online", sysfs_root);
+    int online_count = read_cpu_list(path, online, PLACEMENT_MAX_CPUS);
+    if (online_count <= 0) return -1;
+    
+    // On the real host, only CPUs we are allowed on
+    cpu_set_t allowed;
+    int filter = strcmp(sysfs_root, "/sys") == 0 &&
+                 sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    
+    int core_key[PLACEMENT_MAX_CPUS];
+    for (int i = 0; i < online_count; i++) {
+        int cpu = online[i];
+        if (filter && (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed))) continue;
+        
+        // SMT siblings share a core; the first sibling names it
+        int siblings[PLACEMENT_MAX_CPUS];
+        snprintf(path, sizeof(path), "%s/devices/system/cpu/cpu%d/topology/thread_siblings_list",
+                 sysfs_root, cpu);
+        int key = read_cpu_list(path, siblings, PLACEMENT_MAX_CPUS) > 0 ? siblings[0] : cpu;
+        
+        int core = -1;
+        for (int c = 0; c < topo->core_count; c++) {
+            if (core_key[c] == key) core = c;
+        }
+        if (core < 0) {
+            core = topo->core_count++;
+            core_key[core] = key;
+            topo->core_node[core] = 0;
+        }
+        topo->cpus[topo->cpu_count] = cpu;
+        topo->cpu_core[topo->cpu_count] = core;
+        topo->cpu_count++;
+    }
+    if (topo->cpu_count == 0) return -1;
+    
+    // Nodes own CPUs; a core's node is that of its CPUs
+    for (int node = 0; node < PLACEMENT_MAX_NODES; node++) {
+        int cpus[PLACEMENT_MAX_CPUS];
+        snprintf(path, sizeof(path), "%s/devices/system/node/node%d/cpulist", sysfs_root, node);
+        int count = read_cpu_list(path, cpus, PLACEMENT_MAX_CPUS);
+        for (int i = 0; i < count; i++) {
+            int index = cpu_index(topo, cpus[i]);
+            if (index >= 0) {
+                topo->core_node[topo->cpu_core[index]] = node;
+                if (node + 1 > topo->node_count) topo->node_count = node + 1;
+            }
+        }
+    }
+    return 0;
+}
+
+// Field 22 of /proc/<pid>/stat; 0 = no such process
+static unsigned long long process_start_time(pid_t pid) {
+    char path[64], text[1024];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    size_t len = fread(text, 1, sizeof(text) - 1, fp);
+    fclose(fp);
+    text[len] = '\0';
+    
+    // The command name may contain spaces; fields resume after the last ')'
+    char *p = strrchr(text, ')');
+    if (!p) return 0;
+    unsigned long long start = 0;
+    for (int field = 3; field <= 22 && p; field++) {
+        p = strchr(p + 1, ' ');
+        if (p && field == 22) start = strtoull(p + 1, NULL, 10);
+    }
+    return start;
+}
+
+static int load_lease(const char *path, const PlacementTopology *topo, Lease *lease) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) return -1;
+    char text[8192];
+    size_t len = fread(text, 1, sizeof(text) - 1, fp);
+    fclose(fp);
+    text[len] = '\0';
+    
+    cJSON *json = cJSON_Parse(text);
+    if (!json) return -1;
+    
+    memset(lease, 0, sizeof(*lease));
+    cJSON *item = cJSON_GetObjectItem(json, "pid");
+    lease->pid = cJSON_IsNumber(item) ? (pid_t)item->valuedouble : 0;
+    item = cJSON_GetObjectItem(json, "start");
+    lease->start_time = cJSON_IsNumber(item) ? (unsigned long long)item->valuedouble : 0;
+    item = cJSON_GetObjectItem(json, "cores");
+    lease->cores = cJSON_IsNumber(item) ? item->valueint : 1;
+    item = cJSON_GetObjectItem(json, "cgroup");
+    if (cJSON_IsString(item)) {
+        snprintf(lease->cgroup, sizeof(lease->cgroup), "%s", item->valuestring);
+    }
+    
+    // Back to core indices; a CPU the topology no longer has voids the placement
+    cJSON *cpu;
+    cJSON_ArrayForEach(cpu, cJSON_GetObjectItem(json, "cpus")) {
+        int index = cJSON_IsNumber(cpu) ? cpu_index(topo, cpu->valueint) : -1;
+        if (index < 0) {
+            lease->core_count = 0;
+            break;
+        }
+        int core = topo->cpu_core[index], seen = 0;
+        for (int c = 0; c < lease->core_count; c++) seen |= lease->core_list[c] == core;
+        if (!seen && lease->core_count < PLACEMENT_MAX_CORES_PER_RUN) {
+            lease->core_list[lease->core_count++] = core;
+        }
+    }
+    cJSON_Delete(json);
+    return lease->pid > 0 ? 0 : -1;
+}
+
+// Every CPU of the lease's cores, ascending, and the nodes they sit on
+static int lease_cpus(const PlacementTopology *topo, const Lease *lease, int *cpus, uint64_t *nodes) {
+    int count = 0;
+    *nodes = 0;
+    for (int i = 0; i < topo->cpu_count; i++) {
+        for (int c = 0; c < lease->core_count; c++) {
+            if (topo->cpu_core[i] == lease->core_list[c]) {
+                cpus[count++] = topo->cpus[i];
+                *nodes |= 1ULL << topo->core_node[lease->core_list[c]];
+            }
+        }
+    }
+    return count;
+}
+
+static int save_lease(const char *dir, const PlacementTopology *topo, const Lease *lease) {
+    int cpus[PLACEMENT_MAX_CPUS];
+    uint64_t nodes;
+    int count = lease_cpus(topo, lease, cpus, &nodes);
+    
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "pid", lease->pid);
+    cJSON_AddNumberToObject(json, "start", (double)lease->start_time);
+    cJSON_AddNumberToObject(json, "cores", lease->cores);
+    cJSON_AddItemToObject(json, "cpus", cJSON_CreateIntArray(cpus, count));
+    cJSON_AddStringToObject(json, "cgroup", lease->cgroup);
+    char *text = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+    if (!text) return -1;
+    
+    // Readers never see a half-written lease
+    char path[PATH_MAX], tmp[PATH_MAX + 8];
+    snprintf(path, sizeof(path), "%s/run_%d.json", dir, (int)lease->pid);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *fp = fopen(tmp, "w");
+    int ok = fp && fputs(text, fp) >= 0;
+    if (fp && fclose(fp) != 0) ok = 0;
+    free(text);
+    if (!ok || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// Lock the lease directory and load every live lease; finished runs'
+// leases are deleted. Returns the lock fd.
+static int open_leases(const char *dir, const PlacementTopology *topo, Lease *leases, int *count) {
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) return -1;
+    
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/.lock", dir);
+    int lock_fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (lock_fd < 0) return -1;
+    if (flock(lock_fd, LOCK_EX) != 0) {
+        close(lock_fd);
+        return -1;
+    }
+    
+    *count = 0;
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+    while (d && (entry = readdir(d)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (strncmp(entry->d_name, "run_", 4) != 0 || len < 5 ||
+            strcmp(entry->d_name + len - 5, ".json") != 0) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (*count >= PLACEMENT_MAX_RUNS - 1) break;  // Keep a slot for a new run
+        Lease *lease = &leases[*count];
+        if (load_lease(path, topo, lease) != 0 ||
+            process_start_time(lease->pid) != lease->start_time) {
+            unlink(path);
+            continue;
+        }
+        (*count)++;
+    }
+    if (d) closedir(d);
+    return lock_fd;
+}
+
+static int compare_age(const void *a, const void *b) {
+    const Lease *x = a, *y = b;
+    if (x->start_time != y->start_time) return x->start_time < y->start_time ? -1 : 1;
+    return x->pid - y->pid;
+}
+
+// Give the lease its cores: least loaded first, then the NUMA node with the
+// most idle cores (so a run's memory stays local), then lowest index
+static void place_lease(const PlacementTopology *topo, int reserved, int *load, Lease *lease) {
+    int usable = topo->core_count - reserved;
+    int want = lease->cores < 1 ? 1 : lease->cores;
+    if (want > usable) want = usable;
+    if (want > PLACEMENT_MAX_CORES_PER_RUN) want = PLACEMENT_MAX_CORES_PER_RUN;
+    
+    int idle[PLACEMENT_MAX_NODES] = {0};
+    for (int c = reserved; c < topo->core_count; c++) {
+        if (load[c] == 0) idle[topo->core_node[c]]++;
+    }
+    int best_node = 0;
+    for (int n = 1; n < topo->node_count && n < PLACEMENT_MAX_NODES; n++) {
+        if (idle[n] > idle[best_node]) best_node = n;
+    }
+    
+    int taken[PLACEMENT_MAX_CPUS] = {0};
+    lease->core_count = 0;
+    for (int k = 0; k < want; k++) {
+        int best = -1;
+        for (int c = reserved; c < topo->core_count; c++) {
+            if (taken[c]) continue;
+            if (best < 0 || load[c] < load[best] ||
+                (load[c] == load[best] && topo->core_node[c] == best_node &&
+                 topo->core_node[best] != best_node)) {
+                best = c;
+            }
+        }
+        taken[best] = 1;
+        lease->core_list[lease->core_count++] = best;
+    }
+}
+
+// Oldest runs keep cores they still have to themselves; everyone else is
+// (re)placed, so runs that had to share move onto cores freed since
+static void place_all(const PlacementTopology *topo, int reserve_cores, Lease *leases, int count) {
+    int reserved = reserve_cores < topo->core_count ? reserve_cores : topo->core_count - 1;
+    if (reserved < 0) reserved = 0;
+    int load[PLACEMENT_MAX_CPUS] = {0};
+    
+    qsort(leases, (size_t)count, sizeof(Lease), compare_age);
+    int pending[PLACEMENT_MAX_RUNS];
+    int pending_count = 0;
+    for (int i = 0; i < count; i++) {
+        Lease *lease = &leases[i];
+        int keep = lease->core_count > 0;
+        for (int c = 0; c < lease->core_count; c++) {
+            if (lease->core_list[c] < reserved || load[lease->core_list[c]] > 0) keep = 0;
+        }
+        if (keep) {
+            for (int c = 0; c < lease->core_count; c++) load[lease->core_list[c]]++;
+        } else {
+            pending[pending_count++] = i;
+        }
+    }
+    
+    for (int p = 0; p < pending_count; p++) {
+        Lease *lease = &leases[pending[p]];
+        int before[PLACEMENT_MAX_CORES_PER_RUN];
+        int before_count = lease->core_count;
+        memcpy(before, lease->core_list, sizeof(before));
+        
+        place_lease(topo, reserved, load, lease);
+        for (int c = 0; c < lease->core_count; c++) load[lease->core_list[c]]++;
+        
+        int same = before_count == lease->core_count;
+        for (int c = 0; same && c < before_count; c++) {
+            int found = 0;
+            for (int d = 0; d < lease->core_count; d++) found |= before[c] == lease->core_list[d];
+            same = found;
+        }
+        lease->changed = !same;
+    }
+}
+
+static pid_t parent_pid(pid_t pid) {
+    char path[64], text[512];
+    snprintf(path, sizeof(path), "/proc/%d/stat", (int)pid);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return 0;
+    size_t len = fread(text, 1, sizeof(text) - 1, fp);
+    fclose(fp);
+    text[len] = '\0';
+    
+    int ppid = 0;
+    char *p = strrchr(text, ')');
+    if (p) sscanf(p + 1, " %*c %d", &ppid);
+    return (pid_t)ppid;
+}
+
+// Every thread of pid; returns how many were moved
+static int set_task_affinity(pid_t pid, const cpu_set_t *set) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", (int)pid);
+    DIR *d = opendir(path);
+    if (!d) return 0;
+    int moved = 0;
+    struct dirent *entry;
+    while ((entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] != '.' &&
+            sched_setaffinity((pid_t)atoi(entry->d_name), sizeof(*set), set) == 0) {
+            moved++;
+        }
+    }
+    closedir(d);
+    return moved;
+}
+
+// Every thread of root and its descendants. One pass over /proc collects
+// the parent links (task/<tid>/children needs CONFIG_PROC_CHILDREN).
+static void set_tree_affinity(pid_t root, const cpu_set_t *set) {
+    size_t count = 0, cap = 256;
+    pid_t *pids = malloc(cap * sizeof(pid_t));
+    pid_t *parents = malloc(cap * sizeof(pid_t));
+    DIR *proc = opendir("/proc");
+    struct dirent *entry;
+    while (pids && parents && proc && (entry = readdir(proc)) != NULL) {
+        if (entry->d_name[0] < '1' || entry->d_name[0] > '9') continue;
+        if (count == cap) {
+            cap *= 2;
+            pid_t *grown_pids = realloc(pids, cap * sizeof(pid_t));
+            if (grown_pids) pids = grown_pids;
+            pid_t *grown_parents = realloc(parents, cap * sizeof(pid_t));
+            if (grown_parents) parents = grown_parents;
+            if (!grown_pids || !grown_parents) break;
+        }
+        pids[count] = (pid_t)atoi(entry->d_name);
+        parents[count] = parent_pid(pids[count]);
+        count++;
+    }
+    if (proc) closedir(proc);
+    
+    // Breadth-first: tree[] grows as children are found
+    pid_t *tree = malloc((count + 1) * sizeof(pid_t));
+    if (pids && parents && tree) {
+        size_t tree_count = 0;
+        tree[tree_count++] = root;
+        for (size_t i = 0; i < tree_count; i++) {
+            set_task_affinity(tree[i], set);
+            for (size_t j = 0; j < count && tree_count <= count; j++) {
+                if (parents[j] == tree[i]) tree[tree_count++] = pids[j];
+            }
+        }
+    } else {
+        set_task_affinity(root, set);
+    }
+    free(tree);
+    free(pids);
+    free(parents);
+}
+
+static void set_cgroup_affinity(const char *cgroup, const cpu_set_t *set) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/cgroup.threads", cgroup);
+    FILE *fp = fopen(path, "r");
+    if (!fp) return;
+    int tid;
+    while (fscanf(fp, "%d", &tid) == 1) {
+        sched_setaffinity(tid, sizeof(*set), set);
+    }
+    fclose(fp);
+}
+
+// Confine a run: cpuset.cpus/mems when its cgroup has the cpuset
+// controller (one write for the whole tree), otherwise every task's
+// affinity. The caller also prefers its nodes for new memory.
+static int apply_lease(const PlacementTopology *topo, const Lease *lease, PlacementResult *result) {
+    int cpus[PLACEMENT_MAX_CPUS];
+    uint64_t nodes;
+    int count = lease_cpus(topo, lease, cpus, &nodes);
+    if (count == 0) return -1;
+    
+    char list[1024];
+    placement_format_cpus(cpus, count, list, sizeof(list));
+    int self = lease->pid == getpid();
+    
+    if (self && topo->node_count > 1) {
+        unsigned long mask = (unsigned long)nodes;
+        if (syscall(SYS_set_mempolicy, MPOL_PREFERRED_MANY, &mask, PLACEMENT_MAX_NODES + 1) != 0) {
+            unsigned long first = mask & (~mask + 1);
+            syscall(SYS_set_mempolicy, MPOL_PREFERRED, &first, PLACEMENT_MAX_NODES + 1);
+        }
+    }
+    
+    if (lease->cgroup[0] && cgroup_write(lease->cgroup, "cpuset.cpus", list) == 0) {
+        int node_ids[PLACEMENT_MAX_NODES], node_count = 0;
+        for (int n = 0; n < PLACEMENT_MAX_NODES; n++) {
+            if (nodes & (1ULL << n)) node_ids[node_count++] = n;
+        }
+        char mems[256];
+        placement_format_cpus(node_ids, node_count, mems, sizeof(mems));
+        cgroup_write(lease->cgroup, "cpuset.mems", mems);
+        return 0;
+    }
+    
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < count; i++) {
+        if (cpus[i] < CPU_SETSIZE) CPU_SET(cpus[i], &set);
+    }
+    if (self) {
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            snprintf(result->error, sizeof(result->error), "sched_setaffinity %.200s: %s", list, strerror(errno));
+            return -1;
+        }
+    } else if (lease->cgroup[0]) {
+        set_cgroup_affinity(lease->cgroup, &set);
+    } else {
+        set_tree_affinity(lease->pid, &set);
+    }
+    return 0;
+}
+
+// Place (and confine) every lease that changed, save them and fill in
+// result for the lease at index target (-1 = none)
+static void commit_leases(const PlacementRequest *request, const PlacementTopology *topo,
+                          Lease *leases, int count, pid_t target, PlacementResult *result) {
+    place_all(topo, request->reserve_cores, leases, count);
+    
+    int load[PLACEMENT_MAX_CPUS] = {0};
+    for (int i = 0; i < count; i++) {
+        for (int c = 0; c < leases[i].core_count; c++) load[leases[i].core_list[c]]++;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        Lease *lease = &leases[i];
+        if (lease->pid == target) {
+            result->cpu_count = lease_cpus(topo, lease, result->cpus, &result->nodes);
+            for (int c = 0; c < lease->core_count; c++) {
+                if (load[lease->core_list[c]] > 1) result->shared = 1;
+            }
+        } else if (lease->changed) {
+            result->moved++;
+        }
+        if (lease->pid == target || lease->changed) {
+            apply_lease(topo, lease, result);
+            save_lease(request->dir, topo, lease);
+        }
+    }
+}
+
+int placement_acquire(const PlacementRequest *request, pid_t pid, PlacementResult *result) {
+    memset(result, 0, sizeof(*result));
+    
+    PlacementTopology *topo = malloc(sizeof(PlacementTopology));
+    Lease *leases = calloc(PLACEMENT_MAX_RUNS, sizeof(Lease));
+    if (!topo || !leases || placement_read_topology(request->sysfs_root, topo) != 0) {
+        snprintf(result->error, sizeof(result->error), "cannot read CPU topology under %.200s", request->sysfs_root);
+        free(topo);
+        free(leases);
+        return -1;
+    }
+    
+    int count;
+    int lock_fd = open_leases(request->dir, topo, leases, &count);
+    if (lock_fd < 0) {
+        snprintf(result->error, sizeof(result->error), "placement %.200s: %s", request->dir, strerror(errno));
+        free(topo);
+        free(leases);
+        return -1;
+    }
+    
+    // Re-acquiring (same pid) replaces the old lease
+    Lease *lease = NULL;
+    for (int i = 0; i < count; i++) {
+        if (leases[i].pid == pid) lease = &leases[i];
+    }
+    if (!lease) lease = &leases[count++];
+    memset(lease, 0, sizeof(*lease));
+    lease->pid = pid;
+    lease->start_time = process_start_time(pid);
+    lease->cores = request->cores;
+    snprintf(lease->cgroup, sizeof(lease->cgroup), "%s", request->cgroup_path);
+    
+    commit_leases(request, topo, leases, count, pid, result);
+    
+    close(lock_fd);
+    free(topo);
+    free(leases);
+    return result->error[0] ? -1 : 0;
+}
+
+int placement_rebalance(const PlacementRequest *request, PlacementResult *result) {
+    memset(result, 0, sizeof(*result));
+    
+    PlacementTopology *topo = malloc(sizeof(PlacementTopology));
+    Lease *leases = calloc(PLACEMENT_MAX_RUNS, sizeof(Lease));
+    int count;
+    int lock_fd = -1;
+    if (topo && leases && placement_read_topology(request->sysfs_root, topo) == 0) {
+        lock_fd = open_leases(request->dir, topo, leases, &count);
+    }
+    if (lock_fd < 0) {
+        snprintf(result->error, sizeof(result->error), "placement %.200s: %s", request->dir, strerror(errno));
+        free(topo);
+        free(leases);
+        return -1;
+    }
+    
+    commit_leases(request, topo, leases, count, 0, result);
+    
+    close(lock_fd);
+    free(topo);
+    free(leases);
+    return 0;
+}
+
+int placement_reserve(const PlacementRequest *request, pid_t pid, PlacementResult *result) {
+    memset(result, 0, sizeof(*result));
+    
+    PlacementTopology *topo = malloc(sizeof(PlacementTopology));
+    if (!topo || placement_read_topology(request->sysfs_root, topo) != 0) {
+        snprintf(result->error, sizeof(result->error), "cannot read CPU topology under %.200s", request->sysfs_root);
+        free(topo);
+        return -1;
+    }
+    
+    int reserved = request->reserve_cores < topo->core_count ? request->reserve_cores : topo->core_count - 1;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < topo->cpu_count; i++) {
+        if (topo->cpu_core[i] < reserved) {
+            result->cpus[result->cpu_count++] = topo->cpus[i];
+            result->nodes |= 1ULL << topo->core_node[topo->cpu_core[i]];
+            if (topo->cpus[i] < CPU_SETSIZE) CPU_SET(topo->cpus[i], &set);
+        }
+    }
+    free(topo);
+    
+    if (result->cpu_count == 0) return 0;
+    if (pid == 0 && sched_setaffinity(0, sizeof(set), &set) != 0) {
+        snprintf(result->error, sizeof(result->error), "sched_setaffinity: %s", strerror(errno));
+        return -1;
+    }
+    if (pid != 0 && set_task_affinity(pid, &set) == 0) {
+        snprintf(result->error, sizeof(result->error), "sched_setaffinity %d: %s", (int)pid, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef ZENCUBE_PLACEMENT_H
+#define ZENCUBE_PLACEMENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define PLACEMENT_MAX_CPUS 1024
+#define PLACEMENT_MAX_NODES 64
+#define PLACEMENT_MAX_RUNS 256
+#define PLACEMENT_MAX_CORES_PER_RUN 64
+
+// Host topology as seen from sysfs, limited to the CPUs we may run on.
+// Cores group SMT siblings; every CPU and core belongs to one NUMA node.
+typedef struct {
+    int cpu_count;
+    int cpus[PLACEMENT_MAX_CPUS];       // Logical CPU ids, ascending
+    int cpu_core[PLACEMENT_MAX_CPUS];   // Core index of each CPU
+    int core_count;
+    int core_node[PLACEMENT_MAX_CPUS];  // NUMA node of each core
+    int node_count;                     // Highest node id + 1
+} PlacementTopology;
+
+// Where a run (or the monitoring stack) was put
+typedef struct {
+    int cpus[PLACEMENT_MAX_CPUS];
+    int cpu_count;
+    uint64_t nodes;                     // Bit per NUMA node
+    int moved;                          // Other runs re-placed by this call
+    int shared;                         // No idle core was left; sharing the least loaded
+    char error[256];                    // Set when the placement could not be applied
+} PlacementResult;
+
+typedef struct {
+    char dir[512];             // Lease directory shared by every launcher
+    char sysfs_root[256];      // "/sys"; a copy of its cpu/ and node/ trees for testing
+    int cores;                 // Physical cores requested (SMT siblings included)
+    int reserve_cores;         // Leading cores kept for the monitoring stack
+    char cgroup_path[4096];    // Run cgroup (cpuset.cpus/mems); empty = affinity only
+} PlacementRequest;
+
+// Defaults: one core, one reserved core, $XDG_RUNTIME_DIR/zencube-placement
+// (or /tmp/zencube-placement-<uid>)
+void placement_request_init(PlacementRequest *request);
+
+int placement_read_topology(const char *sysfs_root, PlacementTopology *topo);
+
+// Record a lease for pid and place it on the least loaded whole cores,
+// preferring one NUMA node, then move runs that were sharing cores onto
+// any that finished runs freed. pid is confined here too (pid = getpid()
+// before exec: the placement is inherited by the command).
+int placement_acquire(const PlacementRequest *request, pid_t pid, PlacementResult *result);
+
+// Drop leases of finished runs and re-place the remaining ones
+int placement_rebalance(const PlacementRequest *request, PlacementResult *result);
+
+// Confine the caller (pid 0) or every thread of a running pid to the
+// reserved cores (monitoring stack). No-op on a single-core host.
+int placement_reserve(const PlacementRequest *request, pid_t pid, PlacementResult *result);
+
+// "0-3,8,10-11"
+void placement_format_cpus(const int *cpus, int count, char *out, size_t size);
+
+// Parse a kernel CPU list ("0-3,8,10-11") into ids; returns how many
+int placement_parse_cpus(const char *text, int *out, int max);
+
+#endif // ZENCUBE_PLACEMENT_H
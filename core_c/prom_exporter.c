@@ -1,15 +1,89 @@
 #include "prom_exporter.h"
+#include "capture.h"
+#include "rollup.h"
 #include "cJSON.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <unistd.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <math.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <errno.h>
 
-#define BUFFER_SIZE 8192
+#define BUFFER_SIZE 16384
+#define DEFAULT_MAX_RUNS 16
+#define DEFAULT_POINTS_PER_RUN 65536
+#define SAMPLE_PREFIX "zencube_samples_"
+#define SAMPLE_SUFFIX ".jsonl"
+#define CAPTURE_PREFIX "zencube_capture_"
+#define CAPTURE_SUFFIX ".log.head"
+#define POLL_INTERVAL_MS 250
+
+// Series fields in PromPoint.values order
+static const char *SERIES_FIELDS[PROM_SERIES_FIELDS] = {
+    "cpu_percent", "rss_bytes", "vms_bytes", "threads",
+    "fds_open", "read_bytes", "write_bytes"
+};
+
+// Counters are downsampled by taking the last value, gauges by averaging
+static const int SERIES_IS_COUNTER[PROM_SERIES_FIELDS] = { 0, 0, 0, 0, 0, 1, 1 };
+
+// Growable response body
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} StrBuf;
+
+static int sb_appendf(StrBuf *sb, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        va_start(ap, fmt);
+        int n = vsnprintf(sb->data ? sb->data + sb->len : NULL, sb->cap - sb->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) return -1;
+        if (sb->len + (size_t)n < sb->cap) {
+            sb->len += (size_t)n;
+            return 0;
+        }
+        
+        size_t cap = sb->cap ? sb->cap * 2 : 4096;
+        while (cap <= sb->len + (size_t)n) cap *= 2;
+        char *grown = realloc(sb->data, cap);
+        if (!grown) return -1;
+        sb->data = grown;
+        sb->cap = cap;
+    }
+}
+
+// Append a JSON string literal
+static int sb_append_json_string(StrBuf *sb, const char *str) {
+    if (sb_appendf(sb, "\"") != 0) return -1;
+    for (const unsigned char *c = (const unsigned char *)str; *c; c++) {
+        int rc;
+        if (*c == '"' || *c == '\\') rc = sb_appendf(sb, "\\%c", *c);
+        else if (*c < 0x20) rc = sb_appendf(sb, "\\u%04x", *c);
+        else rc = sb_appendf(sb, "%c", *c);
+        if (rc != 0) return -1;
+    }
+    return sb_appendf(sb, "\"");
+}
+
+// Add a file to the set of tailed sample logs
+static int add_tail(PromExporter *exporter, const char *path) {
+    JsonlTail *grown = realloc(exporter->tails, sizeof(JsonlTail) * (size_t)(exporter->tail_count + 1));
+    if (!grown) return -1;
+    exporter->tails = grown;
+    jsonl_tail_init(&exporter->tails[exporter->tail_count++], path);
+    return 0;
+}
 
 // Initialize exporter
 int prom_exporter_init(PromExporter *exporter, int port, const char *sample_log_path) {
@@ -17,10 +91,20 @@ int prom_exporter_init(PromExporter *exporter, int port, const char *sample_log_
     
     memset(exporter, 0, sizeof(PromExporter));
     exporter->port = port;
-    strncpy(exporter->sample_log_path, sample_log_path, sizeof(exporter->sample_log_path) - 1);
+    exporter->started_at = time(NULL);
+    exporter->max_runs = DEFAULT_MAX_RUNS;
+    exporter->points_per_run = DEFAULT_POINTS_PER_RUN;
+    sketch_init(&exporter->last_cpu, SKETCH_ALPHA);
+    sketch_init(&exporter->last_rss, SKETCH_ALPHA);
+    sketch_init(&exporter->runs_cpu, SKETCH_ALPHA);
+    sketch_init(&exporter->runs_rss, SKETCH_ALPHA);
+    if (sample_log_path) {
+        strncpy(exporter->sample_log_path, sample_log_path, sizeof(exporter->sample_log_path) - 1);
+        if (add_tail(exporter, sample_log_path) != 0) return -1;
+    }
     
     // Create socket
-    exporter->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    exporter->socket_fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
     if (exporter->socket_fd < 0) {
         perror("socket");
         return -1;
@@ -44,7 +128,7 @@ int prom_exporter_init(PromExporter *exporter, int port, const char *sample_log_
     }
     
     // Listen
-    if (listen(exporter->socket_fd, 5) < 0) {
+    if (listen(exporter->socket_fd, 16) < 0) {
         perror("listen");
         close(exporter->socket_fd);
         return -1;
@@ -53,62 +137,276 @@ int prom_exporter_init(PromExporter *exporter, int port, const char *sample_log_
     return 0;
 }
 
-// Read latest metrics from JSONL
-static int read_latest_metrics(const char *log_path, PromMetrics *metrics) {
-    FILE *fp = fopen(log_path, "r");
-    if (!fp) return -1;
-    
-    memset(metrics, 0, sizeof(PromMetrics));
+// Tail every sample log in a directory
+int prom_exporter_set_dir(PromExporter *exporter, const char *sample_dir) {
+    if (!exporter || !sample_dir) return -1;
+    strncpy(exporter->sample_dir, sample_dir, sizeof(exporter->sample_dir) - 1);
+    exporter->last_scan = 0;
+    return 0;
+}
+
+// Pick up sample logs written since the exporter started. Older files in a
+// shared temp directory belong to previous sessions and are left alone.
+static int name_matches(const char *name, const char *prefix, const char *suffix) {
+    size_t len = strlen(name);
+    size_t prefix_len = strlen(prefix);
+    size_t suffix_len = strlen(suffix);
+    return len > prefix_len + suffix_len && strncmp(name, prefix, prefix_len) == 0 &&
+           strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+static void scan_sample_dir(PromExporter *exporter) {
+    DIR *dir = opendir(exporter->sample_dir);
+    if (!dir) return;
+    
+    // Output capture of the newest run, for its drop counters
+    time_t capture_mtime = 0;
+    exporter->capture_header[0] = '\0';
+    
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (name_matches(entry->d_name, CAPTURE_PREFIX, CAPTURE_SUFFIX)) {
+            char path[sizeof(exporter->capture_header)];
+            struct stat st;
+            snprintf(path, sizeof(path), "%s/%s", exporter->sample_dir, entry->d_name);
+            if (stat(path, &st) == 0 && st.st_mtime >= exporter->started_at - 1 && st.st_mtime >= capture_mtime) {
+                capture_mtime = st.st_mtime;
+                snprintf(exporter->capture_header, sizeof(exporter->capture_header), "%s", path);
+            }
+            continue;
+        }
+        if (!name_matches(entry->d_name, SAMPLE_PREFIX, SAMPLE_SUFFIX) || rollup_is_sidecar(entry->d_name)) {
+            continue;
+        }
+        
+        char path[sizeof(exporter->sample_dir) + 256];
+        snprintf(path, sizeof(path), "%s/%s", exporter->sample_dir, entry->d_name);
+        
+        int known = 0;
+        for (int i = 0; i < exporter->tail_count && !known; i++) {
+            known = strcmp(exporter->tails[i].path, path) == 0;
+        }
+        if (known) continue;
+        
+        struct stat st;
+        if (stat(path, &st) != 0 || st.st_mtime < exporter->started_at - 1) continue;
+        
+        add_tail(exporter, path);
+    }
     
-    char line[2048];
-    char last_line[2048] = {0};
+    closedir(dir);
+}
+
+// Parse "YYYY-mm-ddTHH:MM:SSZ" into epoch milliseconds
+static double parse_iso_ms(const char *iso) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    if (!iso || sscanf(iso, "%d-%d-%dT%d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                       &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6) {
+        return 0;
+    }
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    return (double)timegm(&tm) * 1000.0;
+}
+
+// Find a run by id, creating it (and evicting the stalest run) if needed
+static PromRun* get_run(PromExporter *exporter, const char *run_id) {
+    for (int i = 0; i < exporter->run_count; i++) {
+        if (strcmp(exporter->runs[i].run_id, run_id) == 0) {
+            return &exporter->runs[i];
+        }
+    }
     
-    // Read to last line
-    while (fgets(line, sizeof(line), fp)) {
-        strncpy(last_line, line, sizeof(last_line) - 1);
-        last_line[sizeof(last_line) - 1] = '\0';  // Ensure null termination
+    PromRun *run;
+    if (exporter->run_count < exporter->max_runs) {
+        PromRun *grown = realloc(exporter->runs, sizeof(PromRun) * (size_t)(exporter->run_count + 1));
+        if (!grown) return NULL;
+        exporter->runs = grown;
+        run = &exporter->runs[exporter->run_count++];
+    } else {
+        run = &exporter->runs[0];
+        for (int i = 1; i < exporter->run_count; i++) {
+            if (exporter->runs[i].updated < run->updated) run = &exporter->runs[i];
+        }
+        free(run->points);
     }
-    fclose(fp);
     
-    if (last_line[0] == '\0') return -1;
+    memset(run, 0, sizeof(PromRun));
+    snprintf(run->run_id, sizeof(run->run_id), "%s", run_id);
+    run->capacity = exporter->points_per_run;
+    run->points = calloc(run->capacity, sizeof(PromPoint));
+    run->last_seq = -1;
+    if (!run->points) return NULL;
+    return run;
+}
+
+static double json_number(cJSON *obj, const char *name) {
+    cJSON *item = cJSON_GetObjectItem(obj, name);
+    return cJSON_IsNumber(item) ? item->valuedouble : 0.0;
+}
+
+// A run's stop event: keep its sketches and fold them into the totals
+static void ingest_stop(PromExporter *exporter, cJSON *stop) {
+    cJSON *run_id = cJSON_GetObjectItem(stop, "run_id");
+    cJSON *cpu = cJSON_GetObjectItem(cJSON_GetObjectItem(stop, "cpu_percent"), "sketch");
+    cJSON *rss = cJSON_GetObjectItem(cJSON_GetObjectItem(stop, "rss_bytes"), "sketch");
+    if (!cJSON_IsString(run_id) || !cpu || !rss) return;   // Older sampler
+    
+    Sketch cpu_sketch, rss_sketch;
+    if (sketch_from_json(&cpu_sketch, cpu) != 0 || sketch_from_json(&rss_sketch, rss) != 0) return;
+    
+    // A log re-read after truncation must not count the run twice
+    PromRun *run = get_run(exporter, run_id->valuestring);
+    if (!run || run->finished) return;
+    run->finished = 1;
+    
+    exporter->last_cpu = cpu_sketch;
+    exporter->last_rss = rss_sketch;
+    sketch_merge(&exporter->runs_cpu, &cpu_sketch);
+    sketch_merge(&exporter->runs_rss, &rss_sketch);
+    exporter->cpu_seconds_total += json_number(stop, "cpu_seconds");
+    exporter->rss_gib_seconds_total += json_number(stop, "rss_gib_seconds");
+    exporter->finished_runs++;
+}
+
+// Ingest one JSONL line into the series cache
+static void ingest_line(const char *line, void *ctx) {
+    PromExporter *exporter = ctx;
     
-    // Parse last sample
-    cJSON *sample = cJSON_Parse(last_line);
-    if (!sample) return -1;
+    cJSON *sample = cJSON_Parse(line);
+    if (!sample) return;
     
     cJSON *event = cJSON_GetObjectItem(sample, "event");
-    if (!event || strcmp(event->valuestring, "sample") != 0) {
+    cJSON *run_id = cJSON_GetObjectItem(sample, "run_id");
+    if (cJSON_IsString(event) && strcmp(event->valuestring, "stop") == 0) {
+        ingest_stop(exporter, sample);
+    }
+    if (!cJSON_IsString(event) || strcmp(event->valuestring, "sample") != 0) {
         cJSON_Delete(sample);
-        return -1;
+        return;
     }
     
-    // Extract metrics
-    cJSON *item;
-    if ((item = cJSON_GetObjectItem(sample, "cpu_percent"))) 
-        metrics->cpu_percent = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "rss_bytes"))) 
-        metrics->rss_bytes = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "vms_bytes"))) 
-        metrics->vms_bytes = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "threads"))) 
-        metrics->threads = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "fds_open"))) 
-        metrics->fds_open = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "read_bytes"))) 
-        metrics->read_bytes = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "write_bytes"))) 
-        metrics->write_bytes = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "cpu_max"))) 
-        metrics->cpu_max = item->valuedouble;
-    if ((item = cJSON_GetObjectItem(sample, "rss_max"))) 
-        metrics->rss_max = item->valuedouble;
+    PromRun *run = get_run(exporter, cJSON_IsString(run_id) ? run_id->valuestring : "default");
+    if (!run) {
+        cJSON_Delete(sample);
+        return;
+    }
     
+    // A log re-read after truncation must not duplicate points
+    cJSON *seq = cJSON_GetObjectItem(sample, "seq");
+    if (cJSON_IsNumber(seq)) {
+        if ((int64_t)seq->valuedouble <= run->last_seq) {
+            cJSON_Delete(sample);
+            return;
+        }
+        run->last_seq = (int64_t)seq->valuedouble;
+    }
+    
+    // Wall-clock timestamps only have second resolution; mono_ns relative
+    // to the run's first sample gives sub-second spacing
+    cJSON *timestamp = cJSON_GetObjectItem(sample, "timestamp");
+    double t_ms = parse_iso_ms(cJSON_IsString(timestamp) ? timestamp->valuestring : NULL);
+    cJSON *mono = cJSON_GetObjectItem(sample, "mono_ns");
+    if (cJSON_IsNumber(mono)) {
+        uint64_t mono_ns = (uint64_t)mono->valuedouble;
+        if (run->anchor_mono_ns == 0) {
+            run->anchor_ms = t_ms;
+            run->anchor_mono_ns = mono_ns;
+        }
+        t_ms = run->anchor_ms + (double)(int64_t)(mono_ns - run->anchor_mono_ns) / 1e6;
+    }
+    
+    PromPoint *point = &run->points[(run->head + run->count) % run->capacity];
+    if (run->count == run->capacity) {
+        run->head = (run->head + 1) % run->capacity;
+    } else {
+        run->count++;
+    }
+    point->t_ms = t_ms;
+    for (int f = 0; f < PROM_SERIES_FIELDS; f++) {
+        point->values[f] = json_number(sample, SERIES_FIELDS[f]);
+    }
+    
+    PromMetrics *m = &run->latest;
+    m->cpu_percent = point->values[0];
+    m->rss_bytes = point->values[1];
+    m->vms_bytes = point->values[2];
+    m->threads = point->values[3];
+    m->fds_open = point->values[4];
+    m->read_bytes = point->values[5];
+    m->write_bytes = point->values[6];
+    m->cpu_max = json_number(sample, "cpu_max");
+    m->rss_max = json_number(sample, "rss_max");
+    
+    // Samples carry network traffic per interval; export running totals.
+    // Outside its own namespace a run's counters are the host's, not its own.
+    if (cJSON_IsNumber(cJSON_GetObjectItem(sample, "net_rx_bytes")) &&
+        cJSON_IsTrue(cJSON_GetObjectItem(sample, "net_isolated"))) {
+        m->has_net = 1;
+        m->net_rx_bytes += json_number(sample, "net_rx_bytes");
+        m->net_tx_bytes += json_number(sample, "net_tx_bytes");
+        m->net_rx_packets += json_number(sample, "net_rx_packets");
+        m->net_tx_packets += json_number(sample, "net_tx_packets");
+        m->net_tcp_retrans += json_number(sample, "net_tcp_retrans");
+    }
+    
+    run->updated = ++exporter->ingested;
     cJSON_Delete(sample);
-    return 0;
+}
+
+// Ingest newly appended samples from every tailed log
+void prom_exporter_refresh(PromExporter *exporter) {
+    time_t now = time(NULL);
+    if (exporter->sample_dir[0] != '\0' && now != exporter->last_scan) {
+        exporter->last_scan = now;
+        scan_sample_dir(exporter);
+    }
+    
+    for (int i = 0; i < exporter->tail_count; i++) {
+        jsonl_tail_poll(&exporter->tails[i], ingest_line, exporter);
+    }
+}
+
+// Most recently updated run, or NULL before the first sample
+static PromRun* latest_run(PromExporter *exporter) {
+    PromRun *latest = NULL;
+    for (int i = 0; i < exporter->run_count; i++) {
+        if (!latest || exporter->runs[i].updated > latest->updated) {
+            latest = &exporter->runs[i];
+        }
+    }
+    return latest;
+}
+
+// Counters of an output capture, or -1 if there is none to report
+static int read_capture_header(const char *path, CaptureHeader *header) {
+    if (!path[0]) return -1;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    ssize_t n = pread(fd, header, sizeof(CaptureHeader), 0);
+    close(fd);
+    return n == (ssize_t)sizeof(CaptureHeader) && memcmp(header->magic, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) == 0
+        ? 0 : -1;
+}
+
+// A sketch as a Prometheus summary: p50/p90/p99, _sum and _count
+static int append_summary(char *buffer, int offset, const char *name, const char *help, const Sketch *sketch) {
+    static const double QUANTILES[] = { 0.5, 0.9, 0.99 };
+    offset += snprintf(buffer + offset, BUFFER_SIZE - offset, "# HELP %s %s\n# TYPE %s summary\n",
+                       name, help, name);
+    for (size_t i = 0; i < sizeof(QUANTILES) / sizeof(QUANTILES[0]); i++) {
+        offset += snprintf(buffer + offset, BUFFER_SIZE - offset, "%s{quantile=\"%g\"} %.6g\n",
+                           name, QUANTILES[i], sketch_quantile(sketch, QUANTILES[i]));
+    }
+    offset += snprintf(buffer + offset, BUFFER_SIZE - offset, "%s_sum %.6g\n%s_count %llu\n",
+                       name, sketch->sum, name, (unsigned long long)sketch->count);
+    return offset;
 }
 
 // Generate Prometheus metrics text
-static char* generate_metrics_text(const PromMetrics *metrics) {
+static char* generate_metrics_text(const PromExporter *exporter, const PromMetrics *metrics,
+                                   const CaptureHeader *capture) {
     char *buffer = malloc(BUFFER_SIZE);
     if (!buffer) return NULL;
     
@@ -154,56 +452,322 @@ static char* generate_metrics_text(const PromMetrics *metrics) {
     APPEND_STR("# TYPE zencube_memory_rss_max_bytes gauge\n");
     APPEND_FMT("zencube_memory_rss_max_bytes %.0f\n", metrics->rss_max);
     
+    if (metrics->has_net) {
+        APPEND_STR("# HELP zencube_net_rx_bytes_total Bytes received in the run's network namespace\n");
+        APPEND_STR("# TYPE zencube_net_rx_bytes_total counter\n");
+        APPEND_FMT("zencube_net_rx_bytes_total %.0f\n", metrics->net_rx_bytes);
+        
+        APPEND_STR("# HELP zencube_net_tx_bytes_total Bytes sent in the run's network namespace\n");
+        APPEND_STR("# TYPE zencube_net_tx_bytes_total counter\n");
+        APPEND_FMT("zencube_net_tx_bytes_total %.0f\n", metrics->net_tx_bytes);
+        
+        APPEND_STR("# HELP zencube_net_rx_packets_total Packets received in the run's network namespace\n");
+        APPEND_STR("# TYPE zencube_net_rx_packets_total counter\n");
+        APPEND_FMT("zencube_net_rx_packets_total %.0f\n", metrics->net_rx_packets);
+        
+        APPEND_STR("# HELP zencube_net_tx_packets_total Packets sent in the run's network namespace\n");
+        APPEND_STR("# TYPE zencube_net_tx_packets_total counter\n");
+        APPEND_FMT("zencube_net_tx_packets_total %.0f\n", metrics->net_tx_packets);
+        
+        APPEND_STR("# HELP zencube_net_tcp_retrans_segs_total TCP segments retransmitted in the namespace\n");
+        APPEND_STR("# TYPE zencube_net_tcp_retrans_segs_total counter\n");
+        APPEND_FMT("zencube_net_tcp_retrans_segs_total %.0f\n", metrics->net_tcp_retrans);
+    }
+    
+    if (capture) {
+        APPEND_STR("# HELP zencube_output_bytes_total Output written by the latest run\n");
+        APPEND_STR("# TYPE zencube_output_bytes_total counter\n");
+        APPEND_FMT("zencube_output_bytes_total %llu\n", (unsigned long long)capture->bytes);
+        
+        APPEND_STR("# HELP zencube_output_elided_bytes_total Output dropped by the head/tail policy\n");
+        APPEND_STR("# TYPE zencube_output_elided_bytes_total counter\n");
+        APPEND_FMT("zencube_output_elided_bytes_total %llu\n", (unsigned long long)capture->elided);
+        
+        APPEND_STR("# HELP zencube_output_passthrough_dropped_bytes_total Output the passthrough reader missed\n");
+        APPEND_STR("# TYPE zencube_output_passthrough_dropped_bytes_total counter\n");
+        APPEND_FMT("zencube_output_passthrough_dropped_bytes_total %llu\n", (unsigned long long)capture->dropped);
+        
+        APPEND_STR("# HELP zencube_output_throttled_seconds_total Time the run was held to the output rate\n");
+        APPEND_STR("# TYPE zencube_output_throttled_seconds_total counter\n");
+        APPEND_FMT("zencube_output_throttled_seconds_total %.3f\n", (double)capture->throttled_ms / 1000.0);
+        
+        APPEND_STR("# HELP zencube_output_log_bytes Bytes kept in the capture log\n");
+        APPEND_STR("# TYPE zencube_output_log_bytes gauge\n");
+        APPEND_FMT("zencube_output_log_bytes %llu\n", (unsigned long long)capture->log_bytes);
+    }
+    
+    if (exporter->finished_runs > 0) {
+        offset = append_summary(buffer, offset, "zencube_run_cpu_percent",
+                                "CPU percent over the latest finished run", &exporter->last_cpu);
+        offset = append_summary(buffer, offset, "zencube_run_rss_bytes",
+                                "RSS over the latest finished run", &exporter->last_rss);
+        offset = append_summary(buffer, offset, "zencube_runs_cpu_percent",
+                                "CPU percent over every finished run (merged sketches)", &exporter->runs_cpu);
+        offset = append_summary(buffer, offset, "zencube_runs_rss_bytes",
+                                "RSS over every finished run (merged sketches)", &exporter->runs_rss);
+        
+        APPEND_STR("# HELP zencube_runs_finished_total Runs whose stop event was seen\n");
+        APPEND_STR("# TYPE zencube_runs_finished_total counter\n");
+        APPEND_FMT("zencube_runs_finished_total %d\n", exporter->finished_runs);
+        
+        APPEND_STR("# HELP zencube_runs_cpu_seconds_total CPU time used by finished runs\n");
+        APPEND_STR("# TYPE zencube_runs_cpu_seconds_total counter\n");
+        APPEND_FMT("zencube_runs_cpu_seconds_total %.3f\n", exporter->cpu_seconds_total);
+        
+        APPEND_STR("# HELP zencube_runs_rss_gib_seconds_total Memory held by finished runs over time\n");
+        APPEND_STR("# TYPE zencube_runs_rss_gib_seconds_total counter\n");
+        APPEND_FMT("zencube_runs_rss_gib_seconds_total %.6f\n", exporter->rss_gib_seconds_total);
+    }
+    
     #undef APPEND_STR
     #undef APPEND_FMT
     
     return buffer;
 }
 
-// Handle HTTP request
-static void handle_request(int client_fd, const char *log_path) {
-    char request[1024];
-    ssize_t n = recv(client_fd, request, sizeof(request) - 1, 0);
-    if (n <= 0) return;
-    request[n] = '\0';
+// Write a whole buffer to the client
+static int send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+static void send_response(int fd, const char *status, const char *content_type,
+                          const char *body, size_t len) {
+    char header[512];
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.1 %s\r\n"
+                              "Content-Type: %s\r\n"
+                              "Content-Length: %zu\r\n"
+                              "Access-Control-Allow-Origin: *\r\n"
+                              "Connection: close\r\n"
+                              "\r\n",
+                              status, content_type, len);
+    if (send_all(fd, header, (size_t)header_len) == 0) {
+        send_all(fd, body, len);
+    }
+}
+
+// Extract a query parameter (percent-decoded); returns 0 when present
+static int query_param(const char *query, const char *name, char *out, size_t out_size) {
+    size_t name_len = strlen(name);
+    const char *p = query;
+    while (p && *p) {
+        const char *end = strchr(p, '&');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        if (len > name_len && strncmp(p, name, name_len) == 0 && p[name_len] == '=') {
+            size_t o = 0;
+            for (size_t i = name_len + 1; i < len && o + 1 < out_size; i++) {
+                unsigned int hex;
+                if (p[i] == '%' && i + 2 < len && sscanf(p + i + 1, "%2x", &hex) == 1) {
+                    out[o++] = (char)hex;
+                    i += 2;
+                } else {
+                    out[o++] = p[i] == '+' ? ' ' : p[i];
+                }
+            }
+            out[o] = '\0';
+            return 0;
+        }
+        p = end ? end + 1 : NULL;
+    }
+    return -1;
+}
+
+static double query_number(const char *query, const char *name, double fallback) {
+    char value[64];
+    if (query_param(query, name, value, sizeof(value)) != 0 || value[0] == '\0') {
+        return fallback;
+    }
+    return strtod(value, NULL);
+}
+
+// First ring position (0..count) whose time is >= t_ms
+static size_t lower_bound(const PromRun *run, double t_ms) {
+    size_t lo = 0;
+    size_t hi = run->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (run->points[(run->head + mid) % run->capacity].t_ms < t_ms) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// GET /metrics: latest sample of the most recently updated run
+static void handle_metrics(int client_fd, PromExporter *exporter) {
+    PromRun *run = latest_run(exporter);
+    if (!run) {
+        const char *response = "No metrics found\n";
+        send_response(client_fd, "503 Service Unavailable", "text/plain", response, strlen(response));
+        return;
+    }
     
-    // Check for GET /metrics
-    if (strstr(request, "GET /metrics") == NULL) {
-        const char *response = "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nNot Found";
-        send(client_fd, response, strlen(response), 0);
+    // Generate metrics text
+    CaptureHeader capture;
+    int has_capture = read_capture_header(exporter->capture_header, &capture) == 0;
+    char *metrics_text = generate_metrics_text(exporter, &run->latest, has_capture ? &capture : NULL);
+    if (!metrics_text) {
+        const char *response = "Server Error\n";
+        send_response(client_fd, "500 Internal Server Error", "text/plain", response, strlen(response));
         return;
     }
     
-    // Read metrics
-    PromMetrics metrics;
-    if (read_latest_metrics(log_path, &metrics) != 0) {
-        const char *response = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 17\r\n\r\nNo metrics found\n";
-        send(client_fd, response, strlen(response), 0);
+    send_response(client_fd, "200 OK", "text/plain; version=0.0.4", metrics_text, strlen(metrics_text));
+    free(metrics_text);
+}
+
+// GET /api/runs: runs held in the cache
+static void handle_runs(int client_fd, PromExporter *exporter) {
+    StrBuf sb = {0};
+    sb_appendf(&sb, "{\"runs\":[");
+    for (int i = 0; i < exporter->run_count; i++) {
+        PromRun *run = &exporter->runs[i];
+        double first = run->count ? run->points[run->head].t_ms : 0;
+        double last = run->count ? run->points[(run->head + run->count - 1) % run->capacity].t_ms : 0;
+        sb_appendf(&sb, "%s{\"run\":", i ? "," : "");
+        sb_append_json_string(&sb, run->run_id);
+        sb_appendf(&sb, ",\"count\":%zu,\"first\":%.3f,\"last\":%.3f}", run->count, first, last);
+    }
+    sb_appendf(&sb, "]}");
+    
+    send_response(client_fd, "200 OK", "application/json", sb.data, sb.len);
+    free(sb.data);
+}
+
+// GET /api/series?run=&from=&to=&step= : columnar JSON for a time range.
+// from/to are epoch milliseconds; step > 0 aggregates into step-ms buckets.
+static void handle_series(int client_fd, PromExporter *exporter, const char *query) {
+    char run_id[128] = "";
+    query_param(query, "run", run_id, sizeof(run_id));
+    double from = query_number(query, "from", -INFINITY);
+    double to = query_number(query, "to", INFINITY);
+    double step = query_number(query, "step", 0);
+    
+    PromRun *run = NULL;
+    if (run_id[0] == '\0') {
+        run = latest_run(exporter);
+    } else {
+        for (int i = 0; i < exporter->run_count && !run; i++) {
+            if (strcmp(exporter->runs[i].run_id, run_id) == 0) run = &exporter->runs[i];
+        }
+    }
+    if (!run) {
+        const char *response = "{\"error\":\"unknown run\"}";
+        send_response(client_fd, "404 Not Found", "application/json", response, strlen(response));
         return;
     }
     
-    // Generate metrics text
-    char *metrics_text = generate_metrics_text(&metrics);
-    if (!metrics_text) {
-        const char *response = "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 14\r\n\r\nServer Error\n";
-        send(client_fd, response, strlen(response), 0);
+    size_t begin = lower_bound(run, from);
+    size_t end = lower_bound(run, to);
+    if (to != INFINITY) {
+        // Include points stamped exactly at `to`
+        while (end < run->count && run->points[(run->head + end) % run->capacity].t_ms <= to) end++;
+    }
+    
+    // Aggregate into buckets up front so every column has the same length
+    size_t max_out = end > begin ? end - begin : 0;
+    PromPoint *out = malloc(sizeof(PromPoint) * (max_out ? max_out : 1));
+    if (!out) {
+        const char *response = "Server Error\n";
+        send_response(client_fd, "500 Internal Server Error", "text/plain", response, strlen(response));
         return;
     }
     
-    // Send HTTP response
-    char header[512];
-    snprintf(header, sizeof(header),
-             "HTTP/1.1 200 OK\r\n"
-             "Content-Type: text/plain; version=0.0.4\r\n"
-             "Content-Length: %zu\r\n"
-             "Connection: close\r\n"
-             "\r\n",
-             strlen(metrics_text));
+    size_t n = 0;
+    size_t bucket_count = 0;
+    double bucket_start = 0;
+    for (size_t i = begin; i < end; i++) {
+        const PromPoint *p = &run->points[(run->head + i) % run->capacity];
+        if (step <= 0) {
+            out[n++] = *p;
+            continue;
+        }
+        
+        double start = floor(p->t_ms / step) * step;
+        if (bucket_count == 0 || start != bucket_start) {
+            if (bucket_count > 0) {
+                for (int f = 0; f < PROM_SERIES_FIELDS; f++) {
+                    if (!SERIES_IS_COUNTER[f]) out[n - 1].values[f] /= (double)bucket_count;
+                }
+            }
+            out[n].t_ms = start;
+            memset(out[n].values, 0, sizeof(out[n].values));
+            n++;
+            bucket_start = start;
+            bucket_count = 0;
+        }
+        for (int f = 0; f < PROM_SERIES_FIELDS; f++) {
+            if (SERIES_IS_COUNTER[f]) out[n - 1].values[f] = p->values[f];
+            else out[n - 1].values[f] += p->values[f];
+        }
+        bucket_count++;
+    }
+    if (step > 0 && bucket_count > 0) {
+        for (int f = 0; f < PROM_SERIES_FIELDS; f++) {
+            if (!SERIES_IS_COUNTER[f]) out[n - 1].values[f] /= (double)bucket_count;
+        }
+    }
     
-    send(client_fd, header, strlen(header), 0);
-    send(client_fd, metrics_text, strlen(metrics_text), 0);
+    StrBuf sb = {0};
+    sb_appendf(&sb, "{\"run\":");
+    sb_append_json_string(&sb, run->run_id);
+    sb_appendf(&sb, ",\"step\":%g,\"count\":%zu,\"t\":[", step > 0 ? step : 0, n);
+    for (size_t i = 0; i < n; i++) {
+        sb_appendf(&sb, i ? ",%.3f" : "%.3f", out[i].t_ms);
+    }
+    sb_appendf(&sb, "]");
+    for (int f = 0; f < PROM_SERIES_FIELDS; f++) {
+        sb_appendf(&sb, ",\"%s\":[", SERIES_FIELDS[f]);
+        for (size_t i = 0; i < n; i++) {
+            sb_appendf(&sb, i ? ",%.10g" : "%.10g", out[i].values[f]);
+        }
+        sb_appendf(&sb, "]");
+    }
+    sb_appendf(&sb, "}");
+    free(out);
     
-    free(metrics_text);
+    send_response(client_fd, "200 OK", "application/json", sb.data, sb.len);
+    free(sb.data);
+}
+
+// Handle HTTP request
+static void handle_request(int client_fd, PromExporter *exporter) {
+    char request[2048];
+    ssize_t n = recv(client_fd, request, sizeof(request) - 1, 0);
+    if (n <= 0) return;
+    request[n] = '\0';
+    
+    // Request line: GET <path>[?query] HTTP/1.1
+    char target[1024] = "";
+    if (sscanf(request, "GET %1023s", target) != 1) {
+        const char *response = "Not Found";
+        send_response(client_fd, "404 Not Found", "text/plain", response, strlen(response));
+        return;
+    }
+    char *query = strchr(target, '?');
+    if (query) *query++ = '\0';
+    
+    // Serve from the cache, topped up with anything appended since the last poll
+    prom_exporter_refresh(exporter);
+    
+    if (strcmp(target, "/metrics") == 0) {
+        handle_metrics(client_fd, exporter);
+    } else if (strcmp(target, "/api/series") == 0) {
+        handle_series(client_fd, exporter, query ? query : "");
+    } else if (strcmp(target, "/api/runs") == 0) {
+        handle_runs(client_fd, exporter);
+    } else {
+        const char *response = "Not Found";
+        send_response(client_fd, "404 Not Found", "text/plain", response, strlen(response));
+    }
 }
 
 // Run exporter server
@@ -212,19 +776,35 @@ int prom_exporter_run(PromExporter *exporter) {
     
     printf("Prometheus exporter running on port %d\n", exporter->port);
     printf("Metrics available at: http://localhost:%d/metrics\n", exporter->port);
+    fflush(stdout);
+    
+    prom_exporter_refresh(exporter);
     
     while (1) {
+        // Keep ingesting between requests so the cache never lags far behind
+        struct pollfd pfd = { .fd = exporter->socket_fd, .events = POLLIN, .revents = 0 };
+        int ready = poll(&pfd, 1, POLL_INTERVAL_MS);
+        if (ready < 0) {
+            if (errno == EINTR) continue;  // Interrupted by signal
+            perror("poll");
+            break;
+        }
+        if (ready == 0) {
+            prom_exporter_refresh(exporter);
+            continue;
+        }
+        
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
         
-        int client_fd = accept(exporter->socket_fd, (struct sockaddr*)&client_addr, &client_len);
+        int client_fd = accept4(exporter->socket_fd, (struct sockaddr*)&client_addr, &client_len, SOCK_CLOEXEC);
         if (client_fd < 0) {
             if (errno == EINTR) continue;  // Interrupted by signal
             perror("accept");
             break;
         }
         
-        handle_request(client_fd, exporter->sample_log_path);
+        handle_request(client_fd, exporter);
         close(client_fd);
     }
     
@@ -233,8 +813,24 @@ int prom_exporter_run(PromExporter *exporter) {
 
 // Cleanup
 void prom_exporter_cleanup(PromExporter *exporter) {
-    if (exporter && exporter->socket_fd >= 0) {
+    if (!exporter) return;
+    
+    if (exporter->socket_fd >= 0) {
         close(exporter->socket_fd);
         exporter->socket_fd = -1;
     }
+    
+    for (int i = 0; i < exporter->tail_count; i++) {
+        jsonl_tail_close(&exporter->tails[i]);
+    }
+    free(exporter->tails);
+    exporter->tails = NULL;
+    exporter->tail_count = 0;
+    
+    for (int i = 0; i < exporter->run_count; i++) {
+        free(exporter->runs[i].points);
+    }
+    free(exporter->runs);
+    exporter->runs = NULL;
+    exporter->run_count = 0;
 }
@@ -1,6 +1,12 @@
 #ifndef ZENCUBE_PROM_EXPORTER_H
 #define ZENCUBE_PROM_EXPORTER_H
 
+#include "logutil.h"
+#include "sketch.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
 // Prometheus metrics structure
 typedef struct {
     double cpu_percent;
@@ -12,18 +18,75 @@ typedef struct {
     double write_bytes;
     double cpu_max;
     double rss_max;
+    int has_net;               // Samples carried counters of the run's own namespace
+    double net_rx_bytes;       // Totals of the per-interval net_* fields
+    double net_tx_bytes;
+    double net_rx_packets;
+    double net_tx_packets;
+    double net_tcp_retrans;
 } PromMetrics;
 
+// Fields kept per point in the series cache
+#define PROM_SERIES_FIELDS 7
+
+// One cached sample (epoch milliseconds + series fields)
+typedef struct {
+    double t_ms;
+    double values[PROM_SERIES_FIELDS];
+} PromPoint;
+
+// Cached history of one run, as a ring of points ordered by time
+typedef struct {
+    char run_id[128];
+    PromPoint *points;
+    size_t capacity;
+    size_t head;               // Index of the oldest point
+    size_t count;
+    int64_t last_seq;          // Highest seq ingested, -1 if none
+    double anchor_ms;          // Wall clock of the first sample
+    uint64_t anchor_mono_ns;   // Its mono_ns, for sub-second timestamps
+    PromMetrics latest;
+    uint64_t updated;          // Ingest counter at the last update
+    int finished;              // Its stop event was ingested
+} PromRun;
+
 // Prometheus exporter state
 typedef struct {
     int socket_fd;
     int port;
     char sample_log_path[1024];
+    char sample_dir[1024];     // Directory mode: tail every zencube_samples_*.jsonl
+    time_t started_at;
+    time_t last_scan;
+    JsonlTail *tails;
+    int tail_count;
+    PromRun *runs;
+    int run_count;
+    int max_runs;
+    size_t points_per_run;
+    uint64_t ingested;
+    char capture_header[1024 + 256]; // Directory mode: newest zencube_capture_*.log.head
+    
+    // Sketches from stop events: the latest finished run, and every
+    // finished run merged
+    int finished_runs;
+    Sketch last_cpu;
+    Sketch last_rss;
+    Sketch runs_cpu;
+    Sketch runs_rss;
+    double cpu_seconds_total;
+    double rss_gib_seconds_total;
 } PromExporter;
 
 // Initialize Prometheus exporter
 int prom_exporter_init(PromExporter *exporter, int port, const char *sample_log_path);
 
+// Tail every sample log in a directory instead of a single file
+int prom_exporter_set_dir(PromExporter *exporter, const char *sample_dir);
+
+// Ingest newly appended samples into the series cache
+void prom_exporter_refresh(PromExporter *exporter);
+
 // Run exporter HTTP server (blocking)
 int prom_exporter_run(PromExporter *exporter);
 
@@ -4,41 +4,60 @@
 #include <string.h>
 #include <getopt.h>
 #include <signal.h>
+#include <unistd.h>
 
 static PromExporter *global_exporter = NULL;
 
 static void handle_signal(int sig) {
     (void)sig;
-    if (global_exporter) {
-        prom_exporter_cleanup(global_exporter);
+    // Only async-signal-safe calls here; the kernel reclaims the cache
+    if (global_exporter && global_exporter->socket_fd >= 0) {
+        close(global_exporter->socket_fd);
     }
-    exit(0);
+    _exit(0);
 }
 
 static void print_usage(const char *prog) {
-    fprintf(stderr, "Usage: %s --log <samples.jsonl> [--port <port>]\n", prog);
+    fprintf(stderr, "Usage: %s (--log <samples.jsonl> | --dir <dir>) [--port <port>]\n", prog);
     fprintf(stderr, "Options:\n");
-    fprintf(stderr, "  --log PATH    Sample JSONL log to export\n");
-    fprintf(stderr, "  --port PORT   HTTP server port (default: 9090)\n");
-    fprintf(stderr, "  --help        Show this help\n");
+    fprintf(stderr, "  --log PATH      Sample JSONL log to export\n");
+    fprintf(stderr, "  --dir DIR       Export every zencube_samples_*.jsonl written to DIR\n");
+    fprintf(stderr, "                  after startup\n");
+    fprintf(stderr, "  --port PORT     HTTP server port (default: 9090)\n");
+    fprintf(stderr, "  --retain N      Points cached per run (default: 65536)\n");
+    fprintf(stderr, "  --max-runs N    Runs cached before evicting the stalest (default: 16)\n");
+    fprintf(stderr, "  --help          Show this help\n");
+    fprintf(stderr, "\nEndpoints:\n");
+    fprintf(stderr, "  /metrics                               Latest sample (Prometheus text)\n");
+    fprintf(stderr, "  /api/runs                              Cached runs\n");
+    fprintf(stderr, "  /api/series?run=&from=&to=&step=       Columnar JSON range, epoch ms\n");
 }
 
 int main(int argc, char **argv) {
     char *log_path = NULL;
+    char *sample_dir = NULL;
     int port = 9090;
+    long retain = 0;
+    int max_runs = 0;
     
     static struct option long_options[] = {
-        {"log",  required_argument, 0, 'l'},
-        {"port", required_argument, 0, 'p'},
-        {"help", no_argument,       0, 'h'},
+        {"log",      required_argument, 0, 'l'},
+        {"dir",      required_argument, 0, 'd'},
+        {"port",     required_argument, 0, 'p'},
+        {"retain",   required_argument, 0, 'r'},
+        {"max-runs", required_argument, 0, 'm'},
+        {"help",     no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
     
     int opt;
-    while ((opt = getopt_long(argc, argv, "l:p:h", long_options, NULL)) != -1) {
+    while ((opt = getopt_long(argc, argv, "l:d:p:r:m:h", long_options, NULL)) != -1) {
         switch (opt) {
             case 'l': log_path = optarg; break;
+            case 'd': sample_dir = optarg; break;
             case 'p': port = atoi(optarg); break;
+            case 'r': retain = atol(optarg); break;
+            case 'm': max_runs = atoi(optarg); break;
             case 'h':
             default:
                 print_usage(argv[0]);
@@ -46,8 +65,8 @@ int main(int argc, char **argv) {
         }
     }
     
-    if (!log_path) {
-        fprintf(stderr, "Error: Missing required --log argument\n");
+    if (!log_path && !sample_dir) {
+        fprintf(stderr, "Error: Missing required --log or --dir argument\n");
         print_usage(argv[0]);
         return 1;
     }
@@ -59,6 +78,16 @@ int main(int argc, char **argv) {
         return 1;
     }
     
+    if (sample_dir) {
+        prom_exporter_set_dir(&exporter, sample_dir);
+    }
+    if (retain > 0) {
+        exporter.points_per_run = (size_t)retain;
+    }
+    if (max_runs > 0) {
+        exporter.max_runs = max_runs;
+    }
+    
     global_exporter = &exporter;
     
     // Setup signal handlers
@@ -66,7 +95,7 @@ int main(int argc, char **argv) {
     signal(SIGTERM, handle_signal);
     
     printf("Starting Prometheus exporter\n");
-    printf("Sample log: %s\n", log_path);
+    printf("Sample %s: %s\n", sample_dir ? "dir" : "log", sample_dir ? sample_dir : log_path);
     printf("Listening on port: %d\n", port);
     
     // Run server (blocking)
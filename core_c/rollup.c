@@ -0,0 +1,136 @@
+#include "rollup.h"
+#include "cJSON.h"
+#include "logutil.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static const unsigned WIDTHS_S[ROLLUP_LEVELS] = { 10, 60, 600 };
+static const char *const SUFFIXES[ROLLUP_LEVELS] = { ".10s.jsonl", ".1m.jsonl", ".10m.jsonl" };
+
+// Start of the bucket holding t_ms (floor, also before the epoch)
+static int64_t bucket_start(int64_t t_ms, unsigned width_s) {
+    int64_t width_ms = (int64_t)width_s * 1000;
+    int64_t start = t_ms - t_ms % width_ms;
+    return start > t_ms ? start - width_ms : start;
+}
+
+static void reset_level(RollupLevel *level, int64_t start_ms) {
+    level->start_ms = start_ms;
+    level->samples = 0;
+    memset(level->stats, 0, sizeof(level->stats));
+}
+
+static void merge_stat(RollupStat *dst, const RollupStat *src) {
+    if (src->count == 0) return;
+    if (dst->count == 0 || src->min < dst->min) dst->min = src->min;
+    if (dst->count == 0 || src->max > dst->max) dst->max = src->max;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    dst->last = src->last;     // src is the later bucket
+}
+
+static void write_level(const Rollups *rollups, const RollupLevel *level) {
+    cJSON *root = cJSON_CreateObject();
+    if (!root) return;
+    
+    char start[32];
+    time_t start_s = (time_t)(level->start_ms / 1000);
+    struct tm tm;
+    gmtime_r(&start_s, &tm);
+    strftime(start, sizeof(start), "%Y-%m-%dT%H:%M:%SZ", &tm);
+    
+    cJSON_AddStringToObject(root, "event", "rollup");
+    cJSON_AddStringToObject(root, "run_id", rollups->run_id);
+    cJSON_AddNumberToObject(root, "resolution_s", level->width_s);
+    cJSON_AddStringToObject(root, "start", start);
+    cJSON_AddNumberToObject(root, "start_ms", (double)level->start_ms);
+    cJSON_AddNumberToObject(root, "samples", (double)level->samples);
+    for (int i = 0; i < rollups->field_count; i++) {
+        const RollupStat *stat = &level->stats[i];
+        if (stat->count == 0) continue;
+        cJSON *field = cJSON_AddObjectToObject(root, rollups->fields[i]);
+        cJSON_AddNumberToObject(field, "count", (double)stat->count);
+        cJSON_AddNumberToObject(field, "min", stat->min);
+        cJSON_AddNumberToObject(field, "max", stat->max);
+        cJSON_AddNumberToObject(field, "sum", stat->sum);
+        cJSON_AddNumberToObject(field, "last", stat->last);
+    }
+    
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str) append_jsonl(level->path, json_str);
+    free(json_str);
+    cJSON_Delete(root);
+}
+
+// Write level n's bucket and fold it into level n + 1, closing that one
+// first if the bucket belongs to its next one
+static void close_level(Rollups *rollups, int n) {
+    RollupLevel *level = &rollups->levels[n];
+    if (level->start_ms < 0) return;
+    if (level->samples > 0) write_level(rollups, level);
+    
+    if (n + 1 < ROLLUP_LEVELS && level->samples > 0) {
+        RollupLevel *next = &rollups->levels[n + 1];
+        int64_t start = bucket_start(level->start_ms, next->width_s);
+        if (next->start_ms != start) {
+            close_level(rollups, n + 1);
+            reset_level(next, start);
+        }
+        next->samples += level->samples;
+        for (int i = 0; i < rollups->field_count; i++) {
+            merge_stat(&next->stats[i], &level->stats[i]);
+        }
+    }
+    level->start_ms = -1;
+}
+
+int rollup_init(Rollups *rollups, const char *out_path, const char *run_id,
+                const char *const *fields, int field_count) {
+    memset(rollups, 0, sizeof(*rollups));
+    if (field_count > ROLLUP_MAX_FIELDS) return -1;
+    
+    snprintf(rollups->run_id, sizeof(rollups->run_id), "%s", run_id);
+    rollups->fields = fields;
+    rollups->field_count = field_count;
+    for (int n = 0; n < ROLLUP_LEVELS; n++) {
+        RollupLevel *level = &rollups->levels[n];
+        level->width_s = WIDTHS_S[n];
+        snprintf(level->path, sizeof(level->path), "%s%s", out_path, SUFFIXES[n]);
+        reset_level(level, -1);
+    }
+    return 0;
+}
+
+void rollup_add(Rollups *rollups, int64_t wall_ms, const double *values, uint32_t present) {
+    RollupLevel *level = &rollups->levels[0];
+    int64_t start = bucket_start(wall_ms, level->width_s);
+    if (level->start_ms != start) {
+        close_level(rollups, 0);
+        reset_level(level, start);
+    }
+    
+    level->samples++;
+    for (int i = 0; i < rollups->field_count; i++) {
+        if (!(present & (1u << i))) continue;
+        RollupStat one = { 1, values[i], values[i], values[i], values[i] };
+        merge_stat(&level->stats[i], &one);
+    }
+}
+
+void rollup_flush(Rollups *rollups) {
+    // Lowest first, so each partial bucket reaches the coarser levels
+    for (int n = 0; n < ROLLUP_LEVELS; n++) {
+        close_level(rollups, n);
+    }
+}
+
+int rollup_is_sidecar(const char *name) {
+    size_t len = strlen(name);
+    for (int n = 0; n < ROLLUP_LEVELS; n++) {
+        size_t suffix_len = strlen(SUFFIXES[n]);
+        if (len > suffix_len && strcmp(name + len - suffix_len, SUFFIXES[n]) == 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#ifndef ZENCUBE_ROLLUP_H
+#define ZENCUBE_ROLLUP_H
+
+#include <stdint.h>
+
+#define ROLLUP_LEVELS 3
+#define ROLLUP_MAX_FIELDS 16
+
+// Aggregate of one field over a bucket
+typedef struct {
+    uint64_t count;            // Samples that had the field
+    double min;
+    double max;
+    double sum;
+    double last;
+} RollupStat;
+
+// The open bucket of one resolution and the sidecar it is written to
+typedef struct {
+    unsigned width_s;
+    char path[4096 + 16];
+    int64_t start_ms;          // Epoch ms, aligned to width_s; -1 = no bucket open
+    uint64_t samples;
+    RollupStat stats[ROLLUP_MAX_FIELDS];
+} RollupLevel;
+
+// 10 s, 1 min and 10 min rollups of a sample stream, kept as samples
+// arrive. Only the 10 s bucket sees samples: a closed bucket is folded into
+// the next resolution, so each sample costs one update whatever the number
+// of levels. Buckets are aligned to wall-clock multiples of their width,
+// so runs line up with each other.
+typedef struct {
+    char run_id[128];
+    const char *const *fields; // Field names, ROLLUP_MAX_FIELDS at most
+    int field_count;
+    RollupLevel levels[ROLLUP_LEVELS];
+} Rollups;
+
+// Sidecars are "<out_path>.10s.jsonl", ".1m.jsonl" and ".10m.jsonl"
+int rollup_init(Rollups *rollups, const char *out_path, const char *run_id,
+                const char *const *fields, int field_count);
+
+// Add a sample taken at wall_ms. values[i] counts only if bit i of present
+// is set, so optional fields do not drag min down with zeros.
+void rollup_add(Rollups *rollups, int64_t wall_ms, const double *values, uint32_t present);
+
+// Write the open buckets of every level (end of run)
+void rollup_flush(Rollups *rollups);
+
+// Whether a file name is a rollup sidecar, for readers of sample logs
+int rollup_is_sidecar(const char *name);
+
+#endif // ZENCUBE_ROLLUP_H
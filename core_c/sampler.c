@@ -7,6 +7,8 @@
 #include <unistd.h>
 #include <dirent.h>
 #include <signal.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <sys/stat.h>
 
 // Parse /proc/<pid>/stat for CPU times
@@ -110,35 +112,278 @@ static int read_proc_io(int pid, uint64_t *read_bytes, uint64_t *write_bytes) {
     return 0;
 }
 
-// Static vars for CPU calculation
-static unsigned long prev_utime = 0;
-static unsigned long prev_stime = 0;
-static struct timespec prev_time = {0, 0};
-static long clock_ticks = 0;
+static const char *CGROUP_FILES[SAMPLER_CG_FILES] = {
+    "cpu.stat", "memory.current", "pids.current", "io.stat"
+};
+
+// Read a whole cgroup file from offset 0; the kernel regenerates it per read
+static int pread_text(int fd, char *buf, size_t size) {
+    if (fd < 0) return -1;
+    ssize_t n = pread(fd, buf, size - 1, 0);
+    if (n < 0) return -1;
+    buf[n] = '\0';
+    return 0;
+}
+
+static int pread_u64(int fd, uint64_t *value) {
+    char buf[64];
+    if (pread_text(fd, buf, sizeof(buf)) != 0) return -1;
+    return sscanf(buf, "%" SCNu64, value) == 1 ? 0 : -1;
+}
+
+static void open_cgroup_files(SamplerState *state) {
+    for (int i = 0; i < SAMPLER_CG_FILES; i++) {
+        char path[600];
+        snprintf(path, sizeof(path), "%s/%s", state->cgroup_path, CGROUP_FILES[i]);
+        state->cgroup_fds[i] = open(path, O_RDONLY | O_CLOEXEC);
+    }
+    state->cgroup_opened = 1;
+}
+
+// "usage_usec 123" from cpu.stat
+static int read_cgroup_cpu(SamplerState *state, uint64_t *usage_usec) {
+    char buf[1024];
+    if (pread_text(state->cgroup_fds[SAMPLER_CG_CPU_STAT], buf, sizeof(buf)) != 0) return -1;
+    return sscanf(buf, "usage_usec %" SCNu64, usage_usec) == 1 ? 0 : -1;
+}
+
+// Sum rbytes/wbytes over every device line of io.stat
+static int read_cgroup_io(SamplerState *state, uint64_t *read_bytes, uint64_t *write_bytes) {
+    char buf[4096];
+    if (pread_text(state->cgroup_fds[SAMPLER_CG_IO_STAT], buf, sizeof(buf)) != 0) return -1;
+    
+    *read_bytes = 0;
+    *write_bytes = 0;
+    for (char *p = buf; (p = strpbrk(p, "rw")) != NULL; p++) {
+        uint64_t value;
+        if (sscanf(p, "rbytes=%" SCNu64, &value) == 1) *read_bytes += value;
+        else if (sscanf(p, "wbytes=%" SCNu64, &value) == 1) *write_bytes += value;
+    }
+    return 0;
+}
+
+// The target's network namespace, opened on its first collect. The files
+// show the namespace of the process at open time, so one fd each serves
+// every later sample.
+static void open_net_files(SamplerState *state, int pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/net/dev", pid);
+    state->net_dev_fd = open(path, O_RDONLY | O_CLOEXEC);
+    snprintf(path, sizeof(path), "/proc/%d/net/snmp", pid);
+    state->net_snmp_fd = open(path, O_RDONLY | O_CLOEXEC);
+    
+    struct stat target_ns, own_ns;
+    snprintf(path, sizeof(path), "/proc/%d/ns/net", pid);
+    state->net_isolated = stat(path, &target_ns) == 0 && stat("/proc/self/ns/net", &own_ns) == 0 &&
+                          target_ns.st_ino != own_ns.st_ino;
+    state->net_opened = 1;
+}
+
+// Read a whole proc file from offset 0 (normally one pread)
+static ssize_t pread_all(int fd, char *buf, size_t size) {
+    size_t used = 0;
+    ssize_t n;
+    while (used < size - 1 && (n = pread(fd, buf + used, size - 1 - used, (off_t)used)) > 0) {
+        used += (size_t)n;
+    }
+    buf[used] = '\0';
+    return used > 0 ? (ssize_t)used : -1;
+}
+
+// Sum bytes and packets over every interface line of net/dev:
+// "  eth0: rx_bytes rx_packets 6 x rx... tx_bytes tx_packets ..."
+static int read_net_dev(int fd, uint64_t *totals) {
+    char buf[65536];
+    if (fd < 0 || pread_all(fd, buf, sizeof(buf)) < 0) return -1;
+    
+    for (char *line = strchr(buf, ':'); line; line = strchr(line, ':')) {
+        line++;
+        uint64_t rx_bytes, rx_packets, tx_bytes, tx_packets;
+        if (sscanf(line, "%" SCNu64 " %" SCNu64 " %*u %*u %*u %*u %*u %*u %" SCNu64 " %" SCNu64,
+                   &rx_bytes, &rx_packets, &tx_bytes, &tx_packets) == 4) {
+            totals[SAMPLER_NET_RX_BYTES] += rx_bytes;
+            totals[SAMPLER_NET_RX_PACKETS] += rx_packets;
+            totals[SAMPLER_NET_TX_BYTES] += tx_bytes;
+            totals[SAMPLER_NET_TX_PACKETS] += tx_packets;
+        }
+        line = strchr(line, '\n');
+        if (!line) break;
+    }
+    return 0;
+}
+
+// RetransSegs from the "Tcp:" name and value lines of net/snmp
+static int read_net_snmp(int fd, uint64_t *retrans) {
+    char buf[8192];
+    if (fd < 0 || pread_all(fd, buf, sizeof(buf)) < 0) return -1;
+    
+    char *names = strstr(buf, "\nTcp:");
+    char *values = names ? strstr(names + 1, "\nTcp:") : NULL;
+    if (!values) return -1;
+    
+    // Field position in the name line gives the value's position
+    int column = -1;
+    char *p = names + 5;
+    for (int i = 0; *p && *p != '\n'; i++) {
+        p += strspn(p, " ");
+        if (strncmp(p, "RetransSegs", 11) == 0) {
+            column = i;
+            break;
+        }
+        p += strcspn(p, " \n");
+    }
+    if (column < 0) return -1;
+    
+    p = values + 5;
+    for (int i = 0; i < column && *p && *p != '\n'; i++) {
+        p += strspn(p, " ");
+        p += strcspn(p, " \n");
+    }
+    return sscanf(p, " %" SCNu64, retrans) == 1 ? 0 : -1;
+}
+
+// Per-interval network counters; the first sample of a target only primes
+static void collect_net(SamplerState *state, int pid, ProcessSample *sample) {
+    if (!state->net_opened) open_net_files(state, pid);
+    
+    uint64_t totals[SAMPLER_NET_FIELDS] = {0};
+    sample->has_net = read_net_dev(state->net_dev_fd, totals) == 0;
+    if (!sample->has_net) return;
+    if (read_net_snmp(state->net_snmp_fd, &totals[SAMPLER_NET_TCP_RETRANS]) != 0) {
+        totals[SAMPLER_NET_TCP_RETRANS] = state->prev_net[SAMPLER_NET_TCP_RETRANS];
+    }
+    
+    sample->net_isolated = state->net_isolated;
+    for (int i = 0; i < SAMPLER_NET_FIELDS; i++) {
+        // Counters of a removed interface go with it; never report negative
+        sample->net[i] = state->net_primed && totals[i] > state->prev_net[i]
+            ? totals[i] - state->prev_net[i] : 0;
+        state->prev_net[i] = totals[i];
+    }
+    state->net_primed = 1;
+}
+
+// Reset collection state for a new target
+void sampler_state_init(SamplerState *state) {
+    memset(state, 0, sizeof(*state));
+    state->clock_ticks = sysconf(_SC_CLK_TCK);
+    if (state->clock_ticks <= 0) state->clock_ticks = 100;  // Fallback
+}
+
+static void close_cgroup_files(SamplerState *state) {
+    if (state->cgroup_opened) {
+        for (int i = 0; i < SAMPLER_CG_FILES; i++) {
+            if (state->cgroup_fds[i] >= 0) close(state->cgroup_fds[i]);
+        }
+    }
+    state->cgroup_opened = 0;
+}
+
+void sampler_state_set_cgroup(SamplerState *state, const char *path) {
+    close_cgroup_files(state);
+    snprintf(state->cgroup_path, sizeof(state->cgroup_path), "%s", path ? path : "");
+}
+
+int sampler_state_set_jail(SamplerState *state, const char *jail_dir) {
+    JailUsage *jail = malloc(sizeof(JailUsage));
+    if (!jail) return -1;
+    if (jailusage_init(jail, jail_dir, 0) != 0) {
+        free(jail);
+        return -1;
+    }
+    if (state->jail) {
+        jailusage_cleanup(state->jail);
+        free(state->jail);
+    }
+    state->jail = jail;
+    return 0;
+}
+
+int sampler_state_set_delays(SamplerState *state) {
+    if (state->delays) return 0;
+    DelayAcct *acct = malloc(sizeof(DelayAcct));
+    if (!acct) return -1;
+    if (delayacct_open(acct) != 0) {
+        free(acct);
+        return -1;
+    }
+    state->delays = acct;
+    return 0;
+}
+
+int sampler_state_set_map_growth(SamplerState *state, int top_n, double min_interval_s) {
+    if (!state->maps) {
+        state->maps = malloc(sizeof(MapGrowthTracker));
+        if (!state->maps) return -1;
+    } else {
+        mapgrowth_cleanup(state->maps);
+    }
+    mapgrowth_init(state->maps, top_n, min_interval_s);
+    return 0;
+}
+
+void sampler_state_release(SamplerState *state) {
+    close_cgroup_files(state);
+    if (state->net_opened) {
+        if (state->net_dev_fd >= 0) close(state->net_dev_fd);
+        if (state->net_snmp_fd >= 0) close(state->net_snmp_fd);
+    }
+    state->net_opened = 0;
+    state->net_primed = 0;
+    if (state->jail) {
+        jailusage_cleanup(state->jail);
+        free(state->jail);
+        state->jail = NULL;
+    }
+    if (state->delays) {
+        delayacct_close(state->delays);
+        free(state->delays);
+        state->delays = NULL;
+    }
+    if (state->maps) {
+        mapgrowth_cleanup(state->maps);
+        free(state->maps);
+        state->maps = NULL;
+    }
+}
 
 // Initialize sampler
 int sampler_init(SamplerConfig *config) {
     if (!config) return -1;
     
     config->running = 1;
-    clock_ticks = sysconf(_SC_CLK_TCK);
-    if (clock_ticks <= 0) clock_ticks = 100;  // Fallback
-    
-    // Reset CPU tracking
-    prev_utime = 0;
-    prev_stime = 0;
-    prev_time.tv_sec = 0;
-    prev_time.tv_nsec = 0;
+    sampler_state_init(&config->state);
+    if (config->cgroup_path[0]) {
+        sampler_state_set_cgroup(&config->state, config->cgroup_path);
+    }
+    if (config->jail_path[0] && sampler_state_set_jail(&config->state, config->jail_path) != 0) {
+        fprintf(stderr, "Warning: cannot track jail %s, no jail_bytes\n", config->jail_path);
+    }
+    if (config->delays) {
+        if (sampler_state_set_delays(&config->state) != 0) {
+            fprintf(stderr, "Warning: taskstats unavailable (needs CAP_NET_ADMIN), no delay fields\n");
+        } else if (config->state.delays->kernel_enabled == 0) {
+            fprintf(stderr, "Warning: kernel.task_delayacct=0, only cpu_delay_total will move\n");
+        }
+    }
+    if (config->map_top > 0) {
+        sampler_state_set_map_growth(&config->state, config->map_top,
+                                     config->map_interval > 0 ? config->map_interval : 10.0);
+    }
     
     return 0;
 }
 
 // Collect single sample
-int sampler_collect(int pid, ProcessSample *sample) {
-    if (!sample) return -1;
+int sampler_collect(SamplerState *state, int pid, ProcessSample *sample) {
+    if (!state || !sample) return -1;
     
-    // Get timestamp
+    // Get timestamps; mono_ns marks the start of the /proc read so that
+    // downstream consumers can measure end-to-end staleness
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
     get_iso_timestamp(sample->timestamp, sizeof(sample->timestamp));
+    sample->mono_ns = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
     sample->pid = pid;
     
     // Read /proc data
@@ -146,16 +391,30 @@ int sampler_collect(int pid, ProcessSample *sample) {
     if (read_proc_stat(pid, &utime, &stime) != 0) {
         return -1;  // Process gone
     }
+    sample->seq = state->next_seq++;
     
-    // Calculate CPU percent
-    struct timespec now;
-    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (state->cgroup_path[0] && !state->cgroup_opened) {
+        open_cgroup_files(state);
+    }
     
-    if (prev_time.tv_sec > 0) {
-        double time_delta = (now.tv_sec - prev_time.tv_sec) + 
-                           (now.tv_nsec - prev_time.tv_nsec) / 1e9;
-        unsigned long cpu_delta = (utime + stime) - (prev_utime + prev_stime);
-        sample->cpu_percent = (cpu_delta / (double)clock_ticks / time_delta) * 100.0;
+    // Calculate CPU percent; a cgroup covers the whole tree, so it may
+    // exceed 100 on several CPUs
+    uint64_t usage_usec;
+    if (state->cgroup_opened && read_cgroup_cpu(state, &usage_usec) == 0) {
+        if (state->prev_time.tv_sec > 0) {
+            double time_delta = (now.tv_sec - state->prev_time.tv_sec) +
+                               (now.tv_nsec - state->prev_time.tv_nsec) / 1e9;
+            sample->cpu_percent = (usage_usec - state->prev_cgroup_usec) / 1e6 / time_delta * 100.0;
+            if (sample->cpu_percent < 0) sample->cpu_percent = 0;
+        } else {
+            sample->cpu_percent = 0.0;
+        }
+        state->prev_cgroup_usec = usage_usec;
+    } else if (state->prev_time.tv_sec > 0) {
+        double time_delta = (now.tv_sec - state->prev_time.tv_sec) + 
+                           (now.tv_nsec - state->prev_time.tv_nsec) / 1e9;
+        unsigned long cpu_delta = (utime + stime) - (state->prev_utime + state->prev_stime);
+        sample->cpu_percent = (cpu_delta / (double)state->clock_ticks / time_delta) * 100.0;
         
         // Clamp to reasonable values
         if (sample->cpu_percent < 0) sample->cpu_percent = 0;
@@ -164,9 +423,9 @@ int sampler_collect(int pid, ProcessSample *sample) {
         sample->cpu_percent = 0.0;
     }
     
-    prev_utime = utime;
-    prev_stime = stime;
-    prev_time = now;
+    state->prev_utime = utime;
+    state->prev_stime = stime;
+    state->prev_time = now;
     
     // Read memory info
     uint64_t rss, vms;
@@ -181,15 +440,119 @@ int sampler_collect(int pid, ProcessSample *sample) {
         sample->threads = 1;
     }
     
+    // The run's charged memory and task count, where the controllers exist
+    if (state->cgroup_opened) {
+        uint64_t value;
+        if (pread_u64(state->cgroup_fds[SAMPLER_CG_MEMORY_CURRENT], &value) == 0) {
+            sample->memory_rss = value;
+        }
+        if (pread_u64(state->cgroup_fds[SAMPLER_CG_PIDS_CURRENT], &value) == 0) {
+            sample->threads = (int)value;
+        }
+    }
+    
     // Count FDs
     sample->open_files = count_open_fds(pid);
     
     // Read I/O
-    read_proc_io(pid, &sample->read_bytes, &sample->write_bytes);
+    if (!state->cgroup_opened || read_cgroup_io(state, &sample->read_bytes, &sample->write_bytes) != 0) {
+        read_proc_io(pid, &sample->read_bytes, &sample->write_bytes);
+    }
+    
+    collect_net(state, pid, sample);
+    
+    sample->has_delays = state->delays && delayacct_query(state->delays, pid, &sample->delays) == 0;
+    
+    // smaps is costly on large processes; the tracker decides when to scan
+    sample->map_scan = NULL;
+    if (state->maps && mapgrowth_due(state->maps) && mapgrowth_scan(state->maps, pid) >= 0) {
+        sample->map_scan = state->maps;
+    }
+    
+    // Jail usage moves by events only; no walk of the tree here
+    sample->jail_bytes = -1;
+    if (state->jail && jailusage_poll(state->jail) >= 0) {
+        sample->jail_bytes = (int64_t)state->jail->bytes;
+    }
     
     return 0;
 }
 
+void sampler_summary_init(SamplerSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    sketch_init(&summary->cpu, SKETCH_ALPHA);
+    sketch_init(&summary->rss, SKETCH_ALPHA);
+}
+
+void sampler_summary_add(SamplerSummary *summary, const ProcessSample *sample) {
+    double rss = (double)sample->memory_rss;
+    if (summary->first_mono_ns == 0) {
+        summary->first_mono_ns = sample->mono_ns;
+    } else {
+        double dt = (double)(sample->mono_ns - summary->last_mono_ns) / 1e9;
+        summary->cpu_seconds += sample->cpu_percent / 100.0 * dt;
+        summary->rss_byte_seconds += (summary->last_rss + rss) / 2.0 * dt;
+        sketch_add(&summary->cpu, sample->cpu_percent);
+    }
+    sketch_add(&summary->rss, rss);
+    summary->last_mono_ns = sample->mono_ns;
+    summary->last_rss = rss;
+}
+
+static void add_distribution(cJSON *event, const char *name, const Sketch *sketch, double time_avg) {
+    cJSON *dist = cJSON_AddObjectToObject(event, name);
+    cJSON_AddNumberToObject(dist, "p50", sketch_quantile(sketch, 0.50));
+    cJSON_AddNumberToObject(dist, "p90", sketch_quantile(sketch, 0.90));
+    cJSON_AddNumberToObject(dist, "p99", sketch_quantile(sketch, 0.99));
+    cJSON_AddNumberToObject(dist, "time_avg", time_avg);
+    cJSON_AddItemToObject(dist, "sketch", sketch_to_json(sketch));
+}
+
+void sampler_summary_to_json(const SamplerSummary *summary, cJSON *event) {
+    double covered = (double)(summary->last_mono_ns - summary->first_mono_ns) / 1e9;
+    double cpu_avg = covered > 0 ? summary->cpu_seconds / covered * 100.0 : 0.0;
+    double rss_avg = covered > 0 ? summary->rss_byte_seconds / covered : summary->last_rss;
+    
+    add_distribution(event, "cpu_percent", &summary->cpu, cpu_avg);
+    add_distribution(event, "rss_bytes", &summary->rss, rss_avg);
+    cJSON_AddNumberToObject(event, "cpu_seconds", summary->cpu_seconds);
+    cJSON_AddNumberToObject(event, "rss_gib_seconds", summary->rss_byte_seconds / (1024.0 * 1024.0 * 1024.0));
+}
+
+// Start watching pid under run_id
+void sampler_target_init(SamplerTarget *target, int pid, const char *run_id) {
+    memset(target, 0, sizeof(*target));
+    target->pid = pid;
+    snprintf(target->run_id, sizeof(target->run_id), "%s", run_id);
+    sampler_state_init(&target->state);
+    sampler_summary_init(&target->summary);
+}
+
+// Collect and fold one sample into the target's aggregates
+int sampler_target_collect(SamplerTarget *target, const char *output_path) {
+    ProcessSample sample;
+    memset(&sample, 0, sizeof(sample));
+    if (sampler_collect(&target->state, target->pid, &sample) != 0) {
+        return -1;
+    }
+    snprintf(sample.run_id, sizeof(sample.run_id), "%s", target->run_id);
+    
+    target->samples++;
+    if (sample.cpu_percent > target->max_cpu) target->max_cpu = sample.cpu_percent;
+    if (sample.memory_rss > target->max_rss) target->max_rss = sample.memory_rss;
+    if (sample.open_files > target->peak_files) target->peak_files = sample.open_files;
+    target->read_bytes = sample.read_bytes;
+    target->write_bytes = sample.write_bytes;
+    sampler_summary_add(&target->summary, &sample);
+    
+    sample.cpu_max = target->max_cpu;
+    sample.memory_rss_max = target->max_rss;
+    if (output_path) {
+        sampler_write_jsonl(output_path, &sample);
+    }
+    return 0;
+}
+
 // Write sample to JSONL
 int sampler_write_jsonl(const char *path, const ProcessSample *sample) {
     cJSON *root = cJSON_CreateObject();
@@ -198,6 +561,8 @@ int sampler_write_jsonl(const char *path, const ProcessSample *sample) {
     cJSON_AddStringToObject(root, "event", "sample");
     cJSON_AddStringToObject(root, "run_id", sample->run_id);
     cJSON_AddStringToObject(root, "timestamp", sample->timestamp);
+    cJSON_AddNumberToObject(root, "seq", (double)sample->seq);
+    cJSON_AddNumberToObject(root, "mono_ns", (double)sample->mono_ns);
     cJSON_AddNumberToObject(root, "pid", sample->pid);
     cJSON_AddNumberToObject(root, "cpu_percent", sample->cpu_percent);
     cJSON_AddNumberToObject(root, "rss_bytes", sample->memory_rss);
@@ -208,6 +573,43 @@ int sampler_write_jsonl(const char *path, const ProcessSample *sample) {
     cJSON_AddNumberToObject(root, "write_bytes", sample->write_bytes);
     cJSON_AddNumberToObject(root, "cpu_max", sample->cpu_max);
     cJSON_AddNumberToObject(root, "rss_max", sample->memory_rss_max);
+    if (sample->jail_bytes >= 0) {
+        cJSON_AddNumberToObject(root, "jail_bytes", (double)sample->jail_bytes);
+    }
+    if (sample->has_net) {
+        cJSON_AddNumberToObject(root, "net_rx_bytes", (double)sample->net[SAMPLER_NET_RX_BYTES]);
+        cJSON_AddNumberToObject(root, "net_tx_bytes", (double)sample->net[SAMPLER_NET_TX_BYTES]);
+        cJSON_AddNumberToObject(root, "net_rx_packets", (double)sample->net[SAMPLER_NET_RX_PACKETS]);
+        cJSON_AddNumberToObject(root, "net_tx_packets", (double)sample->net[SAMPLER_NET_TX_PACKETS]);
+        cJSON_AddNumberToObject(root, "net_tcp_retrans", (double)sample->net[SAMPLER_NET_TCP_RETRANS]);
+        cJSON_AddBoolToObject(root, "net_isolated", sample->net_isolated);
+    }
+    if (sample->has_delays) {
+        cJSON_AddNumberToObject(root, "cpu_delay_total", (double)sample->delays.cpu_delay_total);
+        cJSON_AddNumberToObject(root, "blkio_delay_total", (double)sample->delays.blkio_delay_total);
+        cJSON_AddNumberToObject(root, "swapin_delay_total", (double)sample->delays.swapin_delay_total);
+        cJSON_AddNumberToObject(root, "freepages_delay_total", (double)sample->delays.freepages_delay_total);
+    }
+    if (sample->map_scan) {
+        const MapGrowthTracker *maps = sample->map_scan;
+        cJSON *growth = cJSON_AddObjectToObject(root, "map_growth");
+        cJSON_AddNumberToObject(growth, "mappings", (double)maps->mappings);
+        cJSON_AddNumberToObject(growth, "scan_ms", maps->scan_ms);
+        cJSON *top = cJSON_AddArrayToObject(growth, "top");
+        for (int i = 0; i < maps->top_count; i++) {
+            const MapGrowth *grower = &maps->top[i];
+            char start[24];
+            snprintf(start, sizeof(start), "0x%" PRIx64, grower->start);
+            cJSON *item = cJSON_CreateObject();
+            cJSON_AddStringToObject(item, "mapping", grower->name);
+            cJSON_AddStringToObject(item, "start", start);
+            cJSON_AddNumberToObject(item, "size_bytes", (double)(grower->end - grower->start));
+            cJSON_AddNumberToObject(item, "rss_bytes", (double)grower->rss);
+            cJSON_AddNumberToObject(item, "rss_delta", (double)grower->rss_delta);
+            cJSON_AddNumberToObject(item, "pss_delta", (double)grower->pss_delta);
+            cJSON_AddItemToArray(top, item);
+        }
+    }
     
     char *json_str = cJSON_PrintUnformatted(root);
     int result = append_jsonl(path, json_str);
@@ -218,9 +620,40 @@ int sampler_write_jsonl(const char *path, const ProcessSample *sample) {
     return result;
 }
 
+// Fields kept in the rollup sidecars, in the order sampler_rollups_add fills them
+static const char *const ROLLUP_FIELDS[] = {
+    "cpu_percent", "rss_bytes", "vms_bytes", "threads", "fds_open", "read_bytes", "write_bytes",
+    "jail_bytes", "net_rx_bytes", "net_tx_bytes", "net_tcp_retrans", "cpu_delay_total", "blkio_delay_total"
+};
+#define ROLLUP_FIELD_COUNT (int)(sizeof(ROLLUP_FIELDS) / sizeof(ROLLUP_FIELDS[0]))
+
+int sampler_rollups_init(Rollups *rollups, const char *out_path, const char *run_id) {
+    return rollup_init(rollups, out_path, run_id, ROLLUP_FIELDS, ROLLUP_FIELD_COUNT);
+}
+
+void sampler_rollups_add(Rollups *rollups, const ProcessSample *sample) {
+    double values[ROLLUP_FIELD_COUNT] = {
+        sample->cpu_percent, (double)sample->memory_rss, (double)sample->memory_vms,
+        sample->threads, sample->open_files, (double)sample->read_bytes, (double)sample->write_bytes,
+        (double)sample->jail_bytes,
+        (double)sample->net[SAMPLER_NET_RX_BYTES], (double)sample->net[SAMPLER_NET_TX_BYTES],
+        (double)sample->net[SAMPLER_NET_TCP_RETRANS],
+        (double)sample->delays.cpu_delay_total, (double)sample->delays.blkio_delay_total
+    };
+    uint32_t present = 0x7f;   // The /proc fields are always there
+    if (sample->jail_bytes >= 0) present |= 1u << 7;
+    if (sample->has_net && sample->net_isolated) present |= 0x7u << 8; // Host-wide otherwise
+    if (sample->has_delays) present |= 0x3u << 11;
+    
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    rollup_add(rollups, (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000, values, present);
+}
+
 // Write summary to JSONL
-int sampler_write_summary(const char *path, int samples, double duration,
-                         double max_cpu, uint64_t max_rss, int peak_files, int exit_code) {
+int sampler_write_summary(const char *path, const char *run_id, int samples, double duration,
+                          double max_cpu, uint64_t max_rss, int peak_files, int exit_code,
+                          const SamplerSummary *summary) {
     cJSON *root = cJSON_CreateObject();
     if (!root) return -1;
     
@@ -228,6 +661,7 @@ int sampler_write_summary(const char *path, int samples, double duration,
     get_iso_timestamp(timestamp, sizeof(timestamp));
     
     cJSON_AddStringToObject(root, "event", "stop");
+    cJSON_AddStringToObject(root, "run_id", run_id);
     cJSON_AddStringToObject(root, "timestamp", timestamp);
     cJSON_AddNumberToObject(root, "samples", samples);
     cJSON_AddNumberToObject(root, "duration_seconds", duration);
@@ -235,6 +669,9 @@ int sampler_write_summary(const char *path, int samples, double duration,
     cJSON_AddNumberToObject(root, "max_memory_rss", max_rss);
     cJSON_AddNumberToObject(root, "peak_open_files", peak_files);
     cJSON_AddNumberToObject(root, "exit_code", exit_code);
+    if (summary) {
+        sampler_summary_to_json(summary, root);
+    }
     
     char *json_str = cJSON_PrintUnformatted(root);
     int result = append_jsonl(path, json_str);
@@ -269,9 +706,17 @@ int sampler_run(SamplerConfig *config) {
     
     ProcessSample sample;
     memset(&sample, 0, sizeof(sample));
+    SamplerSummary *summary = malloc(sizeof(SamplerSummary));
+    if (summary) sampler_summary_init(summary);
+    Rollups *rollups = config->no_rollups ? NULL : malloc(sizeof(Rollups));
+    if (rollups && sampler_rollups_init(rollups, config->output_path, config->run_id) != 0) {
+        // Optional, like the other collectors: sample on without sidecars
+        free(rollups);
+        rollups = NULL;
+    }
     
     while (g_running && config->running) {
-        if (sampler_collect(config->pid, &sample) != 0) {
+        if (sampler_collect(&config->state, config->pid, &sample) != 0) {
             // Process terminated
             break;
         }
@@ -288,6 +733,8 @@ int sampler_run(SamplerConfig *config) {
         // Update sample with current maximums
         sample.cpu_max = max_cpu;
         sample.memory_rss_max = max_rss;
+        if (summary) sampler_summary_add(summary, &sample);
+        if (rollups) sampler_rollups_add(rollups, &sample);
         
         // Write sample
         sampler_write_jsonl(config->output_path, &sample);
@@ -303,8 +750,12 @@ int sampler_run(SamplerConfig *config) {
     double duration = (end_time.tv_sec - start_time.tv_sec) + 
                      (end_time.tv_nsec - start_time.tv_nsec) / 1e9;
     
-    sampler_write_summary(config->output_path, sample_count, duration,
-                         max_cpu, max_rss, peak_files, 0);
+    sampler_write_summary(config->output_path, config->run_id, sample_count, duration,
+                          max_cpu, max_rss, peak_files, 0, summary);
+    free(summary);
+    if (rollups) rollup_flush(rollups);
+    free(rollups);
+    sampler_state_release(&config->state);
     
     return 0;
 }
@@ -1,13 +1,30 @@
 #ifndef ZENCUBE_SAMPLER_H
 #define ZENCUBE_SAMPLER_H
 
+#include "jailusage.h"
+#include "delayacct.h"
+#include "mapgrowth.h"
+#include "sketch.h"
+#include "rollup.h"
 #include <time.h>
 #include <stdint.h>
 
+// Network counters of the target's namespace, summed over its interfaces
+enum {
+    SAMPLER_NET_RX_BYTES,
+    SAMPLER_NET_TX_BYTES,
+    SAMPLER_NET_RX_PACKETS,
+    SAMPLER_NET_TX_PACKETS,
+    SAMPLER_NET_TCP_RETRANS,
+    SAMPLER_NET_FIELDS
+};
+
 // Sample data structure matching Python Schema
 typedef struct {
     char timestamp[32];      // ISO 8601 UTC timestamp
     char run_id[128];        // Run identifier
+    uint64_t seq;            // Per-run sample sequence number (0-based)
+    uint64_t mono_ns;        // CLOCK_MONOTONIC at collection, for latency tracing
     int pid;
     double cpu_percent;
     uint64_t memory_rss;     // bytes
@@ -18,8 +35,78 @@ typedef struct {
     uint64_t write_bytes;
     double cpu_max;          // Maximum CPU observed
     uint64_t memory_rss_max; // Maximum RSS observed
+    int64_t jail_bytes;      // Allocated bytes in the jail, -1 = not tracked
+    int has_net;             // The target's network namespace was readable
+    int net_isolated;        // It is not the sampler's (host) namespace
+    uint64_t net[SAMPLER_NET_FIELDS]; // Per interval, SAMPLER_NET_* order
+    int has_delays;          // taskstats answered for this sample
+    DelayTotals delays;
+    const MapGrowthTracker *map_scan; // Set when smaps was scanned for this sample
 } ProcessSample;
 
+// cgroup v2 files read for a run's whole process tree
+enum {
+    SAMPLER_CG_CPU_STAT,
+    SAMPLER_CG_MEMORY_CURRENT,
+    SAMPLER_CG_PIDS_CURRENT,
+    SAMPLER_CG_IO_STAT,
+    SAMPLER_CG_FILES
+};
+
+// Per-target collection state (CPU deltas, sequence numbers). One instance
+// per monitored process, so several samplers can run in one address space.
+typedef struct {
+    unsigned long prev_utime;
+    unsigned long prev_stime;
+    struct timespec prev_time;
+    long clock_ticks;
+    uint64_t next_seq;
+    
+    char cgroup_path[512];     // Empty = read the process from /proc only
+    int cgroup_opened;
+    int cgroup_fds[SAMPLER_CG_FILES];  // -1 = file absent (controller not enabled)
+    uint64_t prev_cgroup_usec;
+    
+    JailUsage *jail;           // NULL = no jail usage tracking
+    DelayAcct *delays;         // NULL = no delay accounting
+    MapGrowthTracker *maps;    // NULL = no mapping growth attribution
+    
+    int net_opened;
+    int net_dev_fd;            // /proc/<pid>/net/dev, -1 = unreadable
+    int net_snmp_fd;           // /proc/<pid>/net/snmp
+    int net_isolated;
+    int net_primed;            // prev_net holds a previous reading
+    uint64_t prev_net[SAMPLER_NET_FIELDS];
+} SamplerState;
+
+// Distribution and cost of one run's samples, in fixed memory. CPU percent
+// describes the interval before its sample, so it is integrated over that
+// interval; RSS is a point value, integrated between samples (trapezoid).
+typedef struct {
+    Sketch cpu;                // cpu_percent, from the second sample on
+    Sketch rss;                // rss_bytes
+    uint64_t first_mono_ns;    // 0 = no sample yet
+    uint64_t last_mono_ns;
+    double last_rss;
+    double cpu_seconds;        // CPU time used, in seconds
+    double rss_byte_seconds;   // Memory held over time
+} SamplerSummary;
+
+// One process watched by a shared sampler loop, with its running
+// aggregates. Any number of targets can be collected from one thread.
+typedef struct {
+    int pid;
+    char run_id[128];
+    SamplerState state;
+    int samples;
+    double max_cpu;
+    uint64_t max_rss;
+    int peak_files;
+    uint64_t read_bytes;     // Latest cumulative I/O
+    uint64_t write_bytes;
+    SamplerSummary summary;
+} SamplerTarget;
+
 // Sampler configuration
 typedef struct {
     int pid;
@@ -27,13 +114,53 @@ typedef struct {
     char run_id[128];
     char output_path[512];
     int running;             // atomic flag
+    SamplerState state;
+    char cgroup_path[512];   // Optional; see sampler_state_set_cgroup
+    char jail_path[4096];    // Optional; see sampler_state_set_jail
+    int delays;              // Optional; see sampler_state_set_delays
+    int map_top;             // Optional; see sampler_state_set_map_growth
+    double map_interval;
+    int no_rollups;          // Skip the rollup sidecars of output_path
 } SamplerConfig;
 
 // Initialize sampler
 int sampler_init(SamplerConfig *config);
 
+// Reset collection state for a new target
+void sampler_state_init(SamplerState *state);
+
+// Read CPU, memory, tasks and I/O from the run's cgroup instead of /proc.
+// Files are opened on the next collect and re-read with pread, so a sample
+// costs the same however many processes the run has. Liveness, VMS and
+// open files still come from /proc/<pid>.
+void sampler_state_set_cgroup(SamplerState *state, const char *path);
+
+// Report the jail directory's disk usage as jail_bytes. One scan now, then
+// each sample only applies the inotify events since the last one.
+int sampler_state_set_jail(SamplerState *state, const char *jail_dir);
+
+// Add the target's delay accounting (taskstats over one netlink socket
+// kept open for the whole run). Returns -1 if taskstats is unavailable.
+int sampler_state_set_delays(SamplerState *state);
+
+// Attribute memory growth to mappings: every min_interval_s at most (and
+// less often when smaps is slow to read), diff /proc/<pid>/smaps against
+// the previous scan and report the top_n mappings whose Rss grew.
+int sampler_state_set_map_growth(SamplerState *state, int top_n, double min_interval_s);
+
+// Close the cgroup and network files, the jail tracker, the taskstats
+// socket and the smaps collector
+void sampler_state_release(SamplerState *state);
+
 // Collect single sample
-int sampler_collect(int pid, ProcessSample *sample);
+int sampler_collect(SamplerState *state, int pid, ProcessSample *sample);
+
+// Start watching pid under run_id
+void sampler_target_init(SamplerTarget *target, int pid, const char *run_id);
+
+// Collect one sample for target, fold it into the aggregates and append it
+// to output_path (NULL = aggregates only). Returns -1 once the process is gone.
+int sampler_target_collect(SamplerTarget *target, const char *output_path);
 
 // Start sampling loop (blocking)
 int sampler_run(SamplerConfig *config);
@@ -44,9 +171,26 @@ void sampler_stop(SamplerConfig *config);
 // Write sample to JSONL
 int sampler_write_jsonl(const char *path, const ProcessSample *sample);
 
-// Write summary to JSONL
-int sampler_write_summary(const char *path, int samples, double duration, 
-                          double max_cpu, uint64_t max_rss, int peak_files, int exit_code);
+void sampler_summary_init(SamplerSummary *summary);
+
+// Fold one sample into the sketches and integrals
+void sampler_summary_add(SamplerSummary *summary, const ProcessSample *sample);
+
+// Add p50/p90/p99, time-weighted averages, cpu_seconds, rss_gib_seconds
+// and the mergeable sketches to a stop or job event
+void sampler_summary_to_json(const SamplerSummary *summary, cJSON *event);
+
+// 10 s / 1 min / 10 min rollups of a run's samples, next to its JSONL log
+int sampler_rollups_init(Rollups *rollups, const char *out_path, const char *run_id);
+
+// Fold a sample in at the current wall-clock time. Absent optional fields
+// (jail, network, delays) are left out rather than counted as zero.
+void sampler_rollups_add(Rollups *rollups, const ProcessSample *sample);
+
+// Write summary to JSONL (summary may be NULL)
+int sampler_write_summary(const char *path, const char *run_id, int samples, double duration,
+                          double max_cpu, uint64_t max_rss, int peak_files, int exit_code,
+                          const SamplerSummary *summary);
 
 // Get ISO timestamp
 void get_iso_timestamp(char *buffer, size_t size);
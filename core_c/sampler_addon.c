@@ -0,0 +1,361 @@
+// Node N-API addon exposing the sampler in-process.
+//
+// Each sampler instance owns a native thread that calls sampler_collect()
+// on its own SamplerState and hands column-major batches to JavaScript
+// through a threadsafe function, so the consuming thread (the monitoring
+// worker) never blocks on /proc and no sampler process or temp file is
+// needed.
+//
+// JS usage:
+//   const handle = addon.start({ pid, intervalMs, batchMs, runId, out }, cb);
+//   cb({ fields, count, columns: Float64Array, ended })
+//   handle.stop();
+
+#define NAPI_VERSION 8
+#include <node_api.h>
+
+#include "sampler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+// Batch columns, in order
+static const char *const BATCH_FIELDS[] = {
+    "seq", "mono_ms", "cpu_percent", "rss_bytes", "vms_bytes",
+    "threads", "fds_open", "read_bytes", "write_bytes"
+};
+#define FIELD_COUNT (sizeof(BATCH_FIELDS) / sizeof(BATCH_FIELDS[0]))
+#define MAX_BATCH 4096
+
+typedef struct {
+    int pid;
+    unsigned interval_ms;
+    unsigned batch_ms;
+    char run_id[128];
+    char out_path[512];      // optional JSONL copy for exporter/alerts
+    char cgroup_path[512];   // optional: read the run's cgroup v2 files
+    char jail_path[4096];    // optional: jail_bytes in the JSONL copy
+    unsigned delays;         // optional: taskstats delays in the JSONL copy
+    unsigned map_growth;     // optional: top N growing mappings in the JSONL copy
+    unsigned rollups;        // 10s/1m/10m sidecars of the JSONL copy (default on)
+    SamplerState state;
+    
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int stopping;
+    int started;
+    int joined;
+    napi_threadsafe_function tsfn;
+} AddonSampler;
+
+typedef struct {
+    size_t count;
+    int ended;               // last batch: target exited or sampler stopped
+    double values[];         // FIELD_COUNT * count, column-major
+} AddonBatch;
+
+#define NAPI_CALL(env, call)                                        \
+    do {                                                            \
+        if ((call) != napi_ok) {                                    \
+            napi_throw_error((env), NULL, "N-API call failed: " #call); \
+            return NULL;                                            \
+        }                                                           \
+    } while (0)
+
+// Convert staged rows into a column-major batch
+static AddonBatch *make_batch(const double *rows, size_t count, int ended) {
+    AddonBatch *batch = malloc(sizeof(AddonBatch) + sizeof(double) * FIELD_COUNT * count);
+    if (!batch) return NULL;
+    
+    batch->count = count;
+    batch->ended = ended;
+    for (size_t i = 0; i < count; i++) {
+        for (size_t f = 0; f < FIELD_COUNT; f++) {
+            batch->values[f * count + i] = rows[i * FIELD_COUNT + f];
+        }
+    }
+    return batch;
+}
+
+static void flush_batch(AddonSampler *s, const double *rows, size_t *count, int ended) {
+    if (*count == 0 && !ended) return;
+    
+    AddonBatch *batch = make_batch(rows, *count, ended);
+    if (batch && napi_call_threadsafe_function(s->tsfn, batch, napi_tsfn_nonblocking) != napi_ok) {
+        free(batch);
+    }
+    *count = 0;
+}
+
+static uint64_t mono_now_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000ULL + (uint64_t)now.tv_nsec / 1000000ULL;
+}
+
+// Native sampling thread
+static void *sampler_thread(void *arg) {
+    AddonSampler *s = arg;
+    double *rows = malloc(sizeof(double) * FIELD_COUNT * MAX_BATCH);
+    size_t count = 0;
+    
+    double max_cpu = 0.0;
+    uint64_t max_rss = 0;
+    ProcessSample sample;
+    memset(&sample, 0, sizeof(sample));
+    snprintf(sample.run_id, sizeof(sample.run_id), "%s", s->run_id);
+    
+    Rollups *rollups = s->out_path[0] && s->rollups ? malloc(sizeof(Rollups)) : NULL;
+    if (rollups && sampler_rollups_init(rollups, s->out_path, s->run_id) != 0) {
+        free(rollups);
+        rollups = NULL;
+    }
+    
+    uint64_t last_flush = mono_now_ms();
+    
+    pthread_mutex_lock(&s->lock);
+    while (!s->stopping && rows) {
+        pthread_mutex_unlock(&s->lock);
+        
+        if (sampler_collect(&s->state, s->pid, &sample) != 0) {
+            pthread_mutex_lock(&s->lock);
+            break;  // Process terminated
+        }
+        
+        if (sample.cpu_percent > max_cpu) max_cpu = sample.cpu_percent;
+        if (sample.memory_rss > max_rss) max_rss = sample.memory_rss;
+        sample.cpu_max = max_cpu;
+        sample.memory_rss_max = max_rss;
+        
+        if (s->out_path[0]) {
+            sampler_write_jsonl(s->out_path, &sample);
+        }
+        if (rollups) sampler_rollups_add(rollups, &sample);
+        
+        double *row = &rows[count * FIELD_COUNT];
+        row[0] = (double)sample.seq;
+        row[1] = sample.mono_ns / 1e6;
+        row[2] = sample.cpu_percent;
+        row[3] = (double)sample.memory_rss;
+        row[4] = (double)sample.memory_vms;
+        row[5] = sample.threads;
+        row[6] = sample.open_files;
+        row[7] = (double)sample.read_bytes;
+        row[8] = (double)sample.write_bytes;
+        count++;
+        
+        uint64_t now = mono_now_ms();
+        if (count == MAX_BATCH || now - last_flush >= s->batch_ms) {
+            flush_batch(s, rows, &count, 0);
+            last_flush = now;
+        }
+        
+        // Sleep for interval, waking early on stop()
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += s->interval_ms / 1000;
+        deadline.tv_nsec += (long)(s->interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        
+        pthread_mutex_lock(&s->lock);
+        while (!s->stopping &&
+               pthread_cond_timedwait(&s->wake, &s->lock, &deadline) != ETIMEDOUT) {
+        }
+    }
+    pthread_mutex_unlock(&s->lock);
+    
+    // Final batch carries ended=true whether the target exited or stop() ran
+    flush_batch(s, rows, &count, 1);
+    free(rows);
+    if (rollups) rollup_flush(rollups);
+    free(rollups);
+    
+    napi_release_threadsafe_function(s->tsfn, napi_tsfn_release);
+    return NULL;
+}
+
+// Runs on the JS thread for every batch
+static void call_js(napi_env env, napi_value js_cb, void *context, void *data) {
+    (void)context;
+    AddonBatch *batch = data;
+    
+    if (env && js_cb) {
+        napi_value obj, fields, count, columns, buffer, ended, undefined;
+        void *buffer_data = NULL;
+        size_t bytes = sizeof(double) * FIELD_COUNT * batch->count;
+        
+        // External buffers are not allowed under Electron's V8 sandbox; one
+        // memcpy of the packed columns is the only per-batch copy
+        napi_create_object(env, &obj);
+        napi_create_array_with_length(env, FIELD_COUNT, &fields);
+        for (size_t f = 0; f < FIELD_COUNT; f++) {
+            napi_value name;
+            napi_create_string_utf8(env, BATCH_FIELDS[f], NAPI_AUTO_LENGTH, &name);
+            napi_set_element(env, fields, (uint32_t)f, name);
+        }
+        napi_create_arraybuffer(env, bytes, &buffer_data, &buffer);
+        if (bytes > 0) memcpy(buffer_data, batch->values, bytes);
+        napi_create_typedarray(env, napi_float64_array, FIELD_COUNT * batch->count,
+                               buffer, 0, &columns);
+        napi_create_uint32(env, (uint32_t)batch->count, &count);
+        napi_get_boolean(env, batch->ended, &ended);
+        
+        napi_set_named_property(env, obj, "fields", fields);
+        napi_set_named_property(env, obj, "count", count);
+        napi_set_named_property(env, obj, "columns", columns);
+        napi_set_named_property(env, obj, "ended", ended);
+        
+        napi_get_undefined(env, &undefined);
+        napi_call_function(env, undefined, js_cb, 1, &obj, NULL);
+    }
+    
+    free(batch);
+}
+
+static void stop_sampler(AddonSampler *s) {
+    if (!s->started || s->joined) return;
+    
+    pthread_mutex_lock(&s->lock);
+    s->stopping = 1;
+    pthread_cond_signal(&s->wake);
+    pthread_mutex_unlock(&s->lock);
+    
+    pthread_join(s->thread, NULL);
+    s->joined = 1;
+}
+
+static void finalize_sampler(napi_env env, void *data, void *hint) {
+    (void)env;
+    (void)hint;
+    AddonSampler *s = data;
+    stop_sampler(s);
+    sampler_state_release(&s->state);
+    pthread_mutex_destroy(&s->lock);
+    pthread_cond_destroy(&s->wake);
+    free(s);
+}
+
+static napi_value js_stop(napi_env env, napi_callback_info info) {
+    void *data = NULL;
+    NAPI_CALL(env, napi_get_cb_info(env, info, NULL, NULL, NULL, &data));
+    stop_sampler(data);
+    return NULL;
+}
+
+static int get_uint_property(napi_env env, napi_value obj, const char *name, unsigned *out) {
+    bool has = false;
+    napi_value value;
+    if (napi_has_named_property(env, obj, name, &has) != napi_ok || !has) return 0;
+    if (napi_get_named_property(env, obj, name, &value) != napi_ok) return -1;
+    return napi_get_value_uint32(env, value, out) == napi_ok ? 1 : -1;
+}
+
+static int get_string_property(napi_env env, napi_value obj, const char *name, char *out, size_t size) {
+    bool has = false;
+    napi_value value;
+    size_t len;
+    if (napi_has_named_property(env, obj, name, &has) != napi_ok || !has) return 0;
+    if (napi_get_named_property(env, obj, name, &value) != napi_ok) return -1;
+    return napi_get_value_string_utf8(env, value, out, size, &len) == napi_ok ? 1 : -1;
+}
+
+// start({ pid, intervalMs, batchMs, runId, out, cgroup, jail, delays, mapGrowth, rollups },
+//       callback) -> { stop() }
+static napi_value js_start(napi_env env, napi_callback_info info) {
+    size_t argc = 2;
+    napi_value argv[2];
+    NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+    
+    napi_valuetype opts_type = napi_undefined, cb_type = napi_undefined;
+    if (argc == 2) {
+        napi_typeof(env, argv[0], &opts_type);
+        napi_typeof(env, argv[1], &cb_type);
+    }
+    if (opts_type != napi_object || cb_type != napi_function) {
+        napi_throw_type_error(env, NULL, "start(options, callback) expected");
+        return NULL;
+    }
+    
+    AddonSampler *s = calloc(1, sizeof(AddonSampler));
+    if (!s) {
+        napi_throw_error(env, NULL, "Out of memory");
+        return NULL;
+    }
+    
+    unsigned pid = 0;
+    s->interval_ms = 1000;
+    s->batch_ms = 1000;
+    s->rollups = 1;
+    if (get_uint_property(env, argv[0], "pid", &pid) != 1 || pid == 0 ||
+        get_uint_property(env, argv[0], "intervalMs", &s->interval_ms) < 0 ||
+        get_uint_property(env, argv[0], "batchMs", &s->batch_ms) < 0 ||
+        get_string_property(env, argv[0], "runId", s->run_id, sizeof(s->run_id)) < 0 ||
+        get_string_property(env, argv[0], "out", s->out_path, sizeof(s->out_path)) < 0 ||
+        get_string_property(env, argv[0], "cgroup", s->cgroup_path, sizeof(s->cgroup_path)) < 0 ||
+        get_string_property(env, argv[0], "jail", s->jail_path, sizeof(s->jail_path)) < 0 ||
+        get_uint_property(env, argv[0], "delays", &s->delays) < 0 ||
+        get_uint_property(env, argv[0], "mapGrowth", &s->map_growth) < 0 ||
+        get_uint_property(env, argv[0], "rollups", &s->rollups) < 0) {
+        free(s);
+        napi_throw_type_error(env, NULL, "Invalid sampler options (pid required)");
+        return NULL;
+    }
+    if (s->interval_ms == 0) s->interval_ms = 1;
+    s->pid = (int)pid;
+    sampler_state_init(&s->state);
+    if (s->cgroup_path[0]) {
+        sampler_state_set_cgroup(&s->state, s->cgroup_path);
+    }
+    if (s->jail_path[0]) {
+        sampler_state_set_jail(&s->state, s->jail_path);
+    }
+    if (s->delays) {
+        sampler_state_set_delays(&s->state);
+    }
+    if (s->map_growth) {
+        sampler_state_set_map_growth(&s->state, (int)s->map_growth, 10.0);
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->wake, NULL);
+    
+    napi_value resource_name;
+    napi_create_string_utf8(env, "zencube_sampler", NAPI_AUTO_LENGTH, &resource_name);
+    if (napi_create_threadsafe_function(env, argv[1], NULL, resource_name, 0, 1,
+                                        NULL, NULL, s, call_js, &s->tsfn) != napi_ok) {
+        finalize_sampler(env, s, NULL);
+        napi_throw_error(env, NULL, "Failed to create threadsafe function");
+        return NULL;
+    }
+    
+    if (pthread_create(&s->thread, NULL, sampler_thread, s) != 0) {
+        napi_release_threadsafe_function(s->tsfn, napi_tsfn_abort);
+        finalize_sampler(env, s, NULL);
+        napi_throw_error(env, NULL, "Failed to start sampler thread");
+        return NULL;
+    }
+    s->started = 1;
+    
+    napi_value handle, stop_fn;
+    NAPI_CALL(env, napi_create_object(env, &handle));
+    NAPI_CALL(env, napi_create_function(env, "stop", NAPI_AUTO_LENGTH, js_stop, s, &stop_fn));
+    NAPI_CALL(env, napi_set_named_property(env, handle, "stop", stop_fn));
+    // stop() carries the instance pointer, so it owns the instance
+    NAPI_CALL(env, napi_add_finalizer(env, stop_fn, s, finalize_sampler, NULL, NULL));
+    
+    return handle;
+}
+
+static napi_value init(napi_env env, napi_value exports) {
+    napi_value start_fn;
+    NAPI_CALL(env, napi_create_function(env, "start", NAPI_AUTO_LENGTH, js_start, NULL, &start_fn));
+    NAPI_CALL(env, napi_set_named_property(env, exports, "start", start_fn));
+    return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
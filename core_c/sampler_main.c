@@ -11,6 +11,12 @@ static void print_usage(const char *prog) {
     printf("  --interval SECS    Sampling interval in seconds (default: 1.0)\n");
     printf("  --run-id ID        Unique run identifier\n");
     printf("  --out PATH         Output JSONL file path\n");
+    printf("  --cgroup PATH      Read CPU, memory, tasks and I/O from this cgroup v2\n");
+    printf("  --delays           Add taskstats delay accounting (CPU, block I/O, swap-in, reclaim)\n");
+    printf("  --map-growth N     Every --map-interval, report the N mappings whose RSS grew most\n");
+    printf("  --map-interval S   Minimum seconds between smaps scans (default: 10)\n");
+    printf("  --jail DIR         Report DIR's disk usage as jail_bytes (one scan, then inotify)\n");
+    printf("  --no-rollups       Do not write the 10s/1m/10m rollups (PATH.10s.jsonl etc.)\n");
     printf("  --help             Show this help message\n");
     printf("\nExample:\n");
     printf("  %s --pid 12345 --interval 1.0 --run-id monitor_run_123 --out log.jsonl\n", prog);
@@ -26,12 +32,18 @@ int main(int argc, char *argv[]) {
         {"interval", required_argument, 0, 'i'},
         {"run-id",   required_argument, 0, 'r'},
         {"out",      required_argument, 0, 'o'},
+        {"cgroup",   required_argument, 0, 'c'},
+        {"jail",     required_argument, 0, 'j'},
+        {"delays",   no_argument,       0, 'd'},
+        {"map-growth",   required_argument, 0, 'g'},
+        {"map-interval", required_argument, 0, 'G'},
+        {"no-rollups",   no_argument,       0, 'R'},
         {"help",     no_argument,       0, 'h'},
         {0, 0, 0, 0}
     };
     
     int opt, option_index = 0;
-    while ((opt = getopt_long(argc, argv, "p:i:r:o:h", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:i:r:o:c:j:dg:G:Rh", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'p':
                 config.pid = atoi(optarg);
@@ -45,6 +57,24 @@ int main(int argc, char *argv[]) {
             case 'o':
                 strncpy(config.output_path, optarg, sizeof(config.output_path) - 1);
                 break;
+            case 'c':
+                strncpy(config.cgroup_path, optarg, sizeof(config.cgroup_path) - 1);
+                break;
+            case 'j':
+                strncpy(config.jail_path, optarg, sizeof(config.jail_path) - 1);
+                break;
+            case 'd':
+                config.delays = 1;
+                break;
+            case 'g':
+                config.map_top = atoi(optarg);
+                break;
+            case 'G':
+                config.map_interval = atof(optarg);
+                break;
+            case 'R':
+                config.no_rollups = 1;
+                break;
             case 'h':
                 print_usage(argv[0]);
                 return 0;
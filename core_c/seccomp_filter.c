@@ -0,0 +1,445 @@
+#include "seccomp_filter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/audit.h>
+#include <linux/seccomp.h>
+
+#if defined(__x86_64__)
+#define SECCOMP_AUDIT_ARCH AUDIT_ARCH_X86_64
+#define SECCOMP_X32_BIT 0x40000000U
+#elif defined(__aarch64__)
+#define SECCOMP_AUDIT_ARCH AUDIT_ARCH_AARCH64
+#else
+#error "seccomp_filter: unsupported architecture"
+#endif
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define ARG0_LOW offsetof(struct seccomp_data, args[0])
+#else
+#define ARG0_LOW (offsetof(struct seccomp_data, args[0]) + 4)
+#endif
+
+// Jump offsets in classic BPF conditionals are 8 bits
+#define MAX_SHORT_JUMP 255
+
+typedef struct {
+    const char *name;
+    int nr;
+} SyscallName;
+
+#define SYSCALL(name) { #name, __NR_##name }
+
+static const SyscallName SYSCALL_NAMES[] = {
+#if defined(__x86_64__)
+    SYSCALL(read), SYSCALL(write), SYSCALL(open), SYSCALL(close), SYSCALL(stat), SYSCALL(fstat),
+    SYSCALL(lstat), SYSCALL(poll), SYSCALL(lseek), SYSCALL(mmap), SYSCALL(mprotect),
+    SYSCALL(munmap), SYSCALL(brk), SYSCALL(rt_sigaction), SYSCALL(rt_sigprocmask),
+    SYSCALL(rt_sigreturn), SYSCALL(ioctl), SYSCALL(pread64), SYSCALL(pwrite64), SYSCALL(readv),
+    SYSCALL(writev), SYSCALL(access), SYSCALL(pipe), SYSCALL(select), SYSCALL(sched_yield),
+    SYSCALL(mremap), SYSCALL(msync), SYSCALL(mincore), SYSCALL(madvise), SYSCALL(shmget),
+    SYSCALL(shmat), SYSCALL(shmctl), SYSCALL(dup), SYSCALL(dup2), SYSCALL(pause),
+    SYSCALL(nanosleep), SYSCALL(getitimer), SYSCALL(alarm), SYSCALL(setitimer), SYSCALL(getpid),
+    SYSCALL(sendfile), SYSCALL(socket), SYSCALL(connect), SYSCALL(accept), SYSCALL(sendto),
+    SYSCALL(recvfrom), SYSCALL(sendmsg), SYSCALL(recvmsg), SYSCALL(shutdown), SYSCALL(bind),
+    SYSCALL(listen), SYSCALL(getsockname), SYSCALL(getpeername), SYSCALL(socketpair),
+    SYSCALL(setsockopt), SYSCALL(getsockopt), SYSCALL(clone), SYSCALL(fork), SYSCALL(vfork),
+    SYSCALL(execve), SYSCALL(exit), SYSCALL(wait4), SYSCALL(kill), SYSCALL(uname),
+    SYSCALL(semget), SYSCALL(semop), SYSCALL(semctl), SYSCALL(shmdt), SYSCALL(msgget),
+    SYSCALL(msgsnd), SYSCALL(msgrcv), SYSCALL(msgctl), SYSCALL(fcntl), SYSCALL(flock),
+    SYSCALL(fsync), SYSCALL(fdatasync), SYSCALL(truncate), SYSCALL(ftruncate),
+    SYSCALL(getdents), SYSCALL(getcwd), SYSCALL(chdir), SYSCALL(fchdir), SYSCALL(rename),
+    SYSCALL(mkdir), SYSCALL(rmdir), SYSCALL(creat), SYSCALL(link), SYSCALL(unlink),
+    SYSCALL(symlink), SYSCALL(readlink), SYSCALL(chmod), SYSCALL(fchmod), SYSCALL(chown),
+    SYSCALL(fchown), SYSCALL(lchown), SYSCALL(umask), SYSCALL(gettimeofday), SYSCALL(getrlimit),
+    SYSCALL(getrusage), SYSCALL(sysinfo), SYSCALL(times), SYSCALL(ptrace), SYSCALL(getuid),
+    SYSCALL(syslog), SYSCALL(getgid), SYSCALL(setuid), SYSCALL(setgid), SYSCALL(geteuid),
+    SYSCALL(getegid), SYSCALL(setpgid), SYSCALL(getppid), SYSCALL(getpgrp), SYSCALL(setsid),
+    SYSCALL(setreuid), SYSCALL(setregid), SYSCALL(getgroups), SYSCALL(setgroups),
+    SYSCALL(setresuid), SYSCALL(getresuid), SYSCALL(setresgid), SYSCALL(getresgid),
+    SYSCALL(getpgid), SYSCALL(setfsuid), SYSCALL(setfsgid), SYSCALL(getsid), SYSCALL(capget),
+    SYSCALL(capset), SYSCALL(rt_sigpending), SYSCALL(rt_sigtimedwait), SYSCALL(rt_sigqueueinfo),
+    SYSCALL(rt_sigsuspend), SYSCALL(sigaltstack), SYSCALL(utime), SYSCALL(mknod),
+    SYSCALL(uselib), SYSCALL(personality), SYSCALL(ustat), SYSCALL(statfs), SYSCALL(fstatfs),
+    SYSCALL(sysfs), SYSCALL(getpriority), SYSCALL(setpriority), SYSCALL(sched_setparam),
+    SYSCALL(sched_getparam), SYSCALL(sched_setscheduler), SYSCALL(sched_getscheduler),
+    SYSCALL(sched_get_priority_max), SYSCALL(sched_get_priority_min),
+    SYSCALL(sched_rr_get_interval), SYSCALL(mlock), SYSCALL(munlock), SYSCALL(mlockall),
+    SYSCALL(munlockall), SYSCALL(vhangup), SYSCALL(modify_ldt), SYSCALL(pivot_root),
+    SYSCALL(_sysctl), SYSCALL(prctl), SYSCALL(arch_prctl), SYSCALL(adjtimex),
+    SYSCALL(setrlimit), SYSCALL(chroot), SYSCALL(sync), SYSCALL(acct), SYSCALL(settimeofday),
+    SYSCALL(mount), SYSCALL(umount2), SYSCALL(swapon), SYSCALL(swapoff), SYSCALL(reboot),
+    SYSCALL(sethostname), SYSCALL(setdomainname), SYSCALL(iopl), SYSCALL(ioperm),
+    SYSCALL(create_module), SYSCALL(init_module), SYSCALL(delete_module),
+    SYSCALL(get_kernel_syms), SYSCALL(query_module), SYSCALL(quotactl), SYSCALL(nfsservctl),
+    SYSCALL(getpmsg), SYSCALL(putpmsg), SYSCALL(afs_syscall), SYSCALL(tuxcall),
+    SYSCALL(security), SYSCALL(gettid), SYSCALL(readahead), SYSCALL(setxattr),
+    SYSCALL(lsetxattr), SYSCALL(fsetxattr), SYSCALL(getxattr), SYSCALL(lgetxattr),
+    SYSCALL(fgetxattr), SYSCALL(listxattr), SYSCALL(llistxattr), SYSCALL(flistxattr),
+    SYSCALL(removexattr), SYSCALL(lremovexattr), SYSCALL(fremovexattr), SYSCALL(tkill),
+    SYSCALL(time), SYSCALL(futex), SYSCALL(sched_setaffinity), SYSCALL(sched_getaffinity),
+    SYSCALL(set_thread_area), SYSCALL(io_setup), SYSCALL(io_destroy), SYSCALL(io_getevents),
+    SYSCALL(io_submit), SYSCALL(io_cancel), SYSCALL(get_thread_area), SYSCALL(lookup_dcookie),
+    SYSCALL(epoll_create), SYSCALL(epoll_ctl_old), SYSCALL(epoll_wait_old),
+    SYSCALL(remap_file_pages), SYSCALL(getdents64), SYSCALL(set_tid_address),
+    SYSCALL(restart_syscall), SYSCALL(semtimedop), SYSCALL(fadvise64), SYSCALL(timer_create),
+    SYSCALL(timer_settime), SYSCALL(timer_gettime), SYSCALL(timer_getoverrun),
+    SYSCALL(timer_delete), SYSCALL(clock_settime), SYSCALL(clock_gettime),
+    SYSCALL(clock_getres), SYSCALL(clock_nanosleep), SYSCALL(exit_group), SYSCALL(epoll_wait),
+    SYSCALL(epoll_ctl), SYSCALL(tgkill), SYSCALL(utimes), SYSCALL(vserver), SYSCALL(mbind),
+    SYSCALL(set_mempolicy), SYSCALL(get_mempolicy), SYSCALL(mq_open), SYSCALL(mq_unlink),
+    SYSCALL(mq_timedsend), SYSCALL(mq_timedreceive), SYSCALL(mq_notify), SYSCALL(mq_getsetattr),
+    SYSCALL(kexec_load), SYSCALL(waitid), SYSCALL(add_key), SYSCALL(request_key),
+    SYSCALL(keyctl), SYSCALL(ioprio_set), SYSCALL(ioprio_get), SYSCALL(inotify_init),
+    SYSCALL(inotify_add_watch), SYSCALL(inotify_rm_watch), SYSCALL(migrate_pages),
+    SYSCALL(openat), SYSCALL(mkdirat), SYSCALL(mknodat), SYSCALL(fchownat), SYSCALL(futimesat),
+    SYSCALL(newfstatat), SYSCALL(unlinkat), SYSCALL(renameat), SYSCALL(linkat),
+    SYSCALL(symlinkat), SYSCALL(readlinkat), SYSCALL(fchmodat), SYSCALL(faccessat),
+    SYSCALL(pselect6), SYSCALL(ppoll), SYSCALL(unshare), SYSCALL(set_robust_list),
+    SYSCALL(get_robust_list), SYSCALL(splice), SYSCALL(tee), SYSCALL(sync_file_range),
+    SYSCALL(vmsplice), SYSCALL(move_pages), SYSCALL(utimensat), SYSCALL(epoll_pwait),
+    SYSCALL(signalfd), SYSCALL(timerfd_create), SYSCALL(eventfd), SYSCALL(fallocate),
+    SYSCALL(timerfd_settime), SYSCALL(timerfd_gettime), SYSCALL(accept4), SYSCALL(signalfd4),
+    SYSCALL(eventfd2), SYSCALL(epoll_create1), SYSCALL(dup3), SYSCALL(pipe2),
+    SYSCALL(inotify_init1), SYSCALL(preadv), SYSCALL(pwritev), SYSCALL(rt_tgsigqueueinfo),
+    SYSCALL(perf_event_open), SYSCALL(recvmmsg), SYSCALL(fanotify_init), SYSCALL(fanotify_mark),
+    SYSCALL(prlimit64), SYSCALL(name_to_handle_at), SYSCALL(open_by_handle_at),
+    SYSCALL(clock_adjtime), SYSCALL(syncfs), SYSCALL(sendmmsg), SYSCALL(setns), SYSCALL(getcpu),
+    SYSCALL(process_vm_readv), SYSCALL(process_vm_writev), SYSCALL(kcmp), SYSCALL(finit_module),
+    SYSCALL(sched_setattr), SYSCALL(sched_getattr), SYSCALL(renameat2), SYSCALL(seccomp),
+    SYSCALL(getrandom), SYSCALL(memfd_create), SYSCALL(kexec_file_load), SYSCALL(bpf),
+    SYSCALL(execveat), SYSCALL(userfaultfd), SYSCALL(membarrier), SYSCALL(mlock2),
+    SYSCALL(copy_file_range), SYSCALL(preadv2), SYSCALL(pwritev2), SYSCALL(pkey_mprotect),
+    SYSCALL(pkey_alloc), SYSCALL(pkey_free), SYSCALL(statx), SYSCALL(io_pgetevents),
+    SYSCALL(rseq), SYSCALL(pidfd_send_signal), SYSCALL(io_uring_setup), SYSCALL(io_uring_enter),
+    SYSCALL(io_uring_register), SYSCALL(open_tree), SYSCALL(move_mount), SYSCALL(fsopen),
+    SYSCALL(fsconfig), SYSCALL(fsmount), SYSCALL(fspick), SYSCALL(pidfd_open), SYSCALL(clone3),
+    SYSCALL(close_range), SYSCALL(openat2), SYSCALL(pidfd_getfd), SYSCALL(faccessat2),
+    SYSCALL(process_madvise), SYSCALL(epoll_pwait2), SYSCALL(mount_setattr),
+    SYSCALL(quotactl_fd), SYSCALL(landlock_create_ruleset), SYSCALL(landlock_add_rule),
+    SYSCALL(landlock_restrict_self), SYSCALL(memfd_secret), SYSCALL(process_mrelease),
+    SYSCALL(futex_waitv), SYSCALL(set_mempolicy_home_node),
+#endif
+    { NULL, -1 }
+};
+
+// What one syscall range does once dispatched
+typedef struct {
+    uint32_t action;
+    int has_arg0;
+    uint32_t arg0;
+} Leaf;
+
+// Range [start, next segment's start) with one leaf
+typedef struct {
+    uint32_t start;
+    Leaf leaf;
+} Segment;
+
+// Growable instruction buffer
+typedef struct {
+    struct sock_filter *insns;
+    size_t len;
+    size_t capacity;
+} Code;
+
+uint32_t seccomp_action_errno(int err) {
+    return SECCOMP_RET_ERRNO | ((uint32_t)err & SECCOMP_RET_DATA);
+}
+
+uint32_t seccomp_action_allow(void) {
+    return SECCOMP_RET_ALLOW;
+}
+
+uint32_t seccomp_action_kill(void) {
+    return SECCOMP_RET_KILL_PROCESS;
+}
+
+void seccomp_policy_init(SeccompPolicy *policy, uint32_t default_action) {
+    memset(policy, 0, sizeof(SeccompPolicy));
+    policy->default_action = default_action;
+}
+
+static int add_rule(SeccompPolicy *policy, const SeccompRule *rule) {
+    if (rule->nr < 0) return -1;
+
+    if (policy->count == policy->capacity) {
+        int capacity = policy->capacity ? policy->capacity * 2 : 64;
+        SeccompRule *rules = realloc(policy->rules, (size_t)capacity * sizeof(SeccompRule));
+        if (!rules) return -1;
+        policy->rules = rules;
+        policy->capacity = capacity;
+    }
+
+    policy->rules[policy->count++] = *rule;
+    return 0;
+}
+
+int seccomp_policy_add(SeccompPolicy *policy, int nr, uint32_t action) {
+    SeccompRule rule = { nr, action, 0, 0 };
+    return add_rule(policy, &rule);
+}
+
+int seccomp_policy_add_arg0(SeccompPolicy *policy, int nr, uint32_t action, uint32_t arg0) {
+    SeccompRule rule = { nr, action, 1, arg0 };
+    return add_rule(policy, &rule);
+}
+
+int seccomp_syscall_number(const char *name) {
+    char *end;
+    long nr = strtol(name, &end, 10);
+    if (*name && *end == '\0') return nr >= 0 ? (int)nr : -1;
+
+    for (int i = 0; SYSCALL_NAMES[i].name; i++) {
+        if (strcmp(SYSCALL_NAMES[i].name, name) == 0) return SYSCALL_NAMES[i].nr;
+    }
+    return -1;
+}
+
+int seccomp_policy_add_list(SeccompPolicy *policy, const char *list, uint32_t action) {
+    char *copy = strdup(list);
+    if (!copy) return -1;
+
+    int rc = 0;
+    char *saveptr = NULL;
+    for (char *name = strtok_r(copy, ",", &saveptr); name; name = strtok_r(NULL, ",", &saveptr)) {
+        int nr = seccomp_syscall_number(name);
+        if (nr < 0) {
+            fprintf(stderr, "Unknown syscall: %s\n", name);
+            rc = -1;
+            break;
+        }
+        seccomp_policy_add(policy, nr, action);
+    }
+
+    free(copy);
+    return rc;
+}
+
+int seccomp_policy_add_network_deny(SeccompPolicy *policy) {
+    if (seccomp_policy_add_arg0(policy, __NR_socket, seccomp_action_errno(EACCES), AF_UNIX) != 0) return -1;
+#ifdef __NR_io_uring_setup
+    if (seccomp_policy_add(policy, __NR_io_uring_setup, seccomp_action_errno(ENOSYS)) != 0) return -1;
+#endif
+    return 0;
+}
+
+void seccomp_policy_free(SeccompPolicy *policy) {
+    free(policy->rules);
+    policy->rules = NULL;
+    policy->count = 0;
+    policy->capacity = 0;
+}
+
+static int emit(Code *code, struct sock_filter insn) {
+    if (code->len == code->capacity) {
+        size_t capacity = code->capacity ? code->capacity * 2 : 64;
+        struct sock_filter *insns = realloc(code->insns, capacity * sizeof(struct sock_filter));
+        if (!insns) return -1;
+        code->insns = insns;
+        code->capacity = capacity;
+    }
+    code->insns[code->len++] = insn;
+    return 0;
+}
+
+static int append(Code *code, const Code *tail) {
+    for (size_t i = 0; i < tail->len; i++) {
+        if (emit(code, tail->insns[i]) != 0) return -1;
+    }
+    return 0;
+}
+
+static int leaf_equal(const Leaf *a, const Leaf *b) {
+    return a->action == b->action && a->has_arg0 == b->has_arg0 && (!a->has_arg0 || a->arg0 == b->arg0);
+}
+
+static Leaf rule_leaf(const SeccompRule *rule) {
+    Leaf leaf = { rule->action, rule->has_arg0, rule->arg0 };
+    return leaf;
+}
+
+static int emit_leaf(Code *code, const Leaf *leaf) {
+    if (leaf->has_arg0) {
+        if (emit(code, (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, ARG0_LOW)) != 0) return -1;
+        if (emit(code, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, leaf->arg0, 0, 1)) != 0) return -1;
+        if (emit(code, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW)) != 0) return -1;
+    }
+    return emit(code, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, leaf->action));
+}
+
+// Order rules by syscall, keeping insertion order among duplicates so the
+// last one wins
+static int compare_rules(const void *a, const void *b) {
+    const SeccompRule *ra = *(const SeccompRule * const *)a;
+    const SeccompRule *rb = *(const SeccompRule * const *)b;
+    if (ra->nr != rb->nr) return ra->nr < rb->nr ? -1 : 1;
+    return ra < rb ? -1 : (ra > rb);
+}
+
+// Sorted, deduplicated view of the policy's rules
+static const SeccompRule** sorted_rules(const SeccompPolicy *policy, int *count) {
+    const SeccompRule **sorted = malloc(((size_t)policy->count + 1) * sizeof(SeccompRule *));
+    if (!sorted) return NULL;
+
+    for (int i = 0; i < policy->count; i++) {
+        sorted[i] = &policy->rules[i];
+    }
+    qsort(sorted, (size_t)policy->count, sizeof(SeccompRule *), compare_rules);
+
+    int unique = 0;
+    for (int i = 0; i < policy->count; i++) {
+        if (unique > 0 && sorted[unique - 1]->nr == sorted[i]->nr) {
+            sorted[unique - 1] = sorted[i];
+        } else {
+            sorted[unique++] = sorted[i];
+        }
+    }
+    *count = unique;
+    return sorted;
+}
+
+static void push_segment(Segment *segments, int *count, uint32_t start, Leaf leaf) {
+    if (*count > 0 && leaf_equal(&segments[*count - 1].leaf, &leaf)) return;
+    segments[*count].start = start;
+    segments[*count].leaf = leaf;
+    (*count)++;
+}
+
+// Dispatch on the syscall number in the accumulator over segments [lo, hi]
+static int emit_tree(Code *code, const Segment *segments, int lo, int hi, int *depth) {
+    if (lo == hi) {
+        *depth = 0;
+        return emit_leaf(code, &segments[lo].leaf);
+    }
+
+    int mid = lo + (hi - lo + 1) / 2;
+    Code left = {0};
+    Code right = {0};
+    int left_depth = 0;
+    int right_depth = 0;
+    int rc = -1;
+
+    if (emit_tree(&left, segments, lo, mid - 1, &left_depth) != 0) goto out;
+    if (emit_tree(&right, segments, mid, hi, &right_depth) != 0) goto out;
+
+    if (left.len <= MAX_SHORT_JUMP) {
+        // nr >= start[mid]: skip over the left subtree
+        if (emit(code, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, segments[mid].start, (uint8_t)left.len, 0)) != 0) goto out;
+    } else {
+        // Too far for a conditional: branch to an unconditional long jump
+        if (emit(code, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, segments[mid].start, 0, 1)) != 0) goto out;
+        if (emit(code, (struct sock_filter)BPF_STMT(BPF_JMP | BPF_JA, (uint32_t)left.len)) != 0) goto out;
+    }
+    if (append(code, &left) != 0 || append(code, &right) != 0) goto out;
+
+    *depth = 1 + (left_depth > right_depth ? left_depth : right_depth);
+    rc = 0;
+
+out:
+    free(left.insns);
+    free(right.insns);
+    return rc;
+}
+
+static int compile_tree(Code *code, const SeccompPolicy *policy, const SeccompRule **rules, int count, SeccompProgram *program) {
+    Leaf fallback = { policy->default_action, 0, 0 };
+    Segment *segments = malloc(((size_t)count * 2 + 3) * sizeof(Segment));
+    if (!segments) return -1;
+
+    int segment_count = 0;
+    uint32_t next = 0;
+    for (int i = 0; i < count; i++) {
+        uint32_t nr = (uint32_t)rules[i]->nr;
+        if (nr > next) push_segment(segments, &segment_count, next, fallback);
+        push_segment(segments, &segment_count, nr, rule_leaf(rules[i]));
+        next = nr + 1;
+    }
+    push_segment(segments, &segment_count, next, fallback);
+#ifdef SECCOMP_X32_BIT
+    // x32 syscall numbers share the x86_64 audit arch
+    Leaf kill = { SECCOMP_RET_KILL_PROCESS, 0, 0 };
+    if (next < SECCOMP_X32_BIT) push_segment(segments, &segment_count, SECCOMP_X32_BIT, kill);
+#endif
+
+    int rc = emit_tree(code, segments, 0, segment_count - 1, &program->depth);
+    program->ranges = segment_count;
+    free(segments);
+    return rc;
+}
+
+static int compile_linear(Code *code, const SeccompPolicy *policy, const SeccompRule **rules, int count, SeccompProgram *program) {
+    for (int i = 0; i < count; i++) {
+        Leaf leaf = rule_leaf(rules[i]);
+        uint8_t skip = leaf.has_arg0 ? 4 : 1;
+        if (emit(code, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)rules[i]->nr, 0, skip)) != 0) return -1;
+        if (emit_leaf(code, &leaf) != 0) return -1;
+    }
+#ifdef SECCOMP_X32_BIT
+    if (emit(code, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JGE | BPF_K, SECCOMP_X32_BIT, 0, 1)) != 0) return -1;
+    if (emit(code, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS)) != 0) return -1;
+#endif
+    program->ranges = count;
+    program->depth = count + 1;
+    return emit(code, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, policy->default_action));
+}
+
+int seccomp_compile(const SeccompPolicy *policy, SeccompCompileMode mode, SeccompProgram *program) {
+    memset(program, 0, sizeof(SeccompProgram));
+
+    int count = 0;
+    const SeccompRule **rules = sorted_rules(policy, &count);
+    if (!rules) return -1;
+
+    // Arch check first: syscall numbers mean nothing under another ABI
+    Code code = {0};
+    int rc = -1;
+    if (emit(&code, (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch))) != 0) goto out;
+    if (emit(&code, (struct sock_filter)BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, SECCOMP_AUDIT_ARCH, 1, 0)) != 0) goto out;
+    if (emit(&code, (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_KILL_PROCESS)) != 0) goto out;
+    if (emit(&code, (struct sock_filter)BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr))) != 0) goto out;
+
+    if (mode == SECCOMP_COMPILE_LINEAR) {
+        rc = compile_linear(&code, policy, rules, count, program);
+    } else {
+        rc = compile_tree(&code, policy, rules, count, program);
+    }
+
+    if (rc == 0 && code.len > BPF_MAXINSNS) {
+        fprintf(stderr, "seccomp filter too large: %zu instructions\n", code.len);
+        rc = -1;
+    }
+
+out:
+    free(rules);
+    if (rc != 0) {
+        free(code.insns);
+        return -1;
+    }
+    program->insns = code.insns;
+    program->len = code.len;
+    return 0;
+}
+
+int seccomp_install(const SeccompProgram *program) {
+    struct sock_fprog fprog = {
+        .len = (unsigned short)program->len,
+        .filter = program->insns,
+    };
+
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0) return -1;
+    if (syscall(SYS_seccomp, SECCOMP_SET_MODE_FILTER, 0, &fprog) == 0) return 0;
+    return prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &fprog, 0, 0);
+}
+
+void seccomp_program_free(SeccompProgram *program) {
+    free(program->insns);
+    program->insns = NULL;
+    program->len = 0;
+}
@@ -0,0 +1,73 @@
+#ifndef ZENCUBE_SECCOMP_FILTER_H
+#define ZENCUBE_SECCOMP_FILTER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <linux/filter.h>
+
+// Action for one syscall (SECCOMP_RET_* value, errno in the data bits)
+typedef struct {
+    int nr;
+    uint32_t action;
+    int has_arg0;              // Allow instead when args[0] == arg0
+    uint32_t arg0;
+} SeccompRule;
+
+// Allow/deny policy compiled into a classic BPF filter
+typedef struct {
+    SeccompRule *rules;
+    int count;
+    int capacity;
+    uint32_t default_action;   // For syscalls without a rule
+} SeccompPolicy;
+
+// How rules are dispatched
+typedef enum {
+    SECCOMP_COMPILE_TREE,      // Balanced binary search on syscall number
+    SECCOMP_COMPILE_LINEAR     // One compare per rule, in order (benchmark baseline)
+} SeccompCompileMode;
+
+typedef struct {
+    struct sock_filter *insns;
+    size_t len;
+    int ranges;                // Distinct syscall ranges after merging
+    int depth;                 // Compares on the longest path through the dispatch
+} SeccompProgram;
+
+// Actions
+uint32_t seccomp_action_errno(int err);
+uint32_t seccomp_action_allow(void);
+uint32_t seccomp_action_kill(void);
+
+void seccomp_policy_init(SeccompPolicy *policy, uint32_t default_action);
+
+// Set the action for nr; a later rule for the same syscall replaces it
+int seccomp_policy_add(SeccompPolicy *policy, int nr, uint32_t action);
+
+// Like seccomp_policy_add, but calls whose first argument equals arg0 are
+// allowed (e.g. socket(AF_UNIX, ...) under a network deny)
+int seccomp_policy_add_arg0(SeccompPolicy *policy, int nr, uint32_t action, uint32_t arg0);
+
+// Add a comma-separated list of syscall names or numbers. Returns -1 and
+// names the first unknown entry in stderr.
+int seccomp_policy_add_list(SeccompPolicy *policy, const char *list, uint32_t action);
+
+// Deny network access: socket() for every family except AF_UNIX, and
+// io_uring (which can create sockets without socket())
+int seccomp_policy_add_network_deny(SeccompPolicy *policy);
+
+void seccomp_policy_free(SeccompPolicy *policy);
+
+// Syscall number for a name or decimal number, -1 if unknown
+int seccomp_syscall_number(const char *name);
+
+// Compile policy for the build architecture. Calls from any other ABI
+// (and x32 on x86_64) are killed.
+int seccomp_compile(const SeccompPolicy *policy, SeccompCompileMode mode, SeccompProgram *program);
+
+// Set no_new_privs and attach program to the calling thread
+int seccomp_install(const SeccompProgram *program);
+
+void seccomp_program_free(SeccompProgram *program);
+
+#endif // ZENCUBE_SECCOMP_FILTER_H
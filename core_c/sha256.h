@@ -0,0 +1,25 @@
+#ifndef ZENCUBE_SHA256_H
+#define ZENCUBE_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_HEX_SIZE 65
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;           // Bytes hashed so far
+    uint8_t block[64];
+    size_t used;               // Bytes pending in block
+} Sha256;
+
+void sha256_init(Sha256 *ctx);
+void sha256_update(Sha256 *ctx, const void *data, size_t len);
+void sha256_final(Sha256 *ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+// Lowercase hex digest of data
+void sha256_hex(const void *data, size_t len, char out[SHA256_HEX_SIZE]);
+void sha256_digest_hex(const uint8_t digest[SHA256_DIGEST_SIZE], char out[SHA256_HEX_SIZE]);
+
+#endif // ZENCUBE_SHA256_H
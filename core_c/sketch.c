@@ -0,0 +1,182 @@
+#include "sketch.h"
+#include <math.h>
+#include <string.h>
+
+void sketch_init(Sketch *sketch, double alpha) {
+    memset(sketch, 0, sizeof(*sketch));
+    sketch->alpha = alpha;
+    sketch->gamma = (1.0 + alpha) / (1.0 - alpha);
+    sketch->multiplier = 1.0 / log(sketch->gamma);
+}
+
+static int32_t bin_index(const Sketch *sketch, double value) {
+    return (int32_t)ceil(log(value) * sketch->multiplier);
+}
+
+// Representative value of a bin: within alpha of everything in it
+static double bin_value(const Sketch *sketch, int32_t index) {
+    return 2.0 * pow(sketch->gamma, index) / (sketch->gamma + 1.0);
+}
+
+static int store_empty(const Sketch *sketch) {
+    return sketch->count == sketch->zero_count;
+}
+
+// Move the window of bins so that bins[0] is index new_offset. Bins that
+// fall below the window are collapsed into its lowest bin.
+static void shift_window(Sketch *sketch, int32_t new_offset) {
+    int32_t shift = new_offset - sketch->offset;
+    if (shift > 0) {
+        uint64_t collapsed = 0;
+        for (int32_t i = 0; i < shift && i < SKETCH_BINS; i++) collapsed += sketch->bins[i];
+        if (shift < SKETCH_BINS) {
+            memmove(sketch->bins, sketch->bins + shift, sizeof(uint64_t) * (size_t)(SKETCH_BINS - shift));
+            memset(sketch->bins + SKETCH_BINS - shift, 0, sizeof(uint64_t) * (size_t)shift);
+        } else {
+            memset(sketch->bins, 0, sizeof(sketch->bins));
+        }
+        sketch->bins[0] += collapsed;
+        if (sketch->min_index < new_offset) sketch->min_index = new_offset;
+    } else if (shift < 0) {
+        memmove(sketch->bins - shift, sketch->bins, sizeof(uint64_t) * (size_t)(SKETCH_BINS + shift));
+        memset(sketch->bins, 0, sizeof(uint64_t) * (size_t)-shift);
+    }
+    sketch->offset = new_offset;
+}
+
+static void add_to_bin(Sketch *sketch, int32_t index, uint64_t count) {
+    if (store_empty(sketch)) {
+        // Centre the first value so the window can move either way
+        memset(sketch->bins, 0, sizeof(sketch->bins));
+        sketch->offset = index - SKETCH_BINS / 2;
+        sketch->min_index = sketch->max_index = index;
+    }
+    if (index >= sketch->offset + SKETCH_BINS) {
+        shift_window(sketch, index - SKETCH_BINS + 1);
+    } else if (index < sketch->offset) {
+        if (sketch->max_index - index < SKETCH_BINS) {
+            shift_window(sketch, index);
+        } else {
+            index = sketch->offset;   // Out of range below: collapse
+        }
+    }
+    sketch->bins[index - sketch->offset] += count;
+    if (index < sketch->min_index) sketch->min_index = index;
+    if (index > sketch->max_index) sketch->max_index = index;
+}
+
+void sketch_add(Sketch *sketch, double value) {
+    if (isnan(value)) return;
+    if (value > SKETCH_MIN_VALUE) {
+        add_to_bin(sketch, bin_index(sketch, value), 1);
+    } else {
+        sketch->zero_count++;
+    }
+    if (sketch->count == 0 || value < sketch->min) sketch->min = value;
+    if (sketch->count == 0 || value > sketch->max) sketch->max = value;
+    sketch->count++;
+    sketch->sum += value;
+}
+
+double sketch_quantile(const Sketch *sketch, double q) {
+    if (sketch->count == 0) return 0.0;
+    if (q <= 0.0) return sketch->min;
+    if (q >= 1.0) return sketch->max;
+    
+    double rank = q * (double)(sketch->count - 1);
+    double seen = (double)sketch->zero_count;
+    double value = 0.0;
+    if (seen <= rank) {
+        for (int32_t index = sketch->min_index; index <= sketch->max_index; index++) {
+            seen += (double)sketch->bins[index - sketch->offset];
+            if (seen > rank) {
+                value = bin_value(sketch, index);
+                break;
+            }
+        }
+    }
+    if (value < sketch->min) value = sketch->min;
+    if (value > sketch->max) value = sketch->max;
+    return value;
+}
+
+int sketch_merge(Sketch *dst, const Sketch *src) {
+    if (dst->alpha != src->alpha) return -1;
+    if (src->count == 0) return 0;
+    
+    if (!store_empty(src)) {
+        for (int32_t index = src->min_index; index <= src->max_index; index++) {
+            uint64_t count = src->bins[index - src->offset];
+            if (count) {
+                add_to_bin(dst, index, count);
+                dst->count += count;   // Keeps store_empty() accurate mid-merge
+            }
+        }
+        dst->count -= src->count - src->zero_count;
+    }
+    if (dst->count == 0 || src->min < dst->min) dst->min = src->min;
+    if (dst->count == 0 || src->max > dst->max) dst->max = src->max;
+    dst->zero_count += src->zero_count;
+    dst->count += src->count;
+    dst->sum += src->sum;
+    return 0;
+}
+
+cJSON* sketch_to_json(const Sketch *sketch) {
+    cJSON *json = cJSON_CreateObject();
+    if (!json) return NULL;
+    cJSON_AddNumberToObject(json, "alpha", sketch->alpha);
+    cJSON_AddNumberToObject(json, "count", (double)sketch->count);
+    cJSON_AddNumberToObject(json, "sum", sketch->sum);
+    cJSON_AddNumberToObject(json, "min", sketch->min);
+    cJSON_AddNumberToObject(json, "max", sketch->max);
+    cJSON_AddNumberToObject(json, "zero", (double)sketch->zero_count);
+    
+    int empty = store_empty(sketch);
+    cJSON_AddNumberToObject(json, "offset", empty ? 0 : sketch->min_index);
+    cJSON *counts = cJSON_AddArrayToObject(json, "counts");
+    for (int32_t index = sketch->min_index; !empty && index <= sketch->max_index; index++) {
+        cJSON_AddItemToArray(counts, cJSON_CreateNumber((double)sketch->bins[index - sketch->offset]));
+    }
+    return json;
+}
+
+static int json_double(const cJSON *json, const char *name, double *out) {
+    const cJSON *item = cJSON_GetObjectItemCaseSensitive(json, name);
+    if (!cJSON_IsNumber(item)) return -1;
+    *out = item->valuedouble;
+    return 0;
+}
+
+int sketch_from_json(Sketch *sketch, const cJSON *json) {
+    double alpha, count, sum, min, max, zero, offset;
+    const cJSON *counts = cJSON_GetObjectItemCaseSensitive(json, "counts");
+    if (json_double(json, "alpha", &alpha) != 0 || alpha <= 0.0 || alpha >= 1.0 ||
+        json_double(json, "count", &count) != 0 || json_double(json, "sum", &sum) != 0 ||
+        json_double(json, "min", &min) != 0 || json_double(json, "max", &max) != 0 ||
+        json_double(json, "zero", &zero) != 0 || json_double(json, "offset", &offset) != 0 ||
+        !cJSON_IsArray(counts)) {
+        return -1;
+    }
+    
+    sketch_init(sketch, alpha);
+    int32_t index = (int32_t)offset;
+    uint64_t binned = 0;
+    const cJSON *item;
+    cJSON_ArrayForEach(item, counts) {
+        uint64_t n = cJSON_IsNumber(item) && item->valuedouble > 0 ? (uint64_t)item->valuedouble : 0;
+        if (n) {
+            add_to_bin(sketch, index, n);
+            sketch->count += n;
+            binned += n;
+        }
+        index++;
+    }
+    sketch->zero_count = (uint64_t)zero;
+    sketch->count = binned + sketch->zero_count;
+    if (sketch->count != (uint64_t)count) return -1;
+    sketch->sum = sum;
+    sketch->min = min;
+    sketch->max = max;
+    return 0;
+}
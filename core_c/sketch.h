@@ -0,0 +1,49 @@
+#ifndef ZENCUBE_SKETCH_H
+#define ZENCUBE_SKETCH_H
+
+#include "cJSON.h"
+#include <stdint.h>
+
+#define SKETCH_BINS 1024
+#define SKETCH_ALPHA 0.01          // Relative accuracy of quantiles
+#define SKETCH_MIN_VALUE 1e-9      // Smaller values go to the zero bucket
+
+// DDSketch: values are counted in logarithmic bins, so any quantile is
+// within SKETCH_ALPHA of the true value (relative). Memory is fixed: when
+// values span more than SKETCH_BINS bins (a factor of ~10^8 at 1%), the
+// lowest bins are collapsed together and only the low quantiles lose
+// accuracy. Sketches with the same alpha merge exactly, so runs and
+// shards combine without their samples.
+typedef struct {
+    double alpha;
+    double gamma;
+    double multiplier;         // 1 / ln(gamma)
+    int32_t offset;            // Bin index of bins[0]
+    int32_t min_index;         // Lowest and highest bins in use
+    int32_t max_index;
+    uint64_t bins[SKETCH_BINS];
+    uint64_t zero_count;
+    uint64_t count;
+    double sum;
+    double min;
+    double max;
+} Sketch;
+
+void sketch_init(Sketch *sketch, double alpha);
+
+void sketch_add(Sketch *sketch, double value);
+
+// Value at quantile q (0..1); 0 for an empty sketch
+double sketch_quantile(const Sketch *sketch, double q);
+
+// Add every value of src to dst. Returns -1 if their alphas differ.
+int sketch_merge(Sketch *dst, const Sketch *src);
+
+// {"alpha","count","sum","min","max","zero","offset","counts":[...]}, with
+// counts running from the lowest to the highest bin in use
+cJSON* sketch_to_json(const Sketch *sketch);
+
+// Read what sketch_to_json wrote. Returns -1 if it is not a sketch.
+int sketch_from_json(Sketch *sketch, const cJSON *json);
+
+#endif // ZENCUBE_SKETCH_H
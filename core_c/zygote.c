@@ -0,0 +1,760 @@
+#include "zygote.h"
+#include "launcher.h"
+#include "cJSON.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+
+#define TEMPLATE_MAX_CHILDREN 256
+#define TEMPLATE_MAX_ARGS 256
+#define TEMPLATE_READY_TIMEOUT_MS 5000
+
+extern char **environ;
+
+// Running command and the connection that gets its exit event
+typedef struct {
+    pid_t pid;
+    int client_fd;
+} TemplateChild;
+
+// Send one JSON line, optionally with descriptors attached. Clients that
+// cannot take a line immediately lose it rather than stall the loop.
+static int send_json_fds(int fd, cJSON *json, const int *fds, int fd_count) {
+    char *text = cJSON_PrintUnformatted(json);
+    if (!text) return -1;
+    
+    size_t len = strlen(text);
+    text[len] = '\n';           // Replace the terminator; length is explicit
+    
+    struct iovec iov = { .iov_base = text, .iov_len = len + 1 };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    
+    char control[CMSG_SPACE(sizeof(int) * 2)];
+    if (fd_count > 0) {
+        memset(control, 0, sizeof(control));
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)fd_count);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)fd_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * (size_t)fd_count);
+    }
+    
+    ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    free(text);
+    return sent == (ssize_t)(len + 1) ? 0 : -1;
+}
+
+static int send_json(int fd, cJSON *json) {
+    return send_json_fds(fd, json, NULL, 0);
+}
+
+static void send_error(int fd, const char *message) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "type", "error");
+    cJSON_AddStringToObject(json, "message", message);
+    send_json(fd, json);
+    cJSON_Delete(json);
+}
+
+// Receive one request packet and the descriptor passed with it (-1 if none)
+static ssize_t recv_with_fd(int fd, char *buffer, size_t size, int *passed_fd) {
+    struct iovec iov = { .iov_base = buffer, .iov_len = size - 1 };
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    
+    *passed_fd = -1;
+    ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0) return -1;
+    buffer[n] = '\0';
+    
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+        memcpy(passed_fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    return n;
+}
+
+static int pidfd_open_child(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+// Collect a JSON array of strings into out (NULL-terminated)
+static int string_array(cJSON *array, char **out, int max) {
+    int count = 0;
+    cJSON *item;
+    cJSON_ArrayForEach(item, array) {
+        if (!cJSON_IsString(item) || count >= max - 1) return -1;
+        out[count++] = item->valuestring;
+    }
+    out[count] = NULL;
+    return count;
+}
+
+// Start one command for a forwarded request. posix_spawn uses
+// CLONE_VFORK, so the cost is the exec, not copying the template.
+static void template_spawn(const char *line, int client_fd, const char *net, int landlock,
+                           TemplateChild *children, int *child_count) {
+    cJSON *request = cJSON_Parse(line);
+    char *argv[TEMPLATE_MAX_ARGS];
+    char *envp[TEMPLATE_MAX_ARGS];
+    cJSON *env = request ? cJSON_GetObjectItem(request, "env") : NULL;
+    
+    if (!request || string_array(cJSON_GetObjectItem(request, "argv"), argv, TEMPLATE_MAX_ARGS) <= 0) {
+        send_error(client_fd, "spawn needs a non-empty argv");
+        goto fail;
+    }
+    if (cJSON_IsArray(env) && string_array(env, envp, TEMPLATE_MAX_ARGS) < 0) {
+        send_error(client_fd, "env must be an array of strings");
+        goto fail;
+    }
+    if (*child_count >= TEMPLATE_MAX_CHILDREN) {
+        send_error(client_fd, "too many running commands");
+        goto fail;
+    }
+    
+    // One socket carries stdin, stdout and stderr
+    int stdio[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, stdio) != 0) {
+        send_error(client_fd, strerror(errno));
+        goto fail;
+    }
+    
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, stdio[1], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, stdio[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, stdio[1], STDERR_FILENO);
+    
+    // The template blocks SIGCHLD and ignores terminal signals; the
+    // command starts with a clean slate in its own session
+    posix_spawnattr_t attr;
+    sigset_t mask, defaults;
+    sigemptyset(&mask);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGCHLD);
+    sigaddset(&defaults, SIGINT);
+    sigaddset(&defaults, SIGTERM);
+    sigaddset(&defaults, SIGPIPE);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSID);
+    
+    pid_t pid;
+    int rc = posix_spawnp(&pid, argv[0], &actions, &attr, argv, cJSON_IsArray(env) ? envp : environ);
+    posix_spawn_file_actions_destroy(&actions);
+    posix_spawnattr_destroy(&attr);
+    close(stdio[1]);
+    
+    if (rc != 0) {
+        char message[320];
+        snprintf(message, sizeof(message), "exec %.200s: %s", argv[0], strerror(rc));
+        send_error(client_fd, message);
+        close(stdio[0]);
+        goto fail;
+    }
+    
+    int fds[2] = { stdio[0], pidfd_open_child(pid) };
+    cJSON *started = cJSON_CreateObject();
+    cJSON_AddStringToObject(started, "type", "started");
+    cJSON_AddNumberToObject(started, "pid", pid);
+    cJSON_AddStringToObject(started, "net", net);
+    cJSON_AddBoolToObject(started, "landlock", landlock);
+    send_json_fds(client_fd, started, fds, fds[1] >= 0 ? 2 : 1);
+    cJSON_Delete(started);
+    close(fds[0]);
+    if (fds[1] >= 0) close(fds[1]);
+    
+    children[*child_count].pid = pid;
+    children[*child_count].client_fd = client_fd;
+    (*child_count)++;
+    cJSON_Delete(request);
+    return;
+    
+fail:
+    close(client_fd);
+    cJSON_Delete(request);
+}
+
+// Report every exited command to its connection
+static void template_reap(TemplateChild *children, int *child_count) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (int i = 0; i < *child_count; i++) {
+            if (children[i].pid != pid) continue;
+            
+            cJSON *json = cJSON_CreateObject();
+            cJSON_AddStringToObject(json, "type", "exit");
+            cJSON_AddNumberToObject(json, "pid", pid);
+            if (WIFSIGNALED(status)) {
+                cJSON_AddNumberToObject(json, "signal", WTERMSIG(status));
+            } else {
+                cJSON_AddNumberToObject(json, "code", WEXITSTATUS(status));
+            }
+            send_json(children[i].client_fd, json);
+            cJSON_Delete(json);
+            
+            close(children[i].client_fd);
+            children[i] = children[--(*child_count)];
+            break;
+        }
+    }
+}
+
+// Body of a template process: apply the profile, report, then serve
+// forwarded requests until the server closes the control socket
+static void run_template(int control_fd, const ZygoteProfile *profile) {
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_IGN);
+    signal(SIGPIPE, SIG_IGN);
+    
+    LaunchConfig config;
+    launch_config_init(&config);
+    config.jail_best_effort = 1;
+    config.cgroup_best_effort = 1;
+    if (profile->jail_dir[0]) {
+        launch_set_jail(&config, profile->jail_dir);
+        launch_add_default_paths(&config);
+    }
+    
+    // A network namespace when privileged, a socket filter otherwise
+    const char *net = "none";
+    if (profile->no_net) {
+        if (unshare(CLONE_NEWNET) == 0) {
+            net = "namespace";
+        } else {
+            launch_deny_network(&config);
+            net = "seccomp";
+        }
+    }
+    
+    LaunchResult result;
+    int rc = launch_restrict(&config, &result);
+    
+    cJSON *ready = cJSON_CreateObject();
+    cJSON_AddStringToObject(ready, "type", rc == 0 ? "ready" : "error");
+    cJSON_AddStringToObject(ready, "net", net);
+    cJSON_AddBoolToObject(ready, "landlock", result.landlock_enforced);
+    if (result.error[0]) {
+        cJSON_AddStringToObject(ready, "message", result.error);
+    }
+    send_json(control_fd, ready);
+    cJSON_Delete(ready);
+    if (rc != 0) return;
+    
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    int signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    
+    TemplateChild children[TEMPLATE_MAX_CHILDREN];
+    int child_count = 0;
+    int serving = 1;
+    char line[ZYGOTE_MAX_REQUEST];
+    
+    while (serving || child_count > 0) {
+        struct pollfd fds[2] = {
+            { .fd = signal_fd, .events = POLLIN, .revents = 0 },
+            { .fd = serving ? control_fd : -1, .events = POLLIN, .revents = 0 },
+        };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        
+        if (fds[0].revents & POLLIN) {
+            struct signalfd_siginfo info;
+            while (read(signal_fd, &info, sizeof(info)) > 0) {
+            }
+            template_reap(children, &child_count);
+        }
+        
+        if (fds[1].revents & (POLLIN | POLLHUP)) {
+            int client_fd;
+            ssize_t n = recv_with_fd(control_fd, line, sizeof(line), &client_fd);
+            if (n <= 0) {
+                // Server gone: finish the running commands, take no more
+                serving = 0;
+                if (client_fd >= 0) close(client_fd);
+            } else if (client_fd >= 0) {
+                template_spawn(line, client_fd, net, result.landlock_enforced, children, &child_count);
+            }
+        }
+    }
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Read a new template's ready line once its control socket is readable
+static int read_ready(ZygoteTemplate *tmpl) {
+    char line[1024];
+    ssize_t n = recv(tmpl->control_fd, line, sizeof(line) - 1, 0);
+    if (n <= 0) return -1;
+    line[n] = '\0';
+    
+    cJSON *ready = cJSON_Parse(line);
+    cJSON *type = ready ? cJSON_GetObjectItem(ready, "type") : NULL;
+    cJSON *net = ready ? cJSON_GetObjectItem(ready, "net") : NULL;
+    cJSON *message = ready ? cJSON_GetObjectItem(ready, "message") : NULL;
+    int rc = -1;
+    
+    if (cJSON_IsString(type) && strcmp(type->valuestring, "ready") == 0) {
+        snprintf(tmpl->net, sizeof(tmpl->net), "%s", cJSON_IsString(net) ? net->valuestring : "none");
+        tmpl->landlock = cJSON_IsTrue(cJSON_GetObjectItem(ready, "landlock"));
+        rc = 0;
+    } else if (cJSON_IsString(message)) {
+        fprintf(stderr, "zygote: template failed: %s\n", message->valuestring);
+    }
+    
+    cJSON_Delete(ready);
+    return rc;
+}
+
+// Close the server's end; the template exits once its commands have.
+// Requests held for a template that never became ready get an error.
+static void retire_template(ZygoteServer *server, ZygoteTemplate *tmpl) {
+    for (int i = 0; i < server->pending_count; i++) {
+        ZygotePending *pending = &server->pending[i];
+        if (pending->waiting == tmpl && pending->fd >= 0) {
+            send_error(pending->fd, "cannot start template");
+            close(pending->fd);
+            pending->fd = -1;
+        }
+    }
+    if (tmpl->control_fd >= 0) close(tmpl->control_fd);
+    memset(tmpl, 0, sizeof(ZygoteTemplate));
+    tmpl->control_fd = -1;
+}
+
+// Free slot, evicting the least recently used template when full
+static ZygoteTemplate* template_slot(ZygoteServer *server) {
+    ZygoteTemplate *oldest = &server->templates[0];
+    for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+        ZygoteTemplate *tmpl = &server->templates[i];
+        if (tmpl->pid == 0) return tmpl;
+        if (tmpl->last_used < oldest->last_used) oldest = tmpl;
+    }
+    retire_template(server, oldest);
+    return oldest;
+}
+
+static ZygoteTemplate* start_template(ZygoteServer *server, const ZygoteProfile *profile) {
+    ZygoteTemplate *tmpl = template_slot(server);
+    
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, sv) != 0) return NULL;
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(sv[0]);
+        close(sv[1]);
+        return NULL;
+    }
+    
+    if (pid == 0) {
+        // Keep nothing of the server: its sockets must close when it exits
+        close(sv[0]);
+        close(server->listen_fd);
+        close(server->signal_fd);
+        for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+            if (server->templates[i].control_fd >= 0) close(server->templates[i].control_fd);
+        }
+        for (int i = 0; i < server->pending_count; i++) {
+            close(server->pending[i].fd);
+        }
+        run_template(sv[1], profile);
+        _exit(0);
+    }
+    
+    close(sv[1]);
+    tmpl->profile = *profile;
+    tmpl->pid = pid;
+    tmpl->control_fd = sv[0];
+    tmpl->last_used = server->spawns;
+    tmpl->ready_deadline_ms = now_ms() + TEMPLATE_READY_TIMEOUT_MS;
+    return tmpl;
+}
+
+static ZygoteTemplate* find_template(ZygoteServer *server, const ZygoteProfile *profile) {
+    for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+        ZygoteTemplate *tmpl = &server->templates[i];
+        if (tmpl->pid != 0 && tmpl->profile.no_net == profile->no_net &&
+            strcmp(tmpl->profile.jail_dir, profile->jail_dir) == 0) {
+            return tmpl;
+        }
+    }
+    return NULL;
+}
+
+// Resolve the request's profile the way the template will apply it
+static int request_profile(cJSON *request, ZygoteProfile *profile) {
+    memset(profile, 0, sizeof(ZygoteProfile));
+    cJSON *jail = cJSON_GetObjectItem(request, "jail");
+    profile->no_net = cJSON_IsTrue(cJSON_GetObjectItem(request, "no_net"));
+    
+    if (cJSON_IsString(jail) && jail->valuestring[0]) {
+        struct stat st;
+        if (!realpath(jail->valuestring, profile->jail_dir) ||
+            stat(profile->jail_dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Hand a request and its connection to a ready template
+static void dispatch(ZygoteServer *server, ZygoteTemplate *tmpl, int fd, const char *line) {
+    int passed[1] = { fd };
+    struct iovec iov;
+    iov.iov_base = (void *)line;
+    iov.iov_len = strlen(line);
+    struct msghdr msg;
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(&msg, 0, sizeof(msg));
+    memset(control, 0, sizeof(control));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), passed, sizeof(int));
+    
+    if (sendmsg(tmpl->control_fd, &msg, MSG_NOSIGNAL) == (ssize_t)iov.iov_len) {
+        tmpl->spawns++;
+        tmpl->last_used = ++server->spawns;
+    } else {
+        retire_template(server, tmpl);
+        send_error(fd, "template unavailable");
+    }
+}
+
+// A starting template's ready line arrived (or its socket closed): serve
+// the requests held for it, or fail them
+static int template_ready(ZygoteServer *server, ZygoteTemplate *tmpl) {
+    if (read_ready(tmpl) != 0) {
+        retire_template(server, tmpl);
+        return -1;
+    }
+    tmpl->ready_deadline_ms = 0;
+    for (int i = 0; i < server->pending_count; i++) {
+        ZygotePending *pending = &server->pending[i];
+        if (pending->waiting == tmpl && pending->fd >= 0) {
+            dispatch(server, tmpl, pending->fd, pending->buffer);
+            close(pending->fd);
+            pending->fd = -1;
+        }
+    }
+    return 0;
+}
+
+int zygote_warm(ZygoteServer *server, const ZygoteProfile *profile) {
+    ZygoteProfile resolved = *profile;
+    if (profile->jail_dir[0] && !realpath(profile->jail_dir, resolved.jail_dir)) return -1;
+    ZygoteTemplate *tmpl = find_template(server, &resolved);
+    if (!tmpl) tmpl = start_template(server, &resolved);
+    if (!tmpl) return -1;
+    if (tmpl->ready_deadline_ms == 0) return 0;
+    
+    // Nothing is served yet, so waiting here holds up no request
+    struct pollfd pfd = { .fd = tmpl->control_fd, .events = POLLIN, .revents = 0 };
+    if (poll(&pfd, 1, TEMPLATE_READY_TIMEOUT_MS) <= 0) {
+        retire_template(server, tmpl);
+        return -1;
+    }
+    return template_ready(server, tmpl);
+}
+
+static void reply_stats(ZygoteServer *server, int fd) {
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "type", "stats");
+    cJSON_AddNumberToObject(json, "spawns", (double)server->spawns);
+    cJSON *templates = cJSON_AddArrayToObject(json, "templates");
+    for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+        ZygoteTemplate *tmpl = &server->templates[i];
+        if (tmpl->pid == 0) continue;
+        
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddNumberToObject(item, "pid", tmpl->pid);
+        cJSON_AddStringToObject(item, "jail", tmpl->profile.jail_dir);
+        cJSON_AddBoolToObject(item, "no_net", tmpl->profile.no_net);
+        cJSON_AddStringToObject(item, "net", tmpl->net);
+        cJSON_AddBoolToObject(item, "landlock", tmpl->landlock);
+        cJSON_AddNumberToObject(item, "spawns", (double)tmpl->spawns);
+        cJSON_AddItemToArray(templates, item);
+    }
+    send_json(fd, json);
+    cJSON_Delete(json);
+}
+
+// Handle a complete request line. The connection is handed off or closed,
+// unless the request is held until its template is ready.
+static void handle_request(ZygoteServer *server, ZygotePending *pending) {
+    int fd = pending->fd;
+    const char *line = pending->buffer;
+    cJSON *request = cJSON_Parse(line);
+    cJSON *cmd = request ? cJSON_GetObjectItem(request, "cmd") : NULL;
+    ZygoteProfile profile;
+    
+    if (!cJSON_IsString(cmd)) {
+        send_error(fd, "invalid request");
+    } else if (strcmp(cmd->valuestring, "stats") == 0) {
+        reply_stats(server, fd);
+    } else if (strcmp(cmd->valuestring, "spawn") != 0) {
+        send_error(fd, "unknown command");
+    } else if (request_profile(request, &profile) != 0) {
+        send_error(fd, "jail is not a directory");
+    } else {
+        ZygoteTemplate *tmpl = find_template(server, &profile);
+        if (!tmpl) tmpl = start_template(server, &profile);
+        if (!tmpl) {
+            send_error(fd, "cannot start template");
+        } else if (tmpl->ready_deadline_ms != 0) {
+            pending->waiting = tmpl;
+        } else {
+            // The template owns the connection from here on
+            dispatch(server, tmpl, fd, line);
+        }
+    }
+    
+    cJSON_Delete(request);
+    if (!pending->waiting) {
+        close(fd);
+        pending->fd = -1;
+    }
+}
+
+// Read from a pending connection; dispatch once its line is complete.
+// Connections that are done get fd -1.
+static void read_pending(ZygoteServer *server, ZygotePending *pending) {
+    ssize_t n = recv(pending->fd, pending->buffer + pending->len, sizeof(pending->buffer) - 1 - pending->len, 0);
+    if (n <= 0) {
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) return;
+        close(pending->fd);
+        pending->fd = -1;
+        return;
+    }
+    pending->len += (size_t)n;
+    pending->buffer[pending->len] = '\0';
+    
+    char *nl = strchr(pending->buffer, '\n');
+    if (nl) {
+        *nl = '\0';
+        handle_request(server, pending);
+        return;
+    }
+    
+    // A request that does not fit the buffer is not a request
+    if (pending->len >= sizeof(pending->buffer) - 1) {
+        close(pending->fd);
+        pending->fd = -1;
+    }
+}
+
+int zygote_server_init(ZygoteServer *server, const char *socket_path) {
+    memset(server, 0, sizeof(ZygoteServer));
+    server->listen_fd = -1;
+    server->signal_fd = -1;
+    for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+        server->templates[i].control_fd = -1;
+    }
+    
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return -1;
+    }
+    strcpy(addr.sun_path, socket_path);
+    strcpy(server->socket_path, socket_path);
+    
+    server->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (server->listen_fd < 0) {
+        perror("socket");
+        return -1;
+    }
+    
+    // A socket left behind by a previous daemon would make bind fail
+    unlink(socket_path);
+    if (bind(server->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(server->listen_fd, 64) < 0) {
+        perror("bind");
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        return -1;
+    }
+    chmod(socket_path, 0600);
+    
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    server->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    return 0;
+}
+
+// Forget templates that exited
+static void reap_templates(ZygoteServer *server) {
+    struct signalfd_siginfo info;
+    while (read(server->signal_fd, &info, sizeof(info)) > 0) {
+    }
+    
+    pid_t pid;
+    while ((pid = waitpid(-1, NULL, WNOHANG)) > 0) {
+        for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+            if (server->templates[i].pid == pid) {
+                retire_template(server, &server->templates[i]);
+            }
+        }
+    }
+}
+
+int zygote_server_run(ZygoteServer *server, volatile sig_atomic_t *running) {
+    struct pollfd fds[2 + ZYGOTE_MAX_PENDING + ZYGOTE_MAX_TEMPLATES];
+    ZygoteTemplate *starting[ZYGOTE_MAX_TEMPLATES];
+    
+    while (*running) {
+        // Templates that missed their ready deadline fail their requests
+        int64_t now = now_ms();
+        int timeout = 1000;
+        int starting_count = 0;
+        for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+            ZygoteTemplate *tmpl = &server->templates[i];
+            if (tmpl->pid == 0 || tmpl->ready_deadline_ms == 0) continue;
+            if (tmpl->ready_deadline_ms <= now) {
+                fprintf(stderr, "zygote: template %d not ready in time\n", (int)tmpl->pid);
+                retire_template(server, tmpl);
+                continue;
+            }
+            if (tmpl->ready_deadline_ms - now < timeout) timeout = (int)(tmpl->ready_deadline_ms - now);
+            starting[starting_count++] = tmpl;
+        }
+        
+        // Held requests are not read until their template is ready
+        int nfds = 0;
+        fds[nfds++] = (struct pollfd){ .fd = server->listen_fd, .events = POLLIN, .revents = 0 };
+        fds[nfds++] = (struct pollfd){ .fd = server->signal_fd, .events = POLLIN, .revents = 0 };
+        for (int i = 0; i < server->pending_count; i++) {
+            ZygotePending *pending = &server->pending[i];
+            int fd = pending->waiting ? -1 : pending->fd;
+            fds[nfds++] = (struct pollfd){ .fd = fd, .events = POLLIN, .revents = 0 };
+        }
+        int pending_polled = server->pending_count;
+        for (int i = 0; i < starting_count; i++) {
+            fds[nfds++] = (struct pollfd){ .fd = starting[i]->control_fd, .events = POLLIN, .revents = 0 };
+        }
+        
+        int ready = poll(fds, (nfds_t)nfds, timeout);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            return -1;
+        }
+        
+        if (ready > 0) {
+            for (int i = 0; i < starting_count; i++) {
+                if (fds[2 + pending_polled + i].revents && starting[i]->ready_deadline_ms != 0) {
+                    template_ready(server, starting[i]);
+                }
+            }
+            
+            if (fds[1].revents & POLLIN) {
+                reap_templates(server);
+            }
+            
+            for (int i = 0; i < pending_polled; i++) {
+                if (server->pending[i].fd >= 0 && (fds[2 + i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                    read_pending(server, &server->pending[i]);
+                }
+            }
+            
+            if (fds[0].revents & POLLIN) {
+                int fd;
+                while ((fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    if (server->pending_count >= ZYGOTE_MAX_PENDING) {
+                        close(fd);
+                        continue;
+                    }
+                    ZygotePending *pending = &server->pending[server->pending_count++];
+                    pending->fd = fd;
+                    pending->len = 0;
+                    pending->waiting = NULL;
+                    
+                    // Most clients send the request with the connect
+                    read_pending(server, pending);
+                }
+            }
+        }
+        
+        // Dispatched or dropped connections leave the table
+        int kept = 0;
+        for (int i = 0; i < server->pending_count; i++) {
+            if (server->pending[i].fd < 0) continue;
+            if (kept != i) server->pending[kept] = server->pending[i];
+            kept++;
+        }
+        server->pending_count = kept;
+    }
+    
+    return 0;
+}
+
+void zygote_server_cleanup(ZygoteServer *server) {
+    for (int i = 0; i < ZYGOTE_MAX_TEMPLATES; i++) {
+        if (server->templates[i].pid != 0) {
+            retire_template(server, &server->templates[i]);
+        }
+    }
+    
+    for (int i = 0; i < server->pending_count; i++) {
+        if (server->pending[i].fd >= 0) close(server->pending[i].fd);
+    }
+    server->pending_count = 0;
+    
+    if (server->signal_fd >= 0) {
+        close(server->signal_fd);
+        server->signal_fd = -1;
+    }
+    if (server->listen_fd >= 0) {
+        close(server->listen_fd);
+        server->listen_fd = -1;
+        unlink(server->socket_path);
+    }
+}
@@ -0,0 +1,67 @@
+#ifndef ZENCUBE_ZYGOTE_H
+#define ZENCUBE_ZYGOTE_H
+
+#include <signal.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define ZYGOTE_MAX_TEMPLATES 8
+#define ZYGOTE_MAX_PENDING 32
+#define ZYGOTE_MAX_REQUEST 8192
+
+// Restrictions a template applies once and every child inherits
+typedef struct {
+    char jail_dir[4096];       // Empty = no file jail
+    int no_net;
+} ZygoteProfile;
+
+// Warm process with the profile applied; forks a child per request
+typedef struct {
+    ZygoteProfile profile;
+    pid_t pid;                 // 0 = slot free
+    int control_fd;            // SOCK_SEQPACKET: requests plus the client's fd
+    char net[16];              // "namespace", "seccomp" or "none"
+    int landlock;
+    long spawns;
+    long last_used;            // Server spawn counter at the last request
+    int64_t ready_deadline_ms; // Nonzero until the ready line arrives
+} ZygoteTemplate;
+
+// Connection whose request line has not arrived yet
+typedef struct {
+    int fd;
+    char buffer[ZYGOTE_MAX_REQUEST];
+    size_t len;
+    ZygoteTemplate *waiting;   // Complete request held for a starting template
+} ZygotePending;
+
+typedef struct {
+    int listen_fd;
+    int signal_fd;             // SIGCHLD: a template exited
+    char socket_path[108];
+    ZygoteTemplate templates[ZYGOTE_MAX_TEMPLATES];
+    ZygotePending pending[ZYGOTE_MAX_PENDING];
+    int pending_count;
+    long spawns;
+} ZygoteServer;
+
+// Bind the socket at path (replacing a stale one)
+int zygote_server_init(ZygoteServer *server, const char *socket_path);
+
+// Start a template for profile now instead of on the first request and
+// wait for it to be ready; requests start templates without waiting
+int zygote_warm(ZygoteServer *server, const ZygoteProfile *profile);
+
+// Accept requests until *running becomes 0. One connection per launch:
+//   {"cmd":"spawn","argv":[...],"jail":"/dir","no_net":true,"env":["K=V"]}
+//     -> {"type":"started","pid":N,"net":"...","landlock":true} carrying
+//        SCM_RIGHTS [stdio socket, pidfd], then {"type":"exit","pid":N,
+//        "code":C} or {...,"signal":S} when the child is reaped
+//   {"cmd":"stats"} -> {"type":"stats","spawns":N,"templates":[...]}
+int zygote_server_run(ZygoteServer *server, volatile sig_atomic_t *running);
+
+// Close connections and templates (they exit once their children have)
+// and remove the socket
+void zygote_server_cleanup(ZygoteServer *server);
+
+#endif // ZENCUBE_ZYGOTE_H
@@ -0,0 +1,80 @@
+#include "zygote.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <signal.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void handle_signal(int sig) {
+    (void)sig;
+    running = 0;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr, "Usage: %s --socket <path> [--jail <dir>] [--no-net]\n", prog);
+    fprintf(stderr, "Options:\n");
+    fprintf(stderr, "  --socket PATH      Serve launch requests on a Unix socket\n");
+    fprintf(stderr, "  --jail DIR         Pre-start a template jailed to DIR\n");
+    fprintf(stderr, "  --no-net           Pre-start it without network access\n");
+    fprintf(stderr, "  --help             Show this help\n");
+    fprintf(stderr, "\nTemplates for other profiles start on their first request and stay warm.\n");
+}
+
+int main(int argc, char **argv) {
+    char *socket_path = NULL;
+    ZygoteProfile warm;
+    memset(&warm, 0, sizeof(warm));
+    
+    static struct option long_options[] = {
+        {"socket", required_argument, 0, 's'},
+        {"jail",   required_argument, 0, 'j'},
+        {"no-net", no_argument,       0, 'n'},
+        {"help",   no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while ((opt = getopt_long(argc, argv, "s:j:nh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 's': socket_path = optarg; break;
+            case 'j': snprintf(warm.jail_dir, sizeof(warm.jail_dir), "%s", optarg); break;
+            case 'n': warm.no_net = 1; break;
+            case 'h':
+            default:
+                print_usage(argv[0]);
+                return opt == 'h' ? 0 : 1;
+        }
+    }
+    
+    if (!socket_path) {
+        fprintf(stderr, "Error: Missing --socket\n");
+        print_usage(argv[0]);
+        return 1;
+    }
+    
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    
+    ZygoteServer server;
+    if (zygote_server_init(&server, socket_path) != 0) {
+        fprintf(stderr, "Failed to open zygote socket %s\n", socket_path);
+        return 1;
+    }
+    
+    if (zygote_warm(&server, &warm) != 0) {
+        fprintf(stderr, "Failed to start template%s%s\n", warm.jail_dir[0] ? " for " : "", warm.jail_dir);
+        zygote_server_cleanup(&server);
+        return 1;
+    }
+    
+    printf("Serving launch requests on %s\n", socket_path);
+    fflush(stdout);
+    
+    zygote_server_run(&server, &running);
+    zygote_server_cleanup(&server);
+    
+    printf("\nShutdown signal received, cleaning up...\n");
+    return 0;
+}
@@ -6,7 +6,30 @@ SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 REPO_ROOT="$(cd "${SCRIPT_DIR}/.." && pwd)"
 JAIL_DIR="${REPO_ROOT}/sandbox_jail"
 
+JAILBUILD="${REPO_ROOT}/core_c/bin/zencube_jailbuild"
+
 printf '[build-jail] Target directory: %s\n' "${JAIL_DIR}"
+
+# The native builder reflinks (or copies) cached objects and skips
+# dependency resolution when nothing on the host changed. Under
+# ZENCUBE_JAIL_OVERLAY the jail is only an overlay's lower layer, so it can
+# hardlink them instead.
+if [[ -x "${JAILBUILD}" ]]; then
+    JAILBUILD_ARGS=()
+    if [[ "${ZENCUBE_JAIL_OVERLAY:-}" == "tmpfs" || "${ZENCUBE_JAIL_OVERLAY:-}" == "dir" ]]; then
+        JAILBUILD_ARGS+=(--read-only)
+    fi
+    printf '[build-jail] Linking /bin/sh and its dependencies from the jail cache...\n'
+    "${JAILBUILD}" --jail "${JAIL_DIR}" "${JAILBUILD_ARGS[@]}" /bin/sh
+    cat <<EOF
+[build-jail] Done.
+  - Jail root: ${JAIL_DIR}
+  - Try running: python3 monitor/jail_wrapper.py --jail ${JAIL_DIR} -- /bin/sh -c 'pwd'
+  - Remember: activating chroot() still requires root. This script only prepares the directory tree.
+EOF
+    exit 0
+fi
+
 mkdir -p "${JAIL_DIR}" "${JAIL_DIR}/bin" "${JAIL_DIR}/lib" "${JAIL_DIR}/lib64" \
     "${JAIL_DIR}/usr/lib" "${JAIL_DIR}/tmp" "${JAIL_DIR}/etc"
 
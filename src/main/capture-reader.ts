@@ -0,0 +1,315 @@
+/**
+ * Reader for output captured by the native launcher (`--capture`).
+ *
+ * The launcher's capture process splices the sandbox's stdout and stderr
+ * into a log file and publishes progress in a small header file
+ * (`<log>.head`, see core_c/capture.h). Instead of receiving every chunk
+ * through a pipe, the main process polls the header on its own timer and
+ * reads at most one bounded chunk of the log per tick, so a process
+ * writing hundreds of MB/s never floods the event loop. When the terminal
+ * falls too far behind, the reader jumps to the tail and leaves a marker;
+ * the skipped range stays in the log for scrollback until the log is
+ * disposed.
+ *
+ * Under an output policy (`--capture-head/--capture-tail`) the log keeps
+ * only the first and last bytes of the stream. While the run lasts, the
+ * last bytes live in a ring (`<log>.tail`); at the end the capture appends
+ * them to the log after a marker. Reads map stream offsets accordingly.
+ */
+
+import * as fs from 'fs';
+
+export interface CaptureState {
+  bytes: number;      // Bytes the command wrote
+  passed: number;     // Also forwarded to the launcher's stdout
+  dropped: number;    // Not forwarded: that reader was behind
+  updates: number;
+  done: boolean;      // The command and its children closed their output
+  headLimit: number;  // Output policy, 0 = none
+  tailLimit: number;
+  rateLimit: number;
+  elided: number;     // Discarded from the middle by the policy
+  throttledMs: number;
+  logBytes: number;   // Bytes in the log file
+}
+
+// Where a stream offset can be read, or the next offset that can
+type Location = { fd: number; position: number; span: number } | { next: number };
+
+// Output offsets the terminal never showed
+export interface SkippedRange {
+  from: number;
+  to: number;
+}
+
+export interface CaptureReaderOptions {
+  logPath: string;
+  push: (chunk: Buffer) => void;
+  chunkBytes?: number;
+  maxLagBytes?: number;
+  tailBytes?: number;
+}
+
+const CAPTURE_MAGIC = 'ZCCAPT1';
+const HEADER_BYTES = 112;
+
+/**
+ * Parse the fixed little-endian header written by core_c/capture.c
+ */
+export function parseCaptureHeader(buf: Buffer): CaptureState | null {
+  if (buf.length < HEADER_BYTES || buf.toString('latin1', 0, 7) !== CAPTURE_MAGIC) {
+    return null;
+  }
+  return {
+    bytes: Number(buf.readBigUInt64LE(8)),
+    passed: Number(buf.readBigUInt64LE(16)),
+    dropped: Number(buf.readBigUInt64LE(24)),
+    updates: Number(buf.readBigUInt64LE(32)),
+    done: buf.readUInt32LE(40) !== 0,
+    headLimit: Number(buf.readBigUInt64LE(64)),
+    tailLimit: Number(buf.readBigUInt64LE(72)),
+    rateLimit: Number(buf.readBigUInt64LE(80)),
+    elided: Number(buf.readBigUInt64LE(88)),
+    throttledMs: Number(buf.readBigUInt64LE(96)),
+    logBytes: Number(buf.readBigUInt64LE(104)),
+  };
+}
+
+export class CaptureReader {
+  readonly logPath: string;
+  private readonly headerPath: string;
+  private readonly ringPath: string;
+  private readonly opts: Required<Omit<CaptureReaderOptions, 'logPath'>>;
+  private logFd: number | null = null;
+  private headerFd: number | null = null;
+  private ringFd: number | null = null;
+  private headerBuf = Buffer.alloc(HEADER_BYTES);
+  private offset = 0;
+  private paused = false;
+  private state: CaptureState | null = null;
+  skippedBytes = 0;
+  readonly skippedRanges: SkippedRange[] = [];
+
+  constructor(options: CaptureReaderOptions) {
+    this.logPath = options.logPath;
+    this.headerPath = `${options.logPath}.head`;
+    this.ringPath = `${options.logPath}.tail`;
+    this.opts = {
+      chunkBytes: 256 * 1024,
+      maxLagBytes: 8 * 1024 * 1024,
+      tailBytes: 64 * 1024,
+      ...options,
+    };
+  }
+
+  /**
+   * Bytes captured so far (the whole output, shown or not)
+   */
+  get totalBytes(): number {
+    return this.state ? this.state.bytes : 0;
+  }
+
+  get done(): boolean {
+    return this.state !== null && this.state.done;
+  }
+
+  /**
+   * What the output policy did to this run so far
+   */
+  get policyStats(): { elided: number; throttledMs: number } {
+    return {
+      elided: this.state ? this.state.elided : 0,
+      throttledMs: this.state ? this.state.throttledMs : 0,
+    };
+  }
+
+  /**
+   * The terminal is behind: stop reading (the capture keeps logging)
+   */
+  setPaused(paused: boolean): void {
+    this.paused = paused;
+  }
+
+  /**
+   * Refresh the header and push up to one chunk of new output
+   */
+  poll(): void {
+    if (!this.refresh() || this.paused) return;
+    this.pushRange(this.opts.chunkBytes);
+  }
+
+  /**
+   * Call `done` once the capture has written everything (or after
+   * `timeoutMs`, if a leftover child still holds the output open)
+   */
+  whenDone(done: () => void, timeoutMs = 1000): void {
+    const deadline = Date.now() + timeoutMs;
+    const check = (): void => {
+      this.refresh();
+      if (this.done || Date.now() >= deadline) {
+        done();
+      } else {
+        setTimeout(check, 20);
+      }
+    };
+    check();
+  }
+
+  /**
+   * Run ended: push what is left, jumping to the tail if it is too much.
+   * Output the terminal has not reached yet starts with its head, so a
+   * short program that wrote everything in one burst keeps its first lines.
+   */
+  finish(): void {
+    this.refresh();
+    if (this.totalBytes - this.offset > this.opts.tailBytes) {
+      this.pushRange(this.opts.tailBytes, false);
+    }
+    const pending = this.totalBytes - this.offset;
+    if (pending > this.opts.tailBytes) {
+      this.skipTo(this.totalBytes - this.opts.tailBytes, 'skipped');
+    }
+    // The rest may span the end of the head and the tail
+    let moved = 1;
+    while (moved > 0 && this.offset < this.totalBytes) {
+      moved = this.pushRange(this.opts.tailBytes);
+    }
+  }
+
+  /**
+   * Read [offset, offset + length) of the captured output
+   */
+  read(offset: number, length: number): { offset: number; data: string; bytes: number } | null {
+    if (!this.refresh() || offset >= this.totalBytes) return null;
+    let where = this.locate(offset);
+    if ('next' in where) {
+      // Discarded by the output policy: start at the next kept byte
+      offset = where.next;
+      where = this.locate(offset);
+      if ('next' in where) return null;
+    }
+    const buf = Buffer.allocUnsafe(Math.min(length, where.span));
+    const n = fs.readSync(where.fd, buf, 0, buf.length, where.position);
+    return { offset, data: buf.subarray(0, n).toString('utf8'), bytes: n };
+  }
+
+  /**
+   * Release the fds; the log stays on disk until disposed
+   */
+  close(): void {
+    for (const fd of [this.logFd, this.headerFd, this.ringFd]) {
+      if (fd !== null) fs.closeSync(fd);
+    }
+    this.logFd = null;
+    this.headerFd = null;
+    this.ringFd = null;
+  }
+
+  /**
+   * Close and delete the log and its header
+   */
+  dispose(): void {
+    this.close();
+    fs.rmSync(this.logPath, { force: true });
+    fs.rmSync(this.headerPath, { force: true });
+    fs.rmSync(this.ringPath, { force: true });
+  }
+
+  private open(): boolean {
+    if (this.logFd !== null) return true;
+    try {
+      // The launcher creates both files right after it starts
+      this.headerFd = fs.openSync(this.headerPath, 'r');
+      this.logFd = fs.openSync(this.logPath, 'r');
+      return true;
+    } catch {
+      if (this.headerFd !== null) fs.closeSync(this.headerFd);
+      this.headerFd = null;
+      return false;
+    }
+  }
+
+  private refresh(): boolean {
+    if (!this.open()) return false;
+    fs.readSync(this.headerFd!, this.headerBuf, 0, HEADER_BYTES, 0);
+    const state = parseCaptureHeader(this.headerBuf);
+    if (state) this.state = state;
+    return this.state !== null;
+  }
+
+  /**
+   * Map a stream offset to the log (head, or the tail once appended), the
+   * tail ring of a running capture, or past a range the policy discarded
+   */
+  private locate(offset: number): Location {
+    const s = this.state!;
+    if (s.headLimit === 0 && s.tailLimit === 0) {
+      return { fd: this.logFd!, position: offset, span: s.logBytes - offset };
+    }
+    if (offset < s.headLimit) {
+      return { fd: this.logFd!, position: offset, span: Math.min(s.headLimit, s.logBytes) - offset };
+    }
+    const kept = Math.max(s.headLimit, s.bytes - s.tailLimit);
+    if (offset < kept) return { next: kept };
+    if (s.done) {
+      return { fd: this.logFd!, position: s.logBytes - (s.bytes - offset), span: s.bytes - offset };
+    }
+    if (this.ringFd === null) {
+      try {
+        this.ringFd = fs.openSync(this.ringPath, 'r');
+      } catch {
+        return { next: s.bytes };
+      }
+    }
+    const position = (offset - s.headLimit) % s.tailLimit;
+    return { fd: this.ringFd, position, span: Math.min(s.bytes - offset, s.tailLimit - position) };
+  }
+
+  /**
+   * Push up to maxBytes from the current offset, first jumping to the tail
+   * if the terminal is too far behind (catchUp); returns how far it moved
+   */
+  private pushRange(maxBytes: number, catchUp = true): number {
+    const start = this.offset;
+    if (catchUp && this.totalBytes - this.offset > this.opts.maxLagBytes) {
+      this.skipTo(this.totalBytes - this.opts.tailBytes, 'skipped');
+    }
+    let where = this.locate(this.offset);
+    if ('next' in where) {
+      this.skipTo(where.next, 'elided');
+      where = this.locate(this.offset);
+      if ('next' in where) return this.offset - start;
+    }
+    const take = Math.min(where.span, maxBytes);
+    if (take <= 0) return this.offset - start;
+
+    const buf = Buffer.allocUnsafe(take);
+    const n = fs.readSync(where.fd, buf, 0, take, where.position);
+    if (where.fd === this.ringFd) {
+      // The writer may have wrapped over what we just read
+      this.refresh();
+      if (this.totalBytes - this.state!.tailLimit > this.offset) {
+        return this.offset - start;
+      }
+    }
+    this.offset += n;
+    if (n > 0) this.opts.push(buf.subarray(0, n));
+    return this.offset - start;
+  }
+
+  private skipTo(offset: number, reason: 'skipped' | 'elided'): void {
+    const from = this.offset;
+    this.offset = offset;
+    if (reason === 'skipped') {
+      this.skippedBytes += offset - from;
+      this.skippedRanges.push({ from, to: offset });
+      this.opts.push(Buffer.from(
+        `\r\n\x1b[33m[... ${offset - from} bytes skipped (output offsets ${from}-${offset}), kept in ${this.logPath} ...]\x1b[0m\r\n`
+      ));
+    } else {
+      this.opts.push(Buffer.from(
+        `\r\n\x1b[33m[... ${offset - from} bytes dropped by the output policy (output offsets ${from}-${offset}) ...]\x1b[0m\r\n`
+      ));
+    }
+  }
+}
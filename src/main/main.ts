@@ -1,6 +1,5 @@
-import { app, BrowserWindow, ipcMain, shell, dialog } from 'electron';
-import { spawn, ChildProcessWithoutNullStreams, ChildProcess } from 'child_process';
-import { Worker } from 'worker_threads';
+import { app, BrowserWindow, ipcMain, shell, dialog, utilityProcess, UtilityProcess, MessageChannelMain } from 'electron';
+import { spawn, ChildProcessWithoutNullStreams, ChildProcess, SpawnOptions } from 'child_process';
 import * as path from 'path';
 import * as process from 'process';
 import * as fs from 'fs';
@@ -8,13 +7,20 @@ import { createReadStream } from 'fs';
 import { createInterface } from 'readline';
 import * as https from 'https';
 import * as http from 'http';
+import * as net from 'net';
+import { OutputPipeline } from './output-pipeline';
+import { CaptureReader } from './capture-reader';
 
 let mainWindow: BrowserWindow | null = null;
 let sandboxProcess: ChildProcessWithoutNullStreams | null = null;
 let samplerProcess: ChildProcess | null = null;
 let prometheusProcess: ChildProcess | null = null;
-let fileJailMonitor: NodeJS.Timeout | null = null;
-let monitoringWorker: Worker | null = null; // Worker thread for monitoring
+let alertdProcess: ChildProcess | null = null;
+let fileJailMonitor: ChildProcess | null = null;
+let monitoringWorker: UtilityProcess | null = null; // Utility process for monitoring
+let outputPipeline: OutputPipeline | null = null; // Terminal output of the current run
+let outputCapture: CaptureReader | null = null;   // Launcher-side capture log of the current run
+const retainedOutput: Array<OutputPipeline | CaptureReader> = []; // Earlier runs' spools and logs
 
 /**
  * Create the main application window
@@ -64,87 +70,281 @@ function getSandboxPath(): string {
 }
 
 /**
- * File jail monitoring: Check /proc/{pid}/fd for violations
+ * Path to the native launcher that enforces the file jail with Landlock
  */
-function startFileJailMonitor(pid: number, jailPath: string, absoluteJailPath: string): void {
-  // Whitelist of safe paths that should not trigger violations
-  const whitelist = ['/dev/', '/proc/', '/sys/', '/usr/lib/', '/lib/', '/lib64/', '/tmp/'];
+function getLauncherPath(): string {
+  return path.join(app.getAppPath(), 'core_c', 'bin', 'zencube_launch');
+}
+
+/**
+ * Whether sandbox runs get placed on their own cores: opt-in through
+ * ZENCUBE_RUN_CORES, on native Linux with the launcher built
+ */
+function canPlaceRuns(): boolean {
+  return !!process.env.ZENCUBE_RUN_CORES && !isWindows() && fs.existsSync(getLauncherPath());
+}
+
+/**
+ * Physical cores leased to each placed sandbox run
+ */
+function getRunCores(): number {
+  const cores = parseInt(process.env.ZENCUBE_RUN_CORES || '1', 10);
+  return cores > 0 ? cores : 1;
+}
+
+/**
+ * Upper layer for ephemeral jails (ZENCUBE_JAIL_OVERLAY=tmpfs|dir), or
+ * null when runs write straight into the jail directory
+ */
+function getJailOverlay(): string | null {
+  const upper = process.env.ZENCUBE_JAIL_OVERLAY;
+  return upper === 'tmpfs' || upper === 'dir' ? upper : null;
+}
+
+/**
+ * Launcher arguments bounding a run's captured output: the first and last
+ * ZENCUBE_OUTPUT_HEAD_MB / ZENCUBE_OUTPUT_TAIL_MB (default 64 each; 0 on
+ * both keeps everything) and an optional ZENCUBE_OUTPUT_RATE_MB per second
+ */
+function getOutputPolicyArgs(): string[] {
+  const mb = (name: string, fallback: number): number => {
+    const value = parseFloat(process.env[name] ?? '');
+    return Number.isFinite(value) && value >= 0 ? value : fallback;
+  };
+  const args: string[] = [];
+  const head = mb('ZENCUBE_OUTPUT_HEAD_MB', 64);
+  const tail = mb('ZENCUBE_OUTPUT_TAIL_MB', 64);
+  const rate = mb('ZENCUBE_OUTPUT_RATE_MB', 0);
+  if (head > 0 || tail > 0) {
+    args.push('--capture-head', String(head), '--capture-tail', String(tail));
+  }
+  if (rate > 0) {
+    args.push('--capture-rate', String(rate));
+  }
+  return args;
+}
+
+/**
+ * Discard a finished run's overlay upper layer: one rename, then the
+ * launcher deletes it in the background
+ */
+function releaseJailOverlay(pid: number): void {
+  const release = spawn(getLauncherPath(), ['--overlay-release', String(pid)], { stdio: 'ignore' });
+  release.on('error', (err) => {
+    console.error('[FileJail] Overlay release failed:', err.message);
+  });
+}
+
+/**
+ * Spawn a monitoring daemon on the cores reserved for the monitoring
+ * stack, which sandbox runs are never placed on. The launcher execs in
+ * place, so the pid and signals are the daemon's own.
+ */
+function spawnOnReservedCores(command: string, args: string[], options: SpawnOptions): ChildProcess {
+  if (!canPlaceRuns()) {
+    return spawn(command, args, options);
+  }
+  return spawn(getLauncherPath(), ['--reserved', '--', command, ...args], options);
+}
+
+/**
+ * Move a process the launcher did not start (the monitoring worker) onto
+ * the reserved cores, every thread included
+ */
+function moveToReservedCores(pid: number): void {
+  if (!canPlaceRuns()) return;
+  const reserve = spawn(getLauncherPath(), ['--reserve-pid', String(pid)], { stdio: 'ignore' });
+  reserve.on('error', (err) => {
+    console.error('[Placement] Reserving cores failed:', err.message);
+  });
+}
+
+/**
+ * Re-place runs that had to share cores once a run has finished
+ */
+function rebalancePlacement(): void {
+  if (!canPlaceRuns()) return;
+  const rebalance = spawn(getLauncherPath(), ['--rebalance'], { stdio: 'ignore' });
+  rebalance.on('error', (err) => {
+    console.error('[Placement] Rebalance failed:', err.message);
+  });
+}
+
+interface LaunchStatus {
+  event: 'ready' | 'error';
+  landlock?: boolean;
+  landlock_abi?: number;
+  seccomp?: { rules: number; insns: number; depth: number };
+  cgroup?: string;
+  cgroup_error?: string;
+  cpu_seconds?: number;
+  overlay?: { run_dir: string; upper: string; tmpfs: boolean; user_namespace: boolean };
+  message?: string;
+}
+
+/**
+ * Read the launcher's status line (fd 3). Limits it could not apply are
+ * shown in the terminal, since best-effort runs go ahead without them.
+ * For a jail: when Landlock is enforced, escapes fail in the kernel and
+ * nothing needs watching; on kernels without it the launcher runs
+ * best-effort and jailwatch reports violations instead.
+ */
+function watchLauncherStatus(child: ChildProcess, pid: number, jailPath?: string, absoluteJailPath?: string): void {
+  const status = child.stdio[3] as NodeJS.ReadableStream | null;
+  if (!status) {
+    if (jailPath && absoluteJailPath) {
+      startFileJailMonitor(pid, jailPath, absoluteJailPath);
+    }
+    return;
+  }
   
-  fileJailMonitor = setInterval(() => {
-    const fdDir = `/proc/${pid}/fd`;
-    
+  let result: LaunchStatus | null = null;
+  const lines = createInterface({ input: status });
+  lines.on('line', (line) => {
     try {
-      if (!fs.existsSync(fdDir)) {
-        // Process has ended
-        stopFileJailMonitor();
-        return;
-      }
+      result = JSON.parse(line);
+    } catch {
+      // Ignore malformed lines
+    }
+  });
+  
+  // EOF: the launcher exec'd the command (or gave up)
+  lines.on('close', () => {
+    if (!result || result.event !== 'ready' || child !== sandboxProcess) {
+      return;
+    }
+    
+    if (result.cgroup_error) {
+      console.warn(`[Cgroup] Limits not fully applied: ${result.cgroup_error}`);
+      outputPipeline?.push(Buffer.from(
+        `\x1b[33m[Memory/process limits not fully applied: ${result.cgroup_error}]\x1b[0m\r\n`
+      ));
+    }
+    if (!jailPath || !absoluteJailPath) {
+      return;
+    }
+    if (result.overlay) {
+      console.log(`[FileJail] Writes to ${jailPath} go to ${result.overlay.upper} and are discarded after the run`);
+    }
+    if (result.landlock) {
+      console.log(`[FileJail] Landlock ABI ${result.landlock_abi} enforcing ${jailPath}`);
+    } else {
+      console.warn(`[FileJail] ${result.message || 'Landlock not enforced'}; falling back to jailwatch`);
+      startFileJailMonitor(pid, jailPath, absoluteJailPath);
+    }
+  });
+}
 
-      const fds = fs.readdirSync(fdDir);
-      
-      for (const fd of fds) {
-        try {
-          const fdPath = path.join(fdDir, fd);
-          const link = fs.readlinkSync(fdPath);
-          const targetPath = path.resolve(link);
-          
-          // Check if this is a whitelisted path
-          const isWhitelisted = whitelist.some(prefix => targetPath.startsWith(prefix));
-          
-          // Check for violation
-          if (!isWhitelisted && !targetPath.startsWith(absoluteJailPath)) {
-            // Send violation to renderer
-            if (mainWindow) {
-              mainWindow.webContents.send('file-jail-violation', {
-                path: targetPath
-              });
-            }
-          }
-        } catch (err) {
-          // Ignore errors (fd might have closed, etc.)
-        }
-      }
-    } catch (err) {
-      // Process dir doesn't exist or can't be read
-      stopFileJailMonitor();
+/**
+ * File jail monitoring: core_c/bin/jailwatch follows the sandboxed process
+ * tree (fanotify when permitted, otherwise an incremental /proc/<pid>/fd
+ * diff) and streams each new violation as a JSON line. It exits with the
+ * process, so the main thread only parses the occasional violation.
+ */
+function startFileJailMonitor(pid: number, jailPath: string, absoluteJailPath: string): void {
+  stopFileJailMonitor();
+  
+  const jailwatchPath = path.join(app.getAppPath(), 'core_c', 'bin', 'jailwatch');
+  const monitor = spawnOnReservedCores(jailwatchPath, [
+    '--pid', pid.toString(),
+    '--jail', absoluteJailPath
+  ], {
+    stdio: ['ignore', 'pipe', 'pipe'],
+    detached: false
+  });
+  fileJailMonitor = monitor;
+  
+  const lines = createInterface({ input: monitor.stdout! });
+  lines.on('line', (line) => {
+    let event: { event: string; path?: string; pid?: number; mode?: string };
+    try {
+      event = JSON.parse(line);
+    } catch {
+      return;
+    }
+    
+    if (event.event === 'started') {
+      console.log(`[FileJail] Watching ${jailPath} (pid ${pid}, ${event.mode})`);
+    } else if (event.event === 'violation' && mainWindow) {
+      mainWindow.webContents.send('file-jail-violation', {
+        path: event.path
+      });
     }
-  }, 500); // Poll every 500ms
+  });
+  
+  monitor.stderr?.on('data', (data: Buffer) => {
+    console.error(`[FileJail stderr] ${data.toString()}`);
+  });
+  
+  monitor.on('error', (err) => {
+    console.error('[FileJail] Failed to start jailwatch:', err.message);
+  });
+  
+  monitor.on('exit', () => {
+    if (fileJailMonitor === monitor) {
+      fileJailMonitor = null;
+    }
+  });
 }
 
 function stopFileJailMonitor(): void {
   if (fileJailMonitor) {
-    clearInterval(fileJailMonitor);
+    fileJailMonitor.kill();
     fileJailMonitor = null;
   }
 }
 
+const SAMPLE_INTERVAL_MS = 1000;
+
+/**
+ * Kernel delay accounting (taskstats) in samples, opt-in with
+ * ZENCUBE_DELAY_ACCT=1: it needs CAP_NET_ADMIN and, for anything beyond
+ * CPU wait, kernel.task_delayacct=1
+ */
+function useDelayAccounting(): boolean {
+  return process.env.ZENCUBE_DELAY_ACCT === '1';
+}
+
 /**
- * Start the sampler process and worker thread for monitoring
+ * Top growing mappings from smaps diffs in samples (ZENCUBE_MAP_GROWTH=N,
+ * off by default); scans run every 10 s at most
  */
-function startSamplerMonitoring(pid: number): void {
+function getMapGrowthTop(): number {
+  const top = parseInt(process.env.ZENCUBE_MAP_GROWTH ?? '', 10);
+  return Number.isFinite(top) && top > 0 ? top : 0;
+}
+
+/**
+ * Spawn the sampler binary writing JSONL for the worker to tail
+ */
+function spawnSamplerProcess(
+  pid: number, runId: string, outputPath: string, cgroupPath?: string, jailPath?: string
+): void {
   const samplerPath = path.join(app.getAppPath(), 'core_c', 'bin', 'sampler');
-  const outputPath = path.join(app.getPath('temp'), `zencube_samples_${pid}.jsonl`);
-  
-  console.log(`[Sampler] Starting monitoring for PID ${pid}`);
   console.log(`[Sampler] Sampler binary: ${samplerPath}`);
-  console.log(`[Sampler] Output file: ${outputPath}`);
-  
-  // Ensure the output file doesn't exist from a previous run
-  if (fs.existsSync(outputPath)) {
-    fs.unlinkSync(outputPath);
-    console.log(`[Sampler] Removed old output file`);
-  }
   
   const args = [
     '--pid', pid.toString(),
-    '--interval', '1.0',
-    '--run-id', `zencube_${Date.now()}`,
+    '--interval', (SAMPLE_INTERVAL_MS / 1000).toFixed(1),
+    '--run-id', runId,
     '--out', outputPath
   ];
+  if (cgroupPath) {
+    args.push('--cgroup', cgroupPath);
+  }
+  if (jailPath) {
+    args.push('--jail', jailPath);
+  }
+  if (useDelayAccounting()) {
+    args.push('--delays');
+  }
+  if (getMapGrowthTop() > 0) {
+    args.push('--map-growth', String(getMapGrowthTop()));
+  }
   
   console.log(`[Sampler] Spawning with args:`, args);
   
-  samplerProcess = spawn(samplerPath, args, {
+  samplerProcess = spawnOnReservedCores(samplerPath, args, {
     stdio: ['ignore', 'pipe', 'pipe']
   });
   
@@ -167,39 +367,91 @@ function startSamplerMonitoring(pid: number): void {
       console.log(`[Sampler] Process exited with code ${code}, signal ${signal}`);
     });
   }
+}
+
+/**
+ * Start sampling and the monitoring worker. The worker samples in-process
+ * through the core_c N-API addon when it is built; otherwise the sampler
+ * binary is spawned and the worker tails its JSONL output. With a cgroup,
+ * CPU, memory and I/O cover the run's whole process tree. With a jail path,
+ * samples also carry the jail's disk usage (jail_bytes) for alert rules.
+ */
+function startSamplerMonitoring(pid: number, cgroupPath?: string, jailPath?: string): void {
+  const addonPath = path.join(app.getAppPath(), 'core_c', 'bin', 'zencube_sampler.node');
+  const outputPath = path.join(app.getPath('temp'), `zencube_samples_${pid}.jsonl`);
+  const runId = `zencube_${Date.now()}`;
+  const useAddon = fs.existsSync(addonPath);
+  
+  console.log(`[Sampler] Starting monitoring for PID ${pid} (${useAddon ? 'in-process addon' : 'sampler process'})`);
+  console.log(`[Sampler] Output file: ${outputPath}`);
+  
+  // Ensure the output file doesn't exist from a previous run
+  if (fs.existsSync(outputPath)) {
+    fs.unlinkSync(outputPath);
+    console.log(`[Sampler] Removed old output file`);
+  }
   
-  // Start the monitoring worker thread
+  if (!useAddon) {
+    spawnSamplerProcess(pid, runId, outputPath, cgroupPath, jailPath);
+  }
+  
+  // Start the monitoring worker in a utility process
   const workerPath = path.join(__dirname, 'monitoring-worker.js');
-  console.log(`[MonitoringWorker] Starting worker thread: ${workerPath}`);
+  console.log(`[MonitoringWorker] Starting worker process: ${workerPath}`);
+  
+  const worker = utilityProcess.fork(workerPath, [], {
+    serviceName: 'ZenCube Monitoring'
+  });
+  monitoringWorker = worker;
+  
+  // The addon sampler runs inside the worker, so the worker belongs on the
+  // reserved cores like the sampler binary
+  worker.once('spawn', () => {
+    if (worker.pid) moveToReservedCores(worker.pid);
+  });
   
-  monitoringWorker = new Worker(workerPath);
+  // Batches flow worker -> renderer over this channel; the main thread only
+  // hands out the two ends and never touches the data
+  const { port1, port2 } = new MessageChannelMain();
   
-  // Send start message to worker
-  monitoringWorker.postMessage({
+  // Send start message to worker. The JSONL file is still written in addon
+  // mode because the exporter and alert daemon read it.
+  worker.postMessage({
     type: 'start',
     pid,
-    path: outputPath
-  });
+    path: outputPath,
+    runId,
+    intervalMs: SAMPLE_INTERVAL_MS,
+    cgroup: cgroupPath,
+    jail: jailPath,
+    delays: useDelayAccounting(),
+    mapGrowth: getMapGrowthTop(),
+    addonPath: useAddon ? addonPath : undefined
+  }, [port1]);
+  
+  if (mainWindow) {
+    mainWindow.webContents.postMessage('monitoring-port', null, [port2]);
+  } else {
+    port2.close();
+  }
   
-  // Listen for data batches from worker
-  monitoringWorker.on('message', (msg) => {
-    if (msg.type === 'data-batch' && mainWindow) {
-      console.log(`[MonitoringWorker] Received batch with ${msg.data.length} data points`);
+  worker.on('message', (msg) => {
+    if (msg.type === 'addon-failed') {
+      if (monitoringWorker !== worker) return; // Run already stopped
       
-      // Send pre-batched data to renderer
-      mainWindow.webContents.send('monitoring-data-batch', msg.data);
+      // Addon present but not loadable (e.g. ABI mismatch): use the binary
+      spawnSamplerProcess(pid, runId, outputPath, cgroupPath, jailPath);
+      worker.postMessage({ type: 'tail', path: outputPath });
     } else if (msg.type === 'stopped') {
       console.log('[MonitoringWorker] Worker confirmed shutdown');
     }
   });
   
-  monitoringWorker.on('error', (err) => {
-    console.error('[MonitoringWorker] Worker error:', err);
-  });
-  
-  monitoringWorker.on('exit', (code) => {
+  worker.on('exit', (code) => {
     console.log(`[MonitoringWorker] Worker exited with code ${code}`);
-    monitoringWorker = null;
+    if (monitoringWorker === worker) {
+      monitoringWorker = null;
+    }
   });
 }
 
@@ -210,17 +462,42 @@ function stopSamplerMonitoring(): void {
   }
   
   if (monitoringWorker) {
-    console.log('[MonitoringWorker] Stopping worker thread');
-    monitoringWorker.postMessage({ type: 'stop' });
+    console.log('[MonitoringWorker] Stopping worker process');
+    const worker = monitoringWorker;
+    worker.postMessage({ type: 'stop' });
     
     // Give worker 500ms to shut down gracefully, then terminate
     setTimeout(() => {
-      if (monitoringWorker) {
-        monitoringWorker.terminate();
-        monitoringWorker = null;
-      }
+      worker.kill();
     }, 500);
+    monitoringWorker = null;
+  }
+}
+
+/**
+ * Delegated cgroup v2 subtree the launcher creates per-run cgroups under
+ */
+function getCgroupParent(): string {
+  return process.env.ZENCUBE_CGROUP_PARENT || '/sys/fs/cgroup/zencube';
+}
+
+/**
+ * Kill whatever the run left behind in its cgroup and remove it. rmdir
+ * fails with EBUSY until the killed tasks are gone, so it is retried.
+ */
+function removeRunCgroup(cgroupPath: string, attempts = 20): void {
+  try {
+    fs.writeFileSync(path.join(cgroupPath, 'cgroup.kill'), '1');
+  } catch {
+    // Gone already, or a kernel without cgroup.kill (< 5.14)
   }
+  fs.rmdir(cgroupPath, (err) => {
+    if (err && err.code === 'EBUSY' && attempts > 1) {
+      setTimeout(() => removeRunCgroup(cgroupPath, attempts - 1), 100);
+    } else if (err && err.code !== 'ENOENT') {
+      console.error(`[Cgroup] Cannot remove ${cgroupPath}:`, err.message);
+    }
+  });
 }
 
 /**
@@ -278,31 +555,75 @@ ipcMain.handle('execute-sandbox', async (event, options: {
     }
 
     // Prepare the command
-    const finalCommand = options.command;
-    const finalArgs = [...options.args];
-
-    // Handle network isolation
-    if (options.isNetworkDisabled) {
-      if (isWindows()) {
-        // Windows/WSL: wsl unshare -n {command} {args}
-        spawnCommand = 'wsl';
-        spawnArgs = ['unshare', '-n', finalCommand, ...finalArgs];
-      } else {
-        // Linux: unshare -n {command} {args}
-        spawnCommand = 'unshare';
-        spawnArgs = ['-n', finalCommand, ...finalArgs];
+    let finalCommand = options.command;
+    let finalArgs = [...options.args];
+    
+    // Native Linux: the launcher applies the jail (Landlock), network deny
+    // (seccomp) and memory/process limits (a per-run cgroup) in the kernel
+    // before exec, and reports what it enforced on fd 3. CPU time has no
+    // cgroup equivalent and is an RLIMIT_CPU budget set just before exec.
+    // With placement opted into, it also puts the run on cores of its own,
+    // away from the monitoring stack.
+    const jailWithLauncher = Boolean(options.isJailEnabled && absoluteJailPath);
+    const limitWithCgroup = options.memLimit !== undefined || options.procLimit !== undefined;
+    const limitCpuTime = options.cpuLimit !== undefined && options.cpuLimit > 0;
+    const placeRun = canPlaceRuns();
+    const jailOverlay = jailWithLauncher ? getJailOverlay() : null;
+    const useLauncher = !isWindows() &&
+      (jailWithLauncher || options.isNetworkDisabled || limitWithCgroup || limitCpuTime || placeRun);
+    // Best-effort jails and cgroups report what they could not apply on fd 3
+    const readStatus = jailWithLauncher || limitWithCgroup;
+    let captureLog: string | null = null;
+    if (useLauncher) {
+      finalCommand = getLauncherPath();
+      finalArgs = [];
+      if (placeRun) {
+        finalArgs.push('--cores', String(getRunCores()));
       }
-    } else {
-      // No network isolation
-      if (isWindows()) {
-        // Windows/WSL: wsl {command} {args}
-        spawnCommand = 'wsl';
-        spawnArgs = [finalCommand, ...finalArgs];
-      } else {
-        // Linux: {command} {args}
-        spawnCommand = finalCommand;
-        spawnArgs = finalArgs;
+      if (readStatus) {
+        finalArgs.push('--status-fd', '3');
+        spawnOptions.stdio = ['pipe', 'pipe', 'pipe', 'pipe'];
+      }
+      if (jailWithLauncher) {
+        finalArgs.push('--jail', absoluteJailPath, '--jail-best-effort');
+        if (jailOverlay) {
+          // Ephemeral jail: the run sees an overlay and the jail stays untouched
+          finalArgs.push('--overlay', '--overlay-upper', jailOverlay);
+        }
+      }
+      if (options.isNetworkDisabled) {
+        finalArgs.push('--no-net');
       }
+      if (limitWithCgroup) {
+        // Best effort: without a delegated subtree the run goes unlimited
+        finalArgs.push('--cgroup-parent', getCgroupParent(), '--cgroup-best-effort');
+        if (options.memLimit !== undefined) {
+          finalArgs.push('--memory-max', String(options.memLimit));
+        }
+        if (options.procLimit !== undefined) {
+          finalArgs.push('--pids-max', String(options.procLimit));
+        }
+      }
+      if (limitCpuTime) {
+        finalArgs.push('--cpu-seconds', String(Math.ceil(options.cpuLimit!)));
+      }
+      // The launcher splices the run's output into a log; we read it on
+      // our own schedule instead of draining a pipe chunk by chunk
+      captureLog = path.join(app.getPath('temp'), `zencube_capture_${Date.now()}.log`);
+      finalArgs.push('--capture', captureLog, ...getOutputPolicyArgs());
+      finalArgs.push('--', options.command, ...options.args);
+    }
+
+    if (isWindows()) {
+      // Windows/WSL: wsl [unshare -n] {command} {args}
+      spawnCommand = 'wsl';
+      spawnArgs = options.isNetworkDisabled
+        ? ['unshare', '-n', finalCommand, ...finalArgs]
+        : [finalCommand, ...finalArgs];
+    } else {
+      // Linux: {command} {args}, network already handled by the launcher
+      spawnCommand = finalCommand;
+      spawnArgs = finalArgs;
     }
 
     // Spawn the process
@@ -317,78 +638,141 @@ ipcMain.handle('execute-sandbox', async (event, options: {
       };
     }
 
-    // Start file jail monitoring if enabled
-    if (options.isJailEnabled && absoluteJailPath && !isWindows()) {
-      // File jail monitoring only works on native Linux (not WSL from Windows)
-      startFileJailMonitor(pid, options.jailPath!, absoluteJailPath);
+    // File jail: enforced by the launcher, or watched when it cannot be
+    // (native Linux only, not WSL from Windows). Cgroup failures are
+    // reported the same way.
+    if (readStatus && useLauncher) {
+      if (jailWithLauncher) {
+        watchLauncherStatus(sandboxProcess, pid, options.jailPath!, absoluteJailPath);
+      } else {
+        watchLauncherStatus(sandboxProcess, pid);
+      }
     }
 
+    // The launcher execs in place, so its pid names the run's cgroup
+    const cgroupPath = useLauncher && limitWithCgroup
+      ? path.join(getCgroupParent(), `zencube_${pid}`)
+      : undefined;
+
     // Start sampler monitoring
     if (!isWindows()) {
       // Sampler monitoring only works on native Linux
-      startSamplerMonitoring(pid);
+      // An overlay run writes to its upper layer, not the jail itself
+      const usagePath = jailWithLauncher && !jailOverlay ? absoluteJailPath : undefined;
+      startSamplerMonitoring(pid, cgroupPath, usagePath);
     }
 
-    // Output buffering to handle race conditions AND prevent IPC flooding
-    let stdoutBuffer = '';
-    let stderrBuffer = '';
-    let terminalBuffer = ''; // Batching buffer for IPC sends
-    const MAX_BUFFER_SIZE = 65536; // 64KB max per batch
+    // Bounded output pipeline: batches to the renderer, pauses the child's
+    // pipes while the terminal is behind, spools overflow for scrollback
+    const child = sandboxProcess;
+    // Their skip markers are still on screen: keep the files until cleared
+    if (outputPipeline) {
+      outputPipeline.close();
+      retainedOutput.push(outputPipeline);
+    }
+    if (outputCapture) {
+      outputCapture.close();
+      retainedOutput.push(outputCapture);
+      outputCapture = null;
+    }
+    const pipeline = new OutputPipeline({
+      spoolPath: path.join(app.getPath('temp'), `zencube_output_${pid}.spool`),
+      send: (batch) => {
+        if (mainWindow) {
+          mainWindow.webContents.send('sandbox-output', batch);
+        }
+      },
+      setPaused: (paused) => {
+        if (capture) {
+          capture.setPaused(paused);
+        } else if (paused) {
+          child.stdout.pause();
+          child.stderr.pause();
+        } else {
+          child.stdout.resume();
+          child.stderr.resume();
+        }
+      },
+    });
+    outputPipeline = pipeline;
+    const capture = captureLog
+      ? new CaptureReader({ logPath: captureLog, push: (chunk) => pipeline.push(chunk) })
+      : null;
+    outputCapture = capture;
 
-    // Batched IPC sender - sends buffered data every 300ms to prevent UI lag
+    // Batched IPC sender - sends queued output every 300ms to prevent UI lag
     const ipcSender = setInterval(() => {
-      if (terminalBuffer.length > 0 && mainWindow) {
-        // Split large buffers into chunks to prevent overwhelming the renderer
-        const chunk = terminalBuffer.substring(0, MAX_BUFFER_SIZE);
-        mainWindow.webContents.send('sandbox-output', {
-          type: 'stdout',
-          data: chunk,
-        });
-        terminalBuffer = terminalBuffer.substring(MAX_BUFFER_SIZE); // Keep remainder
-      }
-    }, 300); // 300ms batching interval for smoother performance
+      capture?.poll();
+      pipeline.flush();
+    }, 300);
 
-    // Accumulate stdout data (DON'T send immediately)
-    sandboxProcess.stdout.on('data', (data: Buffer) => {
-      const output = data.toString();
-      stdoutBuffer += output;      // Keep for final flush
-      terminalBuffer += output;     // Add to batching buffer
-    });
+    // stdout and stderr are merged into one terminal stream (with a
+    // capture, only what the launcher printed before it started)
+    sandboxProcess.stdout.on('data', (data: Buffer) => pipeline.push(data));
+    sandboxProcess.stderr.on('data', (data: Buffer) => pipeline.push(data));
 
-    // Accumulate stderr data (DON'T send immediately)
-    sandboxProcess.stderr.on('data', (data: Buffer) => {
-      const output = data.toString();
-      stderrBuffer += output;       // Keep for final flush
-      terminalBuffer += output;     // Add to batching buffer (merged with stdout)
-    });
-
-    // Handle process exit - CRITICAL for race condition fix
-    sandboxProcess.on('exit', (code: number | null, signal: string | null) => {
+    // Handle process exit. 'close' fires after both pipes have drained, so
+    // no output can arrive after the summary is built
+    sandboxProcess.on('close', (code: number | null, signal: string | null) => {
       // STOP the batching interval
       clearInterval(ipcSender);
       
-      // Send any final remaining buffered data
-      if (terminalBuffer.length > 0 && mainWindow) {
-        mainWindow.webContents.send('sandbox-output', {
-          type: 'stdout',
-          data: terminalBuffer,
-        });
+      // The capture process may still be writing the last bytes
+      if (capture) {
+        capture.whenDone(() => complete(code, signal));
+      } else {
+        complete(code, signal);
+      }
+    });
+
+    const complete = (code: number | null, signal: string | null): void => {
+      if (capture) {
+        capture.finish();
+        // Runaway output: say what the launcher's output policy did
+        const { elided, throttledMs } = capture.policyStats;
+        if (elided > 0 || throttledMs > 0) {
+          pipeline.push(Buffer.from(
+            `\x1b[33m[Output policy: ${elided} bytes elided, output throttled for ${throttledMs} ms]\x1b[0m\r\n`
+          ));
+        }
+      }
+      const summary = pipeline.finish();
+      if (capture) {
+        // What the terminal skipped is in the log, unless the policy dropped it
+        summary.totalBytes = capture.totalBytes;
+        summary.spooledBytes += capture.skippedBytes;
+        summary.spoolPath = capture.logPath;
       }
-      
       if (mainWindow) {
-        // Send final buffered output with exit event
+        // Only a bounded head and tail travel with the exit event; anything
+        // else was either streamed already or sits in the spool
         mainWindow.webContents.send('sandbox-exit', {
           code,
           signal,
-          finalStdout: stdoutBuffer,
-          finalStderr: stderrBuffer,
+          finalStdout: summary.tail,
+          totalBytes: summary.totalBytes,
+          spooledBytes: summary.spooledBytes,
+          droppedBytes: summary.droppedBytes,
+          spoolPath: summary.spoolPath,
+          skipped: capture ? capture.skippedRanges : summary.skipped,
         });
       }
       
       stopFileJailMonitor();
       stopSamplerMonitoring();
-      sandboxProcess = null;
-    });
+      if (cgroupPath) {
+        removeRunCgroup(cgroupPath);
+      }
+      if (placeRun) {
+        rebalancePlacement();
+      }
+      if (jailOverlay && useLauncher) {
+        releaseJailOverlay(pid);
+      }
+      if (sandboxProcess === child) {
+        sandboxProcess = null;
+      }
+    };
 
     // Handle process errors
     sandboxProcess.on('error', (err: Error) => {
@@ -418,6 +802,43 @@ ipcMain.handle('execute-sandbox', async (event, options: {
   }
 });
 
+/**
+ * Renderer finished writing an output batch; reopens the send window
+ */
+ipcMain.on('sandbox-output-ack', (_event, bytes: number) => {
+  if (outputPipeline && typeof bytes === 'number') {
+    outputPipeline.ack(bytes);
+  }
+});
+
+/**
+ * Read output that was spooled instead of sent to the terminal
+ */
+ipcMain.handle('get-output-scrollback', async (_event, options: { offset: number; length: number }) => {
+  if (outputCapture) {
+    return outputCapture.read(options.offset, Math.min(options.length, 1024 * 1024));
+  }
+  if (!outputPipeline) {
+    return null;
+  }
+  return outputPipeline.readScrollback(options.offset, Math.min(options.length, 1024 * 1024));
+});
+
+/**
+ * Terminal was cleared: no marker points at the finished runs' logs anymore
+ */
+ipcMain.on('clear-output', () => {
+  for (const output of retainedOutput.splice(0)) {
+    output.dispose();
+  }
+  if (!sandboxProcess) {
+    outputPipeline?.dispose();
+    outputPipeline = null;
+    outputCapture?.dispose();
+    outputCapture = null;
+  }
+});
+
 /**
  * Stop the running sandbox process
  */
@@ -443,99 +864,276 @@ ipcMain.handle('get-system-info', async () => {
   };
 });
 
+function getAlertSocketPath(): string {
+  return path.join(app.getPath('temp'), 'zencube_alertd.sock');
+}
+
+let alertSubscription: net.Socket | null = null;
+let alertNextSeq = 1;
+const ALERTD_RESTART_MIN_MS = 1000;
+const ALERTD_RESTART_MAX_MS = 30000;
+let alertdRestartDelay = ALERTD_RESTART_MIN_MS;
+let alertdQuitting = false;
+
 /**
- * Get alerts from alertd
+ * Start the session's alert daemon. It follows every sample log in the temp
+ * directory and answers queries on a Unix socket, so the GUI gets pushed
+ * alert events instead of spawning alertd per request. If it dies it is
+ * respawned, backing off from 1 s to 30 s while it keeps failing.
  */
-ipcMain.handle('get-alerts', async () => {
-  return new Promise<string>((resolve) => {
-    const alertdPath = path.join(app.getAppPath(), 'core_c', 'bin', 'alertd');
-    const alertsFile = path.join(app.getPath('temp'), 'test_alerts.jsonl');
-    
-    // Check if alerts file exists
-    if (!fs.existsSync(alertsFile)) {
-      resolve('No alerts file found. Run the sampler first to generate data.');
+function startAlertDaemon(): void {
+  if (alertdProcess || alertdQuitting) {
+    return;
+  }
+  
+  // A new daemon numbers its events from 1 again
+  alertNextSeq = 1;
+  const alertdPath = path.join(app.getAppPath(), 'core_c', 'bin', 'alertd');
+  const daemon = spawnOnReservedCores(alertdPath, [
+    '--config', path.join(app.getAppPath(), 'core_c', 'alert_rules.json'),
+    '--dir', app.getPath('temp'),
+    '--out', path.join(app.getPath('temp'), 'zencube_alerts.jsonl'),
+    '--socket', getAlertSocketPath()
+  ], {
+    stdio: ['ignore', 'pipe', 'pipe'],
+    detached: false
+  });
+  alertdProcess = daemon;
+  
+  // alertd flushes this line once the socket is listening
+  daemon.stdout?.on('data', (data: Buffer) => {
+    if (data.toString().includes('Serving alert queries')) {
+      alertdRestartDelay = ALERTD_RESTART_MIN_MS;
+      subscribeToAlerts();
+    }
+  });
+  
+  daemon.stderr?.on('data', (data: Buffer) => {
+    console.error(`[alertd stderr] ${data.toString()}`);
+  });
+  
+  daemon.on('error', (err) => {
+    console.error('[alertd]', err.message);
+  });
+  
+  daemon.on('exit', (code) => {
+    console.log(`[alertd] exited with code ${code}`);
+    if (alertdProcess === daemon) {
+      alertdProcess = null;
+      if (!alertdQuitting) {
+        // It rereads the logs of runs still going, so their alerts may repeat
+        setTimeout(startAlertDaemon, alertdRestartDelay);
+        alertdRestartDelay = Math.min(alertdRestartDelay * 2, ALERTD_RESTART_MAX_MS);
+      }
+    }
+  });
+}
+
+/**
+ * Read newline-delimited JSON from an alertd connection
+ */
+function readAlertLines(socket: net.Socket, onMessage: (message: any) => void): void {
+  let buffered = '';
+  socket.setEncoding('utf8');
+  socket.on('data', (chunk: string) => {
+    buffered += chunk;
+    let newline: number;
+    while ((newline = buffered.indexOf('\n')) >= 0) {
+      const line = buffered.slice(0, newline);
+      buffered = buffered.slice(newline + 1);
+      try {
+        onMessage(JSON.parse(line));
+      } catch {
+        // Ignore malformed lines
+      }
+    }
+  });
+}
+
+/**
+ * Keep one subscription open and forward alert events to the renderer. A
+ * dropped connection to a live daemon resubscribes from the last seen
+ * sequence number; a respawned daemon subscribes once it is serving.
+ */
+function subscribeToAlerts(): void {
+  if (alertSubscription || !alertdProcess) {
+    return;
+  }
+  
+  const socket = net.createConnection(getAlertSocketPath());
+  alertSubscription = socket;
+  
+  socket.on('connect', () => {
+    socket.write(JSON.stringify({ cmd: 'subscribe', seq: alertNextSeq - 1 }) + '\n');
+  });
+  
+  readAlertLines(socket, (message) => {
+    if (message.type !== 'event') {
       return;
     }
+    alertNextSeq = Math.max(alertNextSeq, message.seq + 1);
+    if (mainWindow) {
+      mainWindow.webContents.send('alert-event', message);
+    }
+  });
+  
+  socket.on('error', (err) => {
+    console.error('[alertd] Subscription error:', err.message);
+  });
+  
+  socket.on('close', () => {
+    if (alertSubscription === socket) {
+      alertSubscription = null;
+      if (alertdProcess && !alertdQuitting) {
+        setTimeout(subscribeToAlerts, ALERTD_RESTART_MIN_MS);
+      }
+    }
+  });
+}
+
+/**
+ * Send one request to alertd and return its reply
+ */
+function queryAlertd(request: object): Promise<any> {
+  return new Promise((resolve, reject) => {
+    const socket = net.createConnection(getAlertSocketPath());
+    const timeout = setTimeout(() => {
+      socket.destroy();
+      reject(new Error('alertd did not answer'));
+    }, 2000);
     
-    const args = ['--in', alertsFile];
-    
-    const alertProcess = spawn(alertdPath, args, {
-      stdio: ['ignore', 'pipe', 'pipe']
-    });
-    
-    let output = '';
-    let errorOutput = '';
-    
-    alertProcess.stdout.on('data', (data: Buffer) => {
-      output += data.toString();
-    });
-    
-    alertProcess.stderr.on('data', (data: Buffer) => {
-      errorOutput += data.toString();
+    socket.on('connect', () => {
+      socket.write(JSON.stringify(request) + '\n');
     });
     
-    alertProcess.on('close', (code) => {
-      if (code === 0 && output) {
-        resolve(output);
-      } else {
-        resolve(errorOutput || 'No alert data available');
-      }
+    readAlertLines(socket, (message) => {
+      clearTimeout(timeout);
+      socket.end();
+      resolve(message);
     });
     
-    alertProcess.on('error', (err) => {
-      resolve(`Error running alertd: ${err.message}`);
+    socket.on('error', (err) => {
+      clearTimeout(timeout);
+      reject(err);
     });
   });
-});
+}
 
 /**
- * Launch Prometheus metrics exporter and fetch metrics
+ * Get this session's alert events from alertd as JSON lines
  */
-ipcMain.handle('get-prometheus-metrics', async () => {
-  return new Promise<string>(async (resolve) => {
-    // Stop any existing prometheus process
-    if (prometheusProcess) {
-      prometheusProcess.kill();
-      prometheusProcess = null;
+ipcMain.handle('get-alerts', async () => {
+  try {
+    const reply = await queryAlertd({ cmd: 'since', seq: 0 });
+    if (!reply.events || reply.events.length === 0) {
+      return 'No alerts raised this session.';
     }
+    return reply.events.map((event: object) => JSON.stringify(event)).join('\n');
+  } catch (error) {
+    return `Error querying alertd: ${error instanceof Error ? error.message : 'Unknown error'}`;
+  }
+});
+
+const PROM_EXPORTER_PORT = 9090;
+let prometheusReady: Promise<void> | null = null;
+
+/**
+ * Start the session's Prometheus exporter once. It tails every sample log
+ * written to the temp directory and answers /metrics and /api/series from
+ * its in-memory cache, so fetches no longer pay for a process spawn.
+ */
+function ensurePrometheusExporter(): Promise<void> {
+  if (prometheusProcess && prometheusReady) {
+    return prometheusReady;
+  }
+  
+  const promPath = path.join(app.getAppPath(), 'core_c', 'bin', 'prom_exporter');
+  const exporter = spawnOnReservedCores(promPath, [
+    '--dir', app.getPath('temp'),
+    '--port', PROM_EXPORTER_PORT.toString()
+  ], {
+    stdio: ['ignore', 'pipe', 'pipe'],
+    detached: false
+  });
+  prometheusProcess = exporter;
+  
+  prometheusReady = new Promise<void>((resolve, reject) => {
+    const timeout = setTimeout(() => reject(new Error('Prometheus exporter did not start')), 3000);
     
-    const promPath = path.join(app.getAppPath(), 'core_c', 'bin', 'prom_exporter');
-    const samplesFile = path.join(app.getPath('temp'), 'zencube_samples_*.jsonl');
-    
-    prometheusProcess = spawn(promPath, ['--in', samplesFile], {
-      stdio: ['ignore', 'pipe', 'pipe'],
-      detached: false
+    // The exporter flushes this line once it is listening
+    exporter.stdout?.on('data', (data: Buffer) => {
+      if (data.toString().includes('exporter running')) {
+        clearTimeout(timeout);
+        resolve();
+      }
     });
     
-    if (!prometheusProcess) {
-      resolve('Error: Failed to start Prometheus exporter');
-      return;
-    }
+    exporter.stderr?.on('data', (data: Buffer) => {
+      console.error(`[Prometheus stderr] ${data.toString()}`);
+    });
     
-    // Wait for the server to start
-    await new Promise(r => setTimeout(r, 1500));
+    exporter.on('error', (err) => {
+      clearTimeout(timeout);
+      reject(err);
+    });
     
-    // Fetch metrics from the HTTP endpoint
-    try {
-      const response = await fetch('http://localhost:9091/metrics');
-      const metricsText = await response.text();
-      
-      // Kill the process immediately after getting metrics
-      if (prometheusProcess) {
-        prometheusProcess.kill();
-        prometheusProcess = null;
-      }
-      
-      resolve(metricsText);
-    } catch (error) {
-      // Kill the process on error
-      if (prometheusProcess) {
-        prometheusProcess.kill();
+    exporter.on('exit', (code) => {
+      clearTimeout(timeout);
+      reject(new Error(`Prometheus exporter exited with code ${code}`));
+      if (prometheusProcess === exporter) {
         prometheusProcess = null;
+        prometheusReady = null;
       }
-      resolve(`Error fetching metrics: ${error instanceof Error ? error.message : 'Unknown error'}`);
-    }
+    });
   });
+  
+  // Failures surface to callers; avoid an unhandled rejection at startup
+  prometheusReady.catch((err) => console.error('[Prometheus]', err.message));
+  return prometheusReady;
+}
+
+async function fetchFromExporter(pathAndQuery: string): Promise<Response> {
+  await ensurePrometheusExporter();
+  return fetch(`http://localhost:${PROM_EXPORTER_PORT}${pathAndQuery}`);
+}
+
+/**
+ * Fetch metrics from the long-lived Prometheus exporter
+ */
+ipcMain.handle('get-prometheus-metrics', async () => {
+  try {
+    const response = await fetchFromExporter('/metrics');
+    return await response.text();
+  } catch (error) {
+    return `Error fetching metrics: ${error instanceof Error ? error.message : 'Unknown error'}`;
+  }
+});
+
+/**
+ * Fetch a time range of cached samples (epoch ms; step > 0 aggregates)
+ */
+ipcMain.handle('get-metric-series', async (_event, options: {
+  run?: string;
+  from?: number;
+  to?: number;
+  step?: number;
+}) => {
+  const params = new URLSearchParams();
+  if (options.run) params.set('run', options.run);
+  if (options.from !== undefined) params.set('from', options.from.toString());
+  if (options.to !== undefined) params.set('to', options.to.toString());
+  if (options.step !== undefined) params.set('step', options.step.toString());
+  
+  try {
+    const response = await fetchFromExporter(`/api/series?${params.toString()}`);
+    if (!response.ok) {
+      return null;
+    }
+    return await response.json();
+  } catch (error) {
+    console.error('[Prometheus] Series fetch failed:', error);
+    return null;
+  }
 });
 
 /**
@@ -579,6 +1177,11 @@ ipcMain.handle('dialog:openDirectory', async () => {
  */
 app.on('ready', () => {
   createWindow();
+  
+  if (!isWindows()) {
+    ensurePrometheusExporter();
+    startAlertDaemon();
+  }
 });
 
 app.on('window-all-closed', () => {
@@ -607,6 +1210,28 @@ app.on('before-quit', () => {
     prometheusProcess.kill();
   }
   
+  alertdQuitting = true;
+  if (alertSubscription) {
+    alertSubscription.destroy();
+    alertSubscription = null;
+  }
+  
+  if (alertdProcess) {
+    alertdProcess.kill();
+  }
+  
+  if (outputPipeline) {
+    outputPipeline.dispose();
+    outputPipeline = null;
+  }
+  if (outputCapture) {
+    outputCapture.dispose();
+    outputCapture = null;
+  }
+  for (const output of retainedOutput.splice(0)) {
+    output.dispose();
+  }
+  
   stopFileJailMonitor();
   stopSamplerMonitoring();
 });
@@ -1,126 +1,406 @@
 /**
- * Monitoring Worker Thread
+ * Monitoring Worker
  * 
- * This worker runs in a separate Node.js thread to offload all file I/O,
+ * This worker runs in an Electron utility process to offload all file I/O,
  * JSON parsing, and data batching from the main Electron thread.
- * This prevents blocking the UI during heavy monitoring operations.
+ * Batches go straight to the renderer over a MessagePort handed over by the
+ * main process, so the main thread is not in the data path at all.
  */
 
-import { parentPort } from 'worker_threads';
+import type { MessagePortMain } from 'electron';
+import { performance } from 'perf_hooks';
 import * as fs from 'fs';
-import { createReadStream } from 'fs';
-import { createInterface } from 'readline';
 
 interface WorkerMessage {
-  type: 'start' | 'stop';
+  type: 'start' | 'tail' | 'stop';
   pid?: number;
   path?: string;
+  runId?: string;
+  intervalMs?: number;
+  cgroup?: string;
+  jail?: string;
+  delays?: boolean;
+  mapGrowth?: number;
+  addonPath?: string;
 }
 
-interface MonitoringDataPoint {
-  cpu: number;
-  memory: number;
-  timestamp: number;
+/**
+ * In-process sampler from core_c (bin/zencube_sampler.node). It samples on
+ * its own native thread and calls back here with column-major batches.
+ */
+interface NativeBatch {
+  fields: string[];
+  count: number;
+  columns: Float64Array;
+  ended: boolean;
+}
+
+interface NativeSampler {
+  stop(): void;
+}
+
+interface SamplerAddon {
+  start(
+    options: {
+      pid: number;
+      intervalMs: number;
+      batchMs: number;
+      runId?: string;
+      out?: string;
+      cgroup?: string;
+      jail?: string;
+      delays?: number;
+      mapGrowth?: number;
+      rollups?: number;
+    },
+    callback: (batch: NativeBatch) => void
+  ): NativeSampler;
+}
+
+/**
+ * Columns of a batch, in order. Batches are one column-major Float64Array
+ * (column i occupies [i * count, (i + 1) * count)), so a batch costs a single
+ * buffer copy per hop instead of one object per point.
+ */
+const BATCH_FIELDS = ['seq', 'cpu', 'memory', 'collectedAt', 'readAt'] as const;
+const FIELD_COUNT = BATCH_FIELDS.length;
+const INITIAL_CAPACITY = 256;
+
+/**
+ * High-resolution epoch milliseconds. Every hop of the monitoring pipeline
+ * (worker, renderer) stamps with this clock so hop deltas line up.
+ */
+function nowMs(): number {
+  return performance.timeOrigin + performance.now();
 }
 
-let dataBuffer: MonitoringDataPoint[] = [];
+/**
+ * Convert the sampler's CLOCK_MONOTONIC nanoseconds to epoch milliseconds.
+ * process.hrtime uses the same clock, so the offset is measured here.
+ */
+function monoToEpochMs(monoNs: number): number {
+  const offset = nowMs() - Number(process.hrtime.bigint()) / 1e6;
+  return monoNs / 1e6 + offset;
+}
+
+const READ_CHUNK_SIZE = 64 * 1024;
+const NEWLINE = 0x0a;
+
+// Pending points, row-major, reused across batches
+let pending = new Float64Array(INITIAL_CAPACITY * FIELD_COUNT);
+let pendingCount = 0;
+let rendererPort: MessagePortMain | null = null;
+let nativeSampler: NativeSampler | null = null;
+let stopRequested = false;
 let senderInterval: NodeJS.Timeout | null = null;
 let fileWatcher: fs.FSWatcher | null = null;
-let lastSize = 0;
 
-parentPort?.on('message', (msg: WorkerMessage) => {
-  if (msg.type === 'start' && msg.pid && msg.path) {
-    console.log(`[MonitoringWorker] Starting monitoring for PID ${msg.pid}, file: ${msg.path}`);
+// Long-lived reader state: one fd, positional reads into a reusable buffer.
+// Bytes after the last newline stay at the front of the buffer (carry) and
+// are completed by the next read, so lines split across reads are kept.
+let sampleFd: number | null = null;
+let readPosition = 0;
+let readBuffer = Buffer.allocUnsafe(READ_CHUNK_SIZE);
+let carry = 0;
+let drainScheduled = false;
+
+/**
+ * Queue one point for the next batch
+ */
+function pushPoint(seq: number, cpu: number, rssBytes: number, collectedAt: number, readAt: number): void {
+  if ((pendingCount + 1) * FIELD_COUNT > pending.length) {
+    const bigger = new Float64Array(pending.length * 2);
+    bigger.set(pending);
+    pending = bigger;
+  }
+  
+  // Add to buffer (will be sent in next batch)
+  const row = pendingCount * FIELD_COUNT;
+  pending[row] = seq;
+  pending[row + 1] = cpu;
+  pending[row + 2] = rssBytes / 1024 / 1024; // Convert to MB
+  pending[row + 3] = collectedAt;
+  pending[row + 4] = readAt;
+  pendingCount++;
+}
+
+/**
+ * Parse one complete JSONL line and queue it for the next batch
+ */
+function handleLine(start: number, end: number): void {
+  if (end <= start) return;
+  
+  try {
+    const sample = JSON.parse(readBuffer.toString('utf8', start, end));
     
-    // Batched sender - sends accumulated data once per second
-    senderInterval = setInterval(() => {
-      if (dataBuffer.length > 0) {
-        parentPort?.postMessage({ 
-          type: 'data-batch', 
-          data: [...dataBuffer] // Send copy
-        });
-        dataBuffer = []; // Clear buffer
-      }
-    }, 1000); // Send every 1 second (max 1 IPC message/sec)
-
-    // Wait for file to exist
-    const waitForFile = (retries = 10) => {
-      if (fs.existsSync(msg.path!)) {
-        console.log(`[MonitoringWorker] File found, starting watcher`);
-        
-        // Watch file for changes
-        fileWatcher = fs.watch(msg.path!, (eventType) => {
-          if (eventType === 'change') {
-            fs.stat(msg.path!, (err, stats) => {
-              if (err || stats.size <= lastSize) return;
-              
-              console.log(`[MonitoringWorker] Reading new data from ${lastSize} to ${stats.size}`);
-              
-              // Read new lines
-              const stream = createReadStream(msg.path!, {
-                start: lastSize,
-                end: stats.size
-              });
-              
-              lastSize = stats.size;
-              
-              const rl = createInterface({
-                input: stream,
-                crlfDelay: Infinity
-              });
-              
-              rl.on('line', (line) => {
-                try {
-                  const sample = JSON.parse(line);
-                  
-                  if (sample.event === 'sample') {
-                    // Add to buffer (will be sent in next batch)
-                    dataBuffer.push({
-                      cpu: sample.cpu_percent || 0,
-                      memory: (sample.memory_rss || 0) / 1024 / 1024, // Convert to MB
-                      timestamp: Date.now()
-                    });
-                  }
-                } catch (err) {
-                  // Ignore invalid JSON
-                }
-              });
-            });
-          }
-        });
-      } else if (retries > 0) {
+    if (sample.event === 'sample') {
+      const readAt = nowMs();
+      const collectedAt = sample.mono_ns ? monoToEpochMs(sample.mono_ns) : readAt;
+      pushPoint(sample.seq ?? -1, sample.cpu_percent || 0, sample.rss_bytes || 0, collectedAt, readAt);
+    }
+  } catch (err) {
+    // Ignore invalid JSON (only possible for corrupt lines now)
+  }
+}
+
+/**
+ * Read everything appended since the last drain
+ */
+function drainSamples(): void {
+  drainScheduled = false;
+  if (sampleFd === null) return;
+  
+  for (;;) {
+    if (carry === readBuffer.length) {
+      // A single line is larger than the buffer: grow it
+      const bigger = Buffer.allocUnsafe(readBuffer.length * 2);
+      readBuffer.copy(bigger, 0, 0, carry);
+      readBuffer = bigger;
+    }
+    
+    let bytesRead: number;
+    try {
+      bytesRead = fs.readSync(sampleFd, readBuffer, carry, readBuffer.length - carry, readPosition);
+    } catch (err) {
+      console.error('[MonitoringWorker] Read failed:', err);
+      return;
+    }
+    if (bytesRead === 0) return;
+    
+    readPosition += bytesRead;
+    const filled = carry + bytesRead;
+    
+    let lineStart = 0;
+    let newline = readBuffer.indexOf(NEWLINE, carry);
+    while (newline !== -1 && newline < filled) {
+      handleLine(lineStart, newline);
+      lineStart = newline + 1;
+      newline = readBuffer.indexOf(NEWLINE, lineStart);
+    }
+    
+    // Keep the incomplete tail for the next read
+    carry = filled - lineStart;
+    if (carry > 0 && lineStart > 0) {
+      readBuffer.copy(readBuffer, 0, lineStart, filled);
+    }
+  }
+}
+
+/**
+ * Coalesce bursts of watch events into one drain per event-loop turn
+ */
+function scheduleDrain(): void {
+  if (!drainScheduled) {
+    drainScheduled = true;
+    setImmediate(drainSamples);
+  }
+}
+
+/**
+ * Detect truncation or replacement of the sample file (new run, same path)
+ */
+function checkTruncation(): void {
+  if (sampleFd === null) return;
+  
+  try {
+    if (fs.fstatSync(sampleFd).size < readPosition) {
+      readPosition = 0;
+      carry = 0;
+    }
+  } catch (err) {
+    // fd stays valid until closed; ignore transient errors
+  }
+}
+
+function closeSampleFile(): void {
+  if (senderInterval) {
+    clearInterval(senderInterval);
+    senderInterval = null;
+  }
+  
+  if (fileWatcher) {
+    fileWatcher.close();
+    fileWatcher = null;
+  }
+  
+  if (sampleFd !== null) {
+    fs.closeSync(sampleFd);
+    sampleFd = null;
+  }
+  
+  readPosition = 0;
+  carry = 0;
+  drainScheduled = false;
+}
+
+function sendBatch(): void {
+  if (pendingCount === 0) return;
+  if (!rendererPort) {
+    pendingCount = 0; // No renderer attached; nothing to deliver to
+    return;
+  }
+  
+  // Transpose the pending rows into one column-major buffer
+  const columns = new Float64Array(pendingCount * FIELD_COUNT);
+  for (let i = 0; i < pendingCount; i++) {
+    for (let f = 0; f < FIELD_COUNT; f++) {
+      columns[f * pendingCount + i] = pending[i * FIELD_COUNT + f];
+    }
+  }
+  
+  rendererPort.postMessage({
+    type: 'data-batch',
+    fields: BATCH_FIELDS,
+    count: pendingCount,
+    columns,
+    sentAt: nowMs()
+  });
+  pendingCount = 0; // Clear buffer
+}
+
+/**
+ * Tail the JSONL file written by the sampler binary
+ */
+function startTailing(filePath: string): void {
+  // A 'start' or 'tail' without a 'stop' in between must not stack senders
+  closeSampleFile();
+  
+  // Batched sender - sends accumulated data once per second. Draining here
+  // as well covers any change events the watcher coalesced or missed.
+  senderInterval = setInterval(() => {
+    checkTruncation();
+    drainSamples();
+    sendBatch();
+  }, 1000); // Send every 1 second (max 1 IPC message/sec)
+
+  // Wait for file to exist
+  const waitForFile = (retries = 10) => {
+    try {
+      sampleFd = fs.openSync(filePath, 'r');
+    } catch (err) {
+      if (retries > 0) {
         setTimeout(() => waitForFile(retries - 1), 200);
       } else {
-        console.error(`[MonitoringWorker] File never appeared: ${msg.path}`);
+        console.error(`[MonitoringWorker] File never appeared: ${filePath}`);
       }
-    };
+      return;
+    }
     
-    setTimeout(() => waitForFile(), 500);
-  } 
-  else if (msg.type === 'stop') {
-    console.log('[MonitoringWorker] Stopping monitoring');
+    console.log(`[MonitoringWorker] File found, starting watcher`);
     
-    // Clean up
-    if (senderInterval) {
-      clearInterval(senderInterval);
-      senderInterval = null;
+    // The sampler appends in place, so the fd stays valid for the whole run
+    fileWatcher = fs.watch(filePath, (eventType) => {
+      if (eventType === 'change') {
+        scheduleDrain();
+      }
+    });
+    scheduleDrain();
+  };
+  
+  setTimeout(() => waitForFile(), 500);
+}
+
+/**
+ * Sample in-process through the N-API addon. Returns false if the addon
+ * cannot be loaded, in which case the main process falls back to the
+ * sampler binary.
+ */
+function startNative(msg: WorkerMessage): boolean {
+  let addon: SamplerAddon;
+  try {
+    addon = require(msg.addonPath!) as SamplerAddon;
+  } catch (err) {
+    console.error('[MonitoringWorker] Sampler addon unavailable:', err);
+    return false;
+  }
+  
+  nativeSampler = addon.start({
+    pid: msg.pid!,
+    intervalMs: msg.intervalMs ?? 1000,
+    batchMs: 1000, // Same cadence as the file path (max 1 message/sec)
+    runId: msg.runId,
+    out: msg.path,
+    cgroup: msg.cgroup,
+    jail: msg.jail,
+    delays: msg.delays ? 1 : 0,
+    mapGrowth: msg.mapGrowth ?? 0
+  }, (batch) => {
+    const readAt = nowMs();
+    const column = (name: string) => {
+      const index = batch.fields.indexOf(name);
+      return batch.columns.subarray(index * batch.count, (index + 1) * batch.count);
+    };
+    const seq = column('seq');
+    const monoMs = column('mono_ms');
+    const cpu = column('cpu_percent');
+    const rss = column('rss_bytes');
+    
+    for (let i = 0; i < batch.count; i++) {
+      pushPoint(seq[i], cpu[i], rss[i], monoToEpochMs(monoMs[i] * 1e6), readAt);
     }
+    sendBatch();
     
-    if (fileWatcher) {
-      fileWatcher.close();
-      fileWatcher = null;
+    if (batch.ended) {
+      nativeSampler = null;
+      if (stopRequested) {
+        finishStop();
+      }
     }
+  });
+  return true;
+}
+
+/**
+ * Close the renderer channel and confirm shutdown to the main process
+ */
+function finishStop(): void {
+  rendererPort?.close();
+  rendererPort = null;
+  
+  // Signal we're done
+  process.parentPort.postMessage({ type: 'stopped' });
+}
+
+process.parentPort.on('message', (event) => {
+  const msg = event.data as WorkerMessage;
+  
+  if (msg.type === 'start' && msg.pid) {
+    console.log(`[MonitoringWorker] Starting monitoring for PID ${msg.pid}, file: ${msg.path}`);
+    closeSampleFile();
+    stopRequested = false;
+    
+    // The main process hands us one end of a channel whose other end lives
+    // in the renderer
+    rendererPort = event.ports[0] ?? null;
+    rendererPort?.start();
     
-    // Send any remaining data
-    if (dataBuffer.length > 0) {
-      parentPort?.postMessage({ 
-        type: 'data-batch', 
-        data: dataBuffer 
-      });
-      dataBuffer = [];
+    if (msg.addonPath) {
+      if (!startNative(msg)) {
+        process.parentPort.postMessage({ type: 'addon-failed' });
+      }
+    } else if (msg.path) {
+      startTailing(msg.path);
     }
+  }
+  else if (msg.type === 'tail' && msg.path) {
+    startTailing(msg.path);
+  }
+  else if (msg.type === 'stop') {
+    console.log('[MonitoringWorker] Stopping monitoring');
+    
+    // Pick up the final samples, then send any remaining data (closing the
+    // file also stops the sender interval)
+    drainSamples();
+    closeSampleFile();
+    sendBatch();
     
-    // Signal we're done
-    parentPort?.postMessage({ type: 'stopped' });
+    // stop() joins the sampling thread; its final batch arrives through the
+    // threadsafe function and finishes the shutdown from there
+    stopRequested = true;
+    if (nativeSampler) {
+      nativeSampler.stop();
+    } else {
+      finishStop();
+    }
   }
 });
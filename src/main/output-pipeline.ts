@@ -0,0 +1,333 @@
+/**
+ * Bounded terminal output pipeline for sandboxed processes.
+ *
+ * Output chunks are queued as Buffers (no string concatenation) and sent to
+ * the renderer in batches. Bytes the renderer has not acknowledged yet count
+ * against a window; past the high-water mark the child's pipes are paused
+ * so a chatty process is throttled by the terminal instead of growing our
+ * memory. If the live queue still exceeds its byte budget, the oldest
+ * chunks are spooled to a file with an in-memory index for scrollback and
+ * replaced by a skip marker. The spool is capped; skipped output past the
+ * cap is dropped and counted, like the launcher's capture log does. At exit only a bounded head and tail of the
+ * unsent output are sent.
+ */
+
+import * as fs from 'fs';
+import { StringDecoder } from 'string_decoder';
+
+export interface OutputBatch {
+  type: 'stdout' | 'stderr';
+  data: string;
+  bytes: number; // Raw bytes covered by this batch, for acks
+}
+
+export interface OutputPipelineOptions {
+  send: (batch: OutputBatch) => void;
+  setPaused: (paused: boolean) => void;
+  spoolPath: string;
+  queueBudgetBytes?: number;
+  batchBytes?: number;
+  highWaterBytes?: number;
+  lowWaterBytes?: number;
+  tailBytes?: number;
+  spoolLimitBytes?: number;
+}
+
+export interface OutputSummary {
+  totalBytes: number;
+  spooledBytes: number;
+  droppedBytes: number;          // Skipped and past the spool cap
+  spoolPath: string | null;
+  skipped: SkippedRange[];       // Output offsets the terminal never showed
+  tail: string;
+}
+
+export interface SkippedRange {
+  from: number;
+  to: number;
+}
+
+interface SpoolIndex {
+  streamOffset: number[]; // Offset of the chunk in the overall output
+  spoolOffset: number[];  // Offset of the chunk in the spool file
+  length: number[];
+}
+
+interface QueuedChunk {
+  data: Buffer;
+  offset: number; // Offset in the overall output; -1 for skip markers
+  skipFrom?: number; // Start of the range a skip marker stands for
+}
+
+export class OutputPipeline {
+  private readonly opts: Required<OutputPipelineOptions>;
+  private queue: QueuedChunk[] = [];
+  private head = 0;
+  private queuedBytes = 0;
+  private totalBytes = 0;
+  private unackedBytes = 0;
+  private paused = false;
+  private decoder = new StringDecoder('utf8');
+  private spoolFd: number | null = null;
+  private spoolBytes = 0;
+  private droppedBytes = 0;
+  private skipped: SkippedRange[] = [];
+  private index: SpoolIndex = { streamOffset: [], spoolOffset: [], length: [] };
+
+  constructor(options: OutputPipelineOptions) {
+    this.opts = {
+      queueBudgetBytes: 4 * 1024 * 1024,
+      batchBytes: 64 * 1024,
+      highWaterBytes: 256 * 1024,
+      lowWaterBytes: 64 * 1024,
+      tailBytes: 64 * 1024,
+      spoolLimitBytes: 64 * 1024 * 1024,
+      ...options,
+    };
+  }
+
+  /**
+   * Queue a chunk read from the child's stdout or stderr
+   */
+  push(chunk: Buffer): void {
+    this.queue.push({ data: chunk, offset: this.totalBytes });
+    this.queuedBytes += chunk.length;
+    this.totalBytes += chunk.length;
+
+    // Over budget even with backpressure (e.g. renderer gone): spool the
+    // oldest chunks so the live queue stays bounded
+    if (this.queuedBytes > this.opts.queueBudgetBytes) {
+      this.spoolHead(this.opts.queueBudgetBytes / 2, true);
+    }
+  }
+
+  /**
+   * Send up to one batch to the renderer; called on the batching timer
+   */
+  flush(): void {
+    if (this.queuedBytes === 0 || this.unackedBytes >= this.opts.highWaterBytes) {
+      this.updatePressure();
+      return;
+    }
+
+    const parts: Buffer[] = [];
+    let bytes = 0;
+    while (this.queuedBytes > 0 && bytes < this.opts.batchBytes) {
+      const take = this.opts.batchBytes - bytes;
+      const entry = this.queue[this.head];
+      parts.push(entry.data.length <= take ? this.dequeue().data : this.splitHead(take).data);
+      bytes += parts[parts.length - 1].length;
+    }
+
+    this.unackedBytes += bytes;
+    this.opts.send({
+      type: 'stdout',
+      data: this.decoder.write(parts.length === 1 ? parts[0] : Buffer.concat(parts, bytes)),
+      bytes,
+    });
+    this.updatePressure();
+  }
+
+  /**
+   * Renderer finished writing `bytes` into the terminal
+   */
+  ack(bytes: number): void {
+    this.unackedBytes = Math.max(0, this.unackedBytes - bytes);
+    this.updatePressure();
+  }
+
+  /**
+   * Process exited: keep the head and tail of what was never sent, spool
+   * the middle, and return the bounded remainder for the exit event
+   */
+  finish(): OutputSummary {
+    // A short burst is mostly unsent at exit; its first lines still matter
+    const first: Buffer[] = [];
+    let headBytes = 0;
+    while (this.queuedBytes > this.opts.tailBytes && headBytes < this.opts.tailBytes) {
+      const take = Math.min(this.opts.tailBytes - headBytes, this.queuedBytes - this.opts.tailBytes);
+      const entry = this.queue[this.head];
+      first.push(entry.data.length <= take ? this.dequeue().data : this.splitHead(take).data);
+      headBytes += first[first.length - 1].length;
+    }
+    const shown = this.decoder.write(Buffer.concat(first));
+
+    this.spoolHead(this.opts.tailBytes, false);
+
+    const rest: Buffer[] = [];
+    while (this.queuedBytes > 0) {
+      rest.push(this.dequeue().data);
+    }
+    const tail = shown + this.decoder.write(Buffer.concat(rest)) + this.decoder.end();
+
+    if (this.paused) {
+      this.paused = false;
+      this.opts.setPaused(false);
+    }
+
+    return {
+      totalBytes: this.totalBytes,
+      spooledBytes: this.spoolBytes,
+      droppedBytes: this.droppedBytes,
+      spoolPath: this.spoolFd !== null ? this.opts.spoolPath : null,
+      skipped: this.skipped,
+      tail,
+    };
+  }
+
+  /**
+   * Read spooled output overlapping [offset, offset + length) of the
+   * overall stream, for scrollback. Stops at the first gap, so the result
+   * is always one contiguous range starting at the returned offset.
+   */
+  readScrollback(offset: number, length: number): { offset: number; data: string; bytes: number } | null {
+    if (this.spoolFd === null || this.index.length.length === 0) return null;
+
+    // Binary search for the first chunk ending after `offset`
+    const { streamOffset, spoolOffset, length: lengths } = this.index;
+    let lo = 0;
+    let hi = streamOffset.length - 1;
+    while (lo < hi) {
+      const mid = (lo + hi) >> 1;
+      if (streamOffset[mid] + lengths[mid] <= offset) lo = mid + 1;
+      else hi = mid;
+    }
+
+    const parts: Buffer[] = [];
+    let start = -1;
+    let remaining = length;
+    for (let i = lo; i < streamOffset.length && remaining > 0; i++) {
+      const skip = Math.max(0, offset - streamOffset[i]);
+      const take = Math.min(lengths[i] - skip, remaining);
+      if (take <= 0) continue;
+      if (start < 0) start = streamOffset[i] + skip;
+      else if (streamOffset[i] !== start + length - remaining) break;
+
+      const buf = Buffer.allocUnsafe(take);
+      fs.readSync(this.spoolFd, buf, 0, take, spoolOffset[i] + skip);
+      parts.push(buf);
+      remaining -= take;
+    }
+
+    if (start < 0) return null;
+    const data = Buffer.concat(parts);
+    return { offset: start, data: data.toString('utf8'), bytes: data.length };
+  }
+
+  /**
+   * Release the spool fd; the spool file stays on disk until disposed
+   */
+  close(): void {
+    if (this.spoolFd !== null) {
+      fs.closeSync(this.spoolFd);
+      this.spoolFd = null;
+    }
+  }
+
+  /**
+   * Release and delete the spool file
+   */
+  dispose(): void {
+    this.close();
+    if (this.spoolBytes > 0) {
+      fs.rmSync(this.opts.spoolPath, { force: true });
+    }
+  }
+
+  private dequeue(): QueuedChunk {
+    const entry = this.queue[this.head++];
+    this.queuedBytes -= entry.data.length;
+
+    // Compact occasionally instead of shift()ing on every dequeue
+    if (this.head > 1024 && this.head * 2 > this.queue.length) {
+      this.queue = this.queue.slice(this.head);
+      this.head = 0;
+    }
+    return entry;
+  }
+
+  /**
+   * Take the first `bytes` of the head chunk without copying
+   */
+  private splitHead(bytes: number): QueuedChunk {
+    const entry = this.queue[this.head];
+    this.queue[this.head] = {
+      data: entry.data.subarray(bytes),
+      offset: entry.offset < 0 ? -1 : entry.offset + bytes,
+    };
+    this.queuedBytes -= bytes;
+    return { data: entry.data.subarray(0, bytes), offset: entry.offset };
+  }
+
+  /**
+   * Spool the oldest queued output until at most `keepBytes` remain, and
+   * put a skip marker in its place
+   */
+  private spoolHead(keepBytes: number, atomicChunks: boolean): void {
+    let from = -1;
+    let to = -1;
+    const droppedBefore = this.droppedBytes;
+    while (this.queuedBytes > keepBytes) {
+      const excess = this.queuedBytes - keepBytes;
+      const entry = this.queue[this.head].data.length <= excess || atomicChunks
+        ? this.dequeue()
+        : this.splitHead(excess);
+      if (entry.offset < 0) {
+        // A marker that was never shown: fold its range into the new one
+        if (from < 0 && entry.skipFrom !== undefined) {
+          from = entry.skipFrom;
+          this.skipped.pop();
+        }
+        continue;
+      }
+
+      this.spool(entry);
+      if (from < 0) from = entry.offset;
+      to = entry.offset + entry.data.length;
+    }
+
+    if (from >= 0) {
+      // Skipped bytes may end mid-character; restart decoding cleanly
+      this.decoder = new StringDecoder('utf8');
+      const dropped = this.droppedBytes - droppedBefore;
+      const kept = dropped > 0
+        ? `${dropped} bytes dropped past the spool cap`
+        : 'kept in scrollback spool';
+      const marker = Buffer.from(
+        `\r\n\x1b[33m[... ${to - from} bytes skipped (output offsets ${from}-${to}), ${kept} ...]\x1b[0m\r\n`
+      );
+      this.skipped.push({ from, to });
+      this.queue.splice(this.head, 0, { data: marker, offset: -1, skipFrom: from });
+      this.queuedBytes += marker.length;
+    }
+  }
+
+  /**
+   * Append a chunk to the spool, dropping whatever does not fit under the cap
+   */
+  private spool(entry: QueuedChunk): void {
+    const length = Math.min(entry.data.length, this.opts.spoolLimitBytes - this.spoolBytes);
+    this.droppedBytes += entry.data.length - length;
+    if (length <= 0) return;
+
+    if (this.spoolFd === null) {
+      this.spoolFd = fs.openSync(this.opts.spoolPath, 'w+');
+    }
+
+    fs.writeSync(this.spoolFd, entry.data, 0, length, this.spoolBytes);
+    this.index.streamOffset.push(entry.offset);
+    this.index.spoolOffset.push(this.spoolBytes);
+    this.index.length.push(length);
+    this.spoolBytes += length;
+  }
+
+  private updatePressure(): void {
+    if (!this.paused && this.unackedBytes >= this.opts.highWaterBytes) {
+      this.paused = true;
+      this.opts.setPaused(true);
+    } else if (this.paused && this.unackedBytes <= this.opts.lowWaterBytes) {
+      this.paused = false;
+      this.opts.setPaused(false);
+    }
+  }
+}
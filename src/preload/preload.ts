@@ -1,4 +1,54 @@
-import { contextBridge, ipcRenderer } from 'electron';
+import { contextBridge, ipcRenderer, IpcRendererEvent } from 'electron';
+
+/**
+ * Batch of monitoring samples posted by the monitoring worker straight to the
+ * renderer. `columns` is column-major: field i occupies
+ * [i * count, (i + 1) * count). Time fields are high-resolution epoch
+ * milliseconds used for pipeline latency tracking.
+ */
+export interface MonitoringBatch {
+  type: 'data-batch';
+  fields: readonly string[];
+  count: number;
+  columns: Float64Array;
+  sentAt: number;
+}
+
+/**
+ * Range of cached samples from the Prometheus exporter's /api/series.
+ * Columns are parallel arrays; `t` is epoch milliseconds (bucket start
+ * when `step` > 0).
+ */
+export interface MetricSeries {
+  run: string;
+  step: number;
+  count: number;
+  t: number[];
+  cpu_percent: number[];
+  rss_bytes: number[];
+  vms_bytes: number[];
+  threads: number[];
+  fds_open: number[];
+  read_bytes: number[];
+  write_bytes: number[];
+}
+
+/**
+ * Alert state change pushed by the session's alert daemon
+ */
+export interface AlertEvent {
+  type: 'event';
+  seq: number;
+  state: 'firing' | 'resolved';
+  alert_id: string;
+  metric: string;
+  run_id: string;
+  triggered_at: string;
+  value: number;
+  threshold: number;
+  duration_sec: number;
+  acknowledged: boolean;
+}
 
 /**
  * Sandbox API exposed to the renderer process
@@ -28,17 +78,30 @@ export interface SandboxAPI {
   
   getPrometheusMetrics: () => Promise<string>;
   
+  getMetricSeries: (options: { run?: string; from?: number; to?: number; step?: number }) => Promise<MetricSeries | null>;
+  
   openFileDialog: () => Promise<string | null>;
   
   openDirectoryDialog: () => Promise<string | null>;
   
-  onOutput: (callback: (data: { type: 'stdout' | 'stderr'; data: string }) => void) => void;
+  onOutput: (callback: (data: { type: 'stdout' | 'stderr'; data: string; bytes: number }) => void) => void;
+  
+  ackOutput: (bytes: number) => void;
+  
+  getOutputScrollback: (offset: number, length: number) => Promise<{ offset: number; data: string; bytes: number } | null>;
+  
+  clearOutput: () => void;
   
   onExit: (callback: (data: { 
     code: number | null; 
     signal: string | null;
     finalStdout?: string;
     finalStderr?: string;
+    totalBytes?: number;
+    spooledBytes?: number;
+    droppedBytes?: number;
+    spoolPath?: string | null;
+    skipped?: { from: number; to: number }[];
   }) => void) => void;
   
   onError: (callback: (data: { message: string }) => void) => void;
@@ -47,7 +110,7 @@ export interface SandboxAPI {
   
   onMonitoringData: (callback: (data: { cpu: number; memory: number }) => void) => void;
   
-  onMonitoringDataBatch: (callback: (data: Array<{ cpu: number; memory: number; timestamp: number }>) => void) => void;
+  onAlertEvent: (callback: (event: AlertEvent) => void) => () => void;
 }
 
 // Expose protected methods that allow the renderer process to use
@@ -73,19 +136,34 @@ contextBridge.exposeInMainWorld('sandboxAPI', {
   
   getPrometheusMetrics: () => ipcRenderer.invoke('get-prometheus-metrics'),
   
+  getMetricSeries: (options: { run?: string; from?: number; to?: number; step?: number }) =>
+    ipcRenderer.invoke('get-metric-series', options),
+  
   openFileDialog: () => ipcRenderer.invoke('dialog:openFile'),
   
   openDirectoryDialog: () => ipcRenderer.invoke('dialog:openDirectory'),
   
-  onOutput: (callback: (data: { type: 'stdout' | 'stderr'; data: string }) => void) => {
+  onOutput: (callback: (data: { type: 'stdout' | 'stderr'; data: string; bytes: number }) => void) => {
     ipcRenderer.on('sandbox-output', (_event, data) => callback(data));
   },
   
+  ackOutput: (bytes: number) => ipcRenderer.send('sandbox-output-ack', bytes),
+  
+  getOutputScrollback: (offset: number, length: number) =>
+    ipcRenderer.invoke('get-output-scrollback', { offset, length }),
+  
+  clearOutput: () => ipcRenderer.send('clear-output'),
+  
   onExit: (callback: (data: { 
     code: number | null; 
     signal: string | null;
     finalStdout?: string;
     finalStderr?: string;
+    totalBytes?: number;
+    spooledBytes?: number;
+    droppedBytes?: number;
+    spoolPath?: string | null;
+    skipped?: { from: number; to: number }[];
   }) => void) => {
     ipcRenderer.on('sandbox-exit', (_event, data) => callback(data));
   },
@@ -102,7 +180,19 @@ contextBridge.exposeInMainWorld('sandboxAPI', {
     ipcRenderer.on('monitoring-data', (_event, data) => callback(data));
   },
   
-  onMonitoringDataBatch: (callback: (data: Array<{ cpu: number; memory: number; timestamp: number }>) => void) => {
-    ipcRenderer.on('monitoring-data-batch', (_event, data) => callback(data));
+  onAlertEvent: (callback: (event: AlertEvent) => void) => {
+    const listener = (_event: IpcRendererEvent, data: AlertEvent) => callback(data);
+    ipcRenderer.on('alert-event', listener);
+    return () => {
+      ipcRenderer.removeListener('alert-event', listener);
+    };
   },
 } as SandboxAPI);
+
+// Monitoring batches arrive on a MessagePort that the main process hands over
+// once per run. Ports cannot cross the context bridge, so forward it to the
+// page's main world, where lib/monitoring-port keeps it for the app's
+// lifetime and hands it to subscribers whenever they mount.
+ipcRenderer.on('monitoring-port', (event) => {
+  window.postMessage('monitoring-port', '*', event.ports);
+});
@@ -42,7 +42,10 @@ function App() {
   const [jailPath, setJailPath] = useState<string>('');
   const [isNetworkDisabled, setIsNetworkDisabled] = useState<boolean>(false);
 
-  const terminalRef = useRef<{ clear: () => void; write: (data: string) => void }>(null);
+  // Output ranges of the last run the terminal skipped, paged back in on demand
+  const [skipped, setSkipped] = useState<{ from: number; to: number }[]>([]);
+
+  const terminalRef = useRef<{ clear: () => void; write: (data: string, callback?: () => void) => void }>(null);
 
   useEffect(() => {
     // Load system information
@@ -51,19 +54,31 @@ function App() {
     // Set up listeners for sandbox output
     window.sandboxAPI.onOutput((data) => {
       const output = data.data;
+      // Ack once the terminal has consumed the batch so main keeps sending
+      const ack = () => window.sandboxAPI.ackOutput(data.bytes);
       if (terminalRef.current) {
         if (data.type === 'stderr') {
-          terminalRef.current.write(`\x1b[31m${output}\x1b[0m`); // Red for stderr
+          terminalRef.current.write(`\x1b[31m${output}\x1b[0m`, ack); // Red for stderr
         } else {
-          terminalRef.current.write(output);
+          terminalRef.current.write(output, ack);
         }
+      } else {
+        ack();
       }
     });
 
     window.sandboxAPI.onExit((data) => {
       setIsRunning(false);
       if (terminalRef.current) {
-        // Write any final buffered output that might have been missed
+        // Output older than the tail was streamed already or spooled
+        if (data.spooledBytes && data.spooledBytes > 0) {
+          terminalRef.current.write(`\x1b[33m[${data.spooledBytes} of ${data.totalBytes} bytes kept in ${data.spoolPath} until the terminal is cleared]\x1b[0m\n`);
+        }
+        if (data.droppedBytes && data.droppedBytes > 0) {
+          terminalRef.current.write(`\x1b[33m[${data.droppedBytes} skipped bytes dropped past the spool cap]\x1b[0m\n`);
+        }
+        setSkipped(data.skipped ?? []);
+        // Write the bounded tail that had not been sent yet
         if (data.finalStdout && data.finalStdout.length > 0) {
           terminalRef.current.write(data.finalStdout);
         }
@@ -100,6 +115,7 @@ function App() {
     }
 
     setIsRunning(true);
+    setSkipped([]);
     
     if (terminalRef.current) {
       terminalRef.current.write(`\x1b[36m$ ${command} ${args.join(' ')}\x1b[0m\n`);
@@ -139,6 +155,30 @@ function App() {
     if (terminalRef.current) {
       terminalRef.current.clear();
     }
+    // Nothing on screen points at the kept logs anymore
+    setSkipped([]);
+    window.sandboxAPI.clearOutput();
+  };
+
+  // Write the next 64 KB of skipped output from the kept log
+  const handleShowSkipped = async () => {
+    const range = skipped[0];
+    if (!range) {
+      return;
+    }
+    const page = await window.sandboxAPI.getOutputScrollback(range.from, Math.min(range.to - range.from, 64 * 1024));
+    const rest = skipped.slice(1);
+    if (!page || page.bytes === 0 || page.offset >= range.to) {
+      setSkipped(rest);
+      return;
+    }
+    const end = page.offset + page.bytes;
+    if (terminalRef.current) {
+      terminalRef.current.write(`\x1b[33m[Skipped output, offsets ${page.offset}-${end}]\x1b[0m\n`);
+      terminalRef.current.write(page.data);
+      terminalRef.current.write(`\n\x1b[33m[End of skipped page]\x1b[0m\n`);
+    }
+    setSkipped(end < range.to ? [{ from: end, to: range.to }, ...rest] : rest);
   };
 
   return (
@@ -241,6 +281,8 @@ function App() {
                   ref={terminalRef}
                   onClear={handleClear}
                   isRunning={isRunning}
+                  skippedBytes={skipped.reduce((sum, range) => sum + range.to - range.from, 0)}
+                  onShowSkipped={handleShowSkipped}
                 />
               </div>
             </div>
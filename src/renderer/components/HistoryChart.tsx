@@ -0,0 +1,296 @@
+import React, { useEffect, useMemo, useRef, useState } from 'react';
+import { AreaChart, Area, XAxis, YAxis, Brush, ResponsiveContainer } from 'recharts';
+import { HistoryStore, HistorySeries, HistoryView } from '../lib/history-store';
+
+interface HistoryChartProps {
+  store: HistoryStore;
+  series: HistorySeries;
+  version: number;            // Bumped by the owner whenever samples are appended
+  color: string;
+  height: number;
+  yDomain?: [number, number];
+  fontSize?: number;
+  formatValue: (value: number) => string;
+  onRendered?: () => void;
+}
+
+interface Selection {
+  from: number;
+  to: number;
+  live: boolean;              // Follow new samples at the right edge
+}
+
+const OVERVIEW_POINTS = 200;
+const AXIS_WIDTH = 44;
+const TIME_AXIS_HEIGHT = 18;
+
+function formatTime(ms: number): string {
+  return new Date(ms).toLocaleTimeString();
+}
+
+/**
+ * Canvas chart over the long-history store. The canvas only ever draws a
+ * pixel-width view (LTTB over the pyramid), and zoom/pan happens through a
+ * recharts Brush on a small fixed-size overview.
+ */
+const HistoryChart: React.FC<HistoryChartProps> = ({
+  store,
+  series,
+  version,
+  color,
+  height,
+  yDomain,
+  fontSize = 12,
+  formatValue,
+  onRendered,
+}) => {
+  const containerRef = useRef<HTMLDivElement>(null);
+  const canvasRef = useRef<HTMLCanvasElement>(null);
+  const viewRef = useRef<HistoryView | null>(null);
+  const [width, setWidth] = useState(0);
+  const [selection, setSelection] = useState<Selection>({ from: 0, to: 0, live: true });
+  const [hover, setHover] = useState<{ x: number; time: number; value: number } | null>(null);
+
+  // Track container width for the pixel budget
+  useEffect(() => {
+    const element = containerRef.current;
+    if (!element) return;
+    const observer = new ResizeObserver((entries) => {
+      setWidth(Math.floor(entries[0].contentRect.width));
+    });
+    observer.observe(element);
+    return () => observer.disconnect();
+  }, []);
+
+  // Range currently shown; a live selection keeps its span and slides
+  const range = useMemo(() => {
+    if (selection.live) {
+      const span = selection.to > selection.from ? selection.to - selection.from : store.size;
+      return { from: Math.max(store.start, store.end - span), to: store.end };
+    }
+    return { from: Math.max(store.start, selection.from), to: Math.min(store.end, selection.to) };
+  }, [selection, store, version]);
+
+  // Overview for the Brush: fixed point count regardless of history length
+  const overview = useMemo(() => {
+    const view = store.view(series, store.start, store.end, OVERVIEW_POINTS);
+    const data: { index: number; time: number; value: number }[] = [];
+    const step = view.time.length > 1 ? (view.to - view.from) / (view.time.length - 1) : 0;
+    for (let k = 0; k < view.time.length; k++) {
+      data.push({ index: Math.round(view.from + k * step), time: view.time[k], value: view.value[k] });
+    }
+    return data;
+  }, [store, series, version]);
+
+  const brushIndices = useMemo(() => {
+    if (overview.length === 0) return { startIndex: 0, endIndex: 0 };
+    const find = (target: number) => {
+      let lo = 0;
+      let hi = overview.length - 1;
+      while (lo < hi) {
+        const mid = (lo + hi) >> 1;
+        if (overview[mid].index < target) lo = mid + 1;
+        else hi = mid;
+      }
+      return lo;
+    };
+    return {
+      startIndex: find(range.from),
+      endIndex: selection.live ? overview.length - 1 : Math.max(find(range.from), find(range.to - 1)),
+    };
+  }, [overview, range, selection.live]);
+
+  // Draw the pixel-width view on the canvas
+  useEffect(() => {
+    const canvas = canvasRef.current;
+    if (!canvas || width === 0) return;
+
+    const dpr = window.devicePixelRatio || 1;
+    const chartHeight = height - TIME_AXIS_HEIGHT;
+    const plotWidth = Math.max(1, width - AXIS_WIDTH);
+    canvas.width = width * dpr;
+    canvas.height = height * dpr;
+    canvas.style.width = `${width}px`;
+    canvas.style.height = `${height}px`;
+
+    const ctx = canvas.getContext('2d');
+    if (!ctx) return;
+    ctx.setTransform(dpr, 0, 0, dpr, 0, 0);
+    ctx.clearRect(0, 0, width, height);
+
+    const view = store.view(series, range.from, range.to, plotWidth);
+    viewRef.current = view;
+    if (view.time.length === 0) {
+      onRendered?.();
+      return;
+    }
+
+    const t0 = view.time[0];
+    const t1 = view.time[view.time.length - 1];
+    let lo = yDomain ? yDomain[0] : Infinity;
+    let hi = yDomain ? yDomain[1] : -Infinity;
+    if (!yDomain) {
+      const values = view.max ?? view.value;
+      const mins = view.min ?? view.value;
+      for (let k = 0; k < values.length; k++) {
+        if (mins[k] < lo) lo = mins[k];
+        if (values[k] > hi) hi = values[k];
+      }
+      lo = Math.min(0, lo);
+      hi = hi > lo ? hi * 1.1 : lo + 1;
+    }
+
+    const xOf = (t: number) => AXIS_WIDTH + (t1 > t0 ? ((t - t0) / (t1 - t0)) * plotWidth : plotWidth);
+    const yOf = (v: number) => chartHeight - ((v - lo) / (hi - lo)) * (chartHeight - 4);
+
+    // Grid and axis labels
+    ctx.font = `${fontSize}px sans-serif`;
+    ctx.fillStyle = '#9ca3af';
+    ctx.strokeStyle = 'rgba(156, 163, 175, 0.3)';
+    ctx.setLineDash([3, 3]);
+    ctx.lineWidth = 1;
+    ctx.textAlign = 'right';
+    ctx.textBaseline = 'middle';
+    for (let g = 0; g <= 4; g++) {
+      const v = lo + ((hi - lo) * g) / 4;
+      const y = yOf(v);
+      ctx.beginPath();
+      ctx.moveTo(AXIS_WIDTH, y);
+      ctx.lineTo(width, y);
+      ctx.stroke();
+      ctx.fillText(formatValue(v), AXIS_WIDTH - 4, Math.max(fontSize / 2, y));
+    }
+    ctx.setLineDash([]);
+    ctx.textBaseline = 'bottom';
+    ctx.textAlign = 'left';
+    ctx.fillText(formatTime(t0), AXIS_WIDTH, height);
+    ctx.textAlign = 'right';
+    ctx.fillText(formatTime(t1), width, height);
+
+    // Min/max envelope, folded to one column per pixel
+    if (view.min && view.max && view.envelopeTime) {
+      const colMin = new Float64Array(plotWidth + 1).fill(Infinity);
+      const colMax = new Float64Array(plotWidth + 1).fill(-Infinity);
+      for (let k = 0; k < view.envelopeTime.length; k++) {
+        const col = Math.min(plotWidth, Math.max(0, Math.round(xOf(view.envelopeTime[k]) - AXIS_WIDTH)));
+        if (view.min[k] < colMin[col]) colMin[col] = view.min[k];
+        if (view.max[k] > colMax[col]) colMax[col] = view.max[k];
+      }
+      ctx.fillStyle = color;
+      ctx.globalAlpha = 0.15;
+      for (let col = 0; col <= plotWidth; col++) {
+        if (colMax[col] === -Infinity) continue;
+        const top = yOf(colMax[col]);
+        ctx.fillRect(AXIS_WIDTH + col, top, 1, Math.max(1, yOf(colMin[col]) - top));
+      }
+      ctx.globalAlpha = 1;
+    }
+
+    // Area under the downsampled line
+    const gradient = ctx.createLinearGradient(0, 0, 0, chartHeight);
+    gradient.addColorStop(0.05, color + 'cc');
+    gradient.addColorStop(0.95, color + '1a');
+    ctx.beginPath();
+    ctx.moveTo(xOf(view.time[0]), chartHeight);
+    for (let k = 0; k < view.time.length; k++) {
+      ctx.lineTo(xOf(view.time[k]), yOf(view.value[k]));
+    }
+    ctx.lineTo(xOf(view.time[view.time.length - 1]), chartHeight);
+    ctx.closePath();
+    ctx.fillStyle = gradient;
+    ctx.fill();
+
+    ctx.beginPath();
+    for (let k = 0; k < view.time.length; k++) {
+      const x = xOf(view.time[k]);
+      const y = yOf(view.value[k]);
+      if (k === 0) ctx.moveTo(x, y);
+      else ctx.lineTo(x, y);
+    }
+    ctx.strokeStyle = color;
+    ctx.lineWidth = 2;
+    ctx.stroke();
+
+    onRendered?.();
+  }, [store, series, range, width, height, color, yDomain, fontSize, formatValue, onRendered, version]);
+
+  const handleMouseMove = (event: React.MouseEvent<HTMLCanvasElement>) => {
+    const view = viewRef.current;
+    if (!view || view.time.length === 0) return;
+    const rect = event.currentTarget.getBoundingClientRect();
+    const x = event.clientX - rect.left;
+    const t0 = view.time[0];
+    const t1 = view.time[view.time.length - 1];
+    const plotWidth = Math.max(1, width - AXIS_WIDTH);
+    const target = t0 + ((x - AXIS_WIDTH) / plotWidth) * (t1 - t0);
+
+    let lo = 0;
+    let hi = view.time.length - 1;
+    while (lo < hi) {
+      const mid = (lo + hi) >> 1;
+      if (view.time[mid] < target) lo = mid + 1;
+      else hi = mid;
+    }
+    setHover({ x, time: view.time[lo], value: view.value[lo] });
+  };
+
+  const handleBrushChange = (next: { startIndex?: number; endIndex?: number }) => {
+    if (next.startIndex === undefined || next.endIndex === undefined || overview.length === 0) return;
+    const live = next.endIndex >= overview.length - 1;
+    setSelection({
+      from: overview[next.startIndex].index,
+      to: live ? store.end : overview[next.endIndex].index + 1,
+      live,
+    });
+  };
+
+  return (
+    <div ref={containerRef} className="relative w-full">
+      <canvas
+        ref={canvasRef}
+        onMouseMove={handleMouseMove}
+        onMouseLeave={() => setHover(null)}
+      />
+      {hover && (
+        <div
+          className="absolute top-0 pointer-events-none rounded-lg px-2 py-1 text-xs"
+          style={{
+            left: Math.min(hover.x + 8, Math.max(0, width - 140)),
+            backgroundColor: 'rgba(17, 24, 39, 0.95)',
+            border: '1px solid rgba(75, 85, 99, 0.5)',
+            color: '#e5e7eb',
+          }}
+        >
+          <div>{formatTime(hover.time)}</div>
+          <div style={{ color }}>{formatValue(hover.value)}</div>
+        </div>
+      )}
+      <ResponsiveContainer width="100%" height={fontSize * 2 + 28}>
+        <AreaChart data={overview} margin={{ top: 0, right: 0, bottom: 0, left: AXIS_WIDTH }}>
+          <XAxis dataKey="time" hide />
+          <YAxis hide domain={yDomain ?? ['auto', 'auto']} />
+          <Area
+            type="monotone"
+            dataKey="value"
+            stroke={color}
+            fill={color}
+            fillOpacity={0.1}
+            isAnimationActive={false}
+          />
+          <Brush
+            dataKey="time"
+            height={fontSize * 2 + 4}
+            stroke={color}
+            fill="rgba(59, 130, 246, 0.1)"
+            startIndex={brushIndices.startIndex}
+            endIndex={brushIndices.endIndex}
+            tickFormatter={(value: number) => formatTime(value)}
+            onChange={handleBrushChange}
+          />
+        </AreaChart>
+      </ResponsiveContainer>
+    </div>
+  );
+};
+
+export default React.memo(HistoryChart);
@@ -1,70 +1,123 @@
-import React, { useState, useEffect, useRef, useMemo } from 'react';
+import React, { useState, useEffect, useRef, useCallback } from 'react';
 import { RefreshCw, AlertTriangle, Activity, Trash2 } from 'lucide-react';
-import { AreaChart, Area, XAxis, YAxis, CartesianGrid, Tooltip, Legend, ResponsiveContainer, Brush } from 'recharts';
 import { Card, CardHeader, CardTitle, CardDescription, CardContent } from './ui/card';
 import { Button } from './ui/button';
-
-interface MonitoringData {
-  timestamp: number;
-  cpu: number;
-  memory: number;
-  time: string;
-}
+import HistoryChart from './HistoryChart';
+import { getMonitoringHistory, backfillMonitoringHistory } from '../lib/monitoring-history';
+import { LatencyTracker, LatencyHop, LatencyStats, LATENCY_HOPS, nowMs } from '../lib/latency';
+import { subscribeMonitoringBatches, onMonitoringRun, batchColumn } from '../lib/monitoring-port';
+import type { MonitoringBatch } from '../../preload/preload';
 
 interface MonitoringDashboardProps {
   isRunning: boolean;
 }
 
+interface PendingRender {
+  receivedAt: number;
+  collectedAt: Float64Array;
+}
+
+const HOP_LABELS: Record<LatencyHop, string> = {
+  collectToRead: 'sampler → worker',
+  readToSend: 'worker batching',
+  sendToReceive: 'worker → renderer',
+  receiveToRender: 'render',
+  endToEnd: 'end-to-end',
+};
+
+const CPU_DOMAIN: [number, number] = [0, 100];
+const formatCpu = (value: number) => `${value.toFixed(0)}%`;
+const formatMemory = (value: number) => `${value.toFixed(1)} MB`;
+
 const MonitoringDashboard: React.FC<MonitoringDashboardProps> = React.memo(({ isRunning }) => {
-  const [chartData, setChartData] = useState<MonitoringData[]>([]);
+  // Samples live in an app-lifetime typed-array ring, filled even while this
+  // tab is not showing; `version` just tells charts to redraw
+  const store = getMonitoringHistory();
+  const [version, setVersion] = useState(0);
   const [alerts, setAlerts] = useState<string>('');
   const [metricsText, setMetricsText] = useState<string>('');
   const [isLoadingAlerts, setIsLoadingAlerts] = useState(false);
   const [isLoadingMetrics, setIsLoadingMetrics] = useState(false);
+  const [latency, setLatency] = useState<Record<LatencyHop, LatencyStats> | null>(null);
+  const [latencyTracker] = useState(() => new LatencyTracker());
+  const pendingRenders = useRef<PendingRender[]>([]);
 
   useEffect(() => {
-    // Register IPC listener for BATCHED monitoring data - ONLY ONCE
-    console.log('[MonitoringDashboard] Registering monitoring-data-batch listener');
-    
-    if (!window.sandboxAPI || !window.sandboxAPI.onMonitoringDataBatch) {
-      console.error('[MonitoringDashboard] sandboxAPI.onMonitoringDataBatch not available!');
-      return;
-    }
+    // Subscribe to BATCHED monitoring data posted by the worker - ONLY ONCE
+    console.log('[MonitoringDashboard] Subscribing to monitoring batches');
     
-    // Listen for batches of data from the worker thread
-    window.sandboxAPI.onMonitoringDataBatch((batch: Array<{ cpu: number; memory: number; timestamp: number }>) => {
-      console.log(`[MonitoringDashboard] Received batch with ${batch.length} data points`);
+    const unsubscribe = subscribeMonitoringBatches((batch: MonitoringBatch) => {
+      const receivedAt = nowMs();
+      console.log(`[MonitoringDashboard] Received batch with ${batch.count} data points`);
       
-      setChartData((currentData) => {
-        // Add all batch items with formatted timestamps
-        const newPoints = batch.map(point => ({
-          timestamp: point.timestamp,
-          cpu: point.cpu,
-          memory: point.memory,
-          time: new Date(point.timestamp).toLocaleTimeString()
-        }));
-        
-        const newData = [...currentData, ...newPoints];
-        
-        // Keep only last 60 data points
-        while (newData.length > 60) {
-          newData.shift();
-        }
-        
-        return newData;
-      });
+      const seq = batchColumn(batch, 'seq');
+      const collectedAt = batchColumn(batch, 'collectedAt');
+      const readAt = batchColumn(batch, 'readAt');
+      
+      // Per-hop latency up to the renderer; render latency is recorded on commit
+      for (let i = 0; i < batch.count; i++) {
+        latencyTracker.observeSeq(seq[i]);
+        latencyTracker.record('collectToRead', readAt[i] - collectedAt[i]);
+        latencyTracker.record('readToSend', batch.sentAt - readAt[i]);
+      }
+      latencyTracker.record('sendToReceive', receivedAt - batch.sentAt);
+      pendingRenders.current.push({ receivedAt, collectedAt });
+      
+      // lib/monitoring-history already appended the batch to the store
+      setVersion((v) => v + 1);
     });
     
-    // No cleanup needed - IPC listener persists for app lifetime
-  }, []); // Empty array - register ONCE on mount
+    return unsubscribe;
+  }, [latencyTracker]); // Stable - registers ONCE on mount
 
-  // Clear chart data when process stops
-  useEffect(() => {
-    if (!isRunning) {
-      console.log('[MonitoringDashboard] Process stopped, clearing chart data');
-      setChartData([]);
+  // CPU chart drawn: close out render and end-to-end latency
+  const handleRendered = useCallback(() => {
+    if (pendingRenders.current.length === 0) return;
+    
+    const renderedAt = nowMs();
+    for (const pending of pendingRenders.current) {
+      latencyTracker.record('receiveToRender', renderedAt - pending.receivedAt);
+      for (const collectedAt of pending.collectedAt) {
+        latencyTracker.record('endToEnd', renderedAt - collectedAt);
+      }
     }
-  }, [isRunning]);
+    pendingRenders.current = [];
+    setLatency(latencyTracker.summary());
+  }, [latencyTracker]);
+
+  // The history store clears itself when a new run starts; redraw and
+  // start the latency figures over with it
+  useEffect(() => {
+    return onMonitoringRun(() => {
+      setVersion((v) => v + 1);
+      latencyTracker.reset();
+      pendingRenders.current = [];
+      setLatency(null);
+    });
+  }, [latencyTracker]);
+
+  // Nothing in memory (the renderer was reloaded): load what the exporter
+  // still holds of the latest run
+  useEffect(() => {
+    let mounted = true;
+    backfillMonitoringHistory().then((added) => {
+      if (added && mounted) setVersion((v) => v + 1);
+    });
+    return () => {
+      mounted = false;
+    };
+  }, []);
+
+  // Alert events are pushed by the alert daemon as they happen
+  useEffect(() => {
+    if (!window.sandboxAPI || !window.sandboxAPI.onAlertEvent) return;
+    
+    return window.sandboxAPI.onAlertEvent((event) => {
+      const { type: _type, ...fields } = event;
+      const line = JSON.stringify(fields);
+      setAlerts((current) => (current && current.startsWith('{') ? `${current}\n${line}` : line));
+    });
+  }, []);
 
   const handleGetAlerts = async () => {
     setIsLoadingAlerts(true);
@@ -98,10 +151,13 @@ const MonitoringDashboard: React.FC<MonitoringDashboardProps> = React.memo(({ is
     setAlerts('');
   };
 
-  const latestData = chartData.length > 0 ? chartData[chartData.length - 1] : null;
+  const hasData = store.size > 0;
+  const latestData = hasData
+    ? { cpu: store.valueAt('cpu', store.end - 1), memory: store.valueAt('memory', store.end - 1) }
+    : null;
 
   // Show "No Active Process" message when not running
-  if (!isRunning && chartData.length === 0) {
+  if (!isRunning && !hasData) {
     return (
       <div className="space-y-6">
         <Card className="border-2 border-dashed">
@@ -137,56 +193,30 @@ const MonitoringDashboard: React.FC<MonitoringDashboardProps> = React.memo(({ is
               <CardDescription>
                 {latestData ? `Current: ${latestData.cpu.toFixed(1)}%` : 'Waiting for data...'}
               </CardDescription>
+              {latency && latency.endToEnd.count > 0 && (
+                <div
+                  className="text-xs text-gray-500 dark:text-gray-400 font-mono"
+                  title={LATENCY_HOPS.map(hop =>
+                    `${HOP_LABELS[hop]}: p50 ${latency[hop].p50.toFixed(1)} ms, p99 ${latency[hop].p99.toFixed(1)} ms`
+                  ).join('\n')}
+                >
+                  Staleness p50 {latency.endToEnd.p50.toFixed(0)} ms · p99 {latency.endToEnd.p99.toFixed(0)} ms
+                  {latencyTracker.lostSamples > 0 && ` · ${latencyTracker.lostSamples} lost`}
+                </div>
+              )}
             </CardHeader>
             <CardContent>
-              {chartData.length > 0 ? (
-                <ResponsiveContainer width="100%" height={300}>
-                  <AreaChart data={chartData}>
-                    <defs>
-                      <linearGradient id="cpuGradient" x1="0" y1="0" x2="0" y2="1">
-                        <stop offset="5%" stopColor="#3b82f6" stopOpacity={0.8}/>
-                        <stop offset="95%" stopColor="#3b82f6" stopOpacity={0.1}/>
-                      </linearGradient>
-                    </defs>
-                    <CartesianGrid strokeDasharray="3 3" className="stroke-gray-300 dark:stroke-gray-700" />
-                    <XAxis 
-                      dataKey="time" 
-                      className="text-xs text-gray-600 dark:text-gray-400"
-                      tick={{ fontSize: 12 }}
-                    />
-                    <YAxis 
-                      className="text-xs text-gray-600 dark:text-gray-400"
-                      tick={{ fontSize: 12 }}
-                      domain={[0, 100]}
-                    />
-                    <Tooltip
-                      contentStyle={{
-                        backgroundColor: 'rgba(17, 24, 39, 0.95)',
-                        borderRadius: '8px',
-                        border: '1px solid rgba(75, 85, 99, 0.5)',
-                        boxShadow: '0 4px 6px rgba(0, 0, 0, 0.1)',
-                      }}
-                      labelStyle={{ color: '#e5e7eb' }}
-                      itemStyle={{ color: '#93c5fd' }}
-                    />
-                    <Legend />
-                    <Brush 
-                      dataKey="time" 
-                      height={30} 
-                      stroke="#3b82f6"
-                      fill="rgba(59, 130, 246, 0.1)"
-                    />
-                    <Area 
-                      type="monotone" 
-                      dataKey="cpu" 
-                      stroke="#3b82f6" 
-                      fill="url(#cpuGradient)"
-                      strokeWidth={2}
-                      isAnimationActive={true}
-                      animationDuration={300}
-                    />
-                  </AreaChart>
-                </ResponsiveContainer>
+              {hasData ? (
+                <HistoryChart
+                  store={store}
+                  series="cpu"
+                  version={version}
+                  color="#3b82f6"
+                  height={300}
+                  yDomain={CPU_DOMAIN}
+                  formatValue={formatCpu}
+                  onRendered={handleRendered}
+                />
               ) : (
                 <div className="h-[300px] flex items-center justify-center text-gray-400">
                   Run a process to begin monitoring
@@ -209,52 +239,16 @@ const MonitoringDashboard: React.FC<MonitoringDashboardProps> = React.memo(({ is
               </CardDescription>
             </CardHeader>
             <CardContent>
-              {chartData.length > 0 ? (
-                <ResponsiveContainer width="100%" height={300}>
-                  <AreaChart data={chartData}>
-                    <defs>
-                      <linearGradient id="memGradient" x1="0" y1="0" x2="0" y2="1">
-                        <stop offset="5%" stopColor="#10b981" stopOpacity={0.8}/>
-                        <stop offset="95%" stopColor="#10b981" stopOpacity={0.1}/>
-                      </linearGradient>
-                    </defs>
-                    <CartesianGrid strokeDasharray="3 3" className="stroke-gray-300 dark:stroke-gray-700" />
-                    <XAxis 
-                      dataKey="time" 
-                      className="text-xs text-gray-600 dark:text-gray-400"
-                      tick={{ fontSize: 10 }}
-                    />
-                    <YAxis 
-                      className="text-xs text-gray-600 dark:text-gray-400"
-                      tick={{ fontSize: 10 }}
-                    />
-                    <Tooltip
-                      contentStyle={{
-                        backgroundColor: 'rgba(17, 24, 39, 0.95)',
-                        borderRadius: '8px',
-                        border: '1px solid rgba(75, 85, 99, 0.5)',
-                        boxShadow: '0 4px 6px rgba(0, 0, 0, 0.1)',
-                      }}
-                      labelStyle={{ color: '#e5e7eb' }}
-                      itemStyle={{ color: '#6ee7b7' }}
-                    />
-                    <Brush 
-                      dataKey="time" 
-                      height={25} 
-                      stroke="#10b981"
-                      fill="rgba(16, 185, 129, 0.1)"
-                    />
-                    <Area 
-                      type="monotone" 
-                      dataKey="memory" 
-                      stroke="#10b981" 
-                      fill="url(#memGradient)"
-                      strokeWidth={2}
-                      isAnimationActive={true}
-                      animationDuration={300}
-                    />
-                  </AreaChart>
-                </ResponsiveContainer>
+              {hasData ? (
+                <HistoryChart
+                  store={store}
+                  series="memory"
+                  version={version}
+                  color="#10b981"
+                  height={300}
+                  fontSize={10}
+                  formatValue={formatMemory}
+                />
               ) : (
                 <div className="h-[300px] flex items-center justify-center text-gray-400 text-sm">
                   No data
@@ -304,7 +298,7 @@ const MonitoringDashboard: React.FC<MonitoringDashboardProps> = React.memo(({ is
               </div>
               <div className="max-h-64 overflow-auto rounded-lg bg-gray-50 dark:bg-gray-900/50 p-3 border border-gray-200 dark:border-gray-700">
                 <pre className="text-xs text-gray-800 dark:text-gray-200 whitespace-pre-wrap font-mono">
-                  {alerts || 'No alerts yet. Click "Fetch" to load alert logs.'}
+                  {alerts || 'No alerts yet. New alerts appear here as they fire; click "Fetch" for the full session log.'}
                 </pre>
               </div>
             </CardContent>
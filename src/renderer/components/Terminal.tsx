@@ -7,14 +7,16 @@ import { Card, CardHeader, CardContent } from './ui/card';
 interface TerminalProps {
   onClear: () => void;
   isRunning: boolean;
+  skippedBytes?: number;
+  onShowSkipped?: () => void;
 }
 
 export interface TerminalHandle {
-  write: (data: string) => void;
+  write: (data: string, callback?: () => void) => void;
   clear: () => void;
 }
 
-const Terminal = forwardRef<TerminalHandle, TerminalProps>(({ onClear, isRunning }, ref) => {
+const Terminal = forwardRef<TerminalHandle, TerminalProps>(({ onClear, isRunning, skippedBytes = 0, onShowSkipped }, ref) => {
   const terminalRef = useRef<HTMLDivElement>(null);
   const xtermRef = useRef<XTerm | null>(null);
 
@@ -69,9 +71,13 @@ const Terminal = forwardRef<TerminalHandle, TerminalProps>(({ onClear, isRunning
   }, []);
 
   useImperativeHandle(ref, () => ({
-    write: (data: string) => {
+    write: (data: string, callback?: () => void) => {
       if (xtermRef.current) {
-        xtermRef.current.write(data);
+        // The callback fires once xterm has parsed the data, which is what
+        // output acks are keyed on
+        xtermRef.current.write(data, callback);
+      } else if (callback) {
+        callback();
       }
     },
     clear: () => {
@@ -101,17 +107,29 @@ const Terminal = forwardRef<TerminalHandle, TerminalProps>(({ onClear, isRunning
             </span>
           )}
         </div>
-        <Button
-          variant="ghost"
-          size="sm"
-          onClick={onClear}
-          className="h-8"
-        >
-          <svg className="w-4 h-4 mr-1.5" fill="none" stroke="currentColor" viewBox="0 0 24 24">
-            <path strokeLinecap="round" strokeLinejoin="round" strokeWidth={2} d="M19 7l-.867 12.142A2 2 0 0116.138 21H7.862a2 2 0 01-1.995-1.858L5 7m5 4v6m4-6v6m1-10V4a1 1 0 00-1-1h-4a1 1 0 00-1 1v3M4 7h16" />
-          </svg>
-          Clear
-        </Button>
+        <div className="flex items-center gap-1">
+          {skippedBytes > 0 && onShowSkipped && (
+            <Button
+              variant="ghost"
+              size="sm"
+              onClick={onShowSkipped}
+              className="h-8"
+            >
+              Show skipped ({Math.ceil(skippedBytes / 1024)} KB)
+            </Button>
+          )}
+          <Button
+            variant="ghost"
+            size="sm"
+            onClick={onClear}
+            className="h-8"
+          >
+            <svg className="w-4 h-4 mr-1.5" fill="none" stroke="currentColor" viewBox="0 0 24 24">
+              <path strokeLinecap="round" strokeLinejoin="round" strokeWidth={2} d="M19 7l-.867 12.142A2 2 0 0116.138 21H7.862a2 2 0 01-1.995-1.858L5 7m5 4v6m4-6v6m1-10V4a1 1 0 00-1-1h-4a1 1 0 00-1 1v3M4 7h16" />
+            </svg>
+            Clear
+          </Button>
+        </div>
       </CardHeader>
       <CardContent className="flex-1 p-0">
         <div 
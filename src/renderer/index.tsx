@@ -1,6 +1,9 @@
 import React from 'react';
 import ReactDOM from 'react-dom/client';
 import App from './App';
+// Installs the monitoring port listener and the history store's
+// subscription before any run can start
+import './lib/monitoring-history';
 import './styles/index.css';
 
 ReactDOM.createRoot(document.getElementById('root')!).render(
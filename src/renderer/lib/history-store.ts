@@ -0,0 +1,244 @@
+/**
+ * Long-history store for monitoring samples.
+ *
+ * Samples live in fixed-capacity typed-array rings addressed by a global
+ * sample index, so appending never reallocates or shifts. Alongside the raw
+ * ring, a pyramid of coarser levels keeps min/max/sum per bucket, updated
+ * incrementally on append. A view over any range first picks the coarsest
+ * level that still has enough buckets for the requested pixel width and then
+ * runs LTTB over it, so drawing cost depends on pixels, not on history length.
+ */
+
+export type HistorySeries = 'cpu' | 'memory';
+
+// 2^18 samples: a little over 7 hours at 10 Hz
+export const HISTORY_CAPACITY = 1 << 18;
+
+// Each pyramid level aggregates PYRAMID_FANOUT buckets of the level below
+const PYRAMID_FANOUT = 16;
+const PYRAMID_LEVELS = 3; // 16, 256, 4096 samples per bucket
+
+export interface HistoryView {
+  from: number;          // First global sample index covered
+  to: number;            // One past the last global sample index covered
+  bucketSize: number;    // Samples per point before LTTB (1 = raw)
+  time: Float64Array;    // Epoch ms per point
+  value: Float64Array;
+  min: Float64Array | null;  // Bucket envelope, only for aggregated levels
+  max: Float64Array | null;
+  envelopeTime: Float64Array | null;
+}
+
+interface PyramidLevel {
+  bucketSize: number;
+  capacity: number;
+  time: Float64Array;    // Time of the first sample in the bucket
+  count: Uint32Array;
+  min: Record<HistorySeries, Float64Array>;
+  max: Record<HistorySeries, Float64Array>;
+  sum: Record<HistorySeries, Float64Array>;
+}
+
+function perSeries(length: number): Record<HistorySeries, Float64Array> {
+  return { cpu: new Float64Array(length), memory: new Float64Array(length) };
+}
+
+/**
+ * Largest-Triangle-Three-Buckets downsampling. Returns the indices of the
+ * points to keep; the first and last points are always kept.
+ */
+export function lttb(x: ArrayLike<number>, y: ArrayLike<number>, length: number, threshold: number): Uint32Array {
+  if (threshold >= length || threshold < 3) {
+    const all = new Uint32Array(length);
+    for (let i = 0; i < length; i++) all[i] = i;
+    return all;
+  }
+
+  const picked = new Uint32Array(threshold);
+  const every = (length - 2) / (threshold - 2);
+  let a = 0;
+  picked[0] = 0;
+
+  for (let i = 0; i < threshold - 2; i++) {
+    // Average of the next bucket is the third triangle vertex
+    const nextStart = Math.floor((i + 1) * every) + 1;
+    const nextEnd = Math.min(Math.floor((i + 2) * every) + 1, length);
+    let avgX = 0;
+    let avgY = 0;
+    for (let j = nextStart; j < nextEnd; j++) {
+      avgX += x[j];
+      avgY += y[j];
+    }
+    const nextLen = nextEnd - nextStart;
+    avgX /= nextLen;
+    avgY /= nextLen;
+
+    // Pick the point in this bucket with the largest triangle area
+    const start = Math.floor(i * every) + 1;
+    const end = Math.floor((i + 1) * every) + 1;
+    const ax = x[a];
+    const ay = y[a];
+    let maxArea = -1;
+    let next = start;
+    for (let j = start; j < end; j++) {
+      const area = Math.abs((ax - avgX) * (y[j] - ay) - (ax - x[j]) * (avgY - ay));
+      if (area > maxArea) {
+        maxArea = area;
+        next = j;
+      }
+    }
+
+    picked[i + 1] = next;
+    a = next;
+  }
+
+  picked[threshold - 1] = length - 1;
+  return picked;
+}
+
+export class HistoryStore {
+  private readonly time = new Float64Array(HISTORY_CAPACITY);
+  private readonly values = perSeries(HISTORY_CAPACITY);
+  private readonly levels: PyramidLevel[] = [];
+  private total = 0;
+
+  constructor() {
+    let bucketSize = 1;
+    for (let l = 0; l < PYRAMID_LEVELS; l++) {
+      bucketSize *= PYRAMID_FANOUT;
+      const capacity = HISTORY_CAPACITY / bucketSize;
+      this.levels.push({
+        bucketSize,
+        capacity,
+        time: new Float64Array(capacity),
+        count: new Uint32Array(capacity),
+        min: perSeries(capacity),
+        max: perSeries(capacity),
+        sum: perSeries(capacity),
+      });
+    }
+  }
+
+  /** Global index of the oldest sample still held */
+  get start(): number {
+    return Math.max(0, this.total - HISTORY_CAPACITY);
+  }
+
+  /** Global index one past the newest sample */
+  get end(): number {
+    return this.total;
+  }
+
+  get size(): number {
+    return this.total - this.start;
+  }
+
+  append(time: number, cpu: number, memory: number): void {
+    const i = this.total++;
+    const slot = i & (HISTORY_CAPACITY - 1);
+    this.time[slot] = time;
+    this.values.cpu[slot] = cpu;
+    this.values.memory[slot] = memory;
+
+    for (const level of this.levels) {
+      const b = Math.floor(i / level.bucketSize) % level.capacity;
+      if (i % level.bucketSize === 0) {
+        level.time[b] = time;
+        level.count[b] = 0;
+        level.min.cpu[b] = level.max.cpu[b] = cpu;
+        level.min.memory[b] = level.max.memory[b] = memory;
+        level.sum.cpu[b] = level.sum.memory[b] = 0;
+      }
+      level.count[b]++;
+      level.sum.cpu[b] += cpu;
+      level.sum.memory[b] += memory;
+      if (cpu < level.min.cpu[b]) level.min.cpu[b] = cpu;
+      if (cpu > level.max.cpu[b]) level.max.cpu[b] = cpu;
+      if (memory < level.min.memory[b]) level.min.memory[b] = memory;
+      if (memory > level.max.memory[b]) level.max.memory[b] = memory;
+    }
+  }
+
+  timeAt(index: number): number {
+    return this.time[index & (HISTORY_CAPACITY - 1)];
+  }
+
+  valueAt(series: HistorySeries, index: number): number {
+    return this.values[series][index & (HISTORY_CAPACITY - 1)];
+  }
+
+  /**
+   * Downsampled view of [from, to) with at most `points` points
+   */
+  view(series: HistorySeries, from: number, to: number, points: number): HistoryView {
+    from = Math.max(from, this.start);
+    to = Math.min(to, this.end);
+    const span = Math.max(0, to - from);
+
+    // Coarsest level that still has at least one bucket per output point
+    let level: PyramidLevel | null = null;
+    for (const candidate of this.levels) {
+      if (span / candidate.bucketSize >= points) level = candidate;
+    }
+
+    let time: Float64Array;
+    let value: Float64Array;
+    let min: Float64Array | null = null;
+    let max: Float64Array | null = null;
+
+    if (level === null) {
+      time = new Float64Array(span);
+      value = new Float64Array(span);
+      const src = this.values[series];
+      for (let k = 0; k < span; k++) {
+        const slot = (from + k) & (HISTORY_CAPACITY - 1);
+        time[k] = this.time[slot];
+        value[k] = src[slot];
+      }
+    } else {
+      // Only whole buckets that have not been overwritten by the ring
+      const first = Math.ceil(Math.max(from, this.start) / level.bucketSize);
+      const last = Math.ceil(to / level.bucketSize);
+      const n = Math.max(0, last - first);
+      time = new Float64Array(n);
+      value = new Float64Array(n);
+      min = new Float64Array(n);
+      max = new Float64Array(n);
+      for (let k = 0; k < n; k++) {
+        const b = (first + k) % level.capacity;
+        time[k] = level.time[b];
+        value[k] = level.sum[series][b] / level.count[b];
+        min[k] = level.min[series][b];
+        max[k] = level.max[series][b];
+      }
+    }
+
+    const envelopeTime = min ? time : null;
+    const keep = lttb(time, value, time.length, points);
+    if (keep.length < time.length) {
+      const t = new Float64Array(keep.length);
+      const v = new Float64Array(keep.length);
+      for (let k = 0; k < keep.length; k++) {
+        t[k] = time[keep[k]];
+        v[k] = value[keep[k]];
+      }
+      time = t;
+      value = v;
+    }
+
+    return {
+      from,
+      to,
+      bucketSize: level ? level.bucketSize : 1,
+      time,
+      value,
+      min,
+      max,
+      envelopeTime,
+    };
+  }
+
+  clear(): void {
+    this.total = 0;
+  }
+}
@@ -0,0 +1,102 @@
+/**
+ * Monitoring pipeline latency tracking.
+ *
+ * Each sample is stamped at every hop (sampler /proc read, worker parse,
+ * worker batch post, renderer receive, chart commit). The tracker keeps a
+ * fixed window of recent deltas per hop and reports p50/p99, so changes to
+ * batching or file watching can be compared quantitatively.
+ */
+
+export type LatencyHop =
+  | 'collectToRead'    // sampler write + file watch + worker parse
+  | 'readToSend'       // worker batching interval
+  | 'sendToReceive'    // worker -> renderer MessagePort
+  | 'receiveToRender'  // React commit of the new chart data
+  | 'endToEnd';        // /proc read -> rendered chart
+
+export const LATENCY_HOPS: LatencyHop[] = [
+  'collectToRead',
+  'readToSend',
+  'sendToReceive',
+  'receiveToRender',
+  'endToEnd',
+];
+
+export interface LatencyStats {
+  p50: number;
+  p99: number;
+  count: number;
+}
+
+const WINDOW_SIZE = 512;
+
+/**
+ * High-resolution epoch milliseconds, comparable with the monitoring worker's
+ * stamps.
+ */
+export function nowMs(): number {
+  return performance.timeOrigin + performance.now();
+}
+
+function percentile(sorted: Float64Array, p: number): number {
+  if (sorted.length === 0) return 0;
+  const idx = Math.min(sorted.length - 1, Math.max(0, Math.ceil(p * sorted.length) - 1));
+  return sorted[idx];
+}
+
+export class LatencyTracker {
+  private windows = new Map<LatencyHop, Float64Array>();
+  private counts = new Map<LatencyHop, number>();
+  private lastSeq = -1;
+  lostSamples = 0;
+
+  constructor() {
+    for (const hop of LATENCY_HOPS) {
+      this.windows.set(hop, new Float64Array(WINDOW_SIZE));
+      this.counts.set(hop, 0);
+    }
+  }
+
+  record(hop: LatencyHop, ms: number): void {
+    const count = this.counts.get(hop)!;
+    this.windows.get(hop)![count % WINDOW_SIZE] = ms;
+    this.counts.set(hop, count + 1);
+  }
+
+  /**
+   * Track sequence gaps so dropped samples show up next to the latencies
+   */
+  observeSeq(seq: number): void {
+    if (seq < 0) return;
+    if (seq < this.lastSeq) {
+      this.lastSeq = -1; // New run
+    }
+    if (this.lastSeq >= 0 && seq > this.lastSeq + 1) {
+      this.lostSamples += seq - this.lastSeq - 1;
+    }
+    this.lastSeq = seq;
+  }
+
+  stats(hop: LatencyHop): LatencyStats {
+    const count = this.counts.get(hop)!;
+    const n = Math.min(count, WINDOW_SIZE);
+    const sorted = this.windows.get(hop)!.slice(0, n).sort();
+    return { p50: percentile(sorted, 0.5), p99: percentile(sorted, 0.99), count };
+  }
+
+  summary(): Record<LatencyHop, LatencyStats> {
+    const result = {} as Record<LatencyHop, LatencyStats>;
+    for (const hop of LATENCY_HOPS) {
+      result[hop] = this.stats(hop);
+    }
+    return result;
+  }
+
+  reset(): void {
+    for (const hop of LATENCY_HOPS) {
+      this.counts.set(hop, 0);
+    }
+    this.lastSeq = -1;
+    this.lostSamples = 0;
+  }
+}
@@ -0,0 +1,93 @@
+import { HistoryStore } from './history-store';
+import { subscribeMonitoringBatches, onMonitoringRun, batchColumn } from './monitoring-port';
+import type { MonitoringBatch } from '../../preload/preload';
+
+/**
+ * Monitoring history for the app's lifetime.
+ *
+ * Every batch is appended here whether or not the dashboard is mounted, so
+ * switching away from the Monitoring tab keeps the run's history. History
+ * stays after the process stops so it can still be inspected; the next
+ * run starts from an empty store. The store (about 6 MB of typed arrays)
+ * is allocated once, on first use. History the renderer never saw can be
+ * loaded from the exporter's range API.
+ */
+let store: HistoryStore | null = null;
+
+// While a backfill is in flight, live batches wait here so the store stays
+// in time order; `generation` tells a backfill that a new run began
+let held: MonitoringBatch[] | null = null;
+let generation = 0;
+
+export function getMonitoringHistory(): HistoryStore {
+  if (store === null) {
+    store = new HistoryStore();
+  }
+  return store;
+}
+
+// Registered at import, before any component, so the store is up to date
+// when a dashboard's batch callback runs
+onMonitoringRun(() => {
+  store?.clear();
+  held = null;
+  generation++;
+});
+
+function appendBatch(batch: MonitoringBatch): void {
+  const history = getMonitoringHistory();
+  const cpu = batchColumn(batch, 'cpu');
+  const memory = batchColumn(batch, 'memory');
+  const collectedAt = batchColumn(batch, 'collectedAt');
+  for (let i = 0; i < batch.count; i++) {
+    history.append(collectedAt[i], cpu[i], memory[i]);
+  }
+}
+
+subscribeMonitoringBatches((batch) => {
+  if (held) {
+    held.push(batch);
+  } else {
+    appendBatch(batch);
+  }
+});
+
+/**
+ * Fill an empty store from the exporter's cache of the most recent run
+ * (/api/series), e.g. after the renderer was reloaded and its history went
+ * with it. Points older than the first live batch go in first. Resolves to
+ * true if anything was added.
+ */
+export async function backfillMonitoringHistory(): Promise<boolean> {
+  const history = getMonitoringHistory();
+  if (history.size > 0 || held || !window.sandboxAPI?.getMetricSeries) {
+    return false;
+  }
+
+  const started = generation;
+  held = [];
+  let added = 0;
+  try {
+    const series = await window.sandboxAPI.getMetricSeries({});
+    if (series && generation === started) {
+      const pending = held ?? [];
+      const liveFrom = pending.length > 0 ? batchColumn(pending[0], 'collectedAt')[0] : Infinity;
+      for (let i = 0; i < series.count && series.t[i] < liveFrom; i++) {
+        history.append(series.t[i], series.cpu_percent[i], series.rss_bytes[i] / 1024 / 1024);
+        added++;
+      }
+    }
+  } catch (error) {
+    console.error('[MonitoringHistory] Backfill failed:', error);
+  } finally {
+    // A new run in the meantime already dropped what was held
+    if (generation === started && held) {
+      const pending = held;
+      held = null;
+      for (const batch of pending) {
+        appendBatch(batch);
+      }
+    }
+  }
+  return added > 0;
+}
@@ -0,0 +1,81 @@
+import type { MonitoringBatch } from '../../preload/preload';
+
+type BatchCallback = (batch: MonitoringBatch) => void;
+
+// The current run's port is owned here for the app's lifetime rather than
+// by a component: the main process hands it over once, when the run starts,
+// usually while the Execute tab is showing and no dashboard is mounted.
+let currentPort: MessagePort | null = null;
+const subscribers = new Set<BatchCallback>();
+const runListeners = new Set<() => void>();
+
+function dispatch(msg: MessageEvent): void {
+  if (msg.data && msg.data.type === 'data-batch') {
+    for (const callback of subscribers) {
+      callback(msg.data as MonitoringBatch);
+    }
+  }
+}
+
+// Assigning onmessage starts the port and delivers what queued up before
+function attach(port: MessagePort): void {
+  port.onmessage = dispatch;
+  port.onmessageerror = () => port.close();
+}
+
+window.addEventListener('message', (event: MessageEvent) => {
+  if (event.source !== window || event.data !== 'monitoring-port' || event.ports.length === 0) {
+    return;
+  }
+
+  // A new run replaces the previous run's port
+  currentPort?.close();
+  currentPort = event.ports[0];
+  for (const listener of runListeners) {
+    listener();
+  }
+  if (subscribers.size > 0) {
+    attach(currentPort);
+  }
+});
+
+/**
+ * Call `listener` when a new run's port arrives, before its first batch.
+ * Returns an unsubscribe function.
+ */
+export function onMonitoringRun(listener: () => void): () => void {
+  runListeners.add(listener);
+  return () => {
+    runListeners.delete(listener);
+  };
+}
+
+/**
+ * Subscribe to monitoring batches. The preload script forwards one
+ * MessagePort per monitored run; batches then flow from the monitoring
+ * worker to this callback without passing through the main process. A
+ * subscriber that arrives after the run started still gets its batches:
+ * until the first subscription they stay queued in the port. Callbacks run
+ * in subscription order. Returns an unsubscribe function.
+ */
+export function subscribeMonitoringBatches(callback: BatchCallback): () => void {
+  subscribers.add(callback);
+  if (currentPort && currentPort.onmessage === null) {
+    attach(currentPort);
+  }
+
+  return () => {
+    subscribers.delete(callback);
+  };
+}
+
+/**
+ * Zero-copy view of one column of a batch
+ */
+export function batchColumn(batch: MonitoringBatch, field: string): Float64Array {
+  const index = batch.fields.indexOf(field);
+  if (index < 0) {
+    return new Float64Array(batch.count);
+  }
+  return batch.columns.subarray(index * batch.count, (index + 1) * batch.count);
+}
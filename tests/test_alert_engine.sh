@@ -186,6 +186,223 @@ timeout 3s "${BIN_DIR}/alertd" \
 echo "PASS: Handles empty log gracefully"
 echo ""
 
+# Test 8: Query service over the Unix socket
+echo "[Test 8] Querying alertd over its Unix socket..."
+SOCK_LOG="${TEST_DIR}/socket_samples.jsonl"
+SOCKET="${TEST_DIR}/alertd.sock"
+cp "${SAMPLE_LOG}" "${SOCK_LOG}"
+
+"${BIN_DIR}/alertd" \
+    --config "${ALERT_CONFIG}" \
+    --log "${SOCK_LOG}" \
+    --out "${TEST_DIR}/socket_alerts.jsonl" \
+    --run-id "${RUN_ID}" \
+    --socket "${SOCKET}" > "${TEST_DIR}/alertd.log" 2>&1 &
+ALERTD_PID=$!
+trap "kill ${ALERTD_PID} 2>/dev/null || true; rm -rf ${TEST_DIR}" EXIT
+
+for _ in {1..50}; do
+    [[ -S "${SOCKET}" ]] && break
+    sleep 0.1
+done
+if [[ ! -S "${SOCKET}" ]]; then
+    echo "FAIL: alertd did not create ${SOCKET}"
+    cat "${TEST_DIR}/alertd.log"
+    exit 1
+fi
+
+python3 - "${SOCKET}" <<'EOF'
+import json, socket, sys
+
+def query(request):
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.settimeout(2)
+    s.connect(sys.argv[1])
+    s.sendall((json.dumps(request) + "\n").encode())
+    reply = s.makefile().readline()
+    s.close()
+    return json.loads(reply)
+
+active = query({"cmd": "active"})
+assert active["type"] == "active", active
+assert any(a["metric"] == "cpu_percent" for a in active["alerts"]), active
+
+events = query({"cmd": "since", "seq": 0})
+assert events["type"] == "events", events
+assert events["events"] and events["events"][0]["state"] == "firing", events
+assert events["next_seq"] == events["events"][-1]["seq"] + 1, events
+
+last = events["events"][-1]["seq"]
+assert len(query({"cmd": "since", "seq": last - 1})["events"]) == 1
+assert query({"cmd": "since", "seq": last})["events"] == []
+
+assert query({"cmd": "bogus"})["type"] == "error"
+print("  active alerts: %d, events: %d" % (len(active["alerts"]), len(events["events"])))
+EOF
+
+echo "PASS: active and since queries answered"
+echo ""
+
+# Test 9: Subscribers get pushed events promptly
+echo "[Test 9] Checking push latency for subscribers..."
+python3 - "${SOCKET}" "${SOCK_LOG}" "${RUN_ID}" <<'EOF'
+import json, socket, sys, time
+
+sock_path, log_path, run_id = sys.argv[1:4]
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.settimeout(2)
+s.connect(sock_path)
+reader = s.makefile()
+
+s.sendall(b'{"cmd":"active"}\n')
+active = json.loads(reader.readline())
+s.sendall(('{"cmd":"subscribe","seq":%d}\n' % (active["next_seq"] - 1)).encode())
+reply = json.loads(reader.readline())
+assert reply["type"] == "subscribed", reply
+
+def sample(cpu, rss):
+    with open(log_path, "a") as f:
+        f.write(json.dumps({"event": "sample", "run_id": run_id, "timestamp": "2024-01-01T00:10:00Z",
+                            "cpu_percent": cpu, "rss_bytes": rss, "fds_open": 20}) + "\n")
+
+def next_event():
+    while True:
+        msg = json.loads(reader.readline())
+        if msg.get("type") == "event":
+            return msg
+
+# Dropping below the CPU threshold resolves the active alert
+start = time.monotonic()
+sample(10, 50000000)
+event = next_event()
+resolve_ms = (time.monotonic() - start) * 1000
+assert event["state"] == "resolved" and event["metric"] == "cpu_percent", event
+
+# A single RSS violation fires immediately (duration_samples = 1)
+start = time.monotonic()
+sample(10, 200000000)
+event = next_event()
+fire_ms = (time.monotonic() - start) * 1000
+assert event["state"] == "firing" and event["metric"] == "rss_bytes", event
+
+print("  resolve pushed in %.1f ms, firing pushed in %.1f ms" % (resolve_ms, fire_ms))
+assert resolve_ms < 100 and fire_ms < 100, "push latency over 100 ms"
+EOF
+
+kill ${ALERTD_PID} 2>/dev/null || true
+wait ${ALERTD_PID} 2>/dev/null || true
+if [[ -S "${SOCKET}" ]]; then
+    echo "FAIL: socket not removed on shutdown"
+    exit 1
+fi
+
+echo "PASS: Subscribers receive pushed events under 100 ms"
+echo ""
+
+# Test 10: Directory mode follows sample logs, not their rollup sidecars
+echo "[Test 10] Following a directory of sample logs..."
+WATCH_DIR="${TEST_DIR}/watch"
+mkdir -p "${WATCH_DIR}"
+"${BIN_DIR}/alertd" \
+    --config "${ALERT_CONFIG}" \
+    --dir "${WATCH_DIR}" \
+    --out "${TEST_DIR}/dir_alerts.jsonl" \
+    --socket "${TEST_DIR}/alertd_dir.sock" \
+    --interval 0.2 > "${TEST_DIR}/alertd_dir.log" 2>&1 &
+ALERTD_PID=$!
+trap "kill ${ALERTD_PID} 2>/dev/null || true; rm -rf ${TEST_DIR}" EXIT
+sleep 0.5
+
+DIR_LOG="${WATCH_DIR}/zencube_samples_4242.jsonl"
+echo '{"event":"sample","run_id":"dir_run","pid":4242,"cpu_percent":10,"rss_bytes":200000000,"fds_open":5}' > "${DIR_LOG}"
+echo '{"event":"rollup","run_id":"dir_run","resolution_s":10,"samples":1}' > "${DIR_LOG}.10s.jsonl"
+sleep 2
+
+FOLLOWED=$(ls -l /proc/${ALERTD_PID}/fd 2>/dev/null | grep -c "zencube_samples_4242.jsonl$" || true)
+SIDECARS=$(ls -l /proc/${ALERTD_PID}/fd 2>/dev/null | grep -c "\.10s\.jsonl$" || true)
+
+# Output written next to the sample logs must not wake alertd
+wakeups() { awk '/^voluntary_ctxt_switches/ { print $2 }' /proc/${ALERTD_PID}/status; }
+BEFORE=$(wakeups)
+for i in {1..500}; do echo "output ${i}" >> "${WATCH_DIR}/zencube_capture_1.log"; done
+sleep 1
+WOKEN=$(( $(wakeups) - BEFORE ))
+
+# A removed log is no longer followed, so its fd is closed
+rm -f "${DIR_LOG}"
+sleep 2
+LEFT=$(ls -l /proc/${ALERTD_PID}/fd 2>/dev/null | grep -c "zencube_samples_4242" || true)
+kill ${ALERTD_PID} 2>/dev/null || true
+wait ${ALERTD_PID} 2>/dev/null || true
+if [[ ${FOLLOWED} -ne 1 || ${SIDECARS} -ne 0 ]]; then
+    echo "FAIL: Expected the sample log followed and no sidecar (got ${FOLLOWED} and ${SIDECARS})"
+    exit 1
+fi
+if ! grep -q '"run_id":"dir_run"' "${TEST_DIR}/dir_alerts.jsonl"; then
+    echo "FAIL: No alert raised from the followed log"
+    exit 1
+fi
+if [[ ${LEFT} -ne 0 ]]; then
+    echo "FAIL: alertd still holds the removed log open"
+    exit 1
+fi
+if [[ ${WOKEN} -gt 50 ]]; then
+    echo "FAIL: 500 writes to an output log woke alertd ${WOKEN} times"
+    exit 1
+fi
+echo "PASS: Sample log followed and released, rollup sidecar skipped; ${WOKEN} wakeups during 500 unrelated writes"
+echo ""
+
+# Test 11: A subscriber that reads slowly still gets the whole replay
+echo "[Test 11] Replaying a long history to a slow subscriber..."
+BURST_LOG="${TEST_DIR}/burst_samples.jsonl"
+python3 - "${BURST_LOG}" <<'EOF'
+import sys
+with open(sys.argv[1], "w") as log:
+    for i in range(4000):
+        rss = 200000000 if i % 2 == 0 else 1000
+        log.write('{"event":"sample","run_id":"burst","cpu_percent":1,"rss_bytes":%d,"fds_open":1}\n' % rss)
+EOF
+BURST_SOCKET="${TEST_DIR}/burst.sock"
+"${BIN_DIR}/alertd" \
+    --config "${ALERT_CONFIG}" \
+    --log "${BURST_LOG}" \
+    --out "${TEST_DIR}/burst_alerts.jsonl" \
+    --run-id burst \
+    --socket "${BURST_SOCKET}" > "${TEST_DIR}/alertd_burst.log" 2>&1 &
+ALERTD_PID=$!
+trap "kill ${ALERTD_PID} 2>/dev/null || true; rm -rf ${TEST_DIR}" EXIT
+for _ in {1..50}; do
+    [[ -S "${BURST_SOCKET}" ]] && break
+    sleep 0.1
+done
+sleep 1
+
+python3 - "${BURST_SOCKET}" <<'EOF'
+import json, socket, sys, time
+
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4096)
+s.settimeout(5)
+s.connect(sys.argv[1])
+s.sendall(b'{"cmd":"subscribe","seq":0}\n')
+time.sleep(1)                  # Let the replay fill both socket buffers
+
+reader = s.makefile()
+reply = json.loads(reader.readline())
+assert reply["type"] == "subscribed", reply
+expected = min(reply["next_seq"] - 1, 4096)
+assert expected > 3000, reply
+seqs = [json.loads(reader.readline())["seq"] for _ in range(expected)]
+assert seqs == list(range(reply["next_seq"] - expected, reply["next_seq"])), (seqs[:3], seqs[-3:])
+print("  %d events replayed in order" % expected)
+EOF
+
+kill ${ALERTD_PID} 2>/dev/null || true
+wait ${ALERTD_PID} 2>/dev/null || true
+echo "PASS: Slow subscriber received the whole replay"
+echo ""
+
 # Summary
 echo "==================================="
 echo "All alert engine tests PASSED ✓"
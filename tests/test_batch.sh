@@ -0,0 +1,193 @@
+#!/usr/bin/env bash
+# Test script for the batch runner
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+CORE_DIR="${SCRIPT_DIR}/../core_c"
+BIN_DIR="${CORE_DIR}/bin"
+BATCH="${BIN_DIR}/zencube_batch"
+
+echo "=== ZenCube Core C - Batch Runner Test ==="
+echo ""
+
+if [[ ! -x "${BATCH}" ]]; then
+    echo "Error: zencube_batch binary not found. Run 'make' first."
+    exit 1
+fi
+
+TEST_DIR=$(mktemp -d)
+trap "rm -rf ${TEST_DIR}" EXIT
+
+# Test 1: Mixed outcomes, one line per job plus the batch line
+echo "[Test 1] Running a mixed manifest..."
+mkdir -p "${TEST_DIR}/logs"
+cat > "${TEST_DIR}/mixed.json" << 'EOF'
+{
+  "defaults": {"timeout": 5},
+  "jobs": [
+    {"id": "ok", "argv": ["sh", "-c", "echo hello"]},
+    {"id": "fails", "command": "exit 3"},
+    {"id": "slow", "command": "sleep 10", "timeout": 0.3},
+    {"id": "busy", "command": "i=0; while [ $i -lt 200000 ]; do i=$((i+1)); done"},
+    {"id": "missing", "argv": ["/nonexistent/command"]},
+    {"id": "cpu-capped", "command": "while :; do :; done", "cpu_limit": 1}
+  ]
+}
+EOF
+set +e
+"${BATCH}" --manifest "${TEST_DIR}/mixed.json" --results "${TEST_DIR}/results.jsonl" \
+    --samples "${TEST_DIR}/samples.jsonl" --log-dir "${TEST_DIR}/logs" --jobs 3 --interval 0.05 > /dev/null
+CODE=$?
+set -e
+if [[ ${CODE} -ne 1 ]]; then
+    echo "FAIL: Expected exit 1 with failing jobs (got ${CODE})"
+    exit 1
+fi
+python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+d = sys.argv[1]
+lines = [json.loads(l) for l in open(d + "/results.jsonl")]
+jobs = {l["id"]: l for l in lines if l["event"] == "job"}
+batch = [l for l in lines if l["event"] == "batch"]
+assert len(jobs) == 6 and len(batch) == 1 and lines[-1] is batch[0], lines
+assert jobs["ok"]["status"] == "ok" and jobs["ok"]["exit_code"] == 0, jobs["ok"]
+assert jobs["fails"]["status"] == "failed" and jobs["fails"]["exit_code"] == 3, jobs["fails"]
+assert jobs["slow"]["status"] == "timeout" and jobs["slow"]["duration_seconds"] < 2, jobs["slow"]
+assert jobs["missing"]["exit_code"] == 127, jobs["missing"]
+assert jobs["cpu-capped"]["status"] == "signaled" and jobs["cpu-capped"]["user_seconds"] >= 0.9, jobs["cpu-capped"]
+assert jobs["busy"]["samples"] > 0 and jobs["busy"]["max_cpu_percent"] > 0, jobs["busy"]
+assert open(d + "/logs/ok.log").read() == "hello\n"
+b = batch[0]
+assert (b["ok"], b["failed"], b["timeouts"], b["skipped"]) == (2, 3, 1, 0), b
+runs = {json.loads(l)["run_id"] for l in open(d + "/samples.jsonl")}
+assert jobs["busy"]["run_id"] in runs, runs
+print("  ok=%d failed=%d timeouts=%d in %.2fs" % (b["ok"], b["failed"], b["timeouts"], b["duration_seconds"]))
+EOF
+echo "PASS: Exit codes, timeouts, rlimits, logs and samples recorded"
+echo ""
+
+# Test 2: The worker limit bounds concurrency
+echo "[Test 2] Concurrency limit..."
+python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+jobs = [{"id": "j%d" % i, "command": "sleep 0.2"} for i in range(8)]
+json.dump({"jobs": jobs}, open(sys.argv[1] + "/sleep.json", "w"))
+EOF
+"${BATCH}" --manifest "${TEST_DIR}/sleep.json" --results "${TEST_DIR}/sleep.jsonl" --jobs 2 > /dev/null
+python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+lines = [json.loads(l) for l in open(sys.argv[1] + "/sleep.jsonl")]
+batch = lines[-1]
+# 8 jobs of 0.2 s, 2 at a time: at least 4 rounds
+assert batch["ok"] == 8 and batch["duration_seconds"] >= 0.75, batch
+print("  8 jobs, 2 workers: %.2fs" % batch["duration_seconds"])
+EOF
+echo "PASS: At most --jobs jobs ran at once"
+echo ""
+
+# Test 3: Placement pins concurrent jobs to distinct cores
+echo "[Test 3] CPU placement..."
+CORES=$(sort -u /sys/devices/system/cpu/cpu*/topology/thread_siblings_list 2> /dev/null | wc -l)
+if [[ ${CORES} -ge 2 && $(nproc) -ge 2 ]]; then
+    python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+jobs = [{"id": "p%d" % i, "command": "grep Cpus_allowed_list /proc/self/status; sleep 0.3"} for i in range(2)]
+json.dump({"jobs": jobs}, open(sys.argv[1] + "/pin.json", "w"))
+EOF
+    mkdir -p "${TEST_DIR}/pinlogs"
+    "${BATCH}" --manifest "${TEST_DIR}/pin.json" --results "${TEST_DIR}/pin.jsonl" --jobs 2 --log-dir "${TEST_DIR}/pinlogs" \
+        --placement-dir "${TEST_DIR}/leases" > /dev/null
+    python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+d = sys.argv[1]
+jobs = [json.loads(l) for l in open(d + "/pin.jsonl") if '"job"' in l]
+cpus = [j["cpus"] for j in jobs]
+assert all(cpus) and not set(cpus[0]) & set(cpus[1]), cpus
+for j in jobs:
+    allowed = open("%s/pinlogs/%s.log" % (d, j["id"])).read().split()[-1]
+    listed = set()
+    for part in allowed.split(","):
+        first, _, last = part.partition("-")
+        listed.update(range(int(first), int(last or first) + 1))
+    assert listed == set(j["cpus"]), (allowed, j["cpus"])
+print("  placed on CPUs %s" % cpus)
+EOF
+    echo "PASS: Concurrent jobs pinned to distinct cores"
+else
+    echo "SKIP: Needs at least 2 cores"
+fi
+echo ""
+
+# Test 4: Interrupting the batch
+echo "[Test 4] SIGTERM stops the batch..."
+python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+jobs = [{"id": "long%d" % i, "command": "sleep 30"} for i in range(4)]
+json.dump({"jobs": jobs}, open(sys.argv[1] + "/long.json", "w"))
+EOF
+"${BATCH}" --manifest "${TEST_DIR}/long.json" --results "${TEST_DIR}/long.jsonl" --jobs 1 > /dev/null &
+BATCH_PID=$!
+sleep 0.5
+kill -TERM ${BATCH_PID}
+wait ${BATCH_PID} || true
+python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+lines = [json.loads(l) for l in open(sys.argv[1] + "/long.jsonl")]
+batch = lines[-1]
+assert batch["event"] == "batch" and batch["skipped"] == 3 and batch["failed"] == 1, batch
+EOF
+echo "PASS: Running job killed, pending jobs reported as skipped"
+echo ""
+
+# Test 5: Jobs in an overlay jail leave the jail untouched
+echo "[Test 5] Overlay jail jobs..."
+mkdir -p "${TEST_DIR}/jail"
+echo "original" > "${TEST_DIR}/jail/data.txt"
+cat > "${TEST_DIR}/overlay.json" << EOF
+{
+  "defaults": {"jail": "${TEST_DIR}/jail", "overlay": true},
+  "jobs": [
+    {"id": "writer", "command": "echo changed > data.txt; dd if=/dev/zero of=big bs=1M count=4 2> /dev/null; sleep 0.5"},
+    {"id": "direct", "command": "echo direct > direct.txt", "overlay": false}
+  ]
+}
+EOF
+"${BATCH}" --manifest "${TEST_DIR}/overlay.json" --results "${TEST_DIR}/overlay.jsonl" \
+    --overlay-dir "${TEST_DIR}/overlay" --interval 0.05 > /dev/null || true
+python3 - "${TEST_DIR}" << 'EOF'
+import json, os, sys
+d = sys.argv[1]
+jobs = {l["id"]: l for l in map(json.loads, open(d + "/overlay.jsonl")) if l["event"] == "job"}
+if jobs["writer"]["status"] != "ok" and not os.path.exists(d + "/overlay"):
+    print("SKIP: Cannot mount overlayfs here")
+    sys.exit(0)
+assert jobs["writer"]["status"] == "ok" and jobs["writer"]["overlay_bytes"] >= 4 << 20, jobs["writer"]
+assert "overlay_bytes" not in jobs["direct"], jobs["direct"]
+assert open(d + "/jail/data.txt").read() == "original\n"
+assert not os.path.exists(d + "/jail/big") and os.path.exists(d + "/jail/direct.txt")
+EOF
+echo "PASS: Overlay job's writes measured and discarded"
+echo ""
+
+# Test 6: Memory and process limits go through the job's cgroup
+echo "[Test 6] Cgroup limits..."
+cat > "${TEST_DIR}/limited.json" << 'EOF'
+{"jobs": [{"id": "limited", "command": "echo limited", "mem_limit": 64, "proc_limit": 16}]}
+EOF
+# Not a cgroup filesystem: the limits cannot be written and are reported
+"${BATCH}" --manifest "${TEST_DIR}/limited.json" --results "${TEST_DIR}/limited.jsonl" \
+    --cgroup-parent "${TEST_DIR}/not_a_cgroup" --log-dir "${TEST_DIR}/logs" > /dev/null
+python3 - "${TEST_DIR}" << 'EOF'
+import json, os, sys
+d = sys.argv[1]
+job = next(l for l in map(json.loads, open(d + "/limited.jsonl")) if l["event"] == "job")
+assert job["status"] == "ok" and job.get("cgroup_error"), job
+assert open(d + "/logs/limited.log").read() == "limited\n"
+assert not os.listdir(d + "/not_a_cgroup"), os.listdir(d + "/not_a_cgroup")
+EOF
+echo "PASS: Limits applied through a cgroup, failures reported"
+echo ""
+
+echo "==================================="
+echo "All batch tests PASSED ✓"
+echo "==================================="
@@ -178,6 +178,153 @@ fi
 echo "PASS: Returns 503 when sample log not found"
 echo ""
 
+# Test 9: Range API over the cached series
+echo "[Test 9] Fetching /api/series range..."
+SERIES_OUTPUT="${TEST_DIR}/series.json"
+HTTP_CODE=$(curl -s -o "${SERIES_OUTPUT}" -w "%{http_code}" "http://localhost:${PORT}/api/series?run=test_prom")
+
+if [[ "${HTTP_CODE}" != "200" ]] || ! python3 - "${SERIES_OUTPUT}" <<'PY'
+import json, sys
+s = json.load(open(sys.argv[1]))
+assert s["run"] == "test_prom" and s["count"] == 1, s
+assert s["cpu_percent"] == [45.5] and s["rss_bytes"] == [123456789], s
+assert s["t"] == [1704067200000.0], s
+PY
+then
+    echo "FAIL: Unexpected /api/series response (code: ${HTTP_CODE})"
+    cat "${SERIES_OUTPUT}"
+    kill ${EXPORTER_PID} 2>/dev/null || true
+    exit 1
+fi
+
+HTTP_CODE=$(curl -s -o /dev/null -w "%{http_code}" "http://localhost:${PORT}/api/series?run=unknown")
+if [[ "${HTTP_CODE}" != "404" ]]; then
+    echo "FAIL: Expected 404 for unknown run, got ${HTTP_CODE}"
+    kill ${EXPORTER_PID} 2>/dev/null || true
+    exit 1
+fi
+
+echo "PASS: /api/series returns cached points"
+echo ""
+
+# Test 10: Appended samples are ingested incrementally and bucketed by step
+echo "[Test 10] Appending samples and querying with step..."
+for i in 1 2 3 4; do
+    # The last sample's counters are the host's, not the run's
+    ISOLATED=$([[ ${i} -lt 4 ]] && echo true || echo false)
+    echo "{\"event\":\"sample\",\"run_id\":\"test_prom\",\"timestamp\":\"2024-01-01T00:00:0${i}Z\",\"seq\":${i},\"cpu_percent\":$((i * 10)),\"rss_bytes\":1000,\"read_bytes\":${i},\"net_rx_bytes\":100,\"net_tcp_retrans\":${i},\"net_isolated\":${ISOLATED}}" >> "${SAMPLE_LOG}"
+done
+sleep 1
+
+curl -s -o "${SERIES_OUTPUT}" "http://localhost:${PORT}/api/series?run=test_prom&from=1704067201000&to=1704067204000&step=2000"
+if ! python3 - "${SERIES_OUTPUT}" <<'PY'
+import json, sys
+s = json.load(open(sys.argv[1]))
+# Buckets [0s,2s) [2s,4s) [4s,6s) within from=1s..to=4s: {1}, {2,3}, {4}
+assert s["count"] == 3, s
+assert s["t"] == [1704067200000.0, 1704067202000.0, 1704067204000.0], s
+assert s["cpu_percent"] == [10, 25, 40], s
+assert s["read_bytes"] == [1, 3, 4], s
+PY
+then
+    echo "FAIL: Unexpected bucketed series"
+    cat "${SERIES_OUTPUT}"
+    kill ${EXPORTER_PID} 2>/dev/null || true
+    exit 1
+fi
+
+CPU_VALUE=$(curl -s http://localhost:${PORT}/metrics | grep "^zencube_cpu_percent " | awk '{print $2}')
+if [[ "${CPU_VALUE}" != "40.00" ]]; then
+    echo "FAIL: /metrics did not follow appended samples (got ${CPU_VALUE})"
+    kill ${EXPORTER_PID} 2>/dev/null || true
+    exit 1
+fi
+
+NET_RX=$(curl -s http://localhost:${PORT}/metrics | grep "^zencube_net_rx_bytes_total " | awk '{print $2}')
+NET_RETRANS=$(curl -s http://localhost:${PORT}/metrics | grep "^zencube_net_tcp_retrans_segs_total " | awk '{print $2}')
+if [[ "${NET_RX}" != "300" || "${NET_RETRANS}" != "6" ]]; then
+    echo "FAIL: Per-interval network fields of isolated samples not summed (rx=${NET_RX} retrans=${NET_RETRANS})"
+    kill ${EXPORTER_PID} 2>/dev/null || true
+    exit 1
+fi
+
+echo "PASS: Appended samples ingested and aggregated"
+echo ""
+
+# Test 11: A stop event's sketches become summaries; a repeated stop is not counted twice
+echo "[Test 11] Run summaries from stop event sketches..."
+STOP_LINE=$(python3 - <<'PY'
+import json, math
+alpha = 0.01
+gamma = (1 + alpha) / (1 - alpha)
+def sketch(values):
+    idx = [math.ceil(math.log(v) / math.log(gamma)) for v in values]
+    counts = [0] * (max(idx) - min(idx) + 1)
+    for i in idx:
+        counts[i - min(idx)] += 1
+    return {"alpha": alpha, "count": len(values), "sum": sum(values), "min": min(values),
+            "max": max(values), "zero": 0, "offset": min(idx), "counts": counts}
+cpu = sketch(list(range(1, 101)))
+rss = sketch([1e6 * v for v in range(1, 11)])
+print(json.dumps({"event": "stop", "run_id": "test_prom", "samples": 100,
+                  "cpu_percent": {"sketch": cpu}, "rss_bytes": {"sketch": rss},
+                  "cpu_seconds": 1.5, "rss_gib_seconds": 0.25}))
+PY
+)
+echo "${STOP_LINE}" >> "${SAMPLE_LOG}"
+echo "${STOP_LINE}" >> "${SAMPLE_LOG}"
+sleep 1
+METRICS=$(curl -s http://localhost:${PORT}/metrics)
+if ! python3 - <<PY
+m = {}
+for line in """${METRICS}""".splitlines():
+    if line and not line.startswith("#"):
+        k, v = line.rsplit(" ", 1)
+        m[k] = float(v)
+# Within the sketch's 1% relative accuracy
+assert abs(m['zencube_run_cpu_percent{quantile="0.5"}'] - 50) <= 0.5, m
+assert abs(m['zencube_run_cpu_percent{quantile="0.99"}'] - 99) <= 0.99, m
+assert abs(m['zencube_run_rss_bytes{quantile="0.9"}'] - 9e6) <= 9e4, m
+assert m["zencube_run_cpu_percent_count"] == 100 and m["zencube_run_cpu_percent_sum"] == 5050, m
+assert m["zencube_runs_cpu_percent_count"] == 100, m
+assert m["zencube_runs_finished_total"] == 1, m
+assert m["zencube_runs_cpu_seconds_total"] == 1.5, m
+PY
+then
+    echo "FAIL: Run summaries missing or wrong"
+    echo "${METRICS}" | grep "zencube_run"
+    kill ${EXPORTER_PID} 2>/dev/null || true
+    exit 1
+fi
+
+echo "PASS: Stop event sketches exported as summaries"
+echo ""
+
+# Test 12: Directory mode picks up the newest run's output capture counters
+echo "[Test 12] Output policy counters from a capture header..."
+kill ${EXPORTER_PID} 2>/dev/null || true
+wait ${EXPORTER_PID} 2>/dev/null || true
+RUN_DIR="${TEST_DIR}/runs"
+mkdir -p "${RUN_DIR}"
+"${BIN_DIR}/prom_exporter" --dir "${RUN_DIR}" --port ${PORT} &
+EXPORTER_PID=$!
+sleep 1
+head -1 "${SAMPLE_LOG}" > "${RUN_DIR}/zencube_samples_1.jsonl"
+"${BIN_DIR}/zencube_launch" --capture "${RUN_DIR}/zencube_capture_1.log" --capture-head 0.01 --capture-tail 0.01 \
+    -- /bin/sh -c 'head -c 1000000 /dev/zero'
+sleep 1.5
+METRICS=$(curl -s http://localhost:${PORT}/metrics)
+ELIDED=$(echo "${METRICS}" | grep "^zencube_output_elided_bytes_total " | awk '{print $2}')
+TOTAL=$(echo "${METRICS}" | grep "^zencube_output_bytes_total " | awk '{print $2}')
+if [[ "${TOTAL}" != "1000000" || "${ELIDED}" != "$((1000000 - 2 * 10485))" ]]; then
+    echo "FAIL: Capture counters missing or wrong (total=${TOTAL} elided=${ELIDED})"
+    kill ${EXPORTER_PID} 2>/dev/null || true
+    exit 1
+fi
+
+echo "PASS: zencube_output_* counters exported (${ELIDED} bytes elided)"
+echo ""
+
 # Cleanup
 kill ${EXPORTER_PID} 2>/dev/null || true
 wait ${EXPORTER_PID} 2>/dev/null || true
@@ -0,0 +1,180 @@
+#!/usr/bin/env bash
+# Test script for the cached jail builder
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+CORE_DIR="${SCRIPT_DIR}/../core_c"
+BIN_DIR="${CORE_DIR}/bin"
+JAILBUILD="${BIN_DIR}/zencube_jailbuild"
+
+echo "=== ZenCube Core C - Jail Builder Test ==="
+echo ""
+
+if [[ ! -x "${JAILBUILD}" ]]; then
+    echo "Error: zencube_jailbuild binary not found. Run 'make' first."
+    exit 1
+fi
+
+TEST_DIR=$(mktemp -d)
+trap "rm -rf ${TEST_DIR}" EXIT
+CACHE="${TEST_DIR}/cache"
+
+# Test 1: First build resolves the loader and libc without ldd
+echo "[Test 1] Building a jail for /bin/sh..."
+"${JAILBUILD}" --jail "${TEST_DIR}/jail1" --cache "${CACHE}" /bin/sh > "${TEST_DIR}/first.json"
+python3 - "${TEST_DIR}" << 'EOF'
+import json, os, sys
+d = sys.argv[1]
+r = json.load(open(d + "/first.json"))
+assert not r["template_hit"] and r["files"] >= 3 and r["missing"] == 0, r
+assert r["objects_added"] >= 3 and r["hardlinked"] + r["reflinked"] + r["copied"] == r["files"], r
+jail = d + "/jail1"
+names = [f for _, _, fs in os.walk(jail) for f in fs]
+assert any(n.startswith("libc.so") for n in names), names
+assert any(n.startswith("ld-linux") or n.startswith("ld-musl") for n in names), names
+assert os.path.exists(jail + "/bin/sh") and os.path.isdir(jail + "/tmp"), names
+assert open(jail + "/etc/passwd").read().startswith("root:"), "stub passwd"
+EOF
+echo "PASS: sh, its loader and libc are in the jail"
+echo ""
+
+# Test 2: The jail is runnable
+echo "[Test 2] Running sh inside the jail..."
+if [[ $(id -u) -eq 0 ]] && command -v chroot > /dev/null; then
+    OUT=$(chroot "${TEST_DIR}/jail1" /bin/sh -c 'echo jailed')
+else
+    # Without root, run the jail's own loader on the jail's sh
+    LOADER=$(find "${TEST_DIR}/jail1" -name 'ld-linux*' -type f | head -1)
+    OUT=$("${LOADER}" --library-path "$(dirname "$(find "${TEST_DIR}/jail1" -name 'libc.so*' | head -1)")" \
+        "${TEST_DIR}/jail1/bin/sh" -c 'echo jailed')
+fi
+if [[ "${OUT}" != "jailed" ]]; then
+    echo "FAIL: sh did not run from the jail (got '${OUT}')"
+    exit 1
+fi
+echo "PASS: sh runs from the jail"
+echo ""
+
+# Test 3: Rebuilding uses the template and touches nothing
+echo "[Test 3] Rebuilding the same jail..."
+"${JAILBUILD}" --jail "${TEST_DIR}/jail1" --cache "${CACHE}" /bin/sh > "${TEST_DIR}/second.json"
+python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+d = sys.argv[1]
+first = json.load(open(d + "/first.json"))
+r = json.load(open(d + "/second.json"))
+assert r["template_hit"] and r["template"] == first["template"], r
+assert r["objects_added"] == 0 and r["bytes_copied"] == 0, r
+assert first["hardlinked"] == 0, first   # auto never shares the cache's inodes
+assert r["unchanged"] == r["files"], r
+EOF
+echo "PASS: Template hit, no bytes copied"
+echo ""
+
+# Test 4: A second jail shares the cached objects instead of copying them
+echo "[Test 4] Building a second jail from the cache..."
+"${JAILBUILD}" --jail "${TEST_DIR}/jail2" --cache "${CACHE}" --mode hardlink /bin/sh > "${TEST_DIR}/third.json"
+"${JAILBUILD}" --jail "${TEST_DIR}/jail2b" --cache "${CACHE}" --mode hardlink /bin/sh > /dev/null
+python3 - "${TEST_DIR}" << 'EOF'
+import json, os, sys
+d = sys.argv[1]
+r = json.load(open(d + "/third.json"))
+assert r["template_hit"] and r["hardlinked"] == r["files"] and r["bytes_copied"] == 0, r
+a, b = os.stat(d + "/jail2b/bin/sh"), os.stat(d + "/jail2/bin/sh")
+assert a.st_ino == b.st_ino and a.st_nlink >= 3, (a, b)
+assert not (b.st_mode & 0o222), oct(b.st_mode)
+EOF
+echo "PASS: Jails share one read-only inode per file"
+echo ""
+
+# Test 5: Objects are content addressed, so equal files are stored once
+echo "[Test 5] Deduplicating equal files..."
+mkdir -p "${TEST_DIR}/progs"
+cp "$(readlink -f /bin/sh)" "${TEST_DIR}/progs/sh_copy"
+BEFORE=$(find "${CACHE}/objects" -type f | wc -l)
+"${JAILBUILD}" --jail "${TEST_DIR}/jail3" --cache "${CACHE}" "${TEST_DIR}/progs/sh_copy" > "${TEST_DIR}/fourth.json"
+AFTER=$(find "${CACHE}/objects" -type f | wc -l)
+if [[ ${AFTER} -ne ${BEFORE} ]]; then
+    echo "FAIL: Identical files added new objects (${BEFORE} -> ${AFTER})"
+    exit 1
+fi
+echo "PASS: ${AFTER} objects, none duplicated"
+echo ""
+
+# Test 6: Changing a source invalidates the template
+echo "[Test 6] Changing a program after it was cached..."
+echo "# changed" >> "${TEST_DIR}/progs/sh_copy"
+"${JAILBUILD}" --jail "${TEST_DIR}/jail3" --cache "${CACHE}" "${TEST_DIR}/progs/sh_copy" > "${TEST_DIR}/fifth.json"
+python3 - "${TEST_DIR}" << 'EOF'
+import json, sys
+d = sys.argv[1]
+r = json.load(open(d + "/fifth.json"))
+assert not r["template_hit"] and r["objects_added"] == 1, r
+assert open(d + "/jail3" + d + "/progs/sh_copy", "rb").read().endswith(b"# changed\n")
+EOF
+echo "PASS: Template rebuilt, only the changed file stored"
+echo ""
+
+# Test 7: A jailed program rewriting its copy cannot reach the cache
+echo "[Test 7] Rewriting a file inside an auto-mode jail..."
+SH_FILE="${TEST_DIR}/jail1$(readlink -f /bin/sh)"
+[[ -f "${SH_FILE}" ]] || SH_FILE="${TEST_DIR}/jail1/bin/sh"
+chmod u+w "${SH_FILE}"
+echo "poisoned" >> "${SH_FILE}"
+"${JAILBUILD}" --jail "${TEST_DIR}/jail1" --cache "${CACHE}" /bin/sh > "${TEST_DIR}/sixth.json"
+python3 - "${TEST_DIR}" "${SH_FILE}" << 'EOF'
+import json, sys
+d, sh = sys.argv[1], sys.argv[2]
+r = json.load(open(d + "/sixth.json"))
+assert r["unchanged"] == r["files"] - 1, r
+assert not open(sh, "rb").read().endswith(b"poisoned\n"), "jail copy not restored"
+assert not open(d + "/jail2/bin/sh", "rb").read().endswith(b"poisoned\n"), "cache object poisoned"
+EOF
+echo "PASS: The cache is untouched and the rebuild restores the jail's copy"
+echo ""
+
+# Test 8: A read-only jail shares the cached inodes in auto mode
+echo "[Test 8] Building a read-only jail in auto mode..."
+"${JAILBUILD}" --jail "${TEST_DIR}/jail4" --cache "${CACHE}" --read-only /bin/sh > "${TEST_DIR}/seventh.json"
+python3 - "${TEST_DIR}" << 'EOF'
+import json, os, sys
+d = sys.argv[1]
+r = json.load(open(d + "/seventh.json"))
+assert r["hardlinked"] == r["files"] and r["bytes_copied"] == 0, r
+assert os.stat(d + "/jail4/bin/sh").st_ino == os.stat(d + "/jail2/bin/sh").st_ino
+EOF
+echo "PASS: No bytes copied into a read-only jail"
+echo ""
+
+# Test 9: Size and mtime vouch for a copy; a changed mtime means a hash
+echo "[Test 9] Rewriting a copy in place without changing its size..."
+"${JAILBUILD}" --jail "${TEST_DIR}/jail5" --cache "${CACHE}" --mode copy /bin/sh > /dev/null
+SH_COPY="${TEST_DIR}/jail5$(readlink -f /bin/sh)"
+[[ -f "${SH_COPY}" ]] || SH_COPY="${TEST_DIR}/jail5/bin/sh"
+LIBC_COPY=$(find "${TEST_DIR}/jail5" -name 'libc.so*' -type f | head -1)
+touch -d '2001-01-01' "${LIBC_COPY}"
+python3 - "${SH_COPY}" << 'EOF'
+import os, sys
+os.chmod(sys.argv[1], 0o755)
+with open(sys.argv[1], "r+b") as f:
+    f.write(b"XXXX")
+os.chmod(sys.argv[1], 0o555)
+EOF
+"${JAILBUILD}" --jail "${TEST_DIR}/jail5" --cache "${CACHE}" --mode copy /bin/sh > "${TEST_DIR}/eighth.json"
+"${JAILBUILD}" --jail "${TEST_DIR}/jail5" --cache "${CACHE}" --mode copy /bin/sh > "${TEST_DIR}/ninth.json"
+python3 - "${TEST_DIR}" "${SH_COPY}" "${LIBC_COPY}" << 'EOF'
+import json, os, sys
+d, sh, libc = sys.argv[1], sys.argv[2], sys.argv[3]
+r = json.load(open(d + "/eighth.json"))
+assert r["unchanged"] == r["files"] - 1 and r["copied"] == 1, r
+assert not open(sh, "rb").read().startswith(b"XXXX"), "jail copy not restored"
+assert os.stat(libc).st_mtime > 1e9 + 1e8, "touched copy not stamped again"
+r = json.load(open(d + "/ninth.json"))
+assert r["unchanged"] == r["files"] and r["bytes_copied"] == 0, r
+EOF
+echo "PASS: The rewritten copy was replaced, the intact ones kept"
+echo ""
+
+echo "==================================="
+echo "All jail builder tests PASSED ✓"
+echo "==================================="
@@ -0,0 +1,109 @@
+#!/usr/bin/env bash
+# Test script for the jailwatch file jail violation detector
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+CORE_DIR="${SCRIPT_DIR}/../core_c"
+BIN_DIR="${CORE_DIR}/bin"
+
+echo "=== ZenCube Core C - Jailwatch Test ==="
+echo ""
+
+if [[ ! -f "${BIN_DIR}/jailwatch" ]]; then
+    echo "Error: jailwatch binary not found. Run 'make' first."
+    exit 1
+fi
+
+TEST_DIR=$(mktemp -d)
+trap "rm -rf ${TEST_DIR}" EXIT
+JAIL="${TEST_DIR}/jail"
+mkdir -p "${JAIL}"
+echo "inside" > "${JAIL}/inside.txt"
+
+# Run jailwatch against a target script; output goes to $1
+watch_target() {
+    local out="$1" mode="$2" script="$3"
+    bash -c "${script}" &
+    local target=$!
+    "${BIN_DIR}/jailwatch" --pid "${target}" --jail "${JAIL}" --mode "${mode}" --interval-ms 20 > "${out}"
+    wait "${target}" || true
+}
+
+violations() {
+    python3 -c "
+import json, sys
+for line in open(sys.argv[1]):
+    event = json.loads(line)
+    if event['event'] == 'violation':
+        print(event['path'])
+" "$1"
+}
+
+# Test 1: fd scanning flags held fds outside the jail only
+echo "[Test 1] fd scan mode..."
+OUT="${TEST_DIR}/fdscan.jsonl"
+watch_target "${OUT}" fdscan "sleep 0.2; exec 3<${JAIL}/inside.txt; exec 4</etc/hostname; sleep 0.3"
+
+if ! violations "${OUT}" | grep -qx "/etc/hostname"; then
+    echo "FAIL: /etc/hostname not reported"
+    cat "${OUT}"
+    exit 1
+fi
+if violations "${OUT}" | grep -q "inside.txt"; then
+    echo "FAIL: file inside the jail reported"
+    exit 1
+fi
+if [[ "$(tail -n1 "${OUT}" | python3 -c "import sys, json; print(json.load(sys.stdin)['event'])")" != "stopped" ]]; then
+    echo "FAIL: jailwatch did not stop when the target exited"
+    exit 1
+fi
+echo "PASS: Violation reported, jail file ignored, exited with target"
+echo ""
+
+# Test 2: Unchanged fd slots are not re-read
+echo "[Test 2] fd scan cache..."
+OUT="${TEST_DIR}/cache.jsonl"
+watch_target "${OUT}" fdscan "sleep 0.1; for fd in \$(seq 10 40); do eval \"exec \${fd}<${JAIL}/inside.txt\"; done; sleep 1"
+
+READLINKS=$(tail -n1 "${OUT}" | python3 -c "import sys, json; print(json.load(sys.stdin)['readlinks'])")
+echo "  readlinks over ~50 scans of ~35 fds: ${READLINKS}"
+if [[ ${READLINKS} -gt 200 ]]; then
+    echo "FAIL: fd targets re-read on every scan"
+    exit 1
+fi
+echo "PASS: Only new fd slots are resolved"
+echo ""
+
+# Test 3: Descendants are watched
+echo "[Test 3] Child processes..."
+OUT="${TEST_DIR}/child.jsonl"
+watch_target "${OUT}" fdscan "sleep 0.1; bash -c 'exec 5</etc/passwd; sleep 0.4'; sleep 0.1"
+
+if ! violations "${OUT}" | grep -qx "/etc/passwd"; then
+    echo "FAIL: open in child process not reported"
+    cat "${OUT}"
+    exit 1
+fi
+echo "PASS: Child process violation reported"
+echo ""
+
+# Test 4: fanotify catches opens too short for any scan
+echo "[Test 4] fanotify mode..."
+OUT="${TEST_DIR}/fanotify.jsonl"
+sleep 0.1 &
+if "${BIN_DIR}/jailwatch" --pid $! --jail "${JAIL}" --mode fanotify > /dev/null 2>&1; then
+    watch_target "${OUT}" fanotify "sleep 0.2; cat /etc/hostname > /dev/null; sleep 0.2"
+    if ! violations "${OUT}" | grep -qx "/etc/hostname"; then
+        echo "FAIL: short-lived open not reported"
+        cat "${OUT}"
+        exit 1
+    fi
+    echo "PASS: Short-lived open reported"
+else
+    echo "SKIP: fanotify not permitted here"
+fi
+echo ""
+
+echo "==================================="
+echo "All jailwatch tests PASSED ✓"
+echo "==================================="
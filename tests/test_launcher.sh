@@ -0,0 +1,436 @@
+#!/usr/bin/env bash
+# Test script for the zencube_launch sandbox launcher
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+CORE_DIR="${SCRIPT_DIR}/../core_c"
+BIN_DIR="${CORE_DIR}/bin"
+LAUNCH="${BIN_DIR}/zencube_launch"
+
+echo "=== ZenCube Core C - Launcher Test ==="
+echo ""
+
+if [[ ! -f "${LAUNCH}" ]]; then
+    echo "Error: zencube_launch binary not found. Run 'make' first."
+    exit 1
+fi
+
+TEST_DIR=$(mktemp -d)
+# /tmp is on the default whitelist, so "outside" files live elsewhere
+OUTSIDE=$(mktemp -d "${CORE_DIR}/.launcher_test.XXXXXX")
+trap "rm -rf ${TEST_DIR} ${OUTSIDE}" EXIT
+JAIL="${TEST_DIR}/jail"
+mkdir -p "${JAIL}"
+echo "secret" > "${OUTSIDE}/secret.txt"
+
+status_field() {
+    python3 -c "import sys, json; print(json.loads(open(sys.argv[1]).readlines()[-1])[sys.argv[2]])" "$1" "$2"
+}
+
+# Test 1: Status line
+echo "[Test 1] Status report..."
+"${LAUNCH}" --jail "${JAIL}" --jail-best-effort --status-fd 3 -- true 3> "${TEST_DIR}/status.json"
+EVENT=$(status_field "${TEST_DIR}/status.json" event)
+LANDLOCK=$(status_field "${TEST_DIR}/status.json" landlock)
+echo "  event=${EVENT} landlock=${LANDLOCK} abi=$(status_field "${TEST_DIR}/status.json" landlock_abi)"
+if [[ "${EVENT}" != "ready" ]]; then
+    echo "FAIL: Expected ready status"
+    exit 1
+fi
+echo "PASS: Launcher reported status before exec"
+echo ""
+
+if [[ "${LANDLOCK}" != "True" ]]; then
+    echo "SKIP: Landlock not available on this kernel; enforcement tests skipped"
+else
+    # Test 2: The jail is writable and is the working directory
+    echo "[Test 2] Access inside the jail..."
+    "${LAUNCH}" --jail "${JAIL}" -- sh -c 'echo data > inside.txt && cat inside.txt > /dev/null'
+    if [[ ! -f "${JAIL}/inside.txt" ]]; then
+        echo "FAIL: Could not write inside the jail"
+        exit 1
+    fi
+    echo "PASS: Jail directory is read-write"
+    echo ""
+
+    # Test 3: Everything else outside the whitelist is denied by the kernel
+    echo "[Test 3] Access outside the jail..."
+    if "${LAUNCH}" --jail "${JAIL}" -- cat "${OUTSIDE}/secret.txt" 2> "${TEST_DIR}/err.txt"; then
+        echo "FAIL: Read outside the jail succeeded"
+        exit 1
+    fi
+    if ! grep -q "Permission denied" "${TEST_DIR}/err.txt"; then
+        echo "FAIL: Expected EACCES, got: $(cat "${TEST_DIR}/err.txt")"
+        exit 1
+    fi
+    if "${LAUNCH}" --jail "${JAIL}" -- touch "${OUTSIDE}/new.txt" 2> /dev/null; then
+        echo "FAIL: Write outside the jail succeeded"
+        exit 1
+    fi
+    echo "PASS: Outside reads and writes fail with EACCES"
+    echo ""
+
+    # Test 4: System paths stay usable but read-only
+    echo "[Test 4] System paths..."
+    "${LAUNCH}" --jail "${JAIL}" -- sh -c 'ls /usr/bin > /dev/null && echo ok > /dev/null'
+    if "${LAUNCH}" --jail "${JAIL}" -- touch /usr/lib/zencube_launch_test 2> /dev/null; then
+        rm -f /usr/lib/zencube_launch_test
+        echo "FAIL: System library directory writable"
+        exit 1
+    fi
+    echo "PASS: Binaries run, /dev writable, library directories read-only"
+    echo ""
+
+    # Test 5: Extra read-only paths
+    echo "[Test 5] --ro grants read access..."
+    "${LAUNCH}" --jail "${JAIL}" --ro "${OUTSIDE}" -- cat "${OUTSIDE}/secret.txt" > /dev/null
+    echo "PASS: --ro path readable"
+    echo ""
+fi
+
+# Test 6: exec failure
+echo "[Test 6] Missing command..."
+set +e
+"${LAUNCH}" --jail "${JAIL}" --best-effort --status-fd 3 -- /nonexistent/command 3> "${TEST_DIR}/status.json" 2> /dev/null
+CODE=$?
+set -e
+if [[ ${CODE} -ne 127 || "$(status_field "${TEST_DIR}/status.json" event)" != "error" ]]; then
+    echo "FAIL: Expected exit 127 and an error status (got ${CODE})"
+    exit 1
+fi
+echo "PASS: exec failure reported with exit 127"
+echo ""
+
+# Test 7: Network deny
+echo "[Test 7] --no-net..."
+cat > "${TEST_DIR}/net.py" << 'EOF'
+import socket, sys
+try:
+    socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sys.exit("AF_INET socket created")
+except PermissionError:
+    pass
+socket.socket(socket.AF_UNIX, socket.SOCK_STREAM).close()
+EOF
+"${LAUNCH}" --no-net --status-fd 3 -- python3 "${TEST_DIR}/net.py" 3> "${TEST_DIR}/status.json"
+if ! grep -q '"seccomp"' "${TEST_DIR}/status.json"; then
+    echo "FAIL: Status line lacks seccomp details"
+    exit 1
+fi
+echo "PASS: AF_INET denied, AF_UNIX allowed"
+echo ""
+
+# Test 8: Deny and kill lists
+echo "[Test 8] --seccomp-deny / --seccomp-kill..."
+OUT=$("${LAUNCH}" --seccomp-deny getppid,ptrace -- python3 -c 'import ctypes,os; print(ctypes.CDLL(None, use_errno=True).getppid(), os.getpid() > 0)')
+if [[ "${OUT}" != "-1 True" ]]; then
+    echo "FAIL: getppid not denied (got: ${OUT})"
+    exit 1
+fi
+set +e
+# Run under a child shell so its "Bad system call" notice goes to /dev/null
+sh -c '"$@"; exit $?' sh "${LAUNCH}" --seccomp-kill getppid -- python3 -c 'import os; os.getppid()' 2> /dev/null
+CODE=$?
+set -e
+if [[ ${CODE} -ne 159 ]]; then
+    echo "FAIL: Expected SIGSYS exit 159 (got ${CODE})"
+    exit 1
+fi
+if "${LAUNCH}" --seccomp-deny no_such_syscall -- true 2> /dev/null; then
+    echo "FAIL: Unknown syscall accepted"
+    exit 1
+fi
+echo "PASS: Denied calls fail with EPERM, killed calls raise SIGSYS"
+echo ""
+
+# Test 9: Filter benchmark
+echo "[Test 9] bench_seccomp..."
+"${BIN_DIR}/bench_seccomp" --iterations 20000 > "${TEST_DIR}/bench.txt"
+if ! grep -q "deny 256 (tree)" "${TEST_DIR}/bench.txt"; then
+    echo "FAIL: Benchmark output incomplete"
+    exit 1
+fi
+echo "PASS: Benchmark ran"
+echo ""
+
+# Test 10: Per-run cgroup
+echo "[Test 10] --cgroup-parent..."
+CG_MOUNT=$(awk '$0 ~ / - cgroup2 / {print $5; exit}' /proc/self/mountinfo)
+CG_PARENT="${CG_MOUNT}/zencube_test_$$"
+if [[ -z "${CG_MOUNT}" ]] || ! mkdir "${CG_PARENT}" 2> /dev/null; then
+    echo "SKIP: No writable cgroup v2 hierarchy"
+else
+    # cgroup directories are removed with rmdir once their tasks are gone
+    cleanup_cgroup() {
+        rm -rf "${TEST_DIR}" "${OUTSIDE}"
+        local dir
+        for dir in "${CG_PARENT}"/zencube_*; do
+            [[ -d "${dir}" ]] && rmdir "${dir}" 2> /dev/null
+        done
+        rmdir "${CG_PARENT}" 2> /dev/null || true
+    }
+    trap cleanup_cgroup EXIT
+    "${LAUNCH}" --cgroup-parent "${CG_PARENT}" --pids-max 64 --memory-max 256 --cgroup-best-effort \
+        --status-fd 3 -- cat /proc/self/cgroup 3> "${TEST_DIR}/cg_status.json" > "${TEST_DIR}/cg.txt"
+    CG_PATH=$(status_field "${TEST_DIR}/cg_status.json" cgroup)
+    echo "  cgroup=${CG_PATH}"
+    if [[ "${CG_PATH}" != "${CG_PARENT}"/zencube_* ]] ||
+       ! grep -q "^0::.*/zencube_test_$$/$(basename "${CG_PATH}")\$" "${TEST_DIR}/cg.txt"; then
+        echo "FAIL: Command did not run in its own cgroup"
+        exit 1
+    fi
+    if [[ -f "${CG_PATH}/pids.max" ]]; then
+        if [[ "$(cat "${CG_PATH}/pids.max")" != "64" ]]; then
+            echo "FAIL: pids.max not applied"
+            exit 1
+        fi
+        # A fork bomb stops at the limit instead of exhausting the host
+        if "${LAUNCH}" --cgroup-parent "${CG_PARENT}" --pids-max 4 -- \
+            sh -c 'for i in 1 2 3 4 5 6 7 8; do sleep 1 & done; wait' 2> /dev/null; then
+            echo "FAIL: pids.max did not stop forks"
+            exit 1
+        fi
+        echo "  pids.max enforced"
+    else
+        echo "  pids controller not delegated; limits reported: $(status_field "${TEST_DIR}/cg_status.json" cgroup_error)"
+        # Without --best-effort a missing limit is fatal
+        if "${LAUNCH}" --cgroup-parent "${CG_PARENT}" --pids-max 64 -- true 2> /dev/null; then
+            echo "FAIL: Missing pids.max ignored without --best-effort"
+            exit 1
+        fi
+        # Best effort for the jail says nothing about the limits
+        if "${LAUNCH}" --cgroup-parent "${CG_PARENT}" --pids-max 64 --jail-best-effort -- true 2> /dev/null; then
+            echo "FAIL: Missing pids.max ignored with only --jail-best-effort"
+            exit 1
+        fi
+    fi
+    echo "PASS: Run placed in its own cgroup"
+fi
+echo ""
+
+# Test 11: CPU placement on a synthetic 2-node, 8-core, SMT-2 topology
+echo "[Test 11] --cores placement and rebalance..."
+SYSFS="${TEST_DIR}/sys"
+mkdir -p "${SYSFS}/devices/system/cpu" "${SYSFS}/devices/system/node/node0" "${SYSFS}/devices/system/node/node1"
+echo "0-15" > "${SYSFS}/devices/system/cpu/online"
+for cpu in $(seq 0 15); do
+    mkdir -p "${SYSFS}/devices/system/cpu/cpu${cpu}/topology"
+    echo "$((cpu % 8)),$((cpu % 8 + 8))" > "${SYSFS}/devices/system/cpu/cpu${cpu}/topology/thread_siblings_list"
+done
+echo "0-3,8-11" > "${SYSFS}/devices/system/node/node0/cpulist"
+echo "4-7,12-15" > "${SYSFS}/devices/system/node/node1/cpulist"
+
+placement_field() {
+    python3 -c "import sys, json; print(json.loads(open(sys.argv[1]).readline())['placement'][sys.argv[2]])" "$1" "$2"
+}
+PLACE=("${LAUNCH}" --sysfs-root "${SYSFS}" --placement-dir "${TEST_DIR}/leases")
+PIDS=()
+for run in 1 2 3 4; do
+    "${PLACE[@]}" --cores 2 --status-fd 3 -- sleep 30 3> "${TEST_DIR}/place${run}.json" &
+    PIDS+=($!)
+    sleep 0.2
+done
+for run in 1 2 3 4; do
+    echo "  run ${run}: cpus=$(placement_field "${TEST_DIR}/place${run}.json" cpus) nodes=$(placement_field "${TEST_DIR}/place${run}.json" nodes) shared=$(placement_field "${TEST_DIR}/place${run}.json" shared)"
+done
+# Core 0 (CPUs 0 and 8) is reserved; whole cores are leased, one node each
+if [[ "$(placement_field "${TEST_DIR}/place1.json" cpus)" != "4-5,12-13" ||
+      "$(placement_field "${TEST_DIR}/place2.json" cpus)" != "1-2,9-10" ||
+      "$(placement_field "${TEST_DIR}/place3.json" cpus)" != "6-7,14-15" ||
+      "$(placement_field "${TEST_DIR}/place4.json" shared)" != "True" ]]; then
+    kill "${PIDS[@]}" 2> /dev/null
+    echo "FAIL: Unexpected placement"
+    exit 1
+fi
+# Once run 1 finishes, run 4 stops sharing
+kill "${PIDS[0]}"
+wait "${PIDS[0]}" 2> /dev/null || true
+MOVED=$("${PLACE[@]}" --rebalance | python3 -c "import sys, json; print(json.load(sys.stdin)['moved'])")
+NEW_CPUS=$(python3 -c "import sys, json; print(json.load(open(sys.argv[1]))['cpus'])" "${TEST_DIR}/leases/run_${PIDS[3]}.json")
+kill "${PIDS[@]:1}" 2> /dev/null
+wait 2> /dev/null || true
+echo "  after rebalance: moved=${MOVED} run 4 cpus=${NEW_CPUS}"
+if [[ "${MOVED}" != "1" || "${NEW_CPUS}" != "[4, 5, 12, 13]" ]]; then
+    echo "FAIL: Rebalance did not move the sharing run onto freed cores"
+    exit 1
+fi
+# A running process (the monitoring worker) moves onto the reserved core
+sleep 30 &
+RESERVE_PID=$!
+RESERVED=$("${LAUNCH}" --sysfs-root "${SYSFS}" --reserve-pid "${RESERVE_PID}" |
+    python3 -c "import sys, json; print(json.load(sys.stdin)['cpus'])")
+kill "${RESERVE_PID}" 2> /dev/null
+wait "${RESERVE_PID}" 2> /dev/null || true
+echo "  --reserve-pid: cpus=${RESERVED}"
+if [[ "${RESERVED}" != "0,8" ]]; then
+    echo "FAIL: Running process not moved onto the reserved core"
+    exit 1
+fi
+# The real host: the command inherits its placement
+ALLOWED=$("${LAUNCH}" --placement-dir "${TEST_DIR}/leases_host" --cores 1 --status-fd 3 -- \
+    grep Cpus_allowed_list /proc/self/status 3> "${TEST_DIR}/host_place.json" | awk '{print $2}')
+if [[ "${ALLOWED}" != "$(placement_field "${TEST_DIR}/host_place.json" cpus)" ]]; then
+    echo "FAIL: Command not confined to its placement (${ALLOWED})"
+    exit 1
+fi
+echo "PASS: Runs get idle whole cores and move once cores free up; monitors stay reserved"
+echo ""
+
+# Test 12: Ephemeral overlay jail
+echo "[Test 12] --overlay..."
+mkdir -p "${TEST_DIR}/template"
+echo "original" > "${TEST_DIR}/template/keep.txt"
+OVERLAY=(--overlay-dir "${TEST_DIR}/overlay")
+set +e
+"${LAUNCH}" --jail "${TEST_DIR}/template" --overlay "${OVERLAY[@]}" --status-fd 3 -- /bin/sh -c \
+    'echo changed > keep.txt; echo new > new.txt; dd if=/dev/zero of=big bs=1M count=8 2> /dev/null; cat keep.txt; sleep 1' \
+    3> "${TEST_DIR}/overlay.json" > "${TEST_DIR}/overlay.out" &
+RUN_PID=$!
+sleep 0.5
+USAGE=$("${LAUNCH}" "${OVERLAY[@]}" --overlay-usage ${RUN_PID} 2> /dev/null)
+wait ${RUN_PID}
+CODE=$?
+set -e
+if [[ ${CODE} -ne 0 ]] && grep -q '"overlay: ' "${TEST_DIR}/overlay.json"; then
+    echo "SKIP: Cannot mount overlayfs here ($(cat "${TEST_DIR}/overlay.json"))"
+else
+    if [[ "$(cat "${TEST_DIR}/overlay.out")" != "changed" ]] || ! grep -q '"overlay":{' "${TEST_DIR}/overlay.json"; then
+        echo "FAIL: The run did not see its own writes through the overlay"
+        exit 1
+    fi
+    if [[ "$(cat "${TEST_DIR}/template/keep.txt")" != "original" || -e "${TEST_DIR}/template/new.txt" ]]; then
+        echo "FAIL: Writes reached the jail template"
+        exit 1
+    fi
+    BYTES=$(echo "${USAGE}" | python3 -c "import sys, json; print(json.load(sys.stdin)['bytes'])")
+    if [[ ${BYTES} -lt 8000000 ]]; then
+        echo "FAIL: Upper layer usage not reported (${USAGE})"
+        exit 1
+    fi
+    # Directory upper: survives the run until released, then goes in the background
+    "${LAUNCH}" --jail "${TEST_DIR}/template" --overlay --overlay-upper dir "${OVERLAY[@]}" -- /bin/sh -c \
+        'mkdir -p a/b; echo x > a/b/c; chmod 555 a' &
+    RUN_PID=$!
+    wait ${RUN_PID}
+    if [[ ! -f "${TEST_DIR}/overlay/run_${RUN_PID}/upper/a/b/c" ]]; then
+        echo "FAIL: Directory upper layer missing after the run"
+        exit 1
+    fi
+    "${LAUNCH}" "${OVERLAY[@]}" --overlay-release ${RUN_PID} > /dev/null
+    for i in $(seq 1 50); do
+        [[ -z "$(ls -A "${TEST_DIR}/overlay" | grep -v '^run_')" ]] && break
+        sleep 0.1
+    done
+    if [[ -n "$(ls -A "${TEST_DIR}/overlay" | grep -v '^run_')" || -e "${TEST_DIR}/overlay/run_${RUN_PID}" ]]; then
+        echo "FAIL: Released upper layer not deleted ($(ls -A "${TEST_DIR}/overlay"))"
+        exit 1
+    fi
+    echo "PASS: Writes stay in the run's upper layer (${BYTES} bytes) and are discarded"
+fi
+echo ""
+
+# Test 13: Output capture
+echo "[Test 13] --capture..."
+CAPTURE="${TEST_DIR}/capture.log"
+header_field() {
+    python3 -c "import struct, sys
+h = open(sys.argv[1], 'rb').read(64)
+assert h[:7] == b'ZCCAPT1'
+f = dict(zip(('bytes', 'passed', 'dropped', 'updates', 'done', 'writer_pid'), struct.unpack_from('<QQQQIi', h, 8)))
+print(f[sys.argv[2]])" "$1" "$2"
+}
+wait_done() {
+    for i in $(seq 1 50); do
+        [[ "$(header_field "$1.head" done)" == "1" ]] && return 0
+        sleep 0.1
+    done
+    return 1
+}
+"${LAUNCH}" --capture "${CAPTURE}" --status-fd 3 -- /bin/sh -c 'echo out; echo err >&2' 3> "${TEST_DIR}/capture.json" > "${TEST_DIR}/capture.out"
+if ! wait_done "${CAPTURE}"; then
+    echo "FAIL: Capture never finished"
+    exit 1
+fi
+if [[ "$(cat "${CAPTURE}")" != $'out\nerr' || -s "${TEST_DIR}/capture.out" ]] ||
+   ! grep -q '"capture":{' "${TEST_DIR}/capture.json"; then
+    echo "FAIL: Both streams should go to the log, in order ($(cat "${CAPTURE}"))"
+    exit 1
+fi
+if [[ "$(header_field "${CAPTURE}.head" bytes)" != "$(stat -c %s "${CAPTURE}")" ]]; then
+    echo "FAIL: Header byte count does not match the log"
+    exit 1
+fi
+# Passthrough to a pipe
+PASSED=$("${LAUNCH}" --capture "${CAPTURE}" --capture-passthrough -- /bin/sh -c 'echo hello' | cat)
+wait_done "${CAPTURE}"
+if [[ "${PASSED}" != "hello" || "$(cat "${CAPTURE}")" != "hello" ]]; then
+    echo "FAIL: Passthrough output missing (got '${PASSED}')"
+    exit 1
+fi
+# Bulk output lands in full
+START=$(date +%s%N)
+"${LAUNCH}" --capture "${CAPTURE}" -- /bin/sh -c 'head -c 200000000 /dev/zero'
+wait_done "${CAPTURE}"
+ELAPSED_MS=$(( ($(date +%s%N) - START) / 1000000 ))
+if [[ "$(stat -c %s "${CAPTURE}")" != "200000000" ]]; then
+    echo "FAIL: Bulk output truncated ($(stat -c %s "${CAPTURE}") bytes)"
+    exit 1
+fi
+echo "PASS: Output captured in order; 200MB in ${ELAPSED_MS}ms"
+rm -f "${CAPTURE}" "${CAPTURE}.head"
+echo ""
+
+# Test 14: Output policy
+echo "[Test 14] --capture-head / --capture-tail / --capture-rate..."
+"${LAUNCH}" --capture "${CAPTURE}" --capture-head 0.001 --capture-tail 0.001 --status-fd 3 -- \
+    /bin/sh -c 'seq 1 200000' 3> "${TEST_DIR}/policy.json"
+wait_done "${CAPTURE}"
+TOTAL=$(header_field "${CAPTURE}.head" bytes)
+SIZE=$(stat -c %s "${CAPTURE}")
+ELIDED=$(python3 -c "import struct, sys; print(struct.unpack_from('<Q', open(sys.argv[1], 'rb').read(96), 88)[0])" "${CAPTURE}.head")
+if [[ "$(head -1 "${CAPTURE}")" != "1" || "$(tail -1 "${CAPTURE}")" != "200000" ]] ||
+   ! grep -q "zencube: ${ELIDED} bytes of output elided" "${CAPTURE}"; then
+    echo "FAIL: Log should hold the head, a marker and the tail"
+    exit 1
+fi
+if [[ ${SIZE} -gt 2200 || ${ELIDED} -ne $((TOTAL - 2 * 1048)) || -e "${CAPTURE}.tail" ]] ||
+   ! grep -q '"head_bytes":1048' "${TEST_DIR}/policy.json"; then
+    echo "FAIL: Log not bounded (${SIZE} bytes of ${TOTAL}, ${ELIDED} elided)"
+    exit 1
+fi
+START=$(date +%s%N)
+"${LAUNCH}" --capture "${CAPTURE}" --capture-rate 4 -- /bin/sh -c 'head -c 8388608 /dev/zero'
+ELAPSED_MS=$(( ($(date +%s%N) - START) / 1000000 ))
+wait_done "${CAPTURE}"
+if [[ ${ELAPSED_MS} -lt 1000 || "$(stat -c %s "${CAPTURE}")" != "8388608" ]]; then
+    echo "FAIL: 8MB at 4MB/s finished in ${ELAPSED_MS}ms"
+    exit 1
+fi
+echo "PASS: ${SIZE} of ${TOTAL} bytes kept; 8MB at 4MB/s took ${ELAPSED_MS}ms"
+rm -f "${CAPTURE}" "${CAPTURE}.head"
+echo ""
+
+# Test 15: CPU time budget
+echo "[Test 15] --cpu-seconds..."
+START=$(date +%s%N)
+set +e
+timeout 30 "${LAUNCH}" --cpu-seconds 1 --status-fd 3 -- /bin/sh -c 'while :; do :; done' \
+    3> "${TEST_DIR}/cpu.json"
+CODE=$?
+set -e
+ELAPSED_MS=$(( ($(date +%s%N) - START) / 1000000 ))
+# 152 = SIGXCPU, 137 = SIGKILL; 124 would be our timeout
+if [[ ${CODE} -ne 152 && ${CODE} -ne 137 ]]; then
+    echo "FAIL: Busy loop exited with ${CODE} after ${ELAPSED_MS}ms"
+    exit 1
+fi
+if ! grep -q '"cpu_seconds":1' "${TEST_DIR}/cpu.json"; then
+    echo "FAIL: Status line lacks cpu_seconds: $(cat "${TEST_DIR}/cpu.json")"
+    exit 1
+fi
+echo "PASS: Busy loop stopped with ${CODE} after ${ELAPSED_MS}ms"
+echo ""
+
+echo "==================================="
+echo "All launcher tests PASSED ✓"
+echo "==================================="
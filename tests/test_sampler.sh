@@ -97,6 +97,8 @@ REQUIRED_FIELDS=(
     "event"
     "run_id"
     "timestamp"
+    "seq"
+    "mono_ns"
     "pid"
     "cpu_percent"
     "rss_bytes"
@@ -178,6 +180,298 @@ echo "PASS: Timestamp is valid ISO 8601 UTC"
 echo "  ${TIMESTAMP}"
 echo ""
 
+# Test 7: Check sequence numbers and monotonic collection times
+echo "[Test 7] Validating seq/mono_ns ordering..."
+if ! python3 - "${SAMPLE_LOG}" <<'PY'
+import json, sys
+samples = [json.loads(l) for l in open(sys.argv[1]) if '"event":"sample"' in l]
+seqs = [s["seq"] for s in samples]
+monos = [s["mono_ns"] for s in samples]
+assert seqs == list(range(len(seqs))), f"seq not contiguous: {seqs}"
+assert all(b > a for a, b in zip(monos, monos[1:])), "mono_ns not increasing"
+PY
+then
+    echo "FAIL: seq/mono_ns ordering invalid"
+    exit 1
+fi
+
+echo "PASS: seq is contiguous and mono_ns increases"
+echo ""
+
+# Test 8: cgroup mode reads the whole tree's CPU from cpu.stat
+echo "[Test 8] Sampling through a cgroup..."
+CG_MOUNT=$(awk '$0 ~ / - cgroup2 / {print $5; exit}' /proc/self/mountinfo)
+CG_PATH="${CG_MOUNT}/zencube_sampler_test_$$"
+if [[ -z "${CG_MOUNT}" ]] || ! mkdir "${CG_PATH}" 2> /dev/null || [[ ! -f "${CG_PATH}/cpu.stat" ]]; then
+    echo "SKIP: No writable cgroup v2 hierarchy with cpu.stat"
+else
+    # The busy loop is a child of the monitored shell: /proc would see an idle process
+    sh -c 'echo 0 > "$1/cgroup.procs"; sh -c "while :; do :; done" & wait' sh "${CG_PATH}" &
+    TARGET_PID=$!
+    CG_LOG="${TEST_DIR}/cgroup.jsonl"
+    "${BIN_DIR}/sampler" --pid ${TARGET_PID} --interval 0.5 --run-id cg --out "${CG_LOG}" \
+        --cgroup "${CG_PATH}" > /dev/null &
+    SAMPLER_PID=$!
+    sleep 3
+    kill -INT ${SAMPLER_PID} 2>/dev/null || true
+    wait ${SAMPLER_PID} 2>/dev/null || true
+    echo 1 > "${CG_PATH}/cgroup.kill" 2>/dev/null || pkill -P ${TARGET_PID} || true
+    wait ${TARGET_PID} 2>/dev/null || true
+    sleep 0.2
+    rmdir "${CG_PATH}"
+    
+    CG_CPU=$(python3 -c "import sys, json; print(int(max(json.loads(l).get('cpu_max', 0) for l in open(sys.argv[1]))))" "${CG_LOG}")
+    echo "  cpu_max=${CG_CPU}%"
+    if [[ ${CG_CPU} -lt 20 ]]; then
+        echo "FAIL: Busy child not visible through the cgroup"
+        exit 1
+    fi
+    echo "PASS: cgroup CPU covers the process tree"
+fi
+echo ""
+
+# Test 9: Jail disk usage follows writes and deletes without a rescan
+echo "[Test 9] Tracking jail disk usage..."
+JAIL_DIR="${TEST_DIR}/jail"
+mkdir -p "${JAIL_DIR}/sub"
+head -c 1048576 /dev/zero > "${JAIL_DIR}/sub/seed.bin"
+sleep 30 &
+TARGET_PID=$!
+JAIL_LOG="${TEST_DIR}/jail.jsonl"
+"${BIN_DIR}/sampler" --pid ${TARGET_PID} --interval 0.2 --run-id jail --out "${JAIL_LOG}" \
+    --jail "${JAIL_DIR}" > /dev/null &
+SAMPLER_PID=$!
+sleep 0.6
+mkdir "${JAIL_DIR}/sub/new"
+head -c 8388608 /dev/urandom > "${JAIL_DIR}/sub/new/big.bin"
+sync
+sleep 0.8
+rm -rf "${JAIL_DIR}/sub/new"
+sleep 0.8
+kill -INT ${SAMPLER_PID} 2>/dev/null || true
+wait ${SAMPLER_PID} 2>/dev/null || true
+kill ${TARGET_PID} 2>/dev/null || true
+wait ${TARGET_PID} 2>/dev/null || true
+
+JAIL_RESULT=$(python3 - "${JAIL_LOG}" << 'EOF'
+import json, sys
+samples = [json.loads(l) for l in open(sys.argv[1])]
+values = [s.get('jail_bytes') for s in samples if s.get('event') == 'sample']
+if not values or None in values:
+    print("missing")
+else:
+    print(values[0], max(values), values[-1])
+EOF
+)
+echo "  first/max/last jail_bytes: ${JAIL_RESULT}"
+if [[ "${JAIL_RESULT}" == "missing" ]]; then
+    echo "FAIL: Samples lack jail_bytes"
+    exit 1
+fi
+read -r JAIL_FIRST JAIL_MAX JAIL_LAST <<< "${JAIL_RESULT}"
+if [[ ${JAIL_FIRST} -lt 1048576 || $((JAIL_MAX - JAIL_FIRST)) -lt 8388608 || ${JAIL_LAST} -ne ${JAIL_FIRST} ]]; then
+    echo "FAIL: jail_bytes did not follow the 8 MB write and delete"
+    exit 1
+fi
+echo "PASS: jail_bytes grew by the write and returned after the delete"
+echo ""
+
+# Test 10: Network counters come from the target's own namespace
+echo "[Test 10] Sampling network I/O of an isolated namespace..."
+if ! unshare -n true 2>/dev/null || ! command -v ip > /dev/null; then
+    echo "SKIP: Cannot create a network namespace here"
+else
+    # 1000 x 1 KB UDP datagrams over the namespace's loopback, after a pause
+    # so the sampler has primed its counters
+    unshare -n sh -c 'ip link set lo up && sleep 1 && python3 -c "
+import socket, time
+rx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+rx.bind((\"127.0.0.1\", 0))
+tx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+for _ in range(1000):
+    tx.sendto(b\"x\" * 1024, rx.getsockname())
+    rx.recv(2048)
+time.sleep(1)
+"' &
+    TARGET_PID=$!
+    sleep 0.3
+    NET_LOG="${TEST_DIR}/net.jsonl"
+    "${BIN_DIR}/sampler" --pid ${TARGET_PID} --interval 0.2 --run-id net --out "${NET_LOG}" > /dev/null &
+    SAMPLER_PID=$!
+    wait ${TARGET_PID} 2>/dev/null || true
+    wait ${SAMPLER_PID} 2>/dev/null || true
+    
+    NET_RESULT=$(python3 - "${NET_LOG}" << 'EOF'
+import json, sys
+samples = [json.loads(l) for l in open(sys.argv[1])]
+samples = [s for s in samples if s.get('event') == 'sample']
+isolated = all(s.get('net_isolated') for s in samples)
+print(int(isolated), sum(s.get('net_rx_packets', 0) for s in samples),
+      sum(s.get('net_rx_bytes', 0) for s in samples))
+EOF
+)
+    read -r NET_ISOLATED NET_PACKETS NET_BYTES <<< "${NET_RESULT}"
+    echo "  isolated=${NET_ISOLATED} rx_packets=${NET_PACKETS} rx_bytes=${NET_BYTES}"
+    if [[ ${NET_ISOLATED} -ne 1 || ${NET_PACKETS} -lt 1000 || ${NET_BYTES} -lt 1024000 ]]; then
+        echo "FAIL: Loopback traffic of the namespace not reported"
+        exit 1
+    fi
+    echo "PASS: Per-interval rx/tx come from the target's namespace"
+fi
+echo ""
+
+# Test 11: taskstats delay accounting over one netlink socket
+echo "[Test 11] Collecting taskstats delay accounting..."
+# Two busy loops sharing one CPU: each waits for the other
+taskset -c 0 sh -c 'while :; do :; done' &
+TARGET_PID=$!
+taskset -c 0 sh -c 'while :; do :; done' &
+RIVAL_PID=$!
+DELAY_LOG="${TEST_DIR}/delays.jsonl"
+"${BIN_DIR}/sampler" --pid ${TARGET_PID} --interval 0.3 --run-id delays --out "${DELAY_LOG}" \
+    --delays > /dev/null 2> "${TEST_DIR}/delays.err" &
+SAMPLER_PID=$!
+sleep 1.5
+kill -INT ${SAMPLER_PID} 2>/dev/null || true
+wait ${SAMPLER_PID} 2>/dev/null || true
+kill ${TARGET_PID} ${RIVAL_PID} 2>/dev/null || true
+wait ${TARGET_PID} ${RIVAL_PID} 2>/dev/null || true
+
+if grep -q "taskstats unavailable" "${TEST_DIR}/delays.err"; then
+    echo "SKIP: taskstats not available here"
+else
+    DELAY_RESULT=$(python3 - "${DELAY_LOG}" << 'EOF'
+import json, sys
+samples = [json.loads(l) for l in open(sys.argv[1])]
+samples = [s for s in samples if s.get('event') == 'sample']
+fields = ('cpu_delay_total', 'blkio_delay_total', 'swapin_delay_total', 'freepages_delay_total')
+if not samples or any(f not in s for s in samples for f in fields):
+    print("missing")
+else:
+    cpu = [s['cpu_delay_total'] for s in samples]
+    print("ok" if cpu == sorted(cpu) and cpu[-1] > 0 else "flat", cpu[-1])
+EOF
+)
+    echo "  ${DELAY_RESULT}"
+    if [[ "${DELAY_RESULT}" != ok* ]]; then
+        echo "FAIL: Delay fields missing or CPU wait not counted"
+        exit 1
+    fi
+    echo "PASS: Delay accounting fields present and cpu_delay_total grows"
+fi
+echo ""
+
+# Test 12: smaps diffs attribute RSS growth to the mapping that grew
+echo "[Test 12] Attributing memory growth to mappings..."
+python3 -c "
+import time
+keep = []
+for _ in range(16):
+    keep.append(bytearray(4 << 20))
+    for i in range(0, 4 << 20, 4096):
+        keep[-1][i] = 1
+    time.sleep(0.1)
+time.sleep(1)
+" &
+TARGET_PID=$!
+MAP_LOG="${TEST_DIR}/maps.jsonl"
+"${BIN_DIR}/sampler" --pid ${TARGET_PID} --interval 0.2 --run-id maps --out "${MAP_LOG}" \
+    --map-growth 3 --map-interval 0.4 > /dev/null
+MAP_RESULT=$(python3 - "${MAP_LOG}" << 'EOF'
+import json, sys
+scans = [json.loads(l)['map_growth'] for l in open(sys.argv[1]) if '"map_growth"' in l]
+grown = sum(t['rss_delta'] for s in scans for t in s['top'])
+names = sorted({t['mapping'] for s in scans for t in s['top']})
+print(len(scans), grown, ','.join(names))
+EOF
+)
+read -r MAP_SCANS MAP_GROWN MAP_NAMES <<< "${MAP_RESULT}"
+echo "  scans=${MAP_SCANS} attributed=${MAP_GROWN} mappings=${MAP_NAMES}"
+# 64 MB allocated: most of it must show up, and merged regions growing
+# down from a fixed end must not be counted again as new mappings
+if [[ ${MAP_SCANS} -lt 3 || ${MAP_SCANS} -gt 10 || ${MAP_GROWN} -lt 50000000 || ${MAP_GROWN} -gt 100000000 ]]; then
+    echo "FAIL: Growth not attributed, or scans not rate-limited"
+    exit 1
+fi
+echo "PASS: Growing mappings reported, scans limited to the interval"
+echo ""
+
+# Test 13: The stop event summarises the run with quantile sketches
+echo "[Test 13] Run summary quantiles in the stop event..."
+python3 -c "
+import time
+end = time.time() + 1.5
+while time.time() < end: pass
+" &
+TARGET_PID=$!
+SUMMARY_LOG="${TEST_DIR}/summary.jsonl"
+"${BIN_DIR}/sampler" --pid ${TARGET_PID} --interval 0.1 --run-id summary --out "${SUMMARY_LOG}" > /dev/null
+if ! python3 - "${SUMMARY_LOG}" << 'EOF'
+import json, sys
+events = [json.loads(l) for l in open(sys.argv[1])]
+stop = [e for e in events if e['event'] == 'stop'][0]
+samples = [e for e in events if e['event'] == 'sample']
+cpu, rss = stop['cpu_percent'], stop['rss_bytes']
+print("  p50=%.1f p99=%.1f cpu_seconds=%.2f rss_gib_seconds=%.6f" %
+      (cpu['p50'], cpu['p99'], stop['cpu_seconds'], stop['rss_gib_seconds']))
+assert stop['run_id'] == 'summary'
+assert cpu['p50'] <= cpu['p90'] <= cpu['p99'] and cpu['p50'] > 20
+assert cpu['sketch']['count'] == len(samples) - 1
+assert rss['sketch']['count'] == len(samples) and rss['p50'] > 0
+assert 0.3 < stop['cpu_seconds'] < 2.5 and stop['rss_gib_seconds'] > 0
+EOF
+then
+    echo "FAIL: Stop event lacks run summary or it is wrong"
+    tail -1 "${SUMMARY_LOG}"
+    exit 1
+fi
+echo "PASS: Stop event carries quantiles, sketches and resource integrals"
+echo ""
+
+# Test 14: 10s/1m/10m rollups are written next to the log and agree with the samples
+echo "[Test 14] Multi-resolution rollup sidecars..."
+# Start 7-8 s into a 10 s bucket so the run crosses a boundary
+while [[ $(( $(date +%s) % 10 )) -ne 7 ]]; do sleep 0.2; done
+sleep 4 &
+TARGET_PID=$!
+ROLLUP_LOG="${TEST_DIR}/rollup.jsonl"
+"${BIN_DIR}/sampler" --pid ${TARGET_PID} --interval 0.1 --run-id rollup --out "${ROLLUP_LOG}" > /dev/null
+"${BIN_DIR}/sampler" --pid $$ --interval 0.1 --run-id norollup --out "${TEST_DIR}/norollup.jsonl" \
+    --no-rollups > /dev/null &
+NOROLLUP_PID=$!
+sleep 0.5
+kill -INT ${NOROLLUP_PID} 2>/dev/null || true
+wait ${NOROLLUP_PID} 2>/dev/null || true
+if ls "${TEST_DIR}"/norollup.jsonl.* > /dev/null 2>&1; then
+    echo "FAIL: --no-rollups still wrote sidecars"
+    exit 1
+fi
+if ! python3 - "${ROLLUP_LOG}" << 'EOF'
+import json, sys
+log = sys.argv[1]
+samples = [json.loads(l) for l in open(log) if '"sample"' in l]
+rss = [s['rss_bytes'] for s in samples]
+for suffix, width in (('.10s.jsonl', 10), ('.1m.jsonl', 60), ('.10m.jsonl', 600)):
+    rows = [json.loads(l) for l in open(log + suffix)]
+    print("  %-10s %d buckets, %s samples" % (suffix, len(rows), [r['samples'] for r in rows]))
+    assert all(r['event'] == 'rollup' and r['resolution_s'] == width for r in rows)
+    assert all(r['start_ms'] % (width * 1000) == 0 for r in rows)
+    assert sum(r['samples'] for r in rows) == len(samples)
+    assert sum(r['rss_bytes']['count'] for r in rows) == len(samples)
+    assert max(r['rss_bytes']['max'] for r in rows) == max(rss)
+    assert min(r['rss_bytes']['min'] for r in rows) == min(rss)
+    assert rows[-1]['rss_bytes']['last'] == rss[-1]
+    assert 'jail_bytes' not in rows[0]
+    if width == 10:
+        assert len(rows) >= 2
+EOF
+then
+    echo "FAIL: Rollups missing or inconsistent with the samples"
+    exit 1
+fi
+echo "PASS: Rollups cascade from 10s to 10m buckets and match the samples"
+echo ""
+
 # Summary
 echo "==================================="
 echo "All sampler tests PASSED ✓"
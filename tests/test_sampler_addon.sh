@@ -0,0 +1,79 @@
+#!/usr/bin/env bash
+# Test script for the in-process sampler N-API addon
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+CORE_DIR="${SCRIPT_DIR}/../core_c"
+BIN_DIR="${CORE_DIR}/bin"
+
+echo "=== ZenCube Core C - Sampler Addon Test ==="
+echo ""
+
+# Check if addon and node exist
+if [[ ! -f "${BIN_DIR}/zencube_sampler.node" ]]; then
+    echo "Error: zencube_sampler.node not found. Run 'make addon' first."
+    exit 1
+fi
+
+if ! command -v node &> /dev/null; then
+    echo "Error: node not found. Please install Node.js to test the addon."
+    exit 1
+fi
+
+# Test 1: Sample a short-lived process at 50 Hz until it exits
+echo "[Test 1] Sampling a 1s process at 50 Hz..."
+ADDON="${BIN_DIR}/zencube_sampler.node" node - <<'JS'
+const addon = require(process.env.ADDON);
+const { spawn } = require('child_process');
+
+const child = spawn('sleep', ['1']);
+let samples = 0;
+let batches = 0;
+let lastSeq = -1;
+
+addon.start({ pid: child.pid, intervalMs: 20, batchMs: 200 }, (batch) => {
+  batches++;
+  const seq = batch.columns.subarray(0, batch.count);
+  for (const s of seq) {
+    if (s !== lastSeq + 1) throw new Error(`seq gap: ${lastSeq} -> ${s}`);
+    lastSeq = s;
+  }
+  samples += batch.count;
+
+  if (batch.ended) {
+    if (samples < 20) throw new Error(`too few samples: ${samples}`);
+    if (batches < 3) throw new Error(`samples were not batched over time: ${batches}`);
+    console.log(`  ${samples} samples in ${batches} batches`);
+  }
+});
+JS
+echo "PASS: Addon delivered contiguous batches until target exit"
+echo ""
+
+# Test 2: stop() wakes the sampling thread immediately
+echo "[Test 2] Stopping a 10s-interval sampler..."
+ADDON="${BIN_DIR}/zencube_sampler.node" node - <<'JS'
+const addon = require(process.env.ADDON);
+const { spawn } = require('child_process');
+
+const child = spawn('sleep', ['30']);
+const handle = addon.start({ pid: child.pid, intervalMs: 10000 }, (batch) => {
+  if (batch.ended) {
+    child.kill();
+  }
+});
+
+const start = Date.now();
+setTimeout(() => {
+  handle.stop();
+  const elapsed = Date.now() - start;
+  if (elapsed > 1000) throw new Error(`stop() took ${elapsed} ms`);
+}, 100);
+JS
+echo "PASS: stop() returned without waiting for the interval"
+echo ""
+
+# Summary
+echo "==================================="
+echo "All sampler addon tests PASSED ✓"
+echo "==================================="
@@ -0,0 +1,185 @@
+#!/usr/bin/env bash
+# Test script for the pre-forked launch zygote
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+CORE_DIR="${SCRIPT_DIR}/../core_c"
+BIN_DIR="${CORE_DIR}/bin"
+ZYGOTE="${BIN_DIR}/zencube_zygote"
+
+echo "=== ZenCube Core C - Zygote Test ==="
+echo ""
+
+if [[ ! -x "${ZYGOTE}" ]]; then
+    echo "Error: zencube_zygote binary not found. Run 'make' first."
+    exit 1
+fi
+
+TEST_DIR=$(mktemp -d)
+JAIL="${TEST_DIR}/jail"
+mkdir -p "${JAIL}"
+SOCKET="${TEST_DIR}/zygote.sock"
+
+"${ZYGOTE}" --socket "${SOCKET}" --jail "${JAIL}" --no-net > "${TEST_DIR}/zygote.log" 2>&1 &
+ZYGOTE_PID=$!
+trap "kill ${ZYGOTE_PID} 2>/dev/null || true; rm -rf ${TEST_DIR}" EXIT
+
+for _ in {1..50}; do
+    [[ -S "${SOCKET}" ]] && break
+    sleep 0.1
+done
+if [[ ! -S "${SOCKET}" ]]; then
+    echo "FAIL: zygote did not create ${SOCKET}"
+    cat "${TEST_DIR}/zygote.log"
+    exit 1
+fi
+
+# Client shared by the tests: spawn() returns the started reply, the stdio
+# socket and pidfd, and the connection for the exit event
+cat > "${TEST_DIR}/client.py" << 'EOF'
+import array, json, os, socket, sys
+
+SOCKET = sys.argv[1]
+
+def request(req):
+    s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+    s.settimeout(5)
+    s.connect(SOCKET)
+    s.sendall((json.dumps(req) + "\n").encode())
+    return s
+
+def recv_line(s):
+    fds = array.array("i")
+    data, anc, _, _ = s.recvmsg(4096, socket.CMSG_SPACE(2 * fds.itemsize))
+    for level, kind, payload in anc:
+        if level == socket.SOL_SOCKET and kind == socket.SCM_RIGHTS:
+            fds.frombytes(payload[:len(payload) - len(payload) % fds.itemsize])
+    return json.loads(data.decode().split("\n")[0]), list(fds)
+
+def spawn(argv, **profile):
+    s = request(dict(cmd="spawn", argv=argv, **profile))
+    reply, fds = recv_line(s)
+    return s, reply, fds
+
+def run(argv, **profile):
+    s, reply, fds = spawn(argv, **profile)
+    assert reply["type"] == "started", reply
+    stdio = socket.socket(fileno=fds[0])
+    output = b""
+    while chunk := stdio.recv(65536):
+        output += chunk
+    stdio.close()
+    for fd in fds[1:]:
+        os.close(fd)
+    exit_event = json.loads(s.makefile().readline())
+    s.close()
+    return reply, output.decode(), exit_event
+EOF
+
+# Test 1: Spawn a command and get its output and exit code
+echo "[Test 1] Spawn through a warm template..."
+python3 - "${SOCKET}" "${JAIL}" << EOF
+import sys; sys.path.insert(0, "${TEST_DIR}")
+from client import *
+reply, output, exit_event = run(["sh", "-c", "pwd; echo err >&2; exit 3"], jail=sys.argv[2], no_net=True)
+assert output.split() == [os.path.realpath(sys.argv[2]), "err"], output
+assert exit_event == {"type": "exit", "pid": reply["pid"], "code": 3}, exit_event
+assert reply["net"] in ("namespace", "seccomp"), reply
+print("  pid=%d net=%s landlock=%s" % (reply["pid"], reply["net"], reply["landlock"]))
+EOF
+echo "PASS: Output, working directory and exit code delivered"
+echo ""
+
+# Test 2: Restrictions are inherited from the template
+echo "[Test 2] Template restrictions..."
+python3 - "${SOCKET}" "${JAIL}" << EOF
+import sys; sys.path.insert(0, "${TEST_DIR}")
+from client import *
+probe = "import socket\ntry:\n    socket.create_connection(('1.1.1.1', 53), timeout=1)\n    print('net-open')\nexcept OSError:\n    print('net-denied')\n"
+reply, output, _ = run(["python3", "-c", probe], jail=sys.argv[2], no_net=True)
+assert output.strip() == "net-denied", output
+if reply["landlock"]:
+    _, output, exit_event = run(["cat", "${CORE_DIR}/Makefile"], jail=sys.argv[2], no_net=True)
+    assert exit_event["code"] != 0 and "Permission denied" in output, output
+EOF
+echo "PASS: Network denied and file jail enforced in spawned commands"
+echo ""
+
+# Test 3: pidfd and signals
+echo "[Test 3] pidfd..."
+python3 - "${SOCKET}" << EOF
+import sys, signal, select; sys.path.insert(0, "${TEST_DIR}")
+from client import *
+s, reply, fds = spawn(["sleep", "30"])
+assert reply["type"] == "started" and len(fds) == 2, (reply, fds)
+signal.pidfd_send_signal(fds[1], signal.SIGKILL)
+assert select.select([fds[1]], [], [], 5)[0], "pidfd not readable after exit"
+exit_event = json.loads(s.makefile().readline())
+assert exit_event["signal"] == signal.SIGKILL, exit_event
+EOF
+echo "PASS: pidfd signals the child and reports its exit"
+echo ""
+
+# Test 4: Errors
+echo "[Test 4] Bad requests..."
+python3 - "${SOCKET}" << EOF
+import sys; sys.path.insert(0, "${TEST_DIR}")
+from client import *
+assert spawn(["/nonexistent/command"])[1]["type"] == "error"
+assert spawn([])[1]["type"] == "error"
+assert spawn(["true"], jail="/nonexistent")[1]["type"] == "error"
+assert recv_line(request({"cmd": "bogus"}))[0]["type"] == "error"
+EOF
+echo "PASS: Exec failures and invalid requests answered with errors"
+echo ""
+
+# Test 5: Launch latency
+echo "[Test 5] Launch latency..."
+python3 - "${SOCKET}" "${JAIL}" << EOF
+import sys, time, statistics; sys.path.insert(0, "${TEST_DIR}")
+from client import *
+latencies = []
+for _ in range(50):
+    start = time.perf_counter()
+    s, reply, fds = spawn(["true"], jail=sys.argv[2], no_net=True)
+    latencies.append((time.perf_counter() - start) * 1000)
+    for fd in fds:
+        os.close(fd)
+    s.makefile().readline()
+    s.close()
+median = statistics.median(latencies)
+print("  median %.3f ms, max %.3f ms over %d launches" % (median, max(latencies), len(latencies)))
+assert median < 5, "median launch latency %.3f ms" % median
+stats = recv_line(request({"cmd": "stats"}))[0]
+assert stats["spawns"] >= 50 and len(stats["templates"]) >= 2, stats
+EOF
+echo "PASS: Launches served from warm templates"
+echo ""
+
+# Test 6: Requests for a starting template wait without holding up others
+echo "[Test 6] Requests held for a starting template..."
+mkdir -p "${TEST_DIR}/jail2"
+python3 - "${SOCKET}" "${TEST_DIR}/jail2" << EOF
+import sys; sys.path.insert(0, "${TEST_DIR}")
+from client import *
+held = [request(dict(cmd="spawn", argv=["echo", str(i)], jail=sys.argv[2])) for i in range(4)]
+stats = recv_line(request({"cmd": "stats"}))[0]
+assert stats["type"] == "stats", stats
+for i, s in enumerate(held):
+    reply, fds = recv_line(s)
+    assert reply["type"] == "started", reply
+    stdio = socket.socket(fileno=fds[0])
+    assert stdio.makefile().read() == "%d\n" % i
+    stdio.close()
+    os.close(fds[1])
+    assert json.loads(s.makefile().readline())["code"] == 0
+stats = recv_line(request({"cmd": "stats"}))[0]
+jail2 = [t for t in stats["templates"] if t["jail"] == os.path.realpath(sys.argv[2])]
+assert len(jail2) == 1 and jail2[0]["spawns"] == 4, stats
+EOF
+echo "PASS: One template started, held requests served once it was ready"
+echo ""
+
+echo "==================================="
+echo "All zygote tests PASSED ✓"
+echo "==================================="